@@ -29,8 +29,10 @@
 #include <fstream>
 #include <utility>
 #include <iterator>
+#include <set>
 
 #include <wx/datetime.h>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/stdpaths.h>
@@ -47,8 +49,11 @@
 #include <glm/ext.hpp>
 
 #include "common.h"
+#include "streamwrapper.h"
+#include "thread_pool.h"
 #include "3d_cache.h"
 #include "3d_info.h"
+#include "3d_mesh_file.h"
 #include "sg/scenegraph.h"
 #include "filename_resolver.h"
 #include "3d_plugin_manager.h"
@@ -57,6 +62,9 @@
 
 #define MASK_3D_CACHE "3D_CACHE"
 
+#define CACHE_INDEX_FILE    "index"
+#define CACHE_INDEX_HEADER  "KICAD_3D_CACHE_INDEX 1"
+
 static wxCriticalSection lock3D_cache;
 
 
@@ -115,6 +123,30 @@ static const wxString sha1ToWXString( const unsigned char* aSHA1Sum )
 }
 
 
+static bool hexToSHA1( const char* aHex, unsigned char* aSHA1Sum )
+{
+    for( int i = 0; i < 40; ++i )
+    {
+        char c = aHex[i];
+        unsigned char nibble;
+
+        if( c >= '0' && c <= '9' )
+            nibble = c - '0';
+        else if( c >= 'a' && c <= 'f' )
+            nibble = c - 'a' + 10;
+        else
+            return false;
+
+        if( i & 1 )
+            aSHA1Sum[i / 2] |= nibble;
+        else
+            aSHA1Sum[i / 2] = nibble << 4;
+    }
+
+    return true;
+}
+
+
 class S3D_CACHE_ENTRY
 {
 private:
@@ -136,6 +168,7 @@ public:
     std::string   pluginInfo;   // PluginName:Version string
     SCENEGRAPH*   sceneData;
     S3DMODEL*     renderData;
+    bool          renderOnly;   // renderData was read from a mesh file, sceneData not loaded
 };
 
 
@@ -143,6 +176,7 @@ S3D_CACHE_ENTRY::S3D_CACHE_ENTRY()
 {
     sceneData = NULL;
     renderData = NULL;
+    renderOnly = false;
     memset( sha1sum, 0, 20 );
 }
 
@@ -168,6 +202,9 @@ void S3D_CACHE_ENTRY::SetSHA1( const unsigned char* aSHA1Sum )
     }
 
     memcpy( sha1sum, aSHA1Sum, 20 );
+
+    // the cache files are named after the hash
+    m_CacheBaseName.clear();
     return;
 }
 
@@ -183,6 +220,7 @@ const wxString S3D_CACHE_ENTRY::GetCacheBaseName( void )
 
 S3D_CACHE::S3D_CACHE()
 {
+    m_IndexLoaded = false;
     m_DirtyCache = false;
     m_FNResolver = new FILENAME_RESOLVER;
     m_Plugins = new S3D_PLUGIN_MANAGER;
@@ -205,7 +243,8 @@ S3D_CACHE::~S3D_CACHE()
 }
 
 
-SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr,
+                             bool aNeedScene )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
@@ -237,7 +276,7 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
             if( fmdate != mi->second->modTime )
             {
                 unsigned char hashSum[20];
-                getSHA1( full3Dpath, hashSum );
+                getIndexedSHA1( full3Dpath, hashSum );
                 mi->second->modTime = fmdate;
 
                 if( !isSHA1Same( hashSum, mi->second->sha1sum ) )
@@ -258,10 +297,14 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
                 if( NULL != mi->second->renderData )
                     S3D::Destroy3DModel( &mi->second->renderData );
 
-                mi->second->sceneData = m_Plugins->Load3DModel( full3Dpath, mi->second->pluginInfo );
+                loadEntry( mi->second, full3Dpath, aNeedScene );
             }
         }
 
+        // the entry was loaded for rendering only; load its scene graph now
+        if( aNeedScene && mi->second->renderOnly )
+            loadEntry( mi->second, full3Dpath, true );
+
         if( NULL != aCachePtr )
             *aCachePtr = mi->second;
 
@@ -269,7 +312,7 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
     }
 
     // a cache item does not exist; search the Filename->Cachename map
-    return checkCache( full3Dpath, aCachePtr );
+    return checkCache( full3Dpath, aCachePtr, aNeedScene );
 }
 
 
@@ -279,46 +322,14 @@ SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
 }
 
 
-SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr,
+                                   bool aNeedScene )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
 
-    unsigned char sha1sum[20];
-
-    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
-    {
-        // just in case we can't get a hash digest (for example, on access issues)
-        // or we do not have a configured cache file directory, we create an
-        // entry to prevent further attempts at loading the file
-        S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-        m_CacheList.push_back( ep );
-        wxFileName fname( aFileName );
-        ep->modTime = fname.GetModificationTime();
-
-        if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-            ( aFileName, ep ) ).second == false )
-        {
-            wxLogTrace( MASK_3D_CACHE, "%s:%s:%d\n * [BUG] duplicate entry in map file; key = '%s'",
-                        __FILE__, __FUNCTION__, __LINE__, aFileName );
-
-            m_CacheList.pop_back();
-            delete ep;
-        }
-        else
-        {
-            if( aCachePtr )
-                *aCachePtr = ep;
-
-        }
-
-        return NULL;
-    }
-
-    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
+    S3D_CACHE_ENTRY* ep = createEntry( aFileName, aNeedScene );
     m_CacheList.push_back( ep );
-    wxFileName fname( aFileName );
-    ep->modTime = fname.GetModificationTime();
 
     if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
                                ( aFileName, ep ) ).second == false )
@@ -334,20 +345,63 @@ SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY**
     if( aCachePtr )
         *aCachePtr = ep;
 
+    return ep->sceneData;
+}
+
+
+S3D_CACHE_ENTRY* S3D_CACHE::createEntry( const wxString& aFileName, bool aNeedScene )
+{
+    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
+    wxFileName fname( aFileName );
+    ep->modTime = fname.GetModificationTime();
+
+    unsigned char sha1sum[20];
+
+    // just in case we can't get a hash digest (for example, on access issues)
+    // or we do not have a configured cache file directory, the entry is left
+    // empty to prevent further attempts at loading the file
+    if( m_CacheDir.empty() || !getIndexedSHA1( aFileName, sha1sum ) )
+        return ep;
+
     ep->SetSHA1( sha1sum );
+    loadEntry( ep, aFileName, aNeedScene );
 
-    wxString bname = ep->GetCacheBaseName();
-    wxString cachename = m_CacheDir + bname + wxT( ".3dc" );
+    return ep;
+}
 
-    if( wxFileName::FileExists( cachename ) && loadCacheData( ep ) )
-        return ep->sceneData;
 
-    ep->sceneData = m_Plugins->Load3DModel( aFileName, ep->pluginInfo );
+void S3D_CACHE::loadEntry( S3D_CACHE_ENTRY* aCacheItem, const wxString& aFileName,
+                           bool aNeedScene )
+{
+    // the mesh file is all a renderer needs, and it is read without parsing anything
+    if( !aNeedScene && NULL == aCacheItem->renderData && loadRenderData( aCacheItem ) )
+    {
+        aCacheItem->renderOnly = true;
+        return;
+    }
 
-    if( NULL != ep->sceneData )
-        saveCacheData( ep );
+    aCacheItem->renderOnly = false;
 
-    return ep->sceneData;
+    {
+        std::lock_guard<std::mutex> lock( m_SceneLock );
+
+        wxString cachename = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dc" );
+
+        if( !wxFileName::FileExists( cachename ) || !loadCacheData( aCacheItem ) )
+        {
+            aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
+
+            if( NULL != aCacheItem->sceneData )
+                saveCacheData( aCacheItem );
+        }
+
+        if( aNeedScene || NULL == aCacheItem->sceneData || NULL != aCacheItem->renderData )
+            return;
+
+        aCacheItem->renderData = S3D::GetModel( aCacheItem->sceneData );
+    }
+
+    saveRenderData( aCacheItem );
 }
 
 
@@ -407,6 +461,143 @@ bool S3D_CACHE::getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum )
 }
 
 
+bool S3D_CACHE::getIndexedSHA1( const wxString& aFileName, unsigned char* aSHA1Sum )
+{
+    wxFileName fname( aFileName );
+    wxULongLong size = fname.GetSize();
+    wxDateTime modTime = fname.GetModificationTime();
+
+    if( size == wxInvalidSize || !modTime.IsValid() )
+        return getSHA1( aFileName, aSHA1Sum );
+
+    S3D_CACHE_INDEX_ENTRY entry;
+    entry.size = size.GetValue();
+    entry.modTime = modTime.GetValue().GetValue();
+
+    {
+        std::lock_guard<std::mutex> lock( m_IndexLock );
+
+        if( !m_IndexLoaded )
+            loadIndex();
+
+        std::map< wxString, S3D_CACHE_INDEX_ENTRY >::const_iterator mi;
+        mi = m_Index.find( aFileName );
+
+        if( mi != m_Index.end() && mi->second.size == entry.size
+            && mi->second.modTime == entry.modTime )
+        {
+            memcpy( aSHA1Sum, mi->second.sha1sum, 20 );
+            return true;
+        }
+    }
+
+    // hash without holding the lock, other files may be hashed meanwhile
+    if( !getSHA1( aFileName, entry.sha1sum ) )
+        return false;
+
+    memcpy( aSHA1Sum, entry.sha1sum, 20 );
+
+    std::lock_guard<std::mutex> lock( m_IndexLock );
+    m_Index[aFileName] = entry;
+    m_DirtyCache = true;
+
+    return true;
+}
+
+
+void S3D_CACHE::loadIndex()
+{
+    m_IndexLoaded = true;
+
+    if( m_CacheDir.empty() )
+        return;
+
+    wxString fname = m_CacheDir + wxT( CACHE_INDEX_FILE );
+
+    if( !wxFileName::FileExists( fname ) )
+        return;
+
+    OPEN_ISTREAM( file, fname.ToUTF8() );
+
+    std::string line;
+
+    // an index of another version is simply rebuilt
+    if( file.fail() || !std::getline( file, line ) || line != CACHE_INDEX_HEADER )
+    {
+        CLOSE_STREAM( file );
+        return;
+    }
+
+    // each line is: sha1 size modification_time full_path
+    while( std::getline( file, line ) )
+    {
+        S3D_CACHE_INDEX_ENTRY entry;
+        char hex[41];
+        int  pathPos = 0;
+
+        if( sscanf( line.c_str(), "%40s %llu %lld %n", hex, &entry.size, &entry.modTime,
+                    &pathPos ) < 3
+            || pathPos == 0 || (size_t) pathPos >= line.size()
+            || strlen( hex ) != 40 || !hexToSHA1( hex, entry.sha1sum ) )
+        {
+            wxLogTrace( MASK_3D_CACHE, " * [3D model] bad line in the cache index '%s'",
+                        line.c_str() );
+            continue;
+        }
+
+        m_Index[ wxString::FromUTF8( line.c_str() + pathPos ) ] = entry;
+    }
+
+    CLOSE_STREAM( file );
+}
+
+
+void S3D_CACHE::saveIndex()
+{
+    if( !m_DirtyCache || m_CacheDir.empty() )
+        return;
+
+    wxString fname = m_CacheDir + wxT( CACHE_INDEX_FILE );
+
+    // written aside then renamed, so an index is never seen half written
+    wxString tmpName = wxFileName::CreateTempFileName( fname );
+
+    if( tmpName.empty() )
+        return;
+
+    bool ok;
+
+    {
+        OPEN_OSTREAM( file, tmpName.ToUTF8() );
+
+        file << CACHE_INDEX_HEADER << "\n";
+
+        std::map< wxString, S3D_CACHE_INDEX_ENTRY >::const_iterator mi;
+
+        for( mi = m_Index.begin(); mi != m_Index.end(); ++mi )
+        {
+            file << sha1ToWXString( mi->second.sha1sum ).ToUTF8().data() << " "
+                 << mi->second.size << " " << mi->second.modTime << " "
+                 << mi->first.ToUTF8().data() << "\n";
+        }
+
+        ok = !file.fail();
+        CLOSE_STREAM( file );
+    }
+
+    if( ok && wxRenameFile( tmpName, fname, true ) )
+    {
+        m_DirtyCache = false;
+    }
+    else
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] could not write the cache index '%s'",
+                    fname );
+        wxRemoveFile( tmpName );
+    }
+}
+
+
 bool S3D_CACHE::loadCacheData( S3D_CACHE_ENTRY* aCacheItem )
 {
     wxString bname = aCacheItem->GetCacheBaseName();
@@ -502,6 +693,39 @@ bool S3D_CACHE::saveCacheData( S3D_CACHE_ENTRY* aCacheItem )
 }
 
 
+bool S3D_CACHE::loadRenderData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxString bname = aCacheItem->GetCacheBaseName();
+
+    if( bname.empty() || m_CacheDir.empty() )
+        return false;
+
+    aCacheItem->renderData = ReadMeshFile( m_CacheDir + bname + wxT( ".3dm" ) );
+
+    return NULL != aCacheItem->renderData;
+}
+
+
+bool S3D_CACHE::saveRenderData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( NULL == aCacheItem->renderData )
+        return false;
+
+    wxString bname = aCacheItem->GetCacheBaseName();
+
+    if( bname.empty() || m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + bname + wxT( ".3dm" );
+
+    // the file name is the hash of the model file: an existing file is up to date
+    if( wxFileName::FileExists( fname ) )
+        return true;
+
+    return WriteMeshFile( fname, *aCacheItem->renderData );
+}
+
+
 bool S3D_CACHE::Set3DConfigDir( const wxString& aConfigDir )
 {
     if( !m_ConfigDir.empty() )
@@ -694,6 +918,11 @@ std::list< wxString > const* S3D_CACHE::GetFileFilters( void ) const
 
 void S3D_CACHE::FlushCache( bool closePlugins )
 {
+    {
+        std::lock_guard<std::mutex> lock( m_IndexLock );
+        saveIndex();
+    }
+
     std::list< S3D_CACHE_ENTRY* >::iterator sCL = m_CacheList.begin();
     std::list< S3D_CACHE_ENTRY* >::iterator eCL = m_CacheList.end();
 
@@ -725,16 +954,16 @@ void S3D_CACHE::ClosePlugins( void )
 S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
 {
     S3D_CACHE_ENTRY* cp = NULL;
-    SCENEGRAPH* sp = load( aModelFileName, &cp );
-
-    if( !sp )
-        return NULL;
+    SCENEGRAPH* sp = load( aModelFileName, &cp, false );
 
     if( !cp )
     {
-        wxLogTrace( MASK_3D_CACHE,
-                    "%s:%s:%d\n  * [BUG] model loaded with no associated S3D_CACHE_ENTRY",
-                    __FILE__, __FUNCTION__, __LINE__ );
+        if( sp )
+        {
+            wxLogTrace( MASK_3D_CACHE,
+                        "%s:%s:%d\n  * [BUG] model loaded with no associated S3D_CACHE_ENTRY",
+                        __FILE__, __FUNCTION__, __LINE__ );
+        }
 
         return NULL;
     }
@@ -742,10 +971,71 @@ S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
     if( cp->renderData )
         return cp->renderData;
 
-    S3DMODEL* mp = S3D::GetModel( sp );
-    cp->renderData = mp;
+    if( !sp )
+        return NULL;
+
+    {
+        std::lock_guard<std::mutex> lock( m_SceneLock );
+        cp->renderData = S3D::GetModel( sp );
+    }
+
+    saveRenderData( cp );
+
+    return cp->renderData;
+}
+
+
+void S3D_CACHE::PreloadModels( const std::vector< wxString >& aModelFileNames )
+{
+    std::vector< wxString > files;
+
+    {
+        wxCriticalSectionLocker lock( lock3D_cache );
+        std::set< wxString > unique;
+
+        for( const wxString& name : aModelFileNames )
+        {
+            wxString full3Dpath = m_FNResolver->ResolvePath( name );
+
+            if( full3Dpath.empty() || m_CacheMap.count( full3Dpath ) )
+                continue;
+
+            if( unique.insert( full3Dpath ).second )
+                files.push_back( full3Dpath );
+        }
+    }
+
+    if( files.empty() )
+        return;
+
+    // The files are hashed and their mesh files read concurrently; the models which must
+    // be parsed again go through the plugins one at a time (see m_SceneLock).
+    std::vector< S3D_CACHE_ENTRY* > entries( files.size(), NULL );
+
+    ParallelFor( files.size(),
+                 [&]( size_t i )
+                 {
+                     entries[i] = createEntry( files[i], false );
+                 } );
+
+    {
+        wxCriticalSectionLocker lock( lock3D_cache );
+
+        for( size_t i = 0; i < files.size(); ++i )
+        {
+            // the model was loaded by another caller meanwhile
+            if( !m_CacheMap.insert( std::make_pair( files[i], entries[i] ) ).second )
+            {
+                delete entries[i];
+                continue;
+            }
+
+            m_CacheList.push_back( entries[i] );
+        }
+    }
 
-    return mp;
+    std::lock_guard<std::mutex> lock( m_IndexLock );
+    saveIndex();
 }
 
 
@@ -31,6 +31,8 @@
 
 #include <list>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <wx/string.h>
 #include "kicad_string.h"
 #include "filename_resolver.h"
@@ -46,6 +48,17 @@ class  FILENAME_RESOLVER;
 class  S3D_PLUGIN_MANAGER;
 
 
+/**
+ * The hash of a model file, valid as long as the file keeps its size and date
+ */
+struct S3D_CACHE_INDEX_ENTRY
+{
+    unsigned long long size;
+    long long          modTime;      // milliseconds since the epoch
+    unsigned char      sha1sum[20];
+};
+
+
 class S3D_CACHE
 {
 private:
@@ -61,7 +74,19 @@ private:
     /// plugin manager
     S3D_PLUGIN_MANAGER* m_Plugins;
 
-    /// set true if the cache needs to be updated
+    /// hashes of the model files by full path, saved in the cache directory
+    std::map< wxString, S3D_CACHE_INDEX_ENTRY > m_Index;
+
+    /// set true once the index file was read
+    bool m_IndexLoaded;
+
+    /// protects m_Index
+    std::mutex m_IndexLock;
+
+    /// the plugins and the scene graph library are not reentrant: their calls are serialized
+    std::mutex m_SceneLock;
+
+    /// set true if the cache index needs to be saved
     bool m_DirtyCache;
 
     /// 3D cache directory
@@ -81,10 +106,24 @@ private:
      *
      * @param[in]   aFileName   file name (full or partial path)
      * @param[out]  aCachePtr   optional return address for cache entry pointer
+     * @param[in]   aNeedScene  false if the render data is enough; the scene graph is then
+     *                          not loaded when the mesh file of the model is cached
      * @return      SCENEGRAPH object associated with file name
      * @retval      NULL    on error
      */
-    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL,
+                            bool aNeedScene = true );
+
+    /**
+     * Creates the cache entry of a model file, not yet added to the cache map;
+     * several entries may be created at once by different threads.
+     */
+    S3D_CACHE_ENTRY* createEntry( const wxString& aFileName, bool aNeedScene );
+
+    /**
+     * Fills a cache entry from the cache files, or from the plugins if they are missing
+     */
+    void loadEntry( S3D_CACHE_ENTRY* aCacheItem, const wxString& aFileName, bool aNeedScene );
 
     /**
      * Function getSHA1
@@ -97,14 +136,32 @@ private:
      */
     bool getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum );
 
+    /**
+     * Function getIndexedSHA1
+     * returns the SHA1 hash of the given file from the cache index, the file being hashed
+     * only when its size or modification time differ from the indexed ones
+     */
+    bool getIndexedSHA1( const wxString& aFileName, unsigned char* aSHA1Sum );
+
+    // read and write the cache index; m_IndexLock must be held
+    void loadIndex();
+    void saveIndex();
+
     // load scene data from a cache file
     bool loadCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
     // save scene data to a cache file
     bool saveCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
+    // load render data from a mesh file
+    bool loadRenderData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // save render data to a mesh file
+    bool saveRenderData( S3D_CACHE_ENTRY* aCacheItem );
+
     // the real load function (can supply a cache entry pointer to member functions)
-    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL,
+                      bool aNeedScene = true );
 
 public:
     S3D_CACHE();
@@ -200,6 +257,15 @@ public:
      */
     S3DMODEL* GetModel( const wxString& aModelFileName );
 
+    /**
+     * Function PreloadModels
+     * loads the render data of the models not cached yet, the unique files being loaded
+     * concurrently; the following calls to GetModel() then find them in the cache.
+     *
+     * @param aModelFileNames are the partial or full paths of the models, possibly repeated
+     */
+    void PreloadModels( const std::vector< wxString >& aModelFileNames );
+
     wxString GetModelHash( const wxString& aModelFileName );
 };
 
@@ -0,0 +1,381 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "3d_mesh_file.h"
+#include "plugins/3dapi/ifsg_api.h"
+
+
+#define MASK_3D_CACHE "3D_CACHE"
+
+static const char     MESH_FILE_MAGIC[8] = { 'K', 'I', 'C', 'A', 'D', '3', 'D', 'M' };
+static const uint32_t MESH_FILE_VERSION = 1;
+
+/// every array of the file starts on this boundary
+static const size_t   MESH_FILE_ALIGN = 16;
+
+#define MESH_HAS_TEXCOORDS  0x01
+#define MESH_HAS_COLORS     0x02
+
+
+struct MESH_FILE_HEADER
+{
+    char     m_Magic[8];
+    uint32_t m_Version;
+    uint16_t m_MaterialSize;    ///< sizeof( SMATERIAL ) of the writer
+    uint16_t m_VectorSize;      ///< sizeof( SFVEC3F ) of the writer
+    uint32_t m_MaterialsCount;
+    uint32_t m_MeshesCount;
+    uint32_t m_Reserved[2];
+};
+
+
+struct MESH_FILE_MESH
+{
+    uint32_t m_VertexSize;
+    uint32_t m_FaceIdxSize;
+    uint32_t m_MaterialIdx;
+    uint32_t m_Arrays;          ///< MESH_HAS_TEXCOORDS and MESH_HAS_COLORS
+};
+
+
+static inline uint64_t alignUp( uint64_t aOffset )
+{
+    return ( aOffset + MESH_FILE_ALIGN - 1 ) & ~( (uint64_t) MESH_FILE_ALIGN - 1 );
+}
+
+
+/**
+ * A read only view of a whole file, unmapped when it goes out of scope
+ */
+class MAPPED_MESH_FILE
+{
+public:
+    MAPPED_MESH_FILE( const wxString& aFileName ) :
+        m_data( NULL ),
+        m_size( 0 )
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileW( aFileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+        if( file == INVALID_HANDLE_VALUE )
+            return;
+
+        LARGE_INTEGER size;
+
+        if( GetFileSizeEx( file, &size ) && size.QuadPart > 0 )
+        {
+            // The view keeps the mapping alive after its handle is closed
+            HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+            if( mapping )
+            {
+                m_data = (const char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+                CloseHandle( mapping );
+            }
+
+            if( m_data )
+                m_size = (size_t) size.QuadPart;
+        }
+
+        CloseHandle( file );
+#else
+        int fd = open( aFileName.fn_str(), O_RDONLY );
+
+        if( fd < 0 )
+            return;
+
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            // The mapping stays valid after the file is closed
+            void* data = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if( data != MAP_FAILED )
+            {
+                madvise( data, (size_t) st.st_size, MADV_SEQUENTIAL );
+                m_data = (const char*) data;
+                m_size = (size_t) st.st_size;
+            }
+        }
+
+        close( fd );
+#endif
+    }
+
+    ~MAPPED_MESH_FILE()
+    {
+        if( m_data )
+        {
+#ifdef _WIN32
+            UnmapViewOfFile( m_data );
+#else
+            munmap( (void*) m_data, m_size );
+#endif
+        }
+    }
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+};
+
+
+/**
+ * Writes a block and pads it up to the next array boundary.
+ */
+static bool writeBlock( FILE* aFile, const void* aData, size_t aSize, uint64_t& aOffset )
+{
+    static const char zeros[MESH_FILE_ALIGN] = { 0 };
+
+    if( aSize && fwrite( aData, 1, aSize, aFile ) != aSize )
+        return false;
+
+    uint64_t end = aOffset + aSize;
+    size_t   pad = (size_t) ( alignUp( end ) - end );
+
+    if( pad && fwrite( zeros, 1, pad, aFile ) != pad )
+        return false;
+
+    aOffset = end + pad;
+    return true;
+}
+
+
+bool WriteMeshFile( const wxString& aFileName, const S3DMODEL& aModel )
+{
+    if( aModel.m_MeshesSize == 0 || NULL == aModel.m_Meshes )
+        return false;
+
+    wxString tmpName = wxFileName::CreateTempFileName( aFileName );
+
+    if( tmpName.empty() )
+        return false;
+
+#ifdef _WIN32
+    FILE* fp = _wfopen( tmpName.wc_str(), L"wb" );
+#else
+    FILE* fp = fopen( tmpName.ToUTF8(), "wb" );
+#endif
+
+    if( NULL == fp )
+    {
+        wxRemoveFile( tmpName );
+        return false;
+    }
+
+    MESH_FILE_HEADER header;
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.m_Magic, MESH_FILE_MAGIC, sizeof( header.m_Magic ) );
+    header.m_Version = MESH_FILE_VERSION;
+    header.m_MaterialSize = sizeof( SMATERIAL );
+    header.m_VectorSize = sizeof( SFVEC3F );
+    header.m_MaterialsCount = aModel.m_MaterialsSize;
+    header.m_MeshesCount = aModel.m_MeshesSize;
+
+    uint64_t offset = 0;
+    bool ok = writeBlock( fp, &header, sizeof( header ), offset )
+              && writeBlock( fp, aModel.m_Materials, aModel.m_MaterialsSize * sizeof( SMATERIAL ),
+                             offset );
+
+    for( unsigned int i = 0; ok && i < aModel.m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel.m_Meshes[i];
+        MESH_FILE_MESH desc;
+
+        desc.m_VertexSize = mesh.m_VertexSize;
+        desc.m_FaceIdxSize = mesh.m_FaceIdxSize;
+        desc.m_MaterialIdx = mesh.m_MaterialIdx;
+        desc.m_Arrays = ( mesh.m_Texcoords ? MESH_HAS_TEXCOORDS : 0 )
+                        | ( mesh.m_Color ? MESH_HAS_COLORS : 0 );
+
+        ok = ( mesh.m_Positions && mesh.m_Normals && mesh.m_FaceIdx )
+             && writeBlock( fp, &desc, sizeof( desc ), offset );
+    }
+
+    for( unsigned int i = 0; ok && i < aModel.m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel.m_Meshes[i];
+        size_t vec3Size = mesh.m_VertexSize * sizeof( SFVEC3F );
+
+        ok = writeBlock( fp, mesh.m_Positions, vec3Size, offset )
+             && writeBlock( fp, mesh.m_Normals, vec3Size, offset );
+
+        if( ok && mesh.m_Texcoords )
+            ok = writeBlock( fp, mesh.m_Texcoords, mesh.m_VertexSize * sizeof( SFVEC2F ),
+                             offset );
+
+        if( ok && mesh.m_Color )
+            ok = writeBlock( fp, mesh.m_Color, vec3Size, offset );
+
+        if( ok )
+            ok = writeBlock( fp, mesh.m_FaceIdx, mesh.m_FaceIdxSize * sizeof( unsigned int ),
+                             offset );
+    }
+
+    if( fclose( fp ) != 0 )
+        ok = false;
+
+    if( ok )
+        ok = wxRenameFile( tmpName, aFileName, true );
+
+    if( !ok )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] could not write mesh file '%s'", aFileName );
+        wxRemoveFile( tmpName );
+    }
+
+    return ok;
+}
+
+
+/**
+ * Copies an array of the mapped file into a new[] array, as the render data is freed
+ * with delete[].
+ */
+template <typename T>
+static T* readArray( const MAPPED_MESH_FILE& aFile, uint64_t& aOffset, size_t aCount )
+{
+    uint64_t size = (uint64_t) aCount * sizeof( T );
+
+    if( aOffset + size > aFile.Size() )
+        return NULL;
+
+    T* array = new T[aCount];
+    memcpy( array, aFile.Data() + aOffset, (size_t) size );
+    aOffset = alignUp( aOffset + size );
+
+    return array;
+}
+
+
+S3DMODEL* ReadMeshFile( const wxString& aFileName )
+{
+    MAPPED_MESH_FILE file( aFileName );
+
+    if( file.Size() < sizeof( MESH_FILE_HEADER ) )
+        return NULL;
+
+    MESH_FILE_HEADER header;
+    memcpy( &header, file.Data(), sizeof( header ) );
+
+    if( memcmp( header.m_Magic, MESH_FILE_MAGIC, sizeof( header.m_Magic ) )
+        || header.m_Version != MESH_FILE_VERSION
+        || header.m_MaterialSize != sizeof( SMATERIAL )
+        || header.m_VectorSize != sizeof( SFVEC3F )
+        || header.m_MeshesCount == 0 )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] mesh file of another version '%s'",
+                    aFileName );
+        return NULL;
+    }
+
+    uint64_t offset = alignUp( sizeof( header ) );
+    uint64_t descOffset = alignUp( offset + (uint64_t) header.m_MaterialsCount
+                                            * sizeof( SMATERIAL ) );
+
+    if( descOffset + (uint64_t) header.m_MeshesCount * sizeof( MESH_FILE_MESH ) > file.Size() )
+        return NULL;
+
+    S3DMODEL* model = S3D::New3DModel();
+    bool ok = true;
+
+    if( header.m_MaterialsCount )
+    {
+        model->m_Materials = readArray<SMATERIAL>( file, offset, header.m_MaterialsCount );
+        model->m_MaterialsSize = header.m_MaterialsCount;
+        ok = model->m_Materials != NULL;
+    }
+
+    const MESH_FILE_MESH* desc = (const MESH_FILE_MESH*) ( file.Data() + descOffset );
+    offset = descOffset + (uint64_t) header.m_MeshesCount * sizeof( MESH_FILE_MESH );
+
+    model->m_Meshes = new SMESH[header.m_MeshesCount];
+    model->m_MeshesSize = header.m_MeshesCount;
+
+    for( unsigned int i = 0; i < header.m_MeshesCount; ++i )
+        S3D::Init3DMesh( model->m_Meshes[i] );
+
+    for( unsigned int i = 0; ok && i < header.m_MeshesCount; ++i )
+    {
+        MESH_FILE_MESH md;
+        memcpy( &md, desc + i, sizeof( md ) );
+
+        SMESH& mesh = model->m_Meshes[i];
+
+        mesh.m_VertexSize = md.m_VertexSize;
+        mesh.m_FaceIdxSize = md.m_FaceIdxSize;
+        mesh.m_MaterialIdx = md.m_MaterialIdx;
+
+        mesh.m_Positions = readArray<SFVEC3F>( file, offset, md.m_VertexSize );
+        mesh.m_Normals = readArray<SFVEC3F>( file, offset, md.m_VertexSize );
+
+        if( md.m_Arrays & MESH_HAS_TEXCOORDS )
+            mesh.m_Texcoords = readArray<SFVEC2F>( file, offset, md.m_VertexSize );
+
+        if( md.m_Arrays & MESH_HAS_COLORS )
+            mesh.m_Color = readArray<SFVEC3F>( file, offset, md.m_VertexSize );
+
+        mesh.m_FaceIdx = readArray<unsigned int>( file, offset, md.m_FaceIdxSize );
+
+        ok = mesh.m_Positions && mesh.m_Normals && mesh.m_FaceIdx
+             && ( !( md.m_Arrays & MESH_HAS_TEXCOORDS ) || mesh.m_Texcoords )
+             && ( !( md.m_Arrays & MESH_HAS_COLORS ) || mesh.m_Color )
+             && md.m_MaterialIdx < std::max( header.m_MaterialsCount, 1u );
+
+        // The renderers index the vertex arrays without checking them
+        for( unsigned int j = 0; ok && j < md.m_FaceIdxSize; ++j )
+            ok = mesh.m_FaceIdx[j] < md.m_VertexSize;
+    }
+
+    if( !ok )
+    {
+        wxLogTrace( MASK_3D_CACHE, " * [3D model] corrupted mesh file '%s'", aFileName );
+        S3D::Destroy3DModel( &model );
+        return NULL;
+    }
+
+    return model;
+}
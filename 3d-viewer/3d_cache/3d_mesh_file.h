@@ -0,0 +1,65 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file 3d_mesh_file.h
+ * reads and writes the render data of a 3D model as a flat binary file
+ *
+ * The file is a header, the materials, one descriptor per mesh and then the arrays of
+ * the meshes, each one aligned on 16 bytes, exactly as they are in memory.  It is read
+ * through a memory mapping, so loading a cached model is a few copies instead of parsing
+ * its scene graph and converting it again.
+ *
+ * The layout follows the structures of this build: it is a local cache, not an exchange
+ * format, and a file written by a build with another layout is rejected.
+ */
+
+#ifndef MESH_FILE_3D_H
+#define MESH_FILE_3D_H
+
+#include <wx/string.h>
+#include "plugins/3dapi/c3dmodel.h"
+
+
+/**
+ * Function WriteMeshFile
+ * writes the render data of a model; the file is written under a temporary name and
+ * renamed, so a file being read by another thread is never seen half written.
+ *
+ * @param aFileName is the full path of the file
+ * @param aModel is the model to write
+ * @return true on success
+ */
+bool WriteMeshFile( const wxString& aFileName, const S3DMODEL& aModel );
+
+/**
+ * Function ReadMeshFile
+ * reads the render data written by WriteMeshFile()
+ *
+ * @param aFileName is the full path of the file
+ * @return a new model to free with S3D::Destroy3DModel(), or NULL if the file is missing,
+ *         truncated or was written with another layout
+ */
+S3DMODEL* ReadMeshFile( const wxString& aFileName );
+
+#endif  // MESH_FILE_3D_H
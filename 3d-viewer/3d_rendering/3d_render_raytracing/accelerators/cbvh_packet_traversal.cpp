@@ -45,6 +45,13 @@ struct StackNode
 };
 
 
+struct StackNodeSimd
+{
+    int             cell;
+    uint64_t        rays;   // Mask of the rays that hit the parent node
+};
+
+
 static inline unsigned int getFirstHit( const RAYPACKET &aRayPacket,
                                         const CBBOX &aBBox,
                                         unsigned int ia,
@@ -103,6 +110,11 @@ bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
     if( (&m_nodes[0]) == NULL )
         return false;
 
+    const RAYTRACING_SIMD simd = RaytracingSimdGet();
+
+    if( simd != RAYTRACING_SIMD_NONE )
+        return intersectPacketSimd( aRayPacket, aHitInfoPacket, simd );
+
     bool anyHitted = false;
     int todoOffset = 0, nodeNum = 0;
     StackNode todo[MAX_TODOS];
@@ -167,6 +179,78 @@ bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
     return anyHitted;
 
 }// Ranged Traversal
+
+
+// The same traversal, but every node tests all the rays alive in its parent with the
+// vector kernels, and keeps the mask of the rays that hit it instead of a range.
+bool CBVH_PBRT::intersectPacketSimd( const RAYPACKET &aRayPacket,
+                                     HITINFO_PACKET *aHitInfoPacket,
+                                     RAYTRACING_SIMD aSimd ) const
+{
+    RAYPACKET_SOA packet( aRayPacket, aHitInfoPacket );
+
+    bool anyHitted = false;
+    int todoOffset = 0, nodeNum = 0;
+    StackNodeSimd todo[MAX_TODOS];
+
+    uint64_t rays = ~(uint64_t) 0;
+
+    while( true )
+    {
+        const LinearBVHNode *curCell = &m_nodes[nodeNum];
+
+        if( aRayPacket.m_Frustum.Intersect( curCell->bounds ) )
+            rays &= RAYPACKET_IntersectBBox( aSimd, packet, curCell->bounds,
+                                             RAYPACKET_FirstRay( rays ) );
+        else
+            rays = 0;
+
+        if( rays )
+        {
+            if( curCell->nPrimitives == 0 )
+            {
+                StackNodeSimd &node = todo[todoOffset++];
+                node.cell = curCell->secondChildOffset;
+                node.rays = rays;
+                nodeNum = nodeNum + 1;
+                continue;
+            }
+            else
+            {
+                for( int j = 0; j < curCell->nPrimitives; ++j )
+                {
+                    const COBJECT *obj = m_primitives[curCell->primitivesOffset + j];
+
+                    if( aRayPacket.m_Frustum.Intersect( obj->GetBBox() ) )
+                    {
+                        uint64_t hits = obj->IntersectPacket( aRayPacket, packet, rays,
+                                                              aHitInfoPacket, aSimd );
+
+                        for( ; hits; hits &= hits - 1 )
+                        {
+                            const unsigned int i = RAYPACKET_FirstRay( hits );
+
+                            anyHitted = true;
+                            aHitInfoPacket[i].m_hitresult = true;
+                            aHitInfoPacket[i].m_HitInfo.m_acc_node_info = nodeNum;
+                            packet.m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
+                        }
+                    }
+                }
+            }
+        }
+
+        if( todoOffset == 0 )
+            break;
+
+        const StackNodeSimd &node = todo[--todoOffset];
+
+        nodeNum = node.cell;
+        rays = node.rays;
+    }
+
+    return anyHitted;
+}
 #endif
 
 
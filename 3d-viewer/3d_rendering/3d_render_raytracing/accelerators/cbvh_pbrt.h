@@ -125,6 +125,13 @@ public:
 
 private:
 
+    /**
+     * Packet traversal testing all the rays of the packet against a node at once
+     */
+    bool intersectPacketSimd( const RAYPACKET &aRayPacket,
+                              HITINFO_PACKET *aHitInfoPacket,
+                              RAYTRACING_SIMD aSimd ) const;
+
     BVHBuildNode *recursiveBuild( std::vector<BVHPrimitiveInfo> &primitiveInfo,
                                   int start,
                                   int end,
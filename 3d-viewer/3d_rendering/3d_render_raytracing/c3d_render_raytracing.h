@@ -56,6 +56,16 @@ typedef enum
     RT_RENDER_STATE_MAX
 }RT_RENDER_STATE;
 
+
+/// Durations of the phases of the last reload and the last render, in microseconds
+struct RT_RENDER_TIMINGS
+{
+    unsigned long int m_sceneBuild;     ///< board to 3D objects, with the 3D models
+    unsigned long int m_bvhBuild;       ///< accelerator construction
+    unsigned long int m_tracing;
+    unsigned long int m_postShading;    ///< ambient occlusion, blur and final color
+};
+
 class C3D_RENDER_RAYTRACING : public C3D_RENDER_BASE
 {
 public:
@@ -69,6 +79,19 @@ public:
 
     int GetWaitForEditingTimeOut() override;
 
+    /**
+     * @brief RenderOffscreen - renders the whole board without OpenGL, tracing and post
+     * processing to the end, for the batch tools
+     * @param aSize: the size of the image, the camera must have the same one
+     * @param aPixels: receives the RGBA pixels, bottom row first as for glDrawPixels
+     * @param aStatusTextReporter: a pointer to the status progress reporter
+     * @return the size of the image, rounded to whole ray packets
+     */
+    wxSize RenderOffscreen( const wxSize &aSize, std::vector<GLubyte> &aPixels,
+                            REPORTER *aStatusTextReporter = NULL );
+
+    const RT_RENDER_TIMINGS &GetTimings() const { return m_timings; }
+
 private:
     bool initializeOpenGL();
     void initializeNewWindowSize();
@@ -117,6 +140,9 @@ private:
 
     bool m_isPreview;
 
+    /// Renders to the end in one call, without giving back control to show the progress
+    bool m_isOffscreen;
+
     SFVEC3F shadeHit( const SFVEC3F &aBgColor,
                       const RAY &aRay,
                       HITINFO &aHitInfo,
@@ -133,6 +159,8 @@ private:
     /// Save the number of blocks progress of the render
     size_t m_nrBlocksRenderProgress;
 
+    RT_RENDER_TIMINGS m_timings;
+
     CPOSTSHADER_SSAO m_postshader_ssao;
 
     CLIGHTCONTAINER m_lights;
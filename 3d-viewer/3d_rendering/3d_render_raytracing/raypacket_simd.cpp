@@ -0,0 +1,469 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  raypacket_simd.cpp
+ * @brief SSE and AVX kernels testing a whole ray packet against a box or a triangle
+ *
+ * The kernels are compiled for their instruction set function by function, so the rest of
+ * the build keeps its target, and the one to use is chosen from the CPU at run time.
+ */
+
+#include "raypacket_simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define RAYTRACING_SIMD_X86
+#include <immintrin.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#define RAYTRACING_TARGET_SSE2
+#define RAYTRACING_TARGET_AVX
+#else
+#define RAYTRACING_TARGET_SSE2 __attribute__( ( target( "sse2" ) ) )
+#define RAYTRACING_TARGET_AVX __attribute__( ( target( "avx" ) ) )
+#endif
+#endif
+
+
+/// Widens the far distance of the slab test to cover the rounding of its computation
+/// ("Robust BVH Ray Traversal", Thiago Ize, JCGT 2013)
+static const float BBOX_FAR_SCALE = 1.0f + 2.0f * 3.0f * ( FLT_EPSILON * 0.5f );
+
+/// Margin of the barycentric coordinates of the triangle prefilter
+static const float TRIANGLE_EPSILON = 1.0e-5f;
+
+
+static RAYTRACING_SIMD detectSimd()
+{
+#if defined( RAYTRACING_SIMD_X86 ) && defined( _MSC_VER ) && !defined( __clang__ )
+    int info[4];
+
+    __cpuid( info, 1 );
+
+    const bool sse2 = ( info[3] & ( 1 << 26 ) ) != 0;
+    const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+    const bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+
+    // The OS must also save the AVX registers on a context switch
+    if( osxsave && avx && ( _xgetbv( 0 ) & 0x6 ) == 0x6 )
+        return RAYTRACING_SIMD_AVX;
+
+    return sse2 ? RAYTRACING_SIMD_SSE2 : RAYTRACING_SIMD_NONE;
+#elif defined( RAYTRACING_SIMD_X86 )
+    __builtin_cpu_init();
+
+    if( __builtin_cpu_supports( "avx" ) )
+        return RAYTRACING_SIMD_AVX;
+
+    return __builtin_cpu_supports( "sse2" ) ? RAYTRACING_SIMD_SSE2 : RAYTRACING_SIMD_NONE;
+#else
+    return RAYTRACING_SIMD_NONE;
+#endif
+}
+
+
+static std::atomic<int> s_simd( -1 );
+
+
+RAYTRACING_SIMD RaytracingSimdSupported()
+{
+    static const RAYTRACING_SIMD supported = detectSimd();
+
+    return supported;
+}
+
+
+RAYTRACING_SIMD RaytracingSimdGet()
+{
+    int simd = s_simd.load( std::memory_order_relaxed );
+
+    if( simd < 0 )
+    {
+        simd = RaytracingSimdSupported();
+        s_simd.store( simd, std::memory_order_relaxed );
+    }
+
+    return (RAYTRACING_SIMD) simd;
+}
+
+
+void RaytracingSimdSet( RAYTRACING_SIMD aSimd )
+{
+    s_simd.store( std::min( aSimd, RaytracingSimdSupported() ), std::memory_order_relaxed );
+}
+
+
+const char* RaytracingSimdName( RAYTRACING_SIMD aSimd )
+{
+    switch( aSimd )
+    {
+    case RAYTRACING_SIMD_SSE2: return "SSE2";
+    case RAYTRACING_SIMD_AVX:  return "AVX";
+    default:                   return "scalar";
+    }
+}
+
+
+RAYPACKET_SOA::RAYPACKET_SOA( const RAYPACKET &aRayPacket,
+                              const HITINFO_PACKET *aHitInfoPacket )
+{
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        const RAY &ray = aRayPacket.m_ray[i];
+
+        for( unsigned int axis = 0; axis < 3; ++axis )
+        {
+            m_Origin[axis][i] = ray.m_Origin[axis];
+            m_Dir[axis][i] = ray.m_Dir[axis];
+
+            // A ray parallel to a slab would give inf * 0 on its planes
+            m_InvDir[axis][i] = std::max( -FLT_MAX, std::min( ray.m_InvDir[axis], FLT_MAX ) );
+        }
+
+        m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
+    }
+}
+
+
+// The scalar kernels, for the CPUs without the instructions below.  They do the same
+// computation as the vector ones, lane by lane.
+
+static uint64_t intersectBBoxScalar( const RAYPACKET_SOA &aPacket, const CBBOX &aBBox,
+                                     unsigned int aFirst )
+{
+    uint64_t mask = 0;
+
+    for( unsigned int i = aFirst; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        float tNear = -FLT_MAX;
+        float tFar = FLT_MAX;
+
+        for( unsigned int axis = 0; axis < 3; ++axis )
+        {
+            const float t0 = ( aBBox.Min()[axis] - aPacket.m_Origin[axis][i] )
+                             * aPacket.m_InvDir[axis][i];
+            const float t1 = ( aBBox.Max()[axis] - aPacket.m_Origin[axis][i] )
+                             * aPacket.m_InvDir[axis][i];
+
+            tNear = std::max( tNear, std::min( t0, t1 ) );
+            tFar = std::min( tFar, std::max( t0, t1 ) );
+        }
+
+        tFar *= BBOX_FAR_SCALE;
+
+        if( tNear <= tFar && tFar >= 0.0f && tNear < aPacket.m_tHit[i] )
+            mask |= (uint64_t) 1 << i;
+    }
+
+    return mask;
+}
+
+
+static uint64_t intersectTriangleScalar( const RAYPACKET_SOA &aPacket,
+                                         const RAYPACKET_TRIANGLE &aTri, uint64_t aRays )
+{
+    uint64_t mask = 0;
+
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    {
+        if( !( aRays & ( (uint64_t) 1 << i ) ) )
+            continue;
+
+        const float Dk = aPacket.m_Dir[aTri.m_k][i];
+        const float Du = aPacket.m_Dir[aTri.m_ku][i];
+        const float Dv = aPacket.m_Dir[aTri.m_kv][i];
+        const float Ok = aPacket.m_Origin[aTri.m_k][i];
+        const float Ou = aPacket.m_Origin[aTri.m_ku][i];
+        const float Ov = aPacket.m_Origin[aTri.m_kv][i];
+
+        const float lnd = 1.0f / ( Dk + aTri.m_nu * Du + aTri.m_nv * Dv );
+        const float t = ( aTri.m_nd - Ok - aTri.m_nu * Ou - aTri.m_nv * Ov ) * lnd;
+
+        if( !( t > 0.0f && t <= aPacket.m_tHit[i] * BBOX_FAR_SCALE ) )
+            continue;
+
+        const float hu = Ou + t * Du - aTri.m_Au;
+        const float hv = Ov + t * Dv - aTri.m_Av;
+        const float beta = hv * aTri.m_bnu + hu * aTri.m_bnv;
+        const float gamma = hu * aTri.m_cnu + hv * aTri.m_cnv;
+
+        if( beta >= -TRIANGLE_EPSILON && gamma >= -TRIANGLE_EPSILON
+                && beta + gamma <= 1.0f + TRIANGLE_EPSILON )
+            mask |= (uint64_t) 1 << i;
+    }
+
+    return mask;
+}
+
+
+#ifdef RAYTRACING_SIMD_X86
+
+RAYTRACING_TARGET_SSE2
+static uint64_t intersectBBoxSSE2( const RAYPACKET_SOA &aPacket, const CBBOX &aBBox,
+                                   unsigned int aFirst )
+{
+    __m128 bmin[3], bmax[3];
+
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        bmin[axis] = _mm_set1_ps( aBBox.Min()[axis] );
+        bmax[axis] = _mm_set1_ps( aBBox.Max()[axis] );
+    }
+
+    const __m128 farScale = _mm_set1_ps( BBOX_FAR_SCALE );
+    const __m128 zero = _mm_setzero_ps();
+    uint64_t mask = 0;
+
+    for( unsigned int i = aFirst & ~3u; i < RAYPACKET_RAYS_PER_PACKET; i += 4 )
+    {
+        __m128 tNear = _mm_set1_ps( -FLT_MAX );
+        __m128 tFar = _mm_set1_ps( FLT_MAX );
+
+        for( unsigned int axis = 0; axis < 3; ++axis )
+        {
+            const __m128 org = _mm_loadu_ps( &aPacket.m_Origin[axis][i] );
+            const __m128 inv = _mm_loadu_ps( &aPacket.m_InvDir[axis][i] );
+            const __m128 t0 = _mm_mul_ps( _mm_sub_ps( bmin[axis], org ), inv );
+            const __m128 t1 = _mm_mul_ps( _mm_sub_ps( bmax[axis], org ), inv );
+
+            tNear = _mm_max_ps( tNear, _mm_min_ps( t0, t1 ) );
+            tFar = _mm_min_ps( tFar, _mm_max_ps( t0, t1 ) );
+        }
+
+        tFar = _mm_mul_ps( tFar, farScale );
+
+        const __m128 hit = _mm_and_ps( _mm_and_ps( _mm_cmple_ps( tNear, tFar ),
+                                                   _mm_cmpge_ps( tFar, zero ) ),
+                                       _mm_cmplt_ps( tNear,
+                                                     _mm_loadu_ps( &aPacket.m_tHit[i] ) ) );
+
+        mask |= (uint64_t) _mm_movemask_ps( hit ) << i;
+    }
+
+    return mask & ( ~(uint64_t) 0 << aFirst );
+}
+
+
+RAYTRACING_TARGET_AVX
+static uint64_t intersectBBoxAVX( const RAYPACKET_SOA &aPacket, const CBBOX &aBBox,
+                                  unsigned int aFirst )
+{
+    __m256 bmin[3], bmax[3];
+
+    for( unsigned int axis = 0; axis < 3; ++axis )
+    {
+        bmin[axis] = _mm256_set1_ps( aBBox.Min()[axis] );
+        bmax[axis] = _mm256_set1_ps( aBBox.Max()[axis] );
+    }
+
+    const __m256 farScale = _mm256_set1_ps( BBOX_FAR_SCALE );
+    const __m256 zero = _mm256_setzero_ps();
+    uint64_t mask = 0;
+
+    for( unsigned int i = aFirst & ~7u; i < RAYPACKET_RAYS_PER_PACKET; i += 8 )
+    {
+        __m256 tNear = _mm256_set1_ps( -FLT_MAX );
+        __m256 tFar = _mm256_set1_ps( FLT_MAX );
+
+        for( unsigned int axis = 0; axis < 3; ++axis )
+        {
+            const __m256 org = _mm256_loadu_ps( &aPacket.m_Origin[axis][i] );
+            const __m256 inv = _mm256_loadu_ps( &aPacket.m_InvDir[axis][i] );
+            const __m256 t0 = _mm256_mul_ps( _mm256_sub_ps( bmin[axis], org ), inv );
+            const __m256 t1 = _mm256_mul_ps( _mm256_sub_ps( bmax[axis], org ), inv );
+
+            tNear = _mm256_max_ps( tNear, _mm256_min_ps( t0, t1 ) );
+            tFar = _mm256_min_ps( tFar, _mm256_max_ps( t0, t1 ) );
+        }
+
+        tFar = _mm256_mul_ps( tFar, farScale );
+
+        const __m256 hit = _mm256_and_ps(
+                _mm256_and_ps( _mm256_cmp_ps( tNear, tFar, _CMP_LE_OQ ),
+                               _mm256_cmp_ps( tFar, zero, _CMP_GE_OQ ) ),
+                _mm256_cmp_ps( tNear, _mm256_loadu_ps( &aPacket.m_tHit[i] ), _CMP_LT_OQ ) );
+
+        mask |= (uint64_t) _mm256_movemask_ps( hit ) << i;
+    }
+
+    return mask & ( ~(uint64_t) 0 << aFirst );
+}
+
+
+RAYTRACING_TARGET_SSE2
+static uint64_t intersectTriangleSSE2( const RAYPACKET_SOA &aPacket,
+                                       const RAYPACKET_TRIANGLE &aTri, uint64_t aRays )
+{
+    const __m128 nu = _mm_set1_ps( aTri.m_nu );
+    const __m128 nv = _mm_set1_ps( aTri.m_nv );
+    const __m128 nd = _mm_set1_ps( aTri.m_nd );
+    const __m128 Au = _mm_set1_ps( aTri.m_Au );
+    const __m128 Av = _mm_set1_ps( aTri.m_Av );
+    const __m128 bnu = _mm_set1_ps( aTri.m_bnu );
+    const __m128 bnv = _mm_set1_ps( aTri.m_bnv );
+    const __m128 cnu = _mm_set1_ps( aTri.m_cnu );
+    const __m128 cnv = _mm_set1_ps( aTri.m_cnv );
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 farScale = _mm_set1_ps( BBOX_FAR_SCALE );
+    const __m128 minBary = _mm_set1_ps( -TRIANGLE_EPSILON );
+    const __m128 maxBary = _mm_set1_ps( 1.0f + TRIANGLE_EPSILON );
+    uint64_t mask = 0;
+
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; i += 4 )
+    {
+        if( !( ( aRays >> i ) & 0xF ) )
+            continue;
+
+        const __m128 Dk = _mm_loadu_ps( &aPacket.m_Dir[aTri.m_k][i] );
+        const __m128 Du = _mm_loadu_ps( &aPacket.m_Dir[aTri.m_ku][i] );
+        const __m128 Dv = _mm_loadu_ps( &aPacket.m_Dir[aTri.m_kv][i] );
+        const __m128 Ok = _mm_loadu_ps( &aPacket.m_Origin[aTri.m_k][i] );
+        const __m128 Ou = _mm_loadu_ps( &aPacket.m_Origin[aTri.m_ku][i] );
+        const __m128 Ov = _mm_loadu_ps( &aPacket.m_Origin[aTri.m_kv][i] );
+
+        const __m128 lnd = _mm_div_ps( one, _mm_add_ps( _mm_add_ps( Dk, _mm_mul_ps( nu, Du ) ),
+                                                        _mm_mul_ps( nv, Dv ) ) );
+        const __m128 t = _mm_mul_ps( _mm_sub_ps( _mm_sub_ps( _mm_sub_ps( nd, Ok ),
+                                                             _mm_mul_ps( nu, Ou ) ),
+                                                 _mm_mul_ps( nv, Ov ) ),
+                                     lnd );
+
+        const __m128 hu = _mm_sub_ps( _mm_add_ps( Ou, _mm_mul_ps( t, Du ) ), Au );
+        const __m128 hv = _mm_sub_ps( _mm_add_ps( Ov, _mm_mul_ps( t, Dv ) ), Av );
+        const __m128 beta = _mm_add_ps( _mm_mul_ps( hv, bnu ), _mm_mul_ps( hu, bnv ) );
+        const __m128 gamma = _mm_add_ps( _mm_mul_ps( hu, cnu ), _mm_mul_ps( hv, cnv ) );
+
+        const __m128 tHit = _mm_mul_ps( _mm_loadu_ps( &aPacket.m_tHit[i] ), farScale );
+
+        __m128 hit = _mm_and_ps( _mm_cmpgt_ps( t, zero ), _mm_cmple_ps( t, tHit ) );
+        hit = _mm_and_ps( hit, _mm_cmpge_ps( beta, minBary ) );
+        hit = _mm_and_ps( hit, _mm_cmpge_ps( gamma, minBary ) );
+        hit = _mm_and_ps( hit, _mm_cmple_ps( _mm_add_ps( beta, gamma ), maxBary ) );
+
+        mask |= (uint64_t) _mm_movemask_ps( hit ) << i;
+    }
+
+    return mask & aRays;
+}
+
+
+RAYTRACING_TARGET_AVX
+static uint64_t intersectTriangleAVX( const RAYPACKET_SOA &aPacket,
+                                      const RAYPACKET_TRIANGLE &aTri, uint64_t aRays )
+{
+    const __m256 nu = _mm256_set1_ps( aTri.m_nu );
+    const __m256 nv = _mm256_set1_ps( aTri.m_nv );
+    const __m256 nd = _mm256_set1_ps( aTri.m_nd );
+    const __m256 Au = _mm256_set1_ps( aTri.m_Au );
+    const __m256 Av = _mm256_set1_ps( aTri.m_Av );
+    const __m256 bnu = _mm256_set1_ps( aTri.m_bnu );
+    const __m256 bnv = _mm256_set1_ps( aTri.m_bnv );
+    const __m256 cnu = _mm256_set1_ps( aTri.m_cnu );
+    const __m256 cnv = _mm256_set1_ps( aTri.m_cnv );
+    const __m256 one = _mm256_set1_ps( 1.0f );
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 farScale = _mm256_set1_ps( BBOX_FAR_SCALE );
+    const __m256 minBary = _mm256_set1_ps( -TRIANGLE_EPSILON );
+    const __m256 maxBary = _mm256_set1_ps( 1.0f + TRIANGLE_EPSILON );
+    uint64_t mask = 0;
+
+    for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; i += 8 )
+    {
+        if( !( ( aRays >> i ) & 0xFF ) )
+            continue;
+
+        const __m256 Dk = _mm256_loadu_ps( &aPacket.m_Dir[aTri.m_k][i] );
+        const __m256 Du = _mm256_loadu_ps( &aPacket.m_Dir[aTri.m_ku][i] );
+        const __m256 Dv = _mm256_loadu_ps( &aPacket.m_Dir[aTri.m_kv][i] );
+        const __m256 Ok = _mm256_loadu_ps( &aPacket.m_Origin[aTri.m_k][i] );
+        const __m256 Ou = _mm256_loadu_ps( &aPacket.m_Origin[aTri.m_ku][i] );
+        const __m256 Ov = _mm256_loadu_ps( &aPacket.m_Origin[aTri.m_kv][i] );
+
+        const __m256 lnd = _mm256_div_ps( one,
+                                          _mm256_add_ps( _mm256_add_ps( Dk,
+                                                                        _mm256_mul_ps( nu, Du ) ),
+                                                         _mm256_mul_ps( nv, Dv ) ) );
+        const __m256 t = _mm256_mul_ps(
+                _mm256_sub_ps( _mm256_sub_ps( _mm256_sub_ps( nd, Ok ), _mm256_mul_ps( nu, Ou ) ),
+                               _mm256_mul_ps( nv, Ov ) ),
+                lnd );
+
+        const __m256 hu = _mm256_sub_ps( _mm256_add_ps( Ou, _mm256_mul_ps( t, Du ) ), Au );
+        const __m256 hv = _mm256_sub_ps( _mm256_add_ps( Ov, _mm256_mul_ps( t, Dv ) ), Av );
+        const __m256 beta = _mm256_add_ps( _mm256_mul_ps( hv, bnu ), _mm256_mul_ps( hu, bnv ) );
+        const __m256 gamma = _mm256_add_ps( _mm256_mul_ps( hu, cnu ), _mm256_mul_ps( hv, cnv ) );
+
+        const __m256 tHit = _mm256_mul_ps( _mm256_loadu_ps( &aPacket.m_tHit[i] ), farScale );
+
+        __m256 hit = _mm256_and_ps( _mm256_cmp_ps( t, zero, _CMP_GT_OQ ),
+                                    _mm256_cmp_ps( t, tHit, _CMP_LE_OQ ) );
+        hit = _mm256_and_ps( hit, _mm256_cmp_ps( beta, minBary, _CMP_GE_OQ ) );
+        hit = _mm256_and_ps( hit, _mm256_cmp_ps( gamma, minBary, _CMP_GE_OQ ) );
+        hit = _mm256_and_ps( hit, _mm256_cmp_ps( _mm256_add_ps( beta, gamma ), maxBary,
+                                                 _CMP_LE_OQ ) );
+
+        mask |= (uint64_t) _mm256_movemask_ps( hit ) << i;
+    }
+
+    return mask & aRays;
+}
+
+#endif // RAYTRACING_SIMD_X86
+
+
+uint64_t RAYPACKET_IntersectBBox( RAYTRACING_SIMD aSimd, const RAYPACKET_SOA &aPacket,
+                                  const CBBOX &aBBox, unsigned int aFirst )
+{
+#ifdef RAYTRACING_SIMD_X86
+    switch( aSimd )
+    {
+    case RAYTRACING_SIMD_AVX:  return intersectBBoxAVX( aPacket, aBBox, aFirst );
+    case RAYTRACING_SIMD_SSE2: return intersectBBoxSSE2( aPacket, aBBox, aFirst );
+    default:                   break;
+    }
+#endif
+
+    return intersectBBoxScalar( aPacket, aBBox, aFirst );
+}
+
+
+uint64_t RAYPACKET_IntersectTriangle( RAYTRACING_SIMD aSimd, const RAYPACKET_SOA &aPacket,
+                                      const RAYPACKET_TRIANGLE &aTriangle, uint64_t aRays )
+{
+#ifdef RAYTRACING_SIMD_X86
+    switch( aSimd )
+    {
+    case RAYTRACING_SIMD_AVX:  return intersectTriangleAVX( aPacket, aTriangle, aRays );
+    case RAYTRACING_SIMD_SSE2: return intersectTriangleSSE2( aPacket, aTriangle, aRays );
+    default:                   break;
+    }
+#endif
+
+    return intersectTriangleScalar( aPacket, aTriangle, aRays );
+}
@@ -0,0 +1,135 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  raypacket_simd.h
+ * @brief SSE and AVX kernels testing a whole ray packet against a box or a triangle
+ */
+
+#ifndef _RAYPACKET_SIMD_H_
+#define _RAYPACKET_SIMD_H_
+
+#include <stdint.h>
+
+#include "hitinfo.h"
+#include "shapes3D/cbbox.h"
+
+
+/// Vector instructions used by the packet kernels
+enum RAYTRACING_SIMD
+{
+    RAYTRACING_SIMD_NONE,   ///< the scalar per ray tests
+    RAYTRACING_SIMD_SSE2,   ///< 4 rays at once
+    RAYTRACING_SIMD_AVX     ///< 8 rays at once
+};
+
+
+/**
+ * @return the best instruction set supported by this CPU (detected once)
+ */
+RAYTRACING_SIMD RaytracingSimdSupported();
+
+/**
+ * @return the instruction set the packet traversal uses
+ */
+RAYTRACING_SIMD RaytracingSimdGet();
+
+/**
+ * Selects the instruction set of the packet traversal, to compare them.
+ * @param aSimd is lowered to the best one the CPU supports
+ */
+void RaytracingSimdSet( RAYTRACING_SIMD aSimd );
+
+const char* RaytracingSimdName( RAYTRACING_SIMD aSimd );
+
+
+/**
+ * The rays of a RAYPACKET stored as structure of arrays, each component of each ray in its
+ * own lane, with the distance to the nearest hit found so far.
+ */
+struct RAYPACKET_SOA
+{
+    alignas( 32 ) float m_Origin[3][RAYPACKET_RAYS_PER_PACKET];
+    alignas( 32 ) float m_Dir[3][RAYPACKET_RAYS_PER_PACKET];
+
+    /// 1 / m_Dir, clamped to a finite value so no slab test makes a NaN
+    alignas( 32 ) float m_InvDir[3][RAYPACKET_RAYS_PER_PACKET];
+
+    alignas( 32 ) float m_tHit[RAYPACKET_RAYS_PER_PACKET];
+
+    RAYPACKET_SOA( const RAYPACKET &aRayPacket, const HITINFO_PACKET *aHitInfoPacket );
+};
+
+
+/**
+ * The constants of the projection test of a CTRIANGLE (see CTRIANGLE::Intersect)
+ */
+struct RAYPACKET_TRIANGLE
+{
+    unsigned int m_k, m_ku, m_kv;       ///< projection axis and the two others
+    float m_nu, m_nv, m_nd;
+    float m_Au, m_Av;                   ///< first vertex, projected
+    float m_bnu, m_bnv;
+    float m_cnu, m_cnv;
+};
+
+
+/**
+ * @return the index of the first ray of a non empty mask of rays
+ */
+inline unsigned int RAYPACKET_FirstRay( uint64_t aRays )
+{
+#if defined( __GNUC__ )
+    return __builtin_ctzll( aRays );
+#else
+    unsigned int i = 0;
+
+    while( !( aRays & 1 ) )
+    {
+        aRays >>= 1;
+        ++i;
+    }
+
+    return i;
+#endif
+}
+
+
+/**
+ * Slab test of the rays aFirst to the end of the packet against a box.  The far distance
+ * is slightly widened, so the rays grazing the box are kept.
+ * @return the mask of the rays that hit the box nearer than their current hit
+ */
+uint64_t RAYPACKET_IntersectBBox( RAYTRACING_SIMD aSimd, const RAYPACKET_SOA &aPacket,
+                                  const CBBOX &aBBox, unsigned int aFirst );
+
+/**
+ * Projection test of the rays of aRays against a triangle.  The test is slightly
+ * conservative: the scalar test of the candidates decides, so the hits are exactly the
+ * ones of the scalar code.
+ * @return the mask of the rays that may hit the triangle nearer than their current hit
+ */
+uint64_t RAYPACKET_IntersectTriangle( RAYTRACING_SIMD aSimd, const RAYPACKET_SOA &aPacket,
+                                      const RAYPACKET_TRIANGLE &aTriangle, uint64_t aRays );
+
+#endif // _RAYPACKET_SIMD_H_
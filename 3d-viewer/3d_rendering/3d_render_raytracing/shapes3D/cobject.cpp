@@ -43,6 +43,29 @@ COBJECT::COBJECT( OBJECT3D_TYPE aObjType )
 }
 
 
+uint64_t COBJECT::IntersectPacket( const RAYPACKET &aRayPacket,
+                                   const RAYPACKET_SOA &aPacket,
+                                   uint64_t aRays,
+                                   HITINFO_PACKET *aHitInfoPacket,
+                                   RAYTRACING_SIMD aSimd ) const
+{
+    (void)aPacket; // unused
+    (void)aSimd; // unused
+
+    uint64_t hits = 0;
+
+    for( ; aRays; aRays &= aRays - 1 )
+    {
+        const unsigned int i = RAYPACKET_FirstRay( aRays );
+
+        if( Intersect( aRayPacket.m_ray[i], aHitInfoPacket[i].m_HitInfo ) )
+            hits |= (uint64_t) 1 << i;
+    }
+
+    return hits;
+}
+
+
 static const char *OBJECT3D_STR[OBJ3D_MAX] =
 {
     "OBJ3D_CYLINDER",
@@ -33,6 +33,7 @@
 #include "cbbox.h"
 #include "../hitinfo.h"
 #include "../cmaterial.h"
+#include "../raypacket_simd.h"
 
 
 enum OBJECT3D_TYPE
@@ -91,6 +92,22 @@ public:
      */
     virtual bool IntersectP( const RAY &aRay, float aMaxDistance ) const = 0;
 
+    /** Function IntersectPacket
+     * @brief IntersectPacket - intersects some rays of a packet, the default calls
+     * Intersect() for each of them
+     * @param aRayPacket - the packet
+     * @param aPacket - the same rays, for the vector kernels
+     * @param aRays - mask of the rays to test
+     * @param aHitInfoPacket - hit of each ray, updated on a nearer hit
+     * @param aSimd - instruction set of the vector kernels
+     * @return the mask of the rays that intersect the object
+     */
+    virtual uint64_t IntersectPacket( const RAYPACKET &aRayPacket,
+                                      const RAYPACKET_SOA &aPacket,
+                                      uint64_t aRays,
+                                      HITINFO_PACKET *aHitInfoPacket,
+                                      RAYTRACING_SIMD aSimd ) const;
+
     const CBBOX &GetBBox() const { return m_bbox; }
 
     const SFVEC3F &GetCentroid() const { return m_centroid; }
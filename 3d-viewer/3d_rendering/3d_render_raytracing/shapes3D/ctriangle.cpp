@@ -313,6 +313,37 @@ bool CTRIANGLE::IntersectP( const RAY &aRay,
 }
 
 
+uint64_t CTRIANGLE::IntersectPacket( const RAYPACKET &aRayPacket,
+                                     const RAYPACKET_SOA &aPacket,
+                                     uint64_t aRays,
+                                     HITINFO_PACKET *aHitInfoPacket,
+                                     RAYTRACING_SIMD aSimd ) const
+{
+    if( aSimd == RAYTRACING_SIMD_NONE )
+        return COBJECT::IntersectPacket( aRayPacket, aPacket, aRays, aHitInfoPacket, aSimd );
+
+    RAYPACKET_TRIANGLE triangle;
+
+    triangle.m_k  = m_k;
+    triangle.m_ku = s_modulo[m_k + 1];
+    triangle.m_kv = s_modulo[m_k + 2];
+    triangle.m_nu = m_nu;
+    triangle.m_nv = m_nv;
+    triangle.m_nd = m_nd;
+    triangle.m_Au = m_vertex[0][triangle.m_ku];
+    triangle.m_Av = m_vertex[0][triangle.m_kv];
+    triangle.m_bnu = m_bnu;
+    triangle.m_bnv = m_bnv;
+    triangle.m_cnu = m_cnu;
+    triangle.m_cnv = m_cnv;
+
+    // Only the few rays that pass the vector test are shaded by the scalar one
+    const uint64_t candidates = RAYPACKET_IntersectTriangle( aSimd, aPacket, triangle, aRays );
+
+    return COBJECT::IntersectPacket( aRayPacket, aPacket, candidates, aHitInfoPacket, aSimd );
+}
+
+
 bool CTRIANGLE::Intersects( const CBBOX &aBBox ) const
 {
     //!TODO: improove
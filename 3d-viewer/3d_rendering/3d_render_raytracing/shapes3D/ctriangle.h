@@ -66,6 +66,11 @@ public:
     // Imported from COBJECT
     bool Intersect( const RAY &aRay, HITINFO &aHitInfo ) const override;
     bool IntersectP(const RAY &aRay , float aMaxDistance ) const override;
+    uint64_t IntersectPacket( const RAYPACKET &aRayPacket,
+                              const RAYPACKET_SOA &aPacket,
+                              uint64_t aRays,
+                              HITINFO_PACKET *aHitInfoPacket,
+                              RAYTRACING_SIMD aSimd ) const override;
     bool Intersects( const CBBOX &aBBox ) const override;
     SFVEC3F GetDiffuseColor( const HITINFO &aHitInfo ) const override;
 
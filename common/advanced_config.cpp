@@ -65,6 +65,20 @@ static const wxChar EnableSvgImport[] = wxT( "EnableSvgImport" );
  */
 static const wxChar RealtimeConnectivity[] = wxT( "RealtimeConnectivity" );
 
+/**
+ * Debugging mode for the incremental connectivity update: the connectivity data updated by
+ * the DRC is compared to a full rebuild, and rebuilt if they differ.  This is as slow as
+ * the full rebuild it replaces.
+ */
+static const wxChar CheckIncrementalConnectivity[] = wxT( "CheckIncrementalConnectivity" );
+
+/**
+ * Records the routing sessions to this file: the input events and the settings, which the
+ * pns_replay tool of qa_pcbnew_tools replays on the board as it was when the router tool
+ * was started.  The file is written again at the end of each session.
+ */
+static const wxChar RouterEventLog[] = wxT( "RouterEventLog" );
+
 /**
  * Allow legacy canvas to be shown in GTK3. Legacy canvas is generally pretty
  * broken, but this avoids code in an ifdef where it could become broken
@@ -152,6 +166,8 @@ ADVANCED_CFG::ADVANCED_CFG()
     m_enableSvgImport = false;
     m_allowLegacyCanvasInGtk3 = false;
     m_realTimeConnectivity = true;
+    m_checkIncrementalConnectivity = false;
+    m_routerEventLog = wxEmptyString;
 
     loadFromConfigFile();
 }
@@ -194,6 +210,12 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back(
             new PARAM_CFG_BOOL( true, AC_KEYS::RealtimeConnectivity, &m_realTimeConnectivity, false ) );
 
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::CheckIncrementalConnectivity,
+            &m_checkIncrementalConnectivity, false ) );
+
+    configParams.push_back( new PARAM_CFG_WXSTRING( true, AC_KEYS::RouterEventLog,
+            &m_routerEventLog, wxEmptyString ) );
+
     wxConfigLoadSetups( &aCfg, configParams );
 
     dumpCfg( configParams );
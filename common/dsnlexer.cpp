@@ -48,6 +48,8 @@ void DSNLEXER::init()
 
     stringDelimiter = '"';
 
+    inPlaceLines = false;
+
     specctraMode = false;
     space_in_quoted_tokens = false;
     commentsAreTokens = false;
@@ -777,11 +779,11 @@ L_read:
     }           // specctraMode
 
     // non-quoted token, read it into curText.
-    curText.clear();
-
     head = cur;
     while( head<limit && !isSep( *head ) )
-        curText += *head++;
+        ++head;
+
+    curText.assign( cur, head );
 
     if( isNumber( curText.c_str(), curText.c_str() + curText.size() ) )
     {
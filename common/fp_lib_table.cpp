@@ -337,6 +337,18 @@ const MODULE* FP_LIB_TABLE::GetEnumeratedFootprint( const wxString& aNickname,
 }
 
 
+bool FP_LIB_TABLE::GetEnumeratedFootprintMetadata( const wxString& aNickname,
+                                                   const wxString& aFootprintName,
+                                                   FOOTPRINT_METADATA& aMetadata )
+{
+    const FP_LIB_TABLE_ROW* row = FindRow( aNickname );
+    wxASSERT( (PLUGIN*) row->plugin );
+
+    return row->plugin->GetEnumeratedFootprintMetadata( row->GetFullURI( true ), aFootprintName,
+                                                        aMetadata, row->GetProperties() );
+}
+
+
 bool FP_LIB_TABLE::FootprintExists( const wxString& aNickname, const wxString& aFootprintName )
 {
     try
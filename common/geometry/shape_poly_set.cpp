@@ -37,6 +37,8 @@
 
 #include <md5_hash.h>
 #include <map>
+#include <atomic>
+#include <climits>
 
 #include <make_unique.h>
 
@@ -45,17 +47,20 @@
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
 #include <geometry/polygon_triangulation.h>
+#include <geometry/rtree.h>
 
 using namespace ClipperLib;
 
 SHAPE_POLY_SET::SHAPE_POLY_SET() :
-    SHAPE( SH_POLY_SET )
+    SHAPE( SH_POLY_SET ),
+    m_segmentIndexUnverified( false )
 {
 }
 
 
 SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
-    SHAPE( SH_POLY_SET ), m_polys( aOther.m_polys )
+    SHAPE( SH_POLY_SET ), m_polys( aOther.m_polys ),
+    m_segmentIndexUnverified( false )
 {
     if( aOther.IsTriangulationUpToDate() )
     {
@@ -66,6 +71,9 @@ SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther, bool aDeepCopy ) :
         m_hash = aOther.GetHash();
         m_triangulationValid = true;
     }
+
+    m_segmentIndex = std::atomic_load( &aOther.m_segmentIndex );
+    m_segmentIndexUnverified = aOther.m_segmentIndexUnverified.load();
 }
 
 
@@ -165,6 +173,8 @@ bool SHAPE_POLY_SET::GetGlobalIndex( SHAPE_POLY_SET::VERTEX_INDEX aRelativeIndic
 
 int SHAPE_POLY_SET::NewOutline()
 {
+    invalidateIndex();
+
     SHAPE_LINE_CHAIN empty_path;
     POLYGON poly;
 
@@ -177,6 +187,8 @@ int SHAPE_POLY_SET::NewOutline()
 
 int SHAPE_POLY_SET::NewHole( int aOutline )
 {
+    invalidateIndex();
+
     SHAPE_LINE_CHAIN empty_path;
 
     empty_path.SetClosed( true );
@@ -194,6 +206,8 @@ int SHAPE_POLY_SET::NewHole( int aOutline )
 
 int SHAPE_POLY_SET::Append( int x, int y, int aOutline, int aHole, bool aAllowDuplication )
 {
+    invalidateIndex();
+
     if( aOutline < 0 )
         aOutline += m_polys.size();
 
@@ -215,6 +229,8 @@ int SHAPE_POLY_SET::Append( int x, int y, int aOutline, int aHole, bool aAllowDu
 
 void SHAPE_POLY_SET::InsertVertex( int aGlobalIndex, VECTOR2I aNewVertex )
 {
+    invalidateIndex();
+
     VERTEX_INDEX index;
 
     if( aGlobalIndex < 0 )
@@ -268,7 +284,7 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon )
 
     for( int index = aFirstPolygon; index < aLastPolygon; index++ )
     {
-        newPolySet.m_polys.push_back( Polygon( index ) );
+        newPolySet.m_polys.push_back( CPolygon( index ) );
     }
 
     return newPolySet;
@@ -277,6 +293,8 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Subset( int aFirstPolygon, int aLastPolygon )
 
 VECTOR2I& SHAPE_POLY_SET::Vertex( int aIndex, int aOutline, int aHole )
 {
+    invalidateIndex();
+
     if( aOutline < 0 )
         aOutline += m_polys.size();
 
@@ -315,6 +333,8 @@ const VECTOR2I& SHAPE_POLY_SET::CVertex( int aIndex, int aOutline, int aHole ) c
 
 VECTOR2I& SHAPE_POLY_SET::Vertex( int aGlobalIndex )
 {
+    invalidateIndex();
+
     SHAPE_POLY_SET::VERTEX_INDEX index;
 
     // Assure the passed index references a legal position; abort otherwise
@@ -437,6 +457,8 @@ bool SHAPE_POLY_SET::IsSelfIntersecting()
 
 int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 {
+    invalidateIndex();
+
     assert( aOutline.IsClosed() );
 
     POLYGON poly;
@@ -451,6 +473,8 @@ int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 
 int SHAPE_POLY_SET::AddHole( const SHAPE_LINE_CHAIN& aHole, int aOutline )
 {
+    invalidateIndex();
+
     assert( m_polys.size() );
 
     if( aOutline < 0 )
@@ -554,12 +578,6 @@ void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCou
 
 void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount, bool aPreseveCorners )
 {
-    // A static table to avoid repetitive calculations of the coefficient
-    // 1.0 - cos( M_PI/aCircleSegmentsCount)
-    // aCircleSegmentsCount is most of time <= 64 and usually 8, 12, 16, 32
-    #define SEG_CNT_MAX 64
-    static double arc_tolerance_factor[SEG_CNT_MAX + 1];
-
     ClipperOffset c;
 
     // N.B. using jtSquare here does not create square corners.  They end up mitered by
@@ -582,17 +600,9 @@ void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount, bool aPrese
     if( aCircleSegmentsCount < 6 ) // avoid incorrect aCircleSegmentsCount values
         aCircleSegmentsCount = 6;
 
-    double coeff;
-
-    if( aCircleSegmentsCount > SEG_CNT_MAX || arc_tolerance_factor[aCircleSegmentsCount] == 0 )
-    {
-        coeff = 1.0 - cos( M_PI / aCircleSegmentsCount );
-
-        if( aCircleSegmentsCount <= SEG_CNT_MAX )
-            arc_tolerance_factor[aCircleSegmentsCount] = coeff;
-    }
-    else
-        coeff = arc_tolerance_factor[aCircleSegmentsCount];
+    // Computed on each call: a cached table would be shared by the threads inflating
+    // polygons at the same time (zone filling, plotting)
+    double coeff = 1.0 - cos( M_PI / aCircleSegmentsCount );
 
     c.ArcTolerance = std::abs( aFactor ) * coeff;
     c.MiterLimit = std::abs( aFactor );
@@ -605,6 +615,8 @@ void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount, bool aPrese
 
 void SHAPE_POLY_SET::importTree( PolyTree* tree )
 {
+    invalidateIndex();
+
     m_polys.clear();
 
     for( PolyNode* n = tree->GetFirst(); n; n = n->GetNext() )
@@ -843,6 +855,8 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 
 void SHAPE_POLY_SET::Fracture( POLYGON_MODE aFastMode )
 {
+    invalidateIndex();
+
     Simplify( aFastMode );    // remove overlapping holes/degeneracy
 
     for( POLYGON& paths : m_polys )
@@ -1030,6 +1044,8 @@ bool SHAPE_POLY_SET::HasHoles() const
 
 void SHAPE_POLY_SET::Unfracture( POLYGON_MODE aFastMode )
 {
+    invalidateIndex();
+
     for( POLYGON& path : m_polys )
     {
         unfractureSingle( path );
@@ -1107,6 +1123,8 @@ const std::string SHAPE_POLY_SET::Format() const
 
 bool SHAPE_POLY_SET::Parse( std::stringstream& aStream )
 {
+    invalidateIndex();
+
     std::string tmp;
 
     aStream >> tmp;
@@ -1198,61 +1216,288 @@ bool SHAPE_POLY_SET::PointOnEdge( const VECTOR2I& aP ) const
 }
 
 
-bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
+/**
+ * Class SHAPE_POLY_SET::SEGMENT_INDEX
+ * is an R-tree of the edges of all the contours of a SHAPE_POLY_SET.  It keeps its own
+ * copy of the edges, so it can be shared by copies of the set.
+ */
+class SHAPE_POLY_SET::SEGMENT_INDEX
+{
+public:
+    SEGMENT_INDEX( const POLYSET& aPolys, const MD5_HASH& aHash );
+
+    ///> Checksum of the set the index was built from
+    const MD5_HASH& GetHash() const { return m_hash; }
+
+    /**
+     * Function Query
+     * calls \p aVisitor for the edges whose bounding box intersects the box between
+     * \p aMin and \p aMax, until it returns false.
+     */
+    void Query( const VECTOR2I& aMin, const VECTOR2I& aMax, const EDGE_VISITOR& aVisitor ) const
+    {
+        int mmin[2] = { aMin.x, aMin.y };
+        int mmax[2] = { aMax.x, aMax.y };
+
+        m_tree.Search( mmin, mmax,
+                       [&]( const size_t& aEdge ) -> bool
+                       {
+                           const EDGE& edge = m_edges[aEdge];
+                           return aVisitor( edge.m_seg, edge.m_polygon, edge.m_contour );
+                       } );
+    }
+
+    const BOX2I& BBox() const { return m_bbox; }
+
+    ///> Average extent of the edges, a good first guess when searching the nearest one
+    int EdgeSize() const { return m_edgeSize; }
+
+private:
+    struct EDGE
+    {
+        SEG m_seg;
+        int m_polygon;
+        int m_contour;
+    };
+
+    std::vector<EDGE>               m_edges;
+    RTree<size_t, int, 2, double>   m_tree;
+    BOX2I                           m_bbox;
+    int                             m_edgeSize;
+    MD5_HASH                        m_hash;
+};
+
+
+SHAPE_POLY_SET::SEGMENT_INDEX::SEGMENT_INDEX( const POLYSET& aPolys, const MD5_HASH& aHash ) :
+    m_edgeSize( 1 ),
+    m_hash( aHash )
 {
+    long long extent = 0;
 
-    SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
+    for( size_t polygon = 0; polygon < aPolys.size(); polygon++ )
+    {
+        for( size_t contour = 0; contour < aPolys[polygon].size(); contour++ )
+        {
+            const SHAPE_LINE_CHAIN& chain = aPolys[polygon][contour];
+
+            for( int ii = 0; ii < chain.SegmentCount(); ii++ )
+                m_edges.push_back( { chain.CSegment( ii ), (int) polygon, (int) contour } );
+        }
+    }
 
-    // Inflate the polygon if necessary.
-    if( aClearance > 0 )
+    for( size_t ii = 0; ii < m_edges.size(); ii++ )
     {
-        // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
+        const SEG& seg = m_edges[ii].m_seg;
+        int mmin[2] = { std::min( seg.A.x, seg.B.x ), std::min( seg.A.y, seg.B.y ) };
+        int mmax[2] = { std::max( seg.A.x, seg.B.x ), std::max( seg.A.y, seg.B.y ) };
+
+        m_tree.Insert( mmin, mmax, ii );
+
+        if( ii == 0 )
+            m_bbox = BOX2I( seg.A, VECTOR2I( 0, 0 ) );
+
+        m_bbox.Merge( seg.A );
+        m_bbox.Merge( seg.B );
+        extent += std::max( mmax[0] - mmin[0], mmax[1] - mmin[1] );
     }
 
-    // We are going to check to see if the segment crosses an external
-    // boundary.  However, if the full segment is inside the polyset, this
-    // will not be true.  So we first test to see if one of the points is
-    // inside.  If true, then we collide
-    if( polySet.Contains( aSeg.A ) )
-        return true;
+    if( !m_edges.empty() )
+        m_edgeSize = std::max<long long>( 1, extent / m_edges.size() );
+}
+
+
+///> Sets with fewer edges are scanned linearly rather than indexed
+static const int SEGMENT_INDEX_MIN_EDGES = 64;
 
-    for( SEGMENT_ITERATOR iterator = polySet.IterateSegmentsWithHoles(); iterator; iterator++ )
+
+std::shared_ptr<const SHAPE_POLY_SET::SEGMENT_INDEX> SHAPE_POLY_SET::segmentIndex() const
+{
+    // Queries are const and may come from several threads at once (DRC, connectivity),
+    // so the cache pointer is only ever read and published atomically.
+    std::shared_ptr<const SEGMENT_INDEX> index = std::atomic_load( &m_segmentIndex );
+
+    // The contours were handed out for modification since the index was built: keep it
+    // if they were only read.
+    if( index && m_segmentIndexUnverified )
     {
-        SEG polygonEdge = *iterator;
+        if( index->GetHash() == checksum() )
+        {
+            m_segmentIndexUnverified = false;
+        }
+        else
+        {
+            index.reset();
+            std::atomic_store( &m_segmentIndex, index );
+        }
+    }
 
-        if( polygonEdge.Intersect( aSeg, true ) )
-            return true;
+    if( index )
+        return index;
+
+    int edgeCount = 0;
+
+    for( const POLYGON& poly : m_polys )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : poly )
+            edgeCount += chain.SegmentCount();
     }
 
-    return false;
+    if( edgeCount < SEGMENT_INDEX_MIN_EDGES )
+        return index;
+
+    index = std::make_shared<const SEGMENT_INDEX>( m_polys, checksum() );
+    std::atomic_store( &m_segmentIndex, index );
+    m_segmentIndexUnverified = false;
+
+    return index;
 }
 
 
-bool SHAPE_POLY_SET::Collide( const VECTOR2I& aP, int aClearance ) const
+void SHAPE_POLY_SET::visitEdges( const VECTOR2I& aMin, const VECTOR2I& aMax,
+                                 const EDGE_VISITOR& aVisitor ) const
 {
-    SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
+    std::shared_ptr<const SEGMENT_INDEX> index = segmentIndex();
 
-    // Inflate the polygon if necessary.
-    if( aClearance > 0 )
+    if( index )
     {
-        // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
+        index->Query( aMin, aMax, aVisitor );
+        return;
     }
 
-    // There is a collision if and only if the point is inside of the polygon.
-    return polySet.Contains( aP );
+    for( size_t polygon = 0; polygon < m_polys.size(); polygon++ )
+    {
+        for( size_t contour = 0; contour < m_polys[polygon].size(); contour++ )
+        {
+            const SHAPE_LINE_CHAIN& chain = m_polys[polygon][contour];
+
+            for( int ii = 0; ii < chain.SegmentCount(); ii++ )
+            {
+                if( !aVisitor( chain.CSegment( ii ), polygon, contour ) )
+                    return;
+            }
+        }
+    }
+}
+
+
+SEG::ecoord SHAPE_POLY_SET::squaredDistanceToEdges( const VECTOR2I& aMin, const VECTOR2I& aMax,
+        int aPolygonIndex, const std::function<SEG::ecoord( const SEG& )>& aDistance ) const
+{
+    SEG::ecoord minDistance = (SEG::ecoord) INT_MAX * INT_MAX;
+
+    auto visitor = [&]( const SEG& aEdge, int aPolygon, int ) -> bool
+    {
+        if( aPolygon == aPolygonIndex )
+            minDistance = std::min( minDistance, aDistance( aEdge ) );
+
+        return minDistance > 0;
+    };
+
+    std::shared_ptr<const SEGMENT_INDEX> index = segmentIndex();
+
+    if( !index )
+    {
+        visitEdges( aMin, aMax, visitor );
+        return minDistance;
+    }
+
+    // Search boxes of growing size around the object.  Any edge closer than r lies in
+    // the box inflated by r, so the search is over once the nearest edge found is no
+    // farther than that.
+    const BOX2I& bbox = index->BBox();
+    long long    r = index->EdgeSize();
+
+    while( true )
+    {
+        VECTOR2I qmin( std::max<long long>( (long long) aMin.x - r, INT_MIN ),
+                       std::max<long long>( (long long) aMin.y - r, INT_MIN ) );
+        VECTOR2I qmax( std::min<long long>( (long long) aMax.x + r, INT_MAX ),
+                       std::min<long long>( (long long) aMax.y + r, INT_MAX ) );
+
+        index->Query( qmin, qmax, visitor );
+
+        if( (double) minDistance <= (double) r * r )
+            break;
+
+        // The box covers every edge: nothing else to find.
+        if( qmin.x <= bbox.GetLeft() && qmin.y <= bbox.GetTop()
+                && qmax.x >= bbox.GetRight() && qmax.y >= bbox.GetBottom() )
+            break;
+
+        r *= 2;
+    }
+
+    return minDistance;
+}
+
+
+bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
+{
+    // We are going to check to see if the segment crosses (or comes within aClearance of)
+    // an edge.  However, if the full segment is inside the polyset, this will not be true.
+    // So we first test to see if one of the points is inside.  If true, then we collide
+    if( Contains( aSeg.A ) )
+        return true;
+
+    int         clearance = std::max( aClearance, 0 );
+    SEG::ecoord limit = (SEG::ecoord) clearance * clearance;
+    VECTOR2I    margin( clearance, clearance );
+    bool        collision = false;
+
+    VECTOR2I bbMin( std::min( aSeg.A.x, aSeg.B.x ), std::min( aSeg.A.y, aSeg.B.y ) );
+    VECTOR2I bbMax( std::max( aSeg.A.x, aSeg.B.x ), std::max( aSeg.A.y, aSeg.B.y ) );
+
+    visitEdges( bbMin - margin, bbMax + margin,
+                [&]( const SEG& aEdge, int, int ) -> bool
+                {
+                    if( clearance > 0 )
+                        collision = aEdge.SquaredDistance( aSeg ) < limit;
+                    else
+                        collision = (bool) aEdge.Intersect( aSeg, true );
+
+                    return !collision;
+                } );
+
+    return collision;
+}
+
+
+bool SHAPE_POLY_SET::Collide( const VECTOR2I& aP, int aClearance ) const
+{
+    if( Contains( aP ) )
+        return true;
+
+    if( aClearance <= 0 )
+        return false;
+
+    // Outside of the polygon (or on an edge): collide if closer than aClearance to an edge.
+    SEG::ecoord limit = (SEG::ecoord) aClearance * aClearance;
+    VECTOR2I    margin( aClearance, aClearance );
+    bool        collision = false;
+
+    visitEdges( aP - margin, aP + margin,
+                [&]( const SEG& aEdge, int, int ) -> bool
+                {
+                    collision = aEdge.SquaredDistance( aP ) < limit;
+                    return !collision;
+                } );
+
+    return collision;
 }
 
 
 void SHAPE_POLY_SET::RemoveAllContours()
 {
+    invalidateIndex();
+
     m_polys.clear();
 }
 
 
 void SHAPE_POLY_SET::RemoveContour( int aContourIdx, int aPolygonIdx )
 {
+    invalidateIndex();
+
     // Default polygon is the last one
     if( aPolygonIdx < 0 )
         aPolygonIdx += m_polys.size();
@@ -1316,12 +1561,16 @@ int SHAPE_POLY_SET::RemoveNullSegments()
 
 void SHAPE_POLY_SET::DeletePolygon( int aIdx )
 {
+    invalidateIndex();
+
     m_polys.erase( m_polys.begin() + aIdx );
 }
 
 
 void SHAPE_POLY_SET::Append( const SHAPE_POLY_SET& aSet )
 {
+    invalidateIndex();
+
     m_polys.insert( m_polys.end(), aSet.m_polys.begin(), aSet.m_polys.end() );
 }
 
@@ -1405,14 +1654,82 @@ bool SHAPE_POLY_SET::Contains( const VECTOR2I& aP, int aSubpolyIndex, bool aIgno
     if( m_polys.size() == 0 ) // empty set?
         return false;
 
-    // If there is a polygon specified, check the condition against that polygon
-    if( aSubpolyIndex >= 0 )
-        return containsSingle( aP, aSubpolyIndex, aIgnoreHoles );
+    // Contours are identified by ( polygon, contour ) packed in a single key, so sorting
+    // the keys groups the contours of a polygon, outline first.
+    auto contourKey = []( int aPolygon, int aContour ) -> long long
+    {
+        return ( (long long) aPolygon << 32 ) | (unsigned) aContour;
+    };
+
+    std::vector<long long> crossed;
+    std::vector<long long> touched;
+
+    // Same rules as SHAPE_LINE_CHAIN::PointInside(): a contour contains aP if a ray drawn
+    // from aP in the positive x direction crosses it an odd number of times, and aP is not
+    // on one of its edges.  Only edges reaching the ray can cross it.
+    visitEdges( aP, VECTOR2I( INT_MAX, aP.y ),
+                [&]( const SEG& aEdge, int aPolygon, int aContour ) -> bool
+                {
+                    if( aSubpolyIndex >= 0 && aPolygon != aSubpolyIndex )
+                        return true;
+
+                    const VECTOR2I diff = aEdge.B - aEdge.A;
+
+                    if( diff.y != 0 )
+                    {
+                        const int d = rescale( diff.x, ( aP.y - aEdge.A.y ), diff.y );
+
+                        if( ( ( aEdge.A.y > aP.y ) != ( aEdge.B.y > aP.y ) )
+                                && ( aP.x - aEdge.A.x < d ) )
+                            crossed.push_back( contourKey( aPolygon, aContour ) );
+                    }
+
+                    return true;
+                } );
+
+    if( crossed.empty() )
+        return false;
+
+    // SHAPE_LINE_CHAIN::PointOnEdge() with no accuracy: anything closer than 2 units.
+    visitEdges( aP - VECTOR2I( 2, 2 ), aP + VECTOR2I( 2, 2 ),
+                [&]( const SEG& aEdge, int aPolygon, int aContour ) -> bool
+                {
+                    if( aEdge.A == aP || aEdge.B == aP || aEdge.Distance( aP ) <= 1 )
+                        touched.push_back( contourKey( aPolygon, aContour ) );
+
+                    return true;
+                } );
+
+    std::sort( crossed.begin(), crossed.end() );
+    std::sort( touched.begin(), touched.end() );
+
+    std::vector<long long> inside;
+
+    for( size_t ii = 0; ii < crossed.size(); )
+    {
+        size_t jj = ii;
+
+        while( jj < crossed.size() && crossed[jj] == crossed[ii] )
+            jj++;
+
+        long long key = crossed[ii];
+        const SHAPE_LINE_CHAIN& contour = m_polys[key >> 32][key & 0xFFFFFFFF];
+
+        if( ( jj - ii ) % 2 == 1 && contour.IsClosed() && contour.PointCount() >= 3
+                && !std::binary_search( touched.begin(), touched.end(), key ) )
+            inside.push_back( key );
+
+        ii = jj;
+    }
 
-    // In any other case, check it against all polygons in the set
-    for( int polygonIdx = 0; polygonIdx < OutlineCount(); polygonIdx++ )
+    // A polygon contains aP if its outline does and none of its holes do.  The hole
+    // contours of a polygon follow its outline in the sorted keys.
+    for( size_t ii = 0; ii < inside.size(); ii++ )
     {
-        if( containsSingle( aP, polygonIdx, aIgnoreHoles ) )
+        if( ( inside[ii] & 0xFFFFFFFF ) != 0 )
+            continue;
+
+        if( aIgnoreHoles || ii + 1 == inside.size() || ( inside[ii + 1] >> 32 ) != ( inside[ii] >> 32 ) )
             return true;
     }
 
@@ -1434,44 +1751,16 @@ void SHAPE_POLY_SET::RemoveVertex( int aGlobalIndex )
 
 void SHAPE_POLY_SET::RemoveVertex( VERTEX_INDEX aIndex )
 {
-    m_polys[aIndex.m_polygon][aIndex.m_contour].Remove( aIndex.m_vertex );
-}
-
+    invalidateIndex();
 
-bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, bool aIgnoreHoles ) const
-{
-    // Check that the point is inside the outline
-    if( pointInPolygon( aP, m_polys[aSubpolyIndex][0] ) )
-    {
-        if( !aIgnoreHoles )
-        {
-            // Check that the point is not in any of the holes
-            for( int holeIdx = 0; holeIdx < HoleCount( aSubpolyIndex ); holeIdx++ )
-            {
-                const SHAPE_LINE_CHAIN hole = CHole( aSubpolyIndex, holeIdx );
-
-                // If the point is inside a hole (and not on its edge),
-                // it is outside of the polygon
-                if( pointInPolygon( aP, hole ) && !hole.PointOnEdge( aP ) )
-                    return false;
-            }
-        }
-
-        return true;
-    }
-
-    return false;
-}
-
-
-bool SHAPE_POLY_SET::pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const
-{
-    return aPath.PointInside( aP );
+    m_polys[aIndex.m_polygon][aIndex.m_contour].Remove( aIndex.m_vertex );
 }
 
 
 void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 {
+    invalidateIndex();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
@@ -1484,6 +1773,8 @@ void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 
 void SHAPE_POLY_SET::Rotate( double aAngle, const VECTOR2I& aCenter )
 {
+    invalidateIndex();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
@@ -1526,29 +1817,19 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::FilletPolygon( unsigned int aRadius,
 
 int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
 {
-    // We calculate the min dist between the segment and each outline segment
-    // However, if the segment to test is inside the outline, and does not cross
-    // any edge, it can be seen outside the polygon.
-    // Therefore test if a segment end is inside ( testing only one end is enough )
-    if( containsSingle( aPoint, aPolygonIndex ) )
+    // We calculate the min dist between the point and each outline segment
+    // However, if the point is inside the outline, it can be seen outside the polygon
+    // from the edges alone.  Therefore test first if it is inside.
+    if( Contains( aPoint, aPolygonIndex ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
-
-    SEG polygonEdge = *iterator;
-    int minDistance = polygonEdge.Distance( aPoint );
-
-    for( iterator++; iterator && minDistance > 0; iterator++ )
-    {
-        polygonEdge = *iterator;
-
-        int currentDistance = polygonEdge.Distance( aPoint );
-
-        if( currentDistance < minDistance )
-            minDistance = currentDistance;
-    }
+    SEG::ecoord minDistance = squaredDistanceToEdges( aPoint, aPoint, aPolygonIndex,
+            [&]( const SEG& aEdge )
+            {
+                return aEdge.SquaredDistance( aPoint );
+            } );
 
-    return minDistance;
+    return sqrt( minDistance );
 }
 
 
@@ -1558,23 +1839,19 @@ int SHAPE_POLY_SET::DistanceToPolygon( SEG aSegment, int aPolygonIndex, int aSeg
     // However, if the segment to test is inside the outline, and does not cross
     // any edge, it can be seen outside the polygon.
     // Therefore test if a segment end is inside ( testing only one end is enough )
-    if( containsSingle( aSegment.A, aPolygonIndex ) )
+    if( Contains( aSegment.A, aPolygonIndex ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
-
-    SEG polygonEdge = *iterator;
-    int minDistance = polygonEdge.Distance( aSegment );
-
-    for( iterator++; iterator && minDistance > 0; iterator++ )
-    {
-        polygonEdge = *iterator;
+    VECTOR2I bbMin( std::min( aSegment.A.x, aSegment.B.x ), std::min( aSegment.A.y, aSegment.B.y ) );
+    VECTOR2I bbMax( std::max( aSegment.A.x, aSegment.B.x ), std::max( aSegment.A.y, aSegment.B.y ) );
 
-        int currentDistance = polygonEdge.Distance( aSegment );
+    SEG::ecoord minSqDistance = squaredDistanceToEdges( bbMin, bbMax, aPolygonIndex,
+            [&]( const SEG& aEdge )
+            {
+                return aEdge.SquaredDistance( aSegment );
+            } );
 
-        if( currentDistance < minDistance )
-            minDistance = currentDistance;
-    }
+    int minDistance = sqrt( minSqDistance );
 
     // Take into account the width of the segment
     if( aSegmentWidth > 0 )
@@ -1828,6 +2105,10 @@ SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
     m_hash = MD5_HASH{};
     m_triangulationValid = false;
     m_triangulatedPolys.clear();
+
+    // the edge index is immutable, so it can be shared with aOther
+    std::atomic_store( &m_segmentIndex, std::atomic_load( &aOther.m_segmentIndex ) );
+    m_segmentIndexUnverified = aOther.m_segmentIndexUnverified.load();
     return *this;
 }
 
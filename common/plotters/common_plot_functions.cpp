@@ -33,6 +33,8 @@
 #include "ws_data_item.h"
 #include <wx/filename.h>
 
+#include <mutex>
+
 
 
 wxString GetDefaultPlotExtension( PlotFormat aFormat )
@@ -65,6 +67,13 @@ void PlotWorkSheet( PLOTTER* plotter, const TITLE_BLOCK& aTitleBlock,
         plotColor = COLOR4D( RED );
 
     plotter->SetColor( plotColor );
+
+    // The draw items are built from the page layout, which is shared: it keeps the items
+    // of the last build and the current draw environment.  Several plots can run at once
+    // (see PLOT_JOB in pcbnew), so one worksheet is built and plotted at a time.
+    static std::mutex worksheet_mutex;
+    std::lock_guard<std::mutex> lock( worksheet_mutex );
+
     WS_DRAW_ITEM_LIST drawList;
 
     // Print only a short filename, if aFilename is the full filename
@@ -28,6 +28,15 @@
 
 #include <richio.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -225,6 +234,134 @@ char* FILE_LINE_READER::ReadLine()
 }
 
 
+MEMORY_LINE_READER::MEMORY_LINE_READER( const char* aData, size_t aSize,
+            const wxString& aSource, unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    LINE_READER( aMaxLineLength ), m_data( aData ), m_size( aSize ), m_ndx( 0 )
+{
+    m_source  = aSource;
+    m_lineNum = aStartingLineNumber;
+}
+
+
+const char* MEMORY_LINE_READER::ReadLineInPlace()
+{
+    const char* line = m_data + m_ndx;
+    size_t      remaining = m_size - m_ndx;
+
+    if( remaining )
+    {
+        const char* nl = (const char*) memchr( line, '\n', remaining );
+
+        // include the newline, so +1
+        size_t length = nl ? nl - line + 1 : remaining;
+
+        if( length >= m_maxLineLength )
+            THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+        m_length = (unsigned) length;
+        m_ndx += length;
+    }
+    else
+    {
+        m_length = 0;
+    }
+
+    ++m_lineNum;      // this gets incremented even if no bytes were read
+
+    return m_length ? line : NULL;
+}
+
+
+char* MEMORY_LINE_READER::ReadLine()
+{
+    const char* line = ReadLineInPlace();
+
+    if( m_length+1 > m_capacity )   // +1 for terminating nul
+        expandCapacity( m_length+1 );
+
+    if( m_length )
+        memcpy( m_line, line, m_length );
+
+    m_line[m_length] = 0;
+
+    return m_length ? m_line : NULL;
+}
+
+
+MAPPED_FILE_LINE_READER::MAPPED_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber, unsigned aMaxLineLength ) :
+    MEMORY_LINE_READER( NULL, 0, aFileName, aStartingLineNumber, aMaxLineLength )
+{
+    wxString msg = wxString::Format(
+        _( "Unable to open filename \"%s\" for reading" ), aFileName.GetData() );
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW( aFileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+    if( file == INVALID_HANDLE_VALUE )
+        THROW_IO_ERROR( msg );
+
+    LARGE_INTEGER size;
+
+    if( GetFileSizeEx( file, &size ) && size.QuadPart > 0 )
+    {
+        m_size = (size_t) size.QuadPart;
+
+        // The view keeps the mapping alive after its handle is closed
+        HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+        if( mapping )
+        {
+            m_data = (const char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( mapping );
+        }
+    }
+
+    CloseHandle( file );
+#else
+    int fd = open( aFileName.fn_str(), O_RDONLY );
+
+    if( fd < 0 )
+        THROW_IO_ERROR( msg );
+
+    struct stat st;
+
+    if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+    {
+        m_size = (size_t) st.st_size;
+
+        // The mapping stays valid after the file is closed
+        void* data = mmap( NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if( data != MAP_FAILED )
+        {
+            madvise( data, m_size, MADV_SEQUENTIAL );
+            m_data = (const char*) data;
+        }
+    }
+
+    close( fd );
+#endif
+
+    if( m_size && !m_data )
+        THROW_IO_ERROR( msg );
+}
+
+
+MAPPED_FILE_LINE_READER::~MAPPED_FILE_LINE_READER()
+{
+    if( m_data )
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( m_data );
+#else
+        munmap( (void*) m_data, m_size );
+#endif
+    }
+}
+
+
 STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ):
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     m_lines( aString ), m_ndx( 0 )
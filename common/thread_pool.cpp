@@ -0,0 +1,348 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include <widgets/progress_reporter.h>
+
+
+///> The pool the current thread is a worker of, if any
+static thread_local THREAD_POOL* s_workerPool = nullptr;
+
+///> The index of the current thread in the workers of s_workerPool
+static thread_local size_t s_workerIndex = 0;
+
+
+THREAD_POOL& THREAD_POOL::GetInstance()
+{
+    // Never destroyed: at exit, the worker threads may already be gone (in particular when
+    // the pool lives in a dynamically unloaded kiface), and joining them would hang.
+    static THREAD_POOL* pool =
+            new THREAD_POOL( std::max<size_t>( std::thread::hardware_concurrency(), 1 ) );
+
+    return *pool;
+}
+
+
+THREAD_POOL::THREAD_POOL( size_t aThreadCount ) :
+    m_queuedCount( 0 ),
+    m_quit( false )
+{
+    aThreadCount = std::max<size_t>( aThreadCount, 1 );
+
+    for( size_t ii = 0; ii <= aThreadCount; ++ii )
+        m_queues.emplace_back( new TASK_QUEUE );
+
+    for( size_t ii = 0; ii < aThreadCount; ++ii )
+        m_workers.emplace_back( &THREAD_POOL::workerLoop, this, ii );
+}
+
+
+THREAD_POOL::~THREAD_POOL()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_sleepMutex );
+        m_quit = true;
+    }
+
+    m_wakeUp.notify_all();
+
+    for( auto& worker : m_workers )
+        worker.join();
+}
+
+
+bool THREAD_POOL::IsWorkerThread() const
+{
+    return s_workerPool == this;
+}
+
+
+void THREAD_POOL::submit( TASK&& aTask )
+{
+    TASK_QUEUE& queue = IsWorkerThread() ? *m_queues[s_workerIndex] : *m_queues.back();
+
+    {
+        std::lock_guard<std::mutex> lock( queue.m_mutex );
+        queue.m_tasks.push_back( std::move( aTask ) );
+    }
+
+    m_queuedCount++;
+
+    // Taking the lock guarantees that a worker about to sleep sees the new task
+    {
+        std::lock_guard<std::mutex> lock( m_sleepMutex );
+    }
+
+    m_wakeUp.notify_one();
+}
+
+
+bool THREAD_POOL::popTask( TASK& aTask, TASK_GROUP* aGroup )
+{
+    if( m_queuedCount == 0 )
+        return false;
+
+    size_t queueCount = m_queues.size();
+    size_t first = IsWorkerThread() ? s_workerIndex : queueCount - 1;
+
+    auto matches = [aGroup]( const TASK& aQueued )
+    {
+        return !aGroup || aQueued.m_group == aGroup;
+    };
+
+    // The own deque is used as a stack, for locality
+    if( IsWorkerThread() )
+    {
+        TASK_QUEUE& queue = *m_queues[first];
+        std::lock_guard<std::mutex> lock( queue.m_mutex );
+
+        auto it = std::find_if( queue.m_tasks.rbegin(), queue.m_tasks.rend(), matches );
+
+        if( it != queue.m_tasks.rend() )
+        {
+            aTask = std::move( *it );
+            queue.m_tasks.erase( std::next( it ).base() );
+            m_queuedCount--;
+            return true;
+        }
+    }
+
+    // Then the shared queue, then steal the oldest task of the other workers
+    for( size_t ii = 0; ii < queueCount; ++ii )
+    {
+        size_t idx = ( queueCount - 1 + ii ) % queueCount;
+
+        if( IsWorkerThread() && idx == first )
+            continue;
+
+        TASK_QUEUE& queue = *m_queues[idx];
+        std::lock_guard<std::mutex> lock( queue.m_mutex );
+
+        auto it = std::find_if( queue.m_tasks.begin(), queue.m_tasks.end(), matches );
+
+        if( it != queue.m_tasks.end() )
+        {
+            aTask = std::move( *it );
+            queue.m_tasks.erase( it );
+            m_queuedCount--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool THREAD_POOL::runPendingTask( TASK_GROUP* aGroup )
+{
+    TASK task;
+
+    if( !popTask( task, aGroup ) )
+        return false;
+
+    task.m_group->execute( task );
+    return true;
+}
+
+
+void THREAD_POOL::workerLoop( size_t aIndex )
+{
+    s_workerPool = this;
+    s_workerIndex = aIndex;
+
+    while( true )
+    {
+        if( runPendingTask() )
+            continue;
+
+        std::unique_lock<std::mutex> lock( m_sleepMutex );
+
+        m_wakeUp.wait( lock, [this]() { return m_quit || m_queuedCount > 0; } );
+
+        if( m_quit )
+            return;
+    }
+}
+
+
+TASK_GROUP::TASK_GROUP( THREAD_POOL& aPool ) :
+    m_pool( aPool ),
+    m_pending( 0 ),
+    m_cancelled( false )
+{
+}
+
+
+TASK_GROUP::~TASK_GROUP()
+{
+    waitForTasks();
+}
+
+
+void TASK_GROUP::Run( std::function<void()> aTask )
+{
+    m_pending++;
+    m_pool.submit( { std::move( aTask ), this } );
+}
+
+
+void TASK_GROUP::ParallelFor( size_t aCount, std::function<void( size_t )> aFunc, size_t aGrain )
+{
+    if( aCount == 0 )
+        return;
+
+    aGrain = std::max<size_t>( aGrain, 1 );
+
+    size_t chunkCount = ( aCount - 1 ) / aGrain + 1;
+    size_t taskCount = std::min( chunkCount, m_pool.GetThreadCount() );
+    auto   nextIndex = std::make_shared<std::atomic<size_t>>( 0 );
+    auto   func = std::make_shared<std::function<void( size_t )>>( std::move( aFunc ) );
+
+    auto loop_lambda = [this, nextIndex, func, aCount, aGrain]()
+    {
+        for( size_t first = nextIndex->fetch_add( aGrain ); first < aCount && !m_cancelled;
+                first = nextIndex->fetch_add( aGrain ) )
+        {
+            size_t last = std::min( first + aGrain, aCount );
+
+            for( size_t ii = first; ii < last && !m_cancelled; ++ii )
+                ( *func )( ii );
+        }
+    };
+
+    for( size_t ii = 0; ii < taskCount; ++ii )
+        Run( loop_lambda );
+}
+
+
+void TASK_GROUP::execute( THREAD_POOL::TASK& aTask )
+{
+    if( !m_cancelled )
+    {
+        try
+        {
+            aTask.m_func();
+        }
+        catch( ... )
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            if( !m_exception )
+                m_exception = std::current_exception();
+        }
+    }
+
+    // Release the task (and whatever it captured) before the waiter may return
+    aTask.m_func = nullptr;
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( --m_pending == 0 )
+        m_finished.notify_all();
+}
+
+
+void TASK_GROUP::waitForTasks()
+{
+    while( m_pending > 0 )
+    {
+        if( m_pool.runPendingTask( this ) )
+            continue;
+
+        // Our remaining tasks are running on other threads, but they may queue more work
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_finished.wait_for( lock, std::chrono::milliseconds( 1 ),
+                             [this]() { return m_pending == 0; } );
+    }
+
+    // Make sure the last task has released the mutex before the group can go away
+    std::lock_guard<std::mutex> lock( m_mutex );
+}
+
+
+void TASK_GROUP::rethrowException()
+{
+    std::exception_ptr exception;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        std::swap( exception, m_exception );
+    }
+
+    if( exception )
+        std::rethrow_exception( exception );
+}
+
+
+void TASK_GROUP::Wait()
+{
+    waitForTasks();
+    rethrowException();
+}
+
+
+bool TASK_GROUP::Wait( PROGRESS_REPORTER* aReporter, bool aCanCancel )
+{
+    if( !aReporter )
+    {
+        Wait();
+        return !m_cancelled;
+    }
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    // Balance the wait with a 100ms timeout to allow UI updating
+    while( !m_finished.wait_for( lock, std::chrono::milliseconds( 100 ),
+                                 [this]() { return m_pending == 0; } ) )
+    {
+        lock.unlock();
+
+        if( !aReporter->KeepRefreshing() && aCanCancel )
+            Cancel();
+
+        lock.lock();
+    }
+
+    lock.unlock();
+    rethrowException();
+
+    return !m_cancelled;
+}
+
+
+bool TASK_GROUP::WaitFor( std::chrono::milliseconds aTimeout )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    return m_finished.wait_for( lock, aTimeout, [this]() { return m_pending == 0; } );
+}
+
+
+void ParallelFor( size_t aCount, std::function<void( size_t )> aFunc, size_t aGrain )
+{
+    TASK_GROUP group;
+
+    group.ParallelFor( aCount, std::move( aFunc ), aGrain );
+    group.Wait();
+}
@@ -66,6 +66,10 @@ popt.SetSkipPlotNPTH_Pads( False );
 #prepare the gerber job file
 jobfile_writer = GERBER_JOBFILE_WRITER( board )
 
+# All the plots and the drill files are collected in a plot job, and created
+# concurrently when the job is run
+plot_job = PLOT_JOB( board )
+
 # Once the defaults are set it become pretty easy...
 # I have a Turing-complete programming language here: I'll use it...
 # param 0 is a string added to the file base name to identify the drawing
@@ -91,12 +95,12 @@ for layer_info in plot_plan:
         popt.SetSkipPlotNPTH_Pads( False )
 
     pctl.SetLayer(layer_info[1])
-    pctl.OpenPlotfile(layer_info[0], PLOT_FORMAT_GERBER, layer_info[2])
+    if pctl.AddToJob(plot_job, layer_info[0], PLOT_FORMAT_GERBER, layer_info[2]) == False:
+        print "plot error"
+        continue
     print 'plot %s' % pctl.GetPlotFileName()
     if gen_job_file == True:
         jobfile_writer.AddGbrFile( layer_info[1], os.path.basename(pctl.GetPlotFileName()) );
-    if pctl.PlotLayer() == False:
-        print "plot error"
 
 #generate internal copper layers, if any
 lyrcnt = board.GetCopperLayerCount();
@@ -105,15 +109,10 @@ for innerlyr in range ( 1, lyrcnt-1 ):
     popt.SetSkipPlotNPTH_Pads( True );
     pctl.SetLayer(innerlyr)
     lyrname = 'inner%s' % innerlyr
-    pctl.OpenPlotfile(lyrname, PLOT_FORMAT_GERBER, "inner")
-    print 'plot %s' % pctl.GetPlotFileName()
-    if pctl.PlotLayer() == False:
+    if pctl.AddToJob(plot_job, lyrname, PLOT_FORMAT_GERBER, "inner") == False:
         print "plot error"
-
-
-# At the end you have to close the last plot, otherwise you don't know when
-# the object will be recycled!
-pctl.ClosePlot()
+        continue
+    print 'plot %s' % pctl.GetPlotFileName()
 
 # Fabricators need drill files.
 # sometimes a drill map file is asked (for verification purpose)
@@ -134,7 +133,12 @@ drlwriter.SetFormat( metricFmt )
 genDrl = True
 genMap = True
 print 'create drill and map files in %s' % pctl.GetPlotDirName()
-drlwriter.CreateDrillandMapFilesSet( pctl.GetPlotDirName(), genDrl, genMap );
+plot_job.AddDrillFiles( drlwriter, pctl.GetPlotDirName(), genDrl, genMap );
+
+# Now create all the files; the board and the drill writer must not be
+# changed until Run() returns
+if plot_job.Run() == False:
+    print "plot error"
 
 # One can create a text file to report drill statistics
 rptfn = pctl.GetPlotDirName() + 'drill_report.rpt'
@@ -57,22 +57,11 @@ void SCH_EDIT_FRAME::GetSchematicConnections( std::vector< wxPoint >& aConnectio
 
 bool SCH_EDIT_FRAME::TestDanglingEnds()
 {
-    std::vector<DANGLING_END_ITEM> endPoints;
-    bool hasStateChanged = false;
-
-    for( SCH_ITEM* item = GetScreen()->GetDrawList().begin(); item; item = item->Next() )
-        item->GetEndPoints( endPoints );
-
-    for( SCH_ITEM* item = GetScreen()->GetDrawList().begin(); item; item = item->Next() )
-    {
-        if( item->UpdateDanglingState( endPoints ) )
-        {
-            GetCanvas()->GetView()->Update( item, KIGFX::REPAINT );
-            hasStateChanged = true;
-        }
-    }
-
-    return hasStateChanged;
+    return GetScreen()->TestDanglingEnds( [this]( SCH_ITEM* aItem )
+                                          {
+                                              GetCanvas()->GetView()->Update( aItem,
+                                                                              KIGFX::REPAINT );
+                                          } );
 }
 
 
@@ -19,9 +19,7 @@
  */
 
 #include <list>
-#include <thread>
 #include <algorithm>
-#include <future>
 #include <vector>
 #include <unordered_map>
 #include <profile.h>
@@ -38,11 +36,13 @@
 #include <sch_sheet.h>
 #include <sch_sheet_path.h>
 #include <sch_text.h>
+#include <thread_pool.h>
+#include <trigo.h>
 
 #include <connection_graph.h>
 
 
-bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
+bool CONNECTION_SUBGRAPH::ResolveDrivers( std::vector<SCH_MARKER*>* aMarkers )
 {
     int highest_priority = -1;
     std::vector<SCH_ITEM*> candidates;
@@ -134,7 +134,7 @@ bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
     else
         m_driver_connection = nullptr;
 
-    if( aCreateMarkers && m_multiple_drivers )
+    if( aMarkers && m_multiple_drivers )
     {
         // First check if all the candidates are actually the same
         bool same = true;
@@ -169,20 +169,19 @@ bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
                       candidates[1]->GetPosition();
 
             auto marker = new SCH_MARKER();
-            marker->SetTimeStamp( GetNewTimeStamp() );
             marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
             marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
             marker->SetData( ERCE_DRIVER_CONFLICT, p0, msg, p1 );
 
-            m_sheet.LastScreen()->Append( marker );
+            aMarkers->push_back( marker );
 
-            // If aCreateMarkers is true, then this is part of ERC check, so we
+            // If aMarkers is given, then this is part of ERC check, so we
             // should return false even if the driver was assigned
             return false;
         }
     }
 
-    return aCreateMarkers || ( m_driver != nullptr );
+    return aMarkers || ( m_driver != nullptr );
 }
 
 
@@ -352,6 +351,21 @@ bool CONNECTION_GRAPH::m_allowRealTime = true;
 
 void CONNECTION_GRAPH::Reset()
 {
+    // Absorbed subgraphs are not in m_subgraphs any more, but all of them were driven
+    std::unordered_set<CONNECTION_SUBGRAPH*> absorbed;
+
+    for( const auto& it : m_net_name_to_subgraphs_map )
+    {
+        for( CONNECTION_SUBGRAPH* subgraph : it.second )
+        {
+            if( subgraph->m_absorbed )
+                absorbed.insert( subgraph );
+        }
+    }
+
+    for( auto subgraph : absorbed )
+        delete subgraph;
+
     for( auto subgraph : m_subgraphs )
         delete subgraph;
 
@@ -367,37 +381,82 @@ void CONNECTION_GRAPH::Reset()
     m_net_name_to_subgraphs_map.clear();
     m_local_label_cache.clear();
     m_global_label_cache.clear();
+    m_item_to_subgraphs_map.clear();
+    m_link_name_to_subgraphs_map.clear();
+    m_sheet_paths.clear();
+    m_sheet_names.clear();
+    m_bus_alias_members.clear();
     m_last_net_code = 1;
     m_last_bus_code = 1;
     m_last_subgraph_code = 1;
 }
 
 
+/**
+ * @return the members of all the bus aliases of the sheets of \a aSheetList, by alias name.
+ */
+static std::map<wxString, std::vector<wxString>> getBusAliasMembers(
+        const SCH_SHEET_LIST& aSheetList )
+{
+    std::map<wxString, std::vector<wxString>> members;
+
+    for( const auto& sheet : aSheetList )
+    {
+        for( const auto& alias : sheet.LastScreen()->GetBusAliases() )
+            members[ alias->GetName() ] = alias->Members();
+    }
+
+    return members;
+}
+
+
 void CONNECTION_GRAPH::Recalculate( SCH_SHEET_LIST aSheetList, bool aUnconditional )
 {
     PROF_COUNTER recalc_time;
     PROF_COUNTER update_items;
 
-    if( aUnconditional )
-        Reset();
+    std::vector< std::pair< SCH_SHEET_PATH, std::vector<SCH_ITEM*> > > updates;
 
-    for( const auto& sheet : aSheetList )
+    bool incremental = !aUnconditional && invalidateSubgraphs( aSheetList, updates );
+
+    // The invalidated part of the graph is built on its own, and merged into the rest of
+    // the graph, which is kept here meanwhile
+    std::unordered_set<SCH_ITEM*>                     items;
+    std::vector<CONNECTION_SUBGRAPH*>                 subgraphs;
+    std::vector<CONNECTION_SUBGRAPH*>                 driver_subgraphs;
+    std::vector<std::pair<SCH_SHEET_PATH, SCH_PIN*>>  invisible_power_pins;
+
+    std::unordered_map<SCH_SHEET_PATH, std::vector<CONNECTION_SUBGRAPH*>> sheet_subgraphs;
+
+    if( incremental )
     {
-        std::vector<SCH_ITEM*> items;
+        std::swap( items, m_items );
+        std::swap( subgraphs, m_subgraphs );
+        std::swap( driver_subgraphs, m_driver_subgraphs );
+        std::swap( sheet_subgraphs, m_sheet_to_subgraphs_map );
+        std::swap( invisible_power_pins, m_invisible_power_pins );
+    }
+    else
+    {
+        Reset();
 
-        for( auto item = sheet.LastScreen()->GetDrawItems();
-             item; item = item->Next() )
+        for( const auto& sheet : aSheetList )
         {
-            if( item->IsConnectable() &&
-                ( aUnconditional || item->IsConnectivityDirty() ) )
+            std::vector<SCH_ITEM*> sheet_items;
+
+            for( auto item = sheet.LastScreen()->GetDrawItems(); item; item = item->Next() )
             {
-                items.push_back( item );
+                if( item->IsConnectable() )
+                    sheet_items.push_back( item );
             }
-        }
 
-        updateItemConnectivity( sheet, items );
+            updates.emplace_back( sheet, std::move( sheet_items ) );
+        }
     }
 
+    for( auto& update : updates )
+        updateItemConnectivity( update.first, std::move( update.second ) );
+
     update_items.Stop();
     wxLogTrace( "CONN_PROFILE", "UpdateItemConnectivity() %0.4f ms", update_items.msecs() );
 
@@ -414,11 +473,47 @@ void CONNECTION_GRAPH::Recalculate( SCH_SHEET_LIST aSheetList, bool aUncondition
 
     buildConnectionGraph();
 
+    if( incremental )
+    {
+        items.insert( m_items.begin(), m_items.end() );
+        std::swap( items, m_items );
+
+        subgraphs.insert( subgraphs.end(), m_subgraphs.begin(), m_subgraphs.end() );
+        std::swap( subgraphs, m_subgraphs );
+
+        driver_subgraphs.insert( driver_subgraphs.end(), m_driver_subgraphs.begin(),
+                                 m_driver_subgraphs.end() );
+        std::swap( driver_subgraphs, m_driver_subgraphs );
+
+        invisible_power_pins.insert( invisible_power_pins.end(), m_invisible_power_pins.begin(),
+                                     m_invisible_power_pins.end() );
+        std::swap( invisible_power_pins, m_invisible_power_pins );
+
+        for( const auto& it : m_sheet_to_subgraphs_map )
+        {
+            auto& vec = sheet_subgraphs[ it.first ];
+            vec.insert( vec.end(), it.second.begin(), it.second.end() );
+        }
+
+        std::swap( sheet_subgraphs, m_sheet_to_subgraphs_map );
+    }
+
+    recacheNetCodes();
+
+    m_sheet_paths.assign( aSheetList.begin(), aSheetList.end() );
+    m_sheet_names.clear();
+
+    for( const auto& sheet : aSheetList )
+        m_sheet_names.push_back( sheet.PathHumanReadable() );
+
+    m_bus_alias_members = getBusAliasMembers( aSheetList );
+
     build_graph.Stop();
     wxLogTrace( "CONN_PROFILE", "BuildConnectionGraph() %0.4f ms", build_graph.msecs() );
 
     recalc_time.Stop();
-    wxLogTrace( "CONN_PROFILE", "Recalculate time %0.4f ms", recalc_time.msecs() );
+    wxLogTrace( "CONN_PROFILE", "Recalculate time %0.4f ms (%s)", recalc_time.msecs(),
+                incremental ? "incremental" : "full" );
 
 #ifndef DEBUG
     // Pressure relief valve for release builds
@@ -438,6 +533,41 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
 {
     std::unordered_map< wxPoint, std::vector<SCH_ITEM*> > connection_map;
 
+    auto add_sheet_pin = [&]( SCH_SHEET_PIN* aPin )
+    {
+        if( !aPin->Connection( aSheet ) )
+        {
+            aPin->InitializeConnection( aSheet );
+        }
+
+        aPin->ConnectedItems().clear();
+        aPin->Connection( aSheet )->Reset();
+
+        connection_map[ aPin->GetTextPos() ].push_back( aPin );
+        m_items.insert( aPin );
+    };
+
+    auto add_component_pin = [&]( SCH_PIN* aPin )
+    {
+        aPin->InitializeConnection( aSheet );
+
+        wxPoint pos = aPin->GetTransformedPosition();
+
+        // because calling the first time is not thread-safe
+        aPin->GetDefaultNetName( aSheet );
+        aPin->ConnectedItems().clear();
+
+        // Invisible power pins need to be post-processed later
+
+        if( aPin->IsPowerConnection() && !aPin->IsVisible() )
+            m_invisible_power_pins.emplace_back( std::make_pair( aSheet, aPin ) );
+
+        connection_map[ pos ].push_back( aPin );
+        m_items.insert( aPin );
+    };
+
+    // The pins of components and sheets may also be given on their own, when only some of
+    // them need to be connected again
     for( auto item : aItemList )
     {
         std::vector< wxPoint > points;
@@ -447,45 +577,25 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
         if( item->Type() == SCH_SHEET_T )
         {
             for( auto& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
-            {
-                if( !pin.Connection( aSheet ) )
-                {
-                    pin.InitializeConnection( aSheet );
-                }
-
-                pin.ConnectedItems().clear();
-                pin.Connection( aSheet )->Reset();
-
-                connection_map[ pin.GetTextPos() ].push_back( &pin );
-                m_items.insert( &pin );
-            }
+                add_sheet_pin( &pin );
+        }
+        else if( item->Type() == SCH_SHEET_PIN_T )
+        {
+            add_sheet_pin( static_cast<SCH_SHEET_PIN*>( item ) );
         }
         else if( item->Type() == SCH_COMPONENT_T )
         {
             SCH_COMPONENT* component = static_cast<SCH_COMPONENT*>( item );
-            TRANSFORM t = component->GetTransform();
 
             // Assumption: we don't need to call UpdatePins() here because anything
             // that would change the pins of the component will have called it already
 
             for( SCH_PIN& pin : component->GetPins() )
-            {
-                pin.InitializeConnection( aSheet );
-
-                wxPoint pos = t.TransformCoordinate( pin.GetPosition() ) + component->GetPosition();
-
-                // because calling the first time is not thread-safe
-                pin.GetDefaultNetName( aSheet );
-                pin.ConnectedItems().clear();
-
-                // Invisible power pins need to be post-processed later
-
-                if( pin.IsPowerConnection() && !pin.IsVisible() )
-                    m_invisible_power_pins.emplace_back( std::make_pair( aSheet, &pin ) );
-
-                connection_map[ pos ].push_back( &pin );
-                m_items.insert( &pin );
-            }
+                add_component_pin( &pin );
+        }
+        else if( item->Type() == SCH_PIN_T )
+        {
+            add_component_pin( static_cast<SCH_PIN*>( item ) );
         }
         else
         {
@@ -503,7 +613,6 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
                 conn->SetType( CONNECTION_BUS );
                 break;
 
-            case SCH_PIN_T:
             case SCH_BUS_WIRE_ENTRY_T:
                 conn->SetType( CONNECTION_NET );
                 break;
@@ -731,12 +840,6 @@ void CONNECTION_GRAPH::buildConnectionGraph()
 
     // Resolve drivers for subgraphs and propagate connectivity info
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( m_subgraphs.size() + 3 ) / 4 );
-
-    std::atomic<size_t> nextSubgraph( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
     std::vector<CONNECTION_SUBGRAPH*> dirty_graphs;
 
     std::copy_if( m_subgraphs.begin(), m_subgraphs.end(), std::back_inserter( dirty_graphs ),
@@ -744,106 +847,90 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                       return candidate->m_dirty;
                   } );
 
-    auto update_lambda = [&nextSubgraph, &dirty_graphs]() -> size_t
+    // Small subgraphs are cheap, so hand them out a few at a time
+    ParallelFor( dirty_graphs.size(), [&dirty_graphs]( size_t subgraphId )
     {
-        for( size_t subgraphId = nextSubgraph++; subgraphId < dirty_graphs.size(); subgraphId = nextSubgraph++ )
-        {
-            auto subgraph = dirty_graphs[subgraphId];
+        auto subgraph = dirty_graphs[subgraphId];
 
-            if( !subgraph->m_dirty )
-                continue;
+        if( !subgraph->m_dirty )
+            return;
 
-            // Special processing for some items
-            for( auto item : subgraph->m_items )
+        // Special processing for some items
+        for( auto item : subgraph->m_items )
+        {
+            switch( item->Type() )
             {
-                switch( item->Type() )
-                {
-                case SCH_NO_CONNECT_T:
-                    subgraph->m_no_connect = item;
-                    break;
+            case SCH_NO_CONNECT_T:
+                subgraph->m_no_connect = item;
+                break;
 
-                case SCH_BUS_WIRE_ENTRY_T:
-                    subgraph->m_bus_entry = item;
-                    break;
+            case SCH_BUS_WIRE_ENTRY_T:
+                subgraph->m_bus_entry = item;
+                break;
 
-                case SCH_PIN_T:
-                {
-                    auto pin = static_cast<SCH_PIN*>( item );
+            case SCH_PIN_T:
+            {
+                auto pin = static_cast<SCH_PIN*>( item );
 
-                    if( pin->GetType() == PIN_NC )
-                        subgraph->m_no_connect = item;
+                if( pin->GetType() == PIN_NC )
+                    subgraph->m_no_connect = item;
 
-                    break;
-                }
+                break;
+            }
 
-                default:
-                    break;
-                }
+            default:
+                break;
             }
+        }
 
-            if( !subgraph->ResolveDrivers() )
+        if( !subgraph->ResolveDrivers() )
+        {
+            subgraph->m_dirty = false;
+        }
+        else
+        {
+            // Now the subgraph has only one driver
+            SCH_ITEM* driver = subgraph->m_driver;
+            SCH_SHEET_PATH sheet = subgraph->m_sheet;
+            SCH_CONNECTION* connection = driver->Connection( sheet );
+
+            // TODO(JE) This should live in SCH_CONNECTION probably
+            switch( driver->Type() )
             {
-                subgraph->m_dirty = false;
+            case SCH_LABEL_T:
+            case SCH_GLOBAL_LABEL_T:
+            case SCH_HIER_LABEL_T:
+            {
+                auto text = static_cast<SCH_TEXT*>( driver );
+                connection->ConfigureFromLabel( text->GetShownText() );
+                break;
             }
-            else
+            case SCH_SHEET_PIN_T:
             {
-                // Now the subgraph has only one driver
-                SCH_ITEM* driver = subgraph->m_driver;
-                SCH_SHEET_PATH sheet = subgraph->m_sheet;
-                SCH_CONNECTION* connection = driver->Connection( sheet );
-
-                // TODO(JE) This should live in SCH_CONNECTION probably
-                switch( driver->Type() )
-                {
-                case SCH_LABEL_T:
-                case SCH_GLOBAL_LABEL_T:
-                case SCH_HIER_LABEL_T:
-                {
-                    auto text = static_cast<SCH_TEXT*>( driver );
-                    connection->ConfigureFromLabel( text->GetShownText() );
-                    break;
-                }
-                case SCH_SHEET_PIN_T:
-                {
-                    auto pin = static_cast<SCH_SHEET_PIN*>( driver );
-                    connection->ConfigureFromLabel( pin->GetShownText() );
-                    break;
-                }
-                case SCH_PIN_T:
-                {
-                    auto pin = static_cast<SCH_PIN*>( driver );
-                    // NOTE(JE) GetDefaultNetName is not thread-safe.
-                    connection->ConfigureFromLabel( pin->GetDefaultNetName( sheet ) );
-
-                    break;
-                }
-                default:
-                    wxLogTrace( "CONN", "Driver type unsupported: %s",
-                                driver->GetSelectMenuText( MILLIMETRES ) );
-                    break;
-                }
-
-                connection->SetDriver( driver );
-                connection->ClearDirty();
-
-                subgraph->m_dirty = false;
+                auto pin = static_cast<SCH_SHEET_PIN*>( driver );
+                connection->ConfigureFromLabel( pin->GetShownText() );
+                break;
             }
-        }
+            case SCH_PIN_T:
+            {
+                auto pin = static_cast<SCH_PIN*>( driver );
+                // NOTE(JE) GetDefaultNetName is not thread-safe.
+                connection->ConfigureFromLabel( pin->GetDefaultNetName( sheet ) );
 
-        return 1;
-    };
+                break;
+            }
+            default:
+                wxLogTrace( "CONN", "Driver type unsupported: %s",
+                            driver->GetSelectMenuText( MILLIMETRES ) );
+                break;
+            }
 
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
+            connection->SetDriver( driver );
+            connection->ClearDirty();
 
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
+            subgraph->m_dirty = false;
+        }
+    }, 4 );
 
     // Now discard any non-driven subgraphs from further consideration
 
@@ -1372,8 +1459,6 @@ void CONNECTION_GRAPH::buildConnectionGraph()
         }
     }
 
-    m_net_code_to_subgraphs_map.clear();
-
     for( auto subgraph : m_driver_subgraphs )
     {
         // Every driven subgraph should have been marked by now
@@ -1383,18 +1468,558 @@ void CONNECTION_GRAPH::buildConnectionGraph()
             // Reset to false so no complaints come up later
             subgraph->m_dirty = false;
         }
+    }
+
+    m_subgraphs.erase( std::remove_if( m_subgraphs.begin(), m_subgraphs.end(),
+                                 [&] ( const CONNECTION_SUBGRAPH* sg ) {
+                                         return sg->m_absorbed;
+                                     } ), m_subgraphs.end() );
+
+    for( auto subgraph : m_subgraphs )
+        indexSubgraph( subgraph );
+}
+
 
+void CONNECTION_GRAPH::recacheNetCodes()
+{
+    m_net_code_to_subgraphs_map.clear();
+
+    for( auto subgraph : m_driver_subgraphs )
+    {
         if( subgraph->m_driver_connection->IsBus() )
             continue;
 
         int code = subgraph->m_driver_connection->NetCode();
         m_net_code_to_subgraphs_map[ code ].push_back( subgraph );
     }
+}
 
-    m_subgraphs.erase( std::remove_if( m_subgraphs.begin(), m_subgraphs.end(),
-                                 [&] ( const CONNECTION_SUBGRAPH* sg ) {
-                                         return sg->m_absorbed;
-                                     } ), m_subgraphs.end() );
+
+/**
+ * Adds the names of \a aConnection and of all its members to \a aNames, with and without
+ * their sheet path.
+ */
+static void collectConnectionNames( const SCH_CONNECTION& aConnection,
+                                    std::vector<wxString>& aNames )
+{
+    aNames.push_back( aConnection.Name() );
+    aNames.push_back( aConnection.Name( true ) );
+
+    for( const auto& member : aConnection.Members() )
+        collectConnectionNames( *member, aNames );
+}
+
+
+/**
+ * Adds the names \a aItem can link subgraphs by to \a aNames, if it is a potential driver:
+ * the text of labels and sheet pins and the name of power pins, with the members of the
+ * buses they define, or the default net name of other pins.
+ */
+static void collectDriverNames( SCH_ITEM* aItem, const SCH_SHEET_PATH& aSheet,
+                                std::vector<wxString>& aNames )
+{
+    wxString name;
+
+    switch( aItem->Type() )
+    {
+    case SCH_LABEL_T:
+    case SCH_GLOBAL_LABEL_T:
+    case SCH_HIER_LABEL_T:
+    case SCH_SHEET_PIN_T:
+    {
+        auto text = static_cast<SCH_TEXT*>( aItem );
+        aNames.push_back( text->GetText() );
+        name = text->GetShownText();
+        break;
+    }
+
+    case SCH_PIN_T:
+    {
+        auto pin = static_cast<SCH_PIN*>( aItem );
+
+        if( !pin->IsPowerConnection() )
+        {
+            aNames.push_back( pin->GetDefaultNetName( aSheet ) );
+            return;
+        }
+
+        name = pin->GetName();
+        break;
+    }
+
+    default:
+        return;
+    }
+
+    SCH_CONNECTION connection( aItem, aSheet );
+    connection.ConfigureFromLabel( name );
+    collectConnectionNames( connection, aNames );
+}
+
+
+/**
+ * Adds the connectable items of \a aScreen which may be connected to \a aItem to \a aItems:
+ * the items with a connection point in common with it, the wires and buses it lies on and,
+ * if it is a wire or a bus, the labels and bus entries lying on it.  The pins of components
+ * and sheets are added instead of their parent.  Errs on the side of adding too much.
+ */
+static void collectTouchingItems( SCH_SCREEN* aScreen, SCH_ITEM* aItem,
+                                  std::vector<SCH_ITEM*>& aItems )
+{
+    std::vector<wxPoint> points;
+
+    switch( aItem->Type() )
+    {
+    case SCH_PIN_T:
+        points.push_back( static_cast<SCH_PIN*>( aItem )->GetTransformedPosition() );
+        break;
+
+    case SCH_SHEET_PIN_T:
+        points.push_back( static_cast<SCH_SHEET_PIN*>( aItem )->GetTextPos() );
+        break;
+
+    default:
+        aItem->GetConnectionPoints( points );
+        break;
+    }
+
+    if( points.empty() )
+        return;
+
+    bool     isSegment = ( aItem->Type() == SCH_LINE_T && points.size() == 2 );
+    EDA_RECT area( points[0], wxSize( 0, 0 ) );
+
+    for( const wxPoint& point : points )
+        area.Merge( point );
+
+    auto touches = [&]( const wxPoint& aPoint ) -> bool
+    {
+        if( isSegment && IsPointOnSegment( points[0], points[1], aPoint ) )
+            return true;
+
+        return std::find( points.begin(), points.end(), aPoint ) != points.end();
+    };
+
+    for( SCH_ITEM* item : aScreen->Items().Query( area ) )
+    {
+        if( !item->IsConnectable() )
+            continue;
+
+        switch( item->Type() )
+        {
+        case SCH_COMPONENT_T:
+            for( SCH_PIN& pin : static_cast<SCH_COMPONENT*>( item )->GetPins() )
+            {
+                if( touches( pin.GetTransformedPosition() ) )
+                    aItems.push_back( &pin );
+            }
+
+            break;
+
+        case SCH_SHEET_T:
+            for( SCH_SHEET_PIN& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+            {
+                if( touches( pin.GetTextPos() ) )
+                    aItems.push_back( &pin );
+            }
+
+            break;
+
+        case SCH_LINE_T:
+        {
+            auto line = static_cast<SCH_LINE*>( item );
+
+            for( const wxPoint& point : points )
+            {
+                if( IsPointOnSegment( line->GetStartPoint(), line->GetEndPoint(), point ) )
+                {
+                    aItems.push_back( item );
+                    break;
+                }
+            }
+
+            break;
+        }
+
+        default:
+        {
+            std::vector<wxPoint> itemPoints;
+            item->GetConnectionPoints( itemPoints );
+
+            for( const wxPoint& point : itemPoints )
+            {
+                if( touches( point ) )
+                {
+                    aItems.push_back( item );
+                    break;
+                }
+            }
+
+            break;
+        }
+        }
+    }
+}
+
+
+void CONNECTION_GRAPH::indexSubgraph( CONNECTION_SUBGRAPH* aSubgraph )
+{
+    std::vector<wxString>& names = aSubgraph->m_link_names;
+
+    names.clear();
+
+    for( SCH_ITEM* item : aSubgraph->m_items )
+    {
+        m_item_to_subgraphs_map[ item ].push_back( aSubgraph );
+        collectDriverNames( item, aSubgraph->m_sheet, names );
+    }
+
+    if( aSubgraph->m_driver_connection )
+        collectConnectionNames( *aSubgraph->m_driver_connection, names );
+
+    std::sort( names.begin(), names.end() );
+    names.erase( std::unique( names.begin(), names.end() ), names.end() );
+
+    for( const wxString& name : names )
+        m_link_name_to_subgraphs_map[ name ].insert( aSubgraph );
+}
+
+
+bool CONNECTION_GRAPH::invalidateSubgraphs( const SCH_SHEET_LIST& aSheetList,
+        std::vector< std::pair< SCH_SHEET_PATH, std::vector<SCH_ITEM*> > >& aUpdates )
+{
+    if( m_subgraphs.empty() || aSheetList.size() != m_sheet_paths.size() )
+        return false;
+
+    // The net names depend on the sheet names, and the bus members on the aliases
+    for( size_t ii = 0; ii < aSheetList.size(); ++ii )
+    {
+        if( aSheetList[ii] != m_sheet_paths[ii]
+                || aSheetList[ii].PathHumanReadable() != m_sheet_names[ii] )
+        {
+            return false;
+        }
+    }
+
+    if( getBusAliasMembers( aSheetList ) != m_bus_alias_members )
+        return false;
+
+    // Find the changed items of each screen, and the removed ones.  Components and sheets are
+    // connected through their pins, which are the items of the graph.
+    std::unordered_map<SCH_SCREEN*, std::vector<SCH_SHEET_PATH>> screen_sheets;
+    std::unordered_map<SCH_SCREEN*, std::vector<SCH_ITEM*>>      changed_items;
+    std::vector<SCH_ITEM*>                                       dirty_items;
+    std::unordered_set<SCH_ITEM*>                                alive_items;
+    std::unordered_set<SCH_ITEM*>                                removed_items;
+
+    for( const auto& sheet : aSheetList )
+    {
+        SCH_SCREEN* screen = sheet.LastScreen();
+        auto&       sheets = screen_sheets[ screen ];
+
+        sheets.push_back( sheet );
+
+        if( sheets.size() > 1 )
+            continue;
+
+        auto& changed = changed_items[ screen ];
+
+        for( auto item = screen->GetDrawItems(); item; item = item->Next() )
+        {
+            if( !item->IsConnectable() )
+                continue;
+
+            bool dirty = item->IsConnectivityDirty();
+
+            if( dirty )
+                dirty_items.push_back( item );
+
+            auto add_item = [&]( SCH_ITEM* aItem )
+            {
+                alive_items.insert( aItem );
+
+                if( dirty || !m_items.count( aItem ) )
+                    changed.push_back( aItem );
+            };
+
+            if( item->Type() == SCH_COMPONENT_T )
+            {
+                for( SCH_PIN& pin : static_cast<SCH_COMPONENT*>( item )->GetPins() )
+                    add_item( &pin );
+            }
+            else if( item->Type() == SCH_SHEET_T )
+            {
+                for( SCH_SHEET_PIN& pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+                    add_item( &pin );
+            }
+            else
+            {
+                add_item( item );
+            }
+        }
+    }
+
+    // Removed items may have been deleted: they are only used as keys from here on
+    for( SCH_ITEM* item : m_items )
+    {
+        if( !alive_items.count( item ) )
+            removed_items.insert( item );
+    }
+
+    // Gather the subgraphs to rebuild
+    std::unordered_set<const CONNECTION_SUBGRAPH*> invalid;
+    std::vector<CONNECTION_SUBGRAPH*>              invalid_list;
+    std::unordered_set<wxString>                   invalid_names;
+
+    auto invalidate = [&]( CONNECTION_SUBGRAPH* aSubgraph )
+    {
+        while( aSubgraph->m_absorbed )
+            aSubgraph = aSubgraph->m_absorbed_by;
+
+        if( invalid.insert( aSubgraph ).second )
+            invalid_list.push_back( aSubgraph );
+    };
+
+    auto invalidate_item = [&]( SCH_ITEM* aItem )
+    {
+        auto it = m_item_to_subgraphs_map.find( aItem );
+
+        if( it != m_item_to_subgraphs_map.end() )
+        {
+            for( CONNECTION_SUBGRAPH* subgraph : it->second )
+                invalidate( subgraph );
+        }
+    };
+
+    auto invalidate_name = [&]( const wxString& aName )
+    {
+        if( !invalid_names.insert( aName ).second )
+            return;
+
+        auto it = m_link_name_to_subgraphs_map.find( aName );
+
+        if( it != m_link_name_to_subgraphs_map.end() )
+        {
+            for( CONNECTION_SUBGRAPH* subgraph : it->second )
+                invalidate( subgraph );
+        }
+    };
+
+    for( SCH_ITEM* item : removed_items )
+        invalidate_item( item );
+
+    std::vector<SCH_ITEM*> touching_items;
+    std::vector<wxString>  names;
+
+    for( const auto& it : changed_items )
+    {
+        SCH_SCREEN*           screen = it.first;
+        const SCH_SHEET_PATH& sheet = screen_sheets[ screen ].front();
+
+        for( SCH_ITEM* item : it.second )
+        {
+            invalidate_item( item );
+
+            // The new names of the item, which may link it to other subgraphs
+            names.clear();
+            collectDriverNames( item, sheet, names );
+
+            for( const wxString& name : names )
+                invalidate_name( name );
+
+            // The items the changed item may be connected to now
+            touching_items.clear();
+            collectTouchingItems( screen, item, touching_items );
+
+            for( SCH_ITEM* touching_item : touching_items )
+                invalidate_item( touching_item );
+        }
+    }
+
+    // Rebuilding most of the graph incrementally would be slower than from scratch
+    size_t max_invalid = m_subgraphs.size() / 2;
+
+    for( size_t ii = 0; ii < invalid_list.size() && invalid_list.size() <= max_invalid; ++ii )
+    {
+        CONNECTION_SUBGRAPH* subgraph = invalid_list[ii];
+
+        for( const wxString& name : subgraph->m_link_names )
+            invalidate_name( name );
+
+        for( const auto& kv : subgraph->m_bus_neighbors )
+        {
+            for( CONNECTION_SUBGRAPH* neighbor : kv.second )
+                invalidate( neighbor );
+        }
+
+        for( const auto& kv : subgraph->m_bus_parents )
+        {
+            for( CONNECTION_SUBGRAPH* parent : kv.second )
+                invalidate( parent );
+        }
+    }
+
+    if( invalid_list.size() > max_invalid )
+        return false;
+
+    wxLogTrace( "CONN_PROFILE", "Invalidated %lu of %lu subgraphs",
+                static_cast<unsigned long>( invalid_list.size() ),
+                static_cast<unsigned long>( m_subgraphs.size() ) );
+
+    // From here on, the graph is updated.  Gather the items to connect again: the remaining
+    // items of the invalidated subgraphs and the changed items, on all the sheets they are on.
+    std::unordered_map<SCH_SHEET_PATH, std::unordered_set<SCH_ITEM*>> sheet_items;
+
+    for( CONNECTION_SUBGRAPH* subgraph : invalid_list )
+    {
+        auto& items = sheet_items[ subgraph->m_sheet ];
+
+        for( SCH_ITEM* item : subgraph->m_items )
+        {
+            if( alive_items.count( item ) )
+                items.insert( item );
+
+            auto it = m_item_to_subgraphs_map.find( item );
+
+            if( it != m_item_to_subgraphs_map.end() )
+            {
+                auto& vec = it->second;
+                vec.erase( std::remove( vec.begin(), vec.end(), subgraph ), vec.end() );
+
+                if( vec.empty() )
+                    m_item_to_subgraphs_map.erase( it );
+            }
+        }
+
+        for( const wxString& name : subgraph->m_link_names )
+        {
+            auto it = m_link_name_to_subgraphs_map.find( name );
+
+            if( it != m_link_name_to_subgraphs_map.end() )
+            {
+                it->second.erase( subgraph );
+
+                if( it->second.empty() )
+                    m_link_name_to_subgraphs_map.erase( it );
+            }
+        }
+    }
+
+    for( const auto& it : changed_items )
+    {
+        for( const auto& sheet : screen_sheets[ it.first ] )
+            sheet_items[ sheet ].insert( it.second.begin(), it.second.end() );
+    }
+
+    for( const auto& sheet : aSheetList )
+    {
+        auto it = sheet_items.find( sheet );
+
+        if( it != sheet_items.end() )
+        {
+            aUpdates.emplace_back( sheet, std::vector<SCH_ITEM*>( it->second.begin(),
+                                                                  it->second.end() ) );
+        }
+    }
+
+    for( SCH_ITEM* item : removed_items )
+    {
+        m_items.erase( item );
+        m_item_to_subgraphs_map.erase( item );
+    }
+
+    // Forget the invalidated subgraphs, and the subgraphs they absorbed
+    auto is_invalid = [&]( const CONNECTION_SUBGRAPH* aSubgraph ) -> bool
+    {
+        while( aSubgraph->m_absorbed )
+            aSubgraph = aSubgraph->m_absorbed_by;
+
+        return invalid.count( aSubgraph ) > 0;
+    };
+
+    std::unordered_set<CONNECTION_SUBGRAPH*> absorbed;
+
+    for( auto it = m_net_name_to_subgraphs_map.begin(); it != m_net_name_to_subgraphs_map.end(); )
+    {
+        auto& vec = it->second;
+
+        for( CONNECTION_SUBGRAPH* subgraph : vec )
+        {
+            if( subgraph->m_absorbed && is_invalid( subgraph ) )
+                absorbed.insert( subgraph );
+        }
+
+        vec.erase( std::remove_if( vec.begin(), vec.end(), is_invalid ), vec.end() );
+
+        if( vec.empty() )
+            it = m_net_name_to_subgraphs_map.erase( it );
+        else
+            ++it;
+    }
+
+    for( auto it = m_local_label_cache.begin(); it != m_local_label_cache.end(); )
+    {
+        auto& vec = it->second;
+        vec.erase( std::remove_if( vec.begin(), vec.end(), is_invalid ), vec.end() );
+
+        if( vec.empty() )
+            it = m_local_label_cache.erase( it );
+        else
+            ++it;
+    }
+
+    for( auto it = m_global_label_cache.begin(); it != m_global_label_cache.end(); )
+    {
+        auto& vec = it->second;
+        vec.erase( std::remove_if( vec.begin(), vec.end(), is_invalid ), vec.end() );
+
+        if( vec.empty() )
+            it = m_global_label_cache.erase( it );
+        else
+            ++it;
+    }
+
+    for( auto it = m_sheet_to_subgraphs_map.begin(); it != m_sheet_to_subgraphs_map.end(); )
+    {
+        auto& vec = it->second;
+        vec.erase( std::remove_if( vec.begin(), vec.end(), is_invalid ), vec.end() );
+
+        if( vec.empty() )
+            it = m_sheet_to_subgraphs_map.erase( it );
+        else
+            ++it;
+    }
+
+    m_subgraphs.erase( std::remove_if( m_subgraphs.begin(), m_subgraphs.end(), is_invalid ),
+                       m_subgraphs.end() );
+
+    m_driver_subgraphs.erase( std::remove_if( m_driver_subgraphs.begin(),
+                                              m_driver_subgraphs.end(), is_invalid ),
+                              m_driver_subgraphs.end() );
+
+    m_invisible_power_pins.erase( std::remove_if( m_invisible_power_pins.begin(),
+                                                  m_invisible_power_pins.end(),
+            [&]( const std::pair<SCH_SHEET_PATH, SCH_PIN*>& aEntry ) -> bool
+            {
+                if( removed_items.count( aEntry.second ) )
+                    return true;
+
+                auto it = sheet_items.find( aEntry.first );
+
+                return it != sheet_items.end() && it->second.count( aEntry.second );
+            } ), m_invisible_power_pins.end() );
+
+    for( CONNECTION_SUBGRAPH* subgraph : absorbed )
+        delete subgraph;
+
+    for( CONNECTION_SUBGRAPH* subgraph : invalid_list )
+        delete subgraph;
+
+    // The changed items are connected again right away
+    for( SCH_ITEM* item : dirty_items )
+        item->SetConnectivityDirty( false );
+
+    return true;
 }
 
 
@@ -1790,60 +2415,92 @@ bool CONNECTION_GRAPH::UsesNewBusFeatures() const
 
 int CONNECTION_GRAPH::RunERC( const ERC_SETTINGS& aSettings, bool aCreateMarkers )
 {
+    // The subgraphs are checked concurrently.  The markers of each subgraph are kept apart
+    // and added to the screens afterwards, in the order of the subgraphs, so that the result
+    // does not depend on the scheduling.
+    std::vector<int>                       error_counts( m_subgraphs.size(), 0 );
+    std::vector<std::vector<SCH_MARKER*>>  markers( m_subgraphs.size() );
+
+    ParallelFor( m_subgraphs.size(), [&]( size_t ii )
+    {
+        std::vector<SCH_MARKER*>* subgraph_markers = aCreateMarkers ? &markers[ii] : nullptr;
+
+        error_counts[ii] = ercCheckSubgraph( m_subgraphs[ii], aSettings, subgraph_markers );
+    }, 16 );
+
     int error_count = 0;
 
-    for( auto&& subgraph : m_subgraphs )
+    for( size_t ii = 0; ii < m_subgraphs.size(); ++ii )
     {
-        // Graph is supposed to be up-to-date before calling RunERC()
-        wxASSERT( !subgraph->m_dirty );
+        SCH_SCREEN* screen = m_subgraphs[ii]->m_sheet.LastScreen();
+
+        for( SCH_MARKER* marker : markers[ii] )
+        {
+            marker->SetTimeStamp( GetNewTimeStamp() );
+            screen->Append( marker );
+        }
+
+        error_count += error_counts[ii];
+    }
+
+    return error_count;
+}
+
 
-        /**
-         * NOTE:
-         *
-         * We could check that labels attached to bus subgraphs follow the
-         * proper format (i.e. actually define a bus).
-         *
-         * This check doesn't need to be here right now because labels
-         * won't actually be connected to bus wires if they aren't in the right
-         * format due to their TestDanglingEnds() implementation.
-         */
+int CONNECTION_GRAPH::ercCheckSubgraph( CONNECTION_SUBGRAPH* aSubgraph,
+                                        const ERC_SETTINGS& aSettings,
+                                        std::vector<SCH_MARKER*>* aMarkers )
+{
+    int error_count = 0;
 
-        if( aSettings.check_bus_driver_conflicts &&
-            !subgraph->ResolveDrivers( aCreateMarkers ) )
-            error_count++;
+    // Graph is supposed to be up-to-date before calling RunERC()
+    wxASSERT( !aSubgraph->m_dirty );
+
+    /**
+     * NOTE:
+     *
+     * We could check that labels attached to bus subgraphs follow the
+     * proper format (i.e. actually define a bus).
+     *
+     * This check doesn't need to be here right now because labels
+     * won't actually be connected to bus wires if they aren't in the right
+     * format due to their TestDanglingEnds() implementation.
+     */
 
-        if( aSettings.check_bus_to_net_conflicts &&
-            !ercCheckBusToNetConflicts( subgraph, aCreateMarkers ) )
-            error_count++;
+    if( aSettings.check_bus_driver_conflicts &&
+        !aSubgraph->ResolveDrivers( aMarkers ) )
+        error_count++;
 
-        if( aSettings.check_bus_entry_conflicts &&
-            !ercCheckBusToBusEntryConflicts( subgraph, aCreateMarkers ) )
-            error_count++;
+    if( aSettings.check_bus_to_net_conflicts &&
+        !ercCheckBusToNetConflicts( aSubgraph, aMarkers ) )
+        error_count++;
 
-        if( aSettings.check_bus_to_bus_conflicts &&
-            !ercCheckBusToBusConflicts( subgraph, aCreateMarkers ) )
-            error_count++;
+    if( aSettings.check_bus_entry_conflicts &&
+        !ercCheckBusToBusEntryConflicts( aSubgraph, aMarkers ) )
+        error_count++;
 
-        // The following checks are always performed since they don't currently
-        // have an option exposed to the user
+    if( aSettings.check_bus_to_bus_conflicts &&
+        !ercCheckBusToBusConflicts( aSubgraph, aMarkers ) )
+        error_count++;
 
-        if( !ercCheckNoConnects( subgraph, aCreateMarkers ) )
-            error_count++;
+    // The following checks are always performed since they don't currently
+    // have an option exposed to the user
 
-        if( !ercCheckLabels( subgraph, aCreateMarkers, aSettings.check_unique_global_labels ) )
-            error_count++;
-    }
+    if( !ercCheckNoConnects( aSubgraph, aMarkers ) )
+        error_count++;
+
+    if( !ercCheckLabels( aSubgraph, aMarkers, aSettings.check_unique_global_labels ) )
+        error_count++;
 
     return error_count;
 }
 
 
 bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                                  bool aCreateMarkers )
+                                                  std::vector<SCH_MARKER*>* aMarkers )
 {
     wxString msg;
     auto sheet = aSubgraph->m_sheet;
-    auto screen = sheet.LastScreen();
 
     SCH_ITEM* net_item = nullptr;
     SCH_ITEM* bus_item = nullptr;
@@ -1883,7 +2540,7 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSu
 
     if( net_item && bus_item )
     {
-        if( aCreateMarkers )
+        if( aMarkers )
         {
             msg.Printf( _( "%s and %s are graphically connected but cannot"
                            " electrically connect because one is a bus and"
@@ -1892,14 +2549,13 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSu
                         net_item->GetSelectMenuText( m_frame->GetUserUnits() ) );
 
             auto marker = new SCH_MARKER();
-            marker->SetTimeStamp( GetNewTimeStamp() );
             marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
             marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_ERROR );
             marker->SetData( ERCE_BUS_TO_NET_CONFLICT,
                              net_item->GetPosition(), msg,
                              bus_item->GetPosition() );
 
-            screen->Append( marker );
+            aMarkers->push_back( marker );
         }
 
         return false;
@@ -1910,11 +2566,10 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSu
 
 
 bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                                  bool aCreateMarkers )
+                                                  std::vector<SCH_MARKER*>* aMarkers )
 {
     wxString msg;
     auto sheet = aSubgraph->m_sheet;
-    auto screen = sheet.LastScreen();
 
     SCH_ITEM* label = nullptr;
     SCH_ITEM* port = nullptr;
@@ -1965,7 +2620,7 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSu
 
         if( !match )
         {
-            if( aCreateMarkers )
+            if( aMarkers )
             {
                 msg.Printf( _( "%s and %s are graphically connected but do "
                                "not share any bus members" ),
@@ -1973,14 +2628,13 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSu
                             port->GetSelectMenuText( m_frame->GetUserUnits() ) );
 
                 auto marker = new SCH_MARKER();
-                marker->SetTimeStamp( GetNewTimeStamp() );
                 marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
                 marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_ERROR );
                 marker->SetData( ERCE_BUS_TO_BUS_CONFLICT,
                                  label->GetPosition(), msg,
                                  port->GetPosition() );
 
-                screen->Append( marker );
+                aMarkers->push_back( marker );
             }
 
             return false;
@@ -1992,12 +2646,11 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSu
 
 
 bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                                       bool aCreateMarkers )
+                                                       std::vector<SCH_MARKER*>* aMarkers )
 {
     wxString msg;
     bool conflict = false;
     auto sheet = aSubgraph->m_sheet;
-    auto screen = sheet.LastScreen();
 
     SCH_BUS_WIRE_ENTRY* bus_entry = nullptr;
     SCH_ITEM* bus_wire = nullptr;
@@ -2042,7 +2695,7 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH
 
     if( conflict )
     {
-        if( aCreateMarkers )
+        if( aMarkers )
         {
             msg.Printf( _( "%s (%s) is connected to %s (%s) but is not a member of the bus" ),
                         bus_entry->GetSelectMenuText( m_frame->GetUserUnits() ),
@@ -2051,14 +2704,13 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH
                         bus_wire->Connection( sheet )->Name() );
 
             auto marker = new SCH_MARKER();
-            marker->SetTimeStamp( GetNewTimeStamp() );
             marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
             marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
             marker->SetData( ERCE_BUS_ENTRY_CONFLICT,
                              bus_entry->GetPosition(), msg,
                              bus_entry->GetPosition() );
 
-            screen->Append( marker );
+            aMarkers->push_back( marker );
         }
 
         return false;
@@ -2070,11 +2722,10 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH
 
 // TODO(JE) Check sheet pins here too?
 bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
-                                           bool aCreateMarkers )
+                                           std::vector<SCH_MARKER*>* aMarkers )
 {
     wxString msg;
     auto sheet = aSubgraph->m_sheet;
-    auto screen = sheet.LastScreen();
 
     if( aSubgraph->m_no_connect != nullptr )
     {
@@ -2109,7 +2760,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
 
         if( pin && has_invalid_items )
         {
-            if( aCreateMarkers )
+            if( aMarkers )
             {
                 wxPoint pos = pin->GetTransformedPosition();
 
@@ -2118,12 +2769,11 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
                         GetChars( pin->GetParentComponent()->GetRef( &aSubgraph->m_sheet ) ) );
 
                 auto marker = new SCH_MARKER();
-                marker->SetTimeStamp( GetNewTimeStamp() );
                 marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
                 marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
                 marker->SetData( ERCE_NOCONNECT_CONNECTED, pos, msg, pos );
 
-                screen->Append( marker );
+                aMarkers->push_back( marker );
             }
 
             return false;
@@ -2131,19 +2781,18 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
 
         if( !has_other_items )
         {
-            if( aCreateMarkers )
+            if( aMarkers )
             {
                 wxPoint pos = aSubgraph->m_no_connect->GetPosition();
 
                 msg.Printf( _( "No-connect marker is not connected to anything" ) );
 
                 auto marker = new SCH_MARKER();
-                marker->SetTimeStamp( GetNewTimeStamp() );
                 marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
                 marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
                 marker->SetData( ERCE_NOCONNECT_NOT_CONNECTED, pos, msg, pos );
 
-                screen->Append( marker );
+                aMarkers->push_back( marker );
             }
 
             return false;
@@ -2195,7 +2844,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
 
         if( pin && !has_other_connections && pin->GetType() != PIN_NC )
         {
-            if( aCreateMarkers )
+            if( aMarkers )
             {
                 wxPoint pos = pin->GetTransformedPosition();
 
@@ -2204,12 +2853,11 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
                         GetChars( pin->GetParentComponent()->GetRef( &aSubgraph->m_sheet ) ) );
 
                 auto marker = new SCH_MARKER();
-                marker->SetTimeStamp( GetNewTimeStamp() );
                 marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
                 marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
                 marker->SetData( ERCE_PIN_NOT_CONNECTED, pos, msg, pos );
 
-                screen->Append( marker );
+                aMarkers->push_back( marker );
             }
 
             return false;
@@ -2221,7 +2869,8 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
 
 
 bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
-                                       bool aCreateMarkers, bool aCheckGlobalLabels )
+                                       std::vector<SCH_MARKER*>* aMarkers,
+                                       bool aCheckGlobalLabels )
 {
     // Label connection rules:
     // Local labels are flagged if they don't connect to any pins and don't have a no-connect
@@ -2287,9 +2936,8 @@ bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
 
     if( !has_other_connections )
     {
-        if( aCreateMarkers )
+        if( aMarkers )
         {
-            SCH_SCREEN* screen = aSubgraph->m_sheet.LastScreen();
             wxPoint pos = text->GetPosition();
             auto marker = new SCH_MARKER();
 
@@ -2300,12 +2948,11 @@ bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
             msg.Printf( _( "%s %s is not connected anywhere else in the schematic." ),
                         prefix, GetChars( text->ShortenedShownText() ) );
 
-            marker->SetTimeStamp( GetNewTimeStamp() );
             marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
             marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_WARNING );
             marker->SetData( type, pos, msg, pos );
 
-            screen->Append( marker );
+            aMarkers->push_back( marker );
         }
 
         return false;
@@ -21,7 +21,10 @@
 #ifndef _CONNECTION_GRAPH_H
 #define _CONNECTION_GRAPH_H
 
+#include <map>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <common.h>
@@ -38,6 +41,7 @@
 
 class SCH_EDIT_FRAME;
 class SCH_HIERLABEL;
+class SCH_MARKER;
 class SCH_PIN;
 class SCH_SHEET_PIN;
 
@@ -80,10 +84,10 @@ public:
      * If multiple possible drivers exist, picks one according to the priority.
      * If multiple "winners" exist, returns false and sets m_driver to nullptr.
      *
-     * @param aCreateMarkers controls whether ERC markers should be added for conflicts
+     * @param aMarkers is filled with the ERC markers of the conflicts, if not nullptr
      * @return true if m_driver was set, or false if a conflict occurred
      */
-    bool ResolveDrivers( bool aCreateMarkers = false );
+    bool ResolveDrivers( std::vector<SCH_MARKER*>* aMarkers = nullptr );
 
     /**
      * Returns the fully-qualified net name for this subgraph (if one exists)
@@ -188,6 +192,13 @@ public:
 
     // Cache for lookup of any hierarchical ports on this subgraph (for referring up)
     std::vector<SCH_HIERLABEL*> m_hier_ports;
+
+    /**
+     * Every name this subgraph can be linked to other subgraphs by: its net name, the names
+     * of its potential drivers and the members of the buses they define.  Cached for the
+     * incremental updates of the graph, which cannot look at items that may be gone.
+     */
+    std::vector<wxString> m_link_names;
 };
 
 
@@ -206,7 +217,13 @@ public:
     /**
      * Updates the connection graph for the given list of sheets.
      *
-     * @param aSheetList is the list of possibly modified sheets
+     * Unless a full recalculation is requested, only the subgraphs affected by the items
+     * changed since the last update are rebuilt (see invalidateSubgraphs()).  The graph is
+     * still rebuilt from scratch when the hierarchy or the bus aliases have changed, or when
+     * most of it is affected anyway.
+     *
+     * @param aSheetList is the list of possibly modified sheets.  It must hold the whole
+     *                   hierarchy for the graph to be updated incrementally.
      * @param aUnconditional is true if an unconditional full recalculation should be done
      */
     void Recalculate( SCH_SHEET_LIST aSheetList, bool aUnconditional = false );
@@ -284,6 +301,21 @@ private:
     std::unordered_map<wxString,
                        std::vector<CONNECTION_SUBGRAPH*>> m_net_name_to_subgraphs_map;
 
+    /// The subgraphs each item is in, one per sheet the item appears on
+    std::unordered_map<SCH_ITEM*, std::vector<CONNECTION_SUBGRAPH*>> m_item_to_subgraphs_map;
+
+    /// Reverse lookup of CONNECTION_SUBGRAPH::m_link_names
+    std::unordered_map<wxString,
+                       std::unordered_set<CONNECTION_SUBGRAPH*>> m_link_name_to_subgraphs_map;
+
+    /// The sheets the graph was last updated for, and their human readable paths
+    std::vector<SCH_SHEET_PATH> m_sheet_paths;
+
+    std::vector<wxString> m_sheet_names;
+
+    /// The members of each bus alias when the graph was last updated
+    std::map<wxString, std::vector<wxString>> m_bus_alias_members;
+
     int m_last_net_code;
 
     int m_last_bus_code;
@@ -340,6 +372,35 @@ private:
      */
     void buildConnectionGraph();
 
+    /**
+     * Removes the subgraphs affected by the changes since the last update from the graph, so
+     * that they can be built again from their items on their own.
+     *
+     * The changed items are the ones flagged with SCH_ITEM::IsConnectivityDirty(), and the
+     * ones added or removed.  The subgraphs which contain them or touch them are invalidated,
+     * along with every subgraph linked to those by a name (labels, power pins, sheet pins,
+     * bus members or weak net names) or a bus neighbor link, since all the links between
+     * subgraphs are made through these.  Subgraphs which are not invalidated keep their
+     * drivers and net names.
+     *
+     * @param aSheetList is the whole hierarchy
+     * @param aUpdates receives the items to connect again, per sheet
+     * @return false if the graph should be rebuilt from scratch instead, in which case it
+     *         has not been modified
+     */
+    bool invalidateSubgraphs( const SCH_SHEET_LIST& aSheetList,
+                              std::vector< std::pair< SCH_SHEET_PATH,
+                                                      std::vector<SCH_ITEM*> > >& aUpdates );
+
+    /**
+     * Caches the items and link names of a newly built subgraph, for the next incremental
+     * update.
+     */
+    void indexSubgraph( CONNECTION_SUBGRAPH* aSubgraph );
+
+    /// Rebuilds m_net_code_to_subgraphs_map from the driven subgraphs
+    void recacheNetCodes();
+
     /**
      * Helper to assign a new net code to a connection
      *
@@ -376,17 +437,29 @@ private:
 
     void recacheSubgraphName( CONNECTION_SUBGRAPH* aSubgraph, const wxString& aOldName );
 
+    /**
+     * Runs the enabled electrical rule checks on one subgraph.  Only changes the subgraph
+     * itself, so several subgraphs can be checked at the same time.
+     *
+     * @param  aSubgraph      is the subgraph to examine
+     * @param  aSettings      is used to control which tests to run
+     * @param  aMarkers       is filled with the error markers, if not nullptr
+     * @return                the number of errors found
+     */
+    int ercCheckSubgraph( CONNECTION_SUBGRAPH* aSubgraph, const ERC_SETTINGS& aSettings,
+                          std::vector<SCH_MARKER*>* aMarkers );
+
     /**
      * Checks one subgraph for conflicting connections between net and bus labels
      *
      * For example, a net wire connected to a bus port/pin, or vice versa
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCreateMarkers controls whether error markers are created
+     * @param  aMarkers       is filled with the error markers, if not nullptr
      * @return                true for no errors, false for errors
      */
     bool ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                    bool aCreateMarkers );
+                                    std::vector<SCH_MARKER*>* aMarkers );
 
     /**
      * Checks one subgraph for conflicting connections between two bus items
@@ -396,11 +469,11 @@ private:
      * sheet pin
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCreateMarkers controls whether error markers are created
+     * @param  aMarkers       is filled with the error markers, if not nullptr
      * @return                true for no errors, false for errors
      */
     bool ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                    bool aCreateMarkers );
+                                    std::vector<SCH_MARKER*>* aMarkers );
 
     /**
      * Checks one subgraph for conflicting bus entry to bus connections
@@ -412,11 +485,11 @@ private:
      * "USB.DP" but someone might accidentally just enter "DP"
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCreateMarkers controls whether error markers are created
+     * @param  aMarkers       is filled with the error markers, if not nullptr
      * @return                true for no errors, false for errors
      */
     bool ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
-                                         bool aCreateMarkers );
+                                         std::vector<SCH_MARKER*>* aMarkers );
 
     /**
      * Checks one subgraph for proper presence or absence of no-connect symbols
@@ -425,11 +498,11 @@ private:
      * A pin without a no-connect symbol should have at least one connection
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCreateMarkers controls whether error markers are created
+     * @param  aMarkers       is filled with the error markers, if not nullptr
      * @return                true for no errors, false for errors
      */
     bool ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
-                             bool aCreateMarkers );
+                             std::vector<SCH_MARKER*>* aMarkers );
 
     /**
      * Checks one subgraph for proper connection of labels
@@ -437,12 +510,12 @@ private:
      * Labels should be connected to something
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCreateMarkers controls whether error markers are created
+     * @param  aMarkers       is filled with the error markers, if not nullptr
      * @param  aCheckGlobalLabels is true if global labels should be checked for loneliness
      * @return                true for no errors, false for errors
      */
-    bool ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph, bool aCreateMarkers,
-                         bool aCheckGlobalLabels );
+    bool ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
+                         std::vector<SCH_MARKER*>* aMarkers, bool aCheckGlobalLabels );
 
 };
 
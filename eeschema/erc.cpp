@@ -43,6 +43,10 @@
 
 #include <wx/ffile.h>
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 
 /* ERC tests :
  *  1 - conflicts between connected pins ( example: 2 connected outputs )
@@ -693,54 +697,61 @@ void NETLIST_OBJECT_LIST::TestforNonOrphanLabel( unsigned aNetItemRef, unsigned
 // when they are compared using case insensitive coparisons.
 
 
-// A helper struct to compare NETLIST_OBJECT items by sheetpath and label texts
-// for a std::set<NETLIST_OBJECT*> container
-// the full text is "sheetpath+label" for local labels and "label" for global labels
-struct compare_labels
-{
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
-    {
-        wxString str1 = lab1->m_SheetPath.Path() + lab1->m_Label;
-        wxString str2 = lab2->m_SheetPath.Path() + lab2->m_Label;
+// Helper function to build the warning messages about Similar Labels:
+static void SimilarLabelsDiagnose( NETLIST_OBJECT* aItemA, NETLIST_OBJECT* aItemB );
 
-        return str1.Cmp( str2 ) < 0;
-    }
-};
 
-struct compare_label_names
+// Helper function: keeps the groups of more than one label of aGroups, with their labels
+// sorted by text, and sorts them by sheet path and text of their first label
+static std::vector<std::vector<NETLIST_OBJECT*>*> sortLabelGroups(
+        std::unordered_map<wxString, std::vector<NETLIST_OBJECT*>>& aGroups )
 {
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
-    {
-        return lab1->m_Label.Cmp( lab2->m_Label ) < 0;
-    }
-};
+    std::vector<std::vector<NETLIST_OBJECT*>*> groups;
 
-struct compare_paths
-{
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
+    for( auto& group : aGroups )
     {
-        return lab1->m_SheetPath.Path().Cmp( lab2->m_SheetPath.Path() ) < 0;
+        if( group.second.size() < 2 )
+            continue;
+
+        std::sort( group.second.begin(), group.second.end(),
+                   []( const NETLIST_OBJECT* a, const NETLIST_OBJECT* b )
+                   {
+                       return a->m_Label.Cmp( b->m_Label ) < 0;
+                   } );
+
+        groups.push_back( &group.second );
     }
-};
 
-// Helper functions to build the warning messages about Similar Labels:
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel );
-static void SimilarLabelsDiagnose( NETLIST_OBJECT* aItemA, NETLIST_OBJECT* aItemB );
+    std::sort( groups.begin(), groups.end(),
+               []( const std::vector<NETLIST_OBJECT*>* a, const std::vector<NETLIST_OBJECT*>* b )
+               {
+                   int cmp = a->front()->m_SheetPath.Path().Cmp( b->front()->m_SheetPath.Path() );
+
+                   if( cmp != 0 )
+                       return cmp < 0;
+
+                   return a->front()->m_Label.Cmp( b->front()->m_Label ) < 0;
+               } );
+
+    return groups;
+}
 
 
 void NETLIST_OBJECT_LIST::TestforSimilarLabels()
 {
     // Similar labels which are different when using case sensitive comparisons
-    // but are equal when using case insensitive comparisons
+    // but are equal when using case insensitive comparisons.  The labels are grouped
+    // by their case-folded text, and only the labels of a same group are compared.
 
-    // list of all labels (used the better item to build diag messages)
-    std::vector<NETLIST_OBJECT*> fullLabelList;
-    // list of all labels , each label appears only once (used to to detect similar labels)
-    std::set<NETLIST_OBJECT*, compare_labels> uniqueLabelList;
-    wxString msg;
+    // Number of identical labels: global labels in the full project, and all labels in
+    // each sheet (used to choose the label to report)
+    std::unordered_map<wxString, int> globalCounts;
+    std::unordered_map<wxString, int> sheetCounts;
+
+    // Each label appears only once in a given sheet
+    std::unordered_set<wxString> uniqueKeys;
+    std::vector<NETLIST_OBJECT*> uniqueLabelList;
 
-    // Build a list of differents labels. If inside a given sheet there are
-    // more than one given label, only one label is stored.
     // not also the sheet labels are not taken in account for 2 reasons:
     //  * they are in the root sheet but they are seen only from the child sheet
     //  * any mismatch between child sheet hierarchical labels and the sheet label
@@ -756,10 +767,20 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         case NET_HIERLABEL:
         case NET_HIERBUSLABELMEMBER:
         case NET_GLOBLABEL:
-            // add this label in lists
-            uniqueLabelList.insert( GetItem( netItem ) );
-            fullLabelList.push_back( GetItem( netItem ) );
+        {
+            NETLIST_OBJECT* label = GetItem( netItem );
+            wxString        key = label->m_SheetPath.Path() + wxT( '\n' ) + label->m_Label;
+
+            if( label->IsLabelGlobal() )
+                globalCounts[ label->m_Label ]++;
+
+            sheetCounts[ key ]++;
+
+            if( uniqueKeys.insert( key ).second )
+                uniqueLabelList.push_back( label );
+
             break;
+        }
 
         case NET_SHEETLABEL:
         case NET_SHEETBUSLABELMEMBER:
@@ -768,118 +789,79 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         }
     }
 
-    // build global labels and compare
-    std::set<NETLIST_OBJECT*, compare_label_names> loc_labelList;
-    std::set<NETLIST_OBJECT*>::const_iterator it;
-
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
-    {
-        if( (*it)->IsLabelGlobal() )
-            loc_labelList.insert( *it );
-    }
-
-    // compare global labels (same label names appears only once in list)
-    for( it = loc_labelList.begin(); it != loc_labelList.end(); ++it )
+    auto diagnose = [&]( NETLIST_OBJECT* aItemA, NETLIST_OBJECT* aItemB )
     {
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = it;
-
-        for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
+        auto count = [&]( NETLIST_OBJECT* aLabel ) -> int
         {
-            if( (*it)->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-            {
-                // Create new marker for ERC.
-                int cntA = countIndenticalLabels( fullLabelList, *it );
-                int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                if( cntA <= cntB )
-                    SimilarLabelsDiagnose( (*it), (*it_aux) );
-                else
-                    SimilarLabelsDiagnose( (*it_aux), (*it) );
-            }
-        }
-    }
+            if( aLabel->IsLabelGlobal() )
+                return globalCounts[ aLabel->m_Label ];
 
-    // Build paths list
-    std::set<NETLIST_OBJECT*, compare_paths> pathsList;
+            return sheetCounts[ aLabel->m_SheetPath.Path() + wxT( '\n' ) + aLabel->m_Label ];
+        };
 
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
-        pathsList.insert( *it );
+        // Report the label used the less
+        if( count( aItemA ) <= count( aItemB ) )
+            SimilarLabelsDiagnose( aItemA, aItemB );
+        else
+            SimilarLabelsDiagnose( aItemB, aItemA );
+    };
 
-    // Examine each label inside a sheet path:
-    for( it = pathsList.begin(); it != pathsList.end(); ++it )
-    {
-        loc_labelList.clear();
+    // Global labels: each label text appears only once, from the first sheet path
+    std::unordered_map<wxString, NETLIST_OBJECT*> globalLabels;
 
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = uniqueLabelList.begin();
+    for( NETLIST_OBJECT* label : uniqueLabelList )
+    {
+        if( !label->IsLabelGlobal() )
+            continue;
 
-        for( ; it_aux != uniqueLabelList.end(); ++it_aux )
-        {
-            if( (*it)->m_SheetPath.Path() == (*it_aux)->m_SheetPath.Path() )
-                loc_labelList.insert( *it_aux );
-        }
+        auto it = globalLabels.find( label->m_Label );
 
-        // at this point, loc_labelList contains labels of the current sheet path.
-        // Detect similar labels (same label names appears only once in list)
-        std::set<NETLIST_OBJECT*>::const_iterator ref_it;
+        if( it == globalLabels.end() )
+            globalLabels[ label->m_Label ] = label;
+        else if( label->m_SheetPath.Path().Cmp( it->second->m_SheetPath.Path() ) < 0 )
+            it->second = label;
+    }
 
-        for( ref_it = loc_labelList.begin(); ref_it != loc_labelList.end(); ++ref_it )
-        {
-            NETLIST_OBJECT* ref_item = *ref_it;
-            it_aux = ref_it;
+    std::unordered_map<wxString, std::vector<NETLIST_OBJECT*>> globalGroups;
 
-            for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
-            {
-                // global label versus global label was already examined.
-                // here, at least one label must be local
-                if( ref_item->IsLabelGlobal() && (*it_aux)->IsLabelGlobal() )
-                    continue;
+    for( const auto& it : globalLabels )
+        globalGroups[ it.first.Lower() ].push_back( it.second );
 
-                if( ref_item->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-                {
-                    // Create new marker for ERC.
-                    int cntA = countIndenticalLabels( fullLabelList, ref_item );
-                    int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                    if( cntA <= cntB )
-                        SimilarLabelsDiagnose( ref_item, (*it_aux) );
-                    else
-                        SimilarLabelsDiagnose( (*it_aux), ref_item );
-                }
-            }
+    // In the global groups, the label texts are all different
+    for( std::vector<NETLIST_OBJECT*>* group : sortLabelGroups( globalGroups ) )
+    {
+        for( size_t ii = 0; ii < group->size(); ++ii )
+        {
+            for( size_t jj = ii + 1; jj < group->size(); ++jj )
+                diagnose( ( *group )[ii], ( *group )[jj] );
         }
     }
-}
 
-// Helper function: count the number of labels identical to aLabel
-//  for global label: global labels in the full project
-//  for local label: all labels in the current sheet
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel )
-{
-    int count = 0;
+    // Labels inside a sheet path, at least one of them being local
+    std::unordered_map<wxString, std::vector<NETLIST_OBJECT*>> sheetGroups;
 
-    if( aLabel->IsLabelGlobal() )
+    for( NETLIST_OBJECT* label : uniqueLabelList )
     {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
-        {
-            NETLIST_OBJECT* item = aList[netItem];
-
-            if( item->IsLabelGlobal() && item->m_Label == aLabel->m_Label )
-                count++;
-        }
+        wxString key = label->m_SheetPath.Path() + wxT( '\n' ) + label->m_Label.Lower();
+        sheetGroups[ key ].push_back( label );
     }
-    else
+
+    for( std::vector<NETLIST_OBJECT*>* group : sortLabelGroups( sheetGroups ) )
     {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
+        for( size_t ii = 0; ii < group->size(); ++ii )
         {
-            NETLIST_OBJECT* item = aList[netItem];
+            NETLIST_OBJECT* ref_item = ( *group )[ii];
+
+            for( size_t jj = ii + 1; jj < group->size(); ++jj )
+            {
+                // global label versus global label was already examined.
+                if( ref_item->IsLabelGlobal() && ( *group )[jj]->IsLabelGlobal() )
+                    continue;
 
-            if( item->m_Label == aLabel->m_Label &&
-                item->m_SheetPath.Path() == aLabel->m_SheetPath.Path() )
-                count++;
+                diagnose( ref_item, ( *group )[jj] );
+            }
         }
     }
-
-    return count;
 }
 
 // Helper function: creates a marker for similar labels ERC warning
@@ -432,6 +432,11 @@ void SCH_BASE_FRAME::RefreshItem( EDA_ITEM* aItem, bool isAddOrDelete )
             GetCanvas()->GetView()->Update( parent, KIGFX::REPAINT );
     }
 
+    // The item may have moved or changed size.  Items which are not schematic items, or
+    // not on the screen, are ignored by the screen.
+    if( SCH_ITEM* item = dynamic_cast<SCH_ITEM*>( aItem ) )
+        GetScreen()->Update( item );
+
     GetCanvas()->Refresh();
 }
 
@@ -467,6 +467,9 @@ void SCH_COMPONENT::UpdatePins( SCH_SHEET_PATH* aSheet )
                     m_pins.erase( m_pins.begin() + i, m_pins.end() );
 
                 m_pins.emplace_back( SCH_PIN( libPin, this ) );
+
+                // The connection graph holds pointers to the pins
+                SetConnectivityDirty();
             }
 
             m_pinMap[ libPin ] = i;
@@ -476,9 +479,18 @@ void SCH_COMPONENT::UpdatePins( SCH_SHEET_PATH* aSheet )
 
             ++i;
         }
+
+        if( m_pins.size() > i )
+        {
+            m_pins.erase( m_pins.begin() + i, m_pins.end() );
+            SetConnectivityDirty();
+        }
     }
     else
     {
+        if( !m_pins.empty() )
+            SetConnectivityDirty();
+
         m_pins.clear();
         m_pinMap.clear();
     }
@@ -666,8 +666,11 @@ void SCH_EDIT_FRAME::OnModify()
     GetScreen()->SetModify();
     GetScreen()->SetSave();
 
+    // Catch the items edited without telling the screen, before the hit tests use them
+    GetScreen()->RevalidateIndex();
+
     if( ADVANCED_CFG::GetCfg().m_realTimeConnectivity && CONNECTION_GRAPH::m_allowRealTime )
-        RecalculateConnections( false );
+        RecalculateConnections( false, false );
 
     m_canvas->Refresh();
 }
@@ -1231,7 +1234,7 @@ void SCH_EDIT_FRAME::UpdateTitle()
 }
 
 
-void SCH_EDIT_FRAME::RecalculateConnections( bool aDoCleanup )
+void SCH_EDIT_FRAME::RecalculateConnections( bool aDoCleanup, bool aUnconditional )
 {
     SCH_SHEET_LIST list( g_RootSheet );
 
@@ -1247,7 +1250,7 @@ void SCH_EDIT_FRAME::RecalculateConnections( bool aDoCleanup )
     timer.Stop();
     wxLogTrace( "CONN_PROFILE", "SchematicCleanUp() %0.4f ms", timer.msecs() );
 
-    g_ConnectionGraph->Recalculate( list, true );
+    g_ConnectionGraph->Recalculate( list, aUnconditional );
 }
 
 
@@ -1110,8 +1110,12 @@ public:
 
     /**
      * Generates the connection data for the entire schematic hierarchy.
+     *
+     * @param aDoCleanup true to clean up the schematic (merge wires...) first.
+     * @param aUnconditional false to only rebuild the part of the connection graph affected by
+     *                       the items marked with connectivity dirty, true to rebuild it all.
      */
-    void RecalculateConnections( bool aDoCleanup = true );
+    void RecalculateConnections( bool aDoCleanup = true, bool aUnconditional = true );
 
     /**
      * Allows Eeschema to install its preferences panels into the preferences dialog.
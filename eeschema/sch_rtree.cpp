@@ -0,0 +1,254 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <sch_rtree.h>
+
+#include <algorithm>
+
+#include <sch_item.h>
+#include <sch_sheet.h>
+
+
+/**
+ * @return true if items of type \a aType are stored in the draw list, as opposed to
+ *         the children of the draw list items and the pseudo types used by the locators.
+ */
+static bool isDrawListType( KICAD_T aType )
+{
+    switch( aType )
+    {
+    case SCH_MARKER_T:
+    case SCH_JUNCTION_T:
+    case SCH_NO_CONNECT_T:
+    case SCH_BUS_WIRE_ENTRY_T:
+    case SCH_BUS_BUS_ENTRY_T:
+    case SCH_LINE_T:
+    case SCH_BITMAP_T:
+    case SCH_TEXT_T:
+    case SCH_LABEL_T:
+    case SCH_GLOBAL_LABEL_T:
+    case SCH_HIER_LABEL_T:
+    case SCH_COMPONENT_T:
+    case SCH_SHEET_T:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+EE_RTREE::EE_RTREE() :
+    m_tree( new TREE ),
+    m_nextOrder( 0 )
+{
+}
+
+
+EE_RTREE::~EE_RTREE()
+{
+    delete m_tree;
+}
+
+
+EDA_RECT EE_RTREE::GetIndexedBox( SCH_ITEM* aItem )
+{
+    EDA_RECT box = aItem->GetBoundingBox();
+
+    // Sheet pins are hit tested on their own and may stick out of the sheet
+    if( aItem->Type() == SCH_SHEET_T )
+    {
+        for( SCH_SHEET_PIN& pin : static_cast<SCH_SHEET*>( aItem )->GetPins() )
+            box.Merge( pin.GetBoundingBox() );
+    }
+
+    box.Normalize();
+
+    // Some hit tests widen their accuracy by the pen size when none is given
+    box.Inflate( aItem->GetPenSize() );
+
+    return box;
+}
+
+
+void EE_RTREE::insertInTree( ENTRY* aEntry )
+{
+    const EDA_RECT& box = aEntry->m_box;
+    const int       mmin[3] = { aEntry->m_item->Type(), box.GetX(), box.GetY() };
+    const int       mmax[3] = { aEntry->m_item->Type(), box.GetRight(), box.GetBottom() };
+
+    m_tree->Insert( mmin, mmax, aEntry );
+    aEntry->m_indexed = true;
+}
+
+
+void EE_RTREE::removeFromTree( ENTRY* aEntry )
+{
+    if( !aEntry->m_indexed )
+        return;
+
+    // The box the item was indexed with is kept, so the removal never needs to search the
+    // whole tree, even if the item has moved since.
+    const EDA_RECT& box = aEntry->m_box;
+    const int       mmin[3] = { aEntry->m_item->Type(), box.GetX(), box.GetY() };
+    const int       mmax[3] = { aEntry->m_item->Type(), box.GetRight(), box.GetBottom() };
+
+    m_tree->Remove( mmin, mmax, aEntry );
+    aEntry->m_indexed = false;
+}
+
+
+void EE_RTREE::Insert( SCH_ITEM* aItem )
+{
+    wxCHECK_RET( aItem, "Cannot index a null item." );
+
+    ENTRY& entry = m_entries[aItem];
+
+    removeFromTree( &entry );
+
+    entry.m_item = aItem;
+    entry.m_order = m_nextOrder++;
+    entry.m_indexed = false;
+
+    m_dirty.insert( &entry );
+}
+
+
+void EE_RTREE::Remove( SCH_ITEM* aItem )
+{
+    auto it = m_entries.find( aItem );
+
+    if( it == m_entries.end() )
+        return;
+
+    removeFromTree( &it->second );
+    m_dirty.erase( &it->second );
+    m_entries.erase( it );
+}
+
+
+void EE_RTREE::Update( SCH_ITEM* aItem )
+{
+    auto it = m_entries.find( aItem );
+
+    if( it != m_entries.end() )
+        m_dirty.insert( &it->second );
+}
+
+
+void EE_RTREE::Revalidate()
+{
+    for( auto& pair : m_entries )
+    {
+        ENTRY& entry = pair.second;
+
+        if( !entry.m_indexed )
+            continue;
+
+        EDA_RECT box = GetIndexedBox( entry.m_item );
+
+        if( box.GetPosition() != entry.m_box.GetPosition()
+                || box.GetSize() != entry.m_box.GetSize() )
+        {
+            m_dirty.insert( &entry );
+        }
+    }
+}
+
+
+void EE_RTREE::Clear()
+{
+    m_tree->RemoveAll();
+    m_entries.clear();
+    m_dirty.clear();
+    m_nextOrder = 0;
+}
+
+
+void EE_RTREE::flush() const
+{
+    std::lock_guard<std::mutex> lock( m_flushMutex );
+
+    if( m_dirty.empty() )
+        return;
+
+    EE_RTREE* self = const_cast<EE_RTREE*>( this );
+
+    for( ENTRY* entry : m_dirty )
+    {
+        self->removeFromTree( entry );
+        entry->m_box = GetIndexedBox( entry->m_item );
+        self->insertInTree( entry );
+    }
+
+    m_dirty.clear();
+}
+
+
+std::vector<SCH_ITEM*> EE_RTREE::Query( const EDA_RECT& aArea, KICAD_T aType ) const
+{
+    flush();
+
+    EDA_RECT area = aArea;
+    area.Normalize();
+
+    bool      allTypes = !isDrawListType( aType );
+    const int mmin[3] = { allTypes ? 0 : aType, area.GetX(), area.GetY() };
+    const int mmax[3] = { allTypes ? MAX_STRUCT_TYPE_ID : aType, area.GetRight(),
+                          area.GetBottom() };
+
+    std::vector<ENTRY*> found;
+
+    m_tree->Search( mmin, mmax, [&found]( ENTRY* const& aEntry )
+                                {
+                                    found.push_back( aEntry );
+                                    return true;
+                                } );
+
+    std::sort( found.begin(), found.end(),
+               []( const ENTRY* aA, const ENTRY* aB )
+               {
+                   return aA->m_order < aB->m_order;
+               } );
+
+    std::vector<SCH_ITEM*> items;
+    items.reserve( found.size() );
+
+    for( ENTRY* entry : found )
+        items.push_back( entry->m_item );
+
+    return items;
+}
+
+
+std::vector<SCH_ITEM*> EE_RTREE::Query( const wxPoint& aPosition, int aAccuracy,
+                                        KICAD_T aType ) const
+{
+    // One more unit, for the hit tests which round distances
+    int      margin = std::max( aAccuracy, 0 ) + 1;
+    EDA_RECT area( aPosition, wxSize( 0, 0 ) );
+
+    area.Inflate( margin );
+
+    return Query( area, aType );
+}
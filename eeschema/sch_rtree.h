@@ -0,0 +1,156 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file sch_rtree.h
+ * @brief Spatial index of the items of a SCH_SCREEN.
+ */
+
+#ifndef EESCHEMA_SCH_RTREE_H_
+#define EESCHEMA_SCH_RTREE_H_
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <core/typeinfo.h>
+#include <eda_rect.h>
+#include <geometry/rtree.h>
+
+class SCH_ITEM;
+
+
+/**
+ * Class EE_RTREE
+ * is an R-tree of the items of a schematic screen, keyed by item type and bounding box.
+ * Non-owning: the items stay in the draw list of the screen.
+ *
+ * The geometry of the items is read lazily.  Inserted and updated items are only (re)indexed
+ * by the next query, so an item can be flagged before it is actually changed and a freshly
+ * loaded component is indexed once its library symbol is resolved.
+ *
+ * Queries return the items in insertion order, i.e. in draw list order, so that the hit
+ * tests built on them keep returning the same item as a scan of the draw list.  Queries can
+ * run concurrently, but not concurrently with the modifications of the index.
+ */
+class EE_RTREE
+{
+public:
+    EE_RTREE();
+    ~EE_RTREE();
+
+    EE_RTREE( const EE_RTREE& ) = delete;
+    EE_RTREE& operator=( const EE_RTREE& ) = delete;
+
+    /**
+     * Function Insert
+     * adds \a aItem after all the items already in the index.
+     */
+    void Insert( SCH_ITEM* aItem );
+
+    /**
+     * Function Remove
+     * removes \a aItem from the index.  Does nothing if the item is not in the index.
+     */
+    void Remove( SCH_ITEM* aItem );
+
+    /**
+     * Function Update
+     * flags \a aItem to be reindexed by the next query, because its geometry has changed or
+     * is about to change.  Does nothing if the item is not in the index.
+     */
+    void Update( SCH_ITEM* aItem );
+
+    /**
+     * Function Revalidate
+     * checks the indexed bounding box of all the items against their current one, and flags
+     * the items which were changed behind the back of the index.
+     */
+    void Revalidate();
+
+    /**
+     * Function Clear
+     * removes all the items from the index.
+     */
+    void Clear();
+
+    bool Contains( SCH_ITEM* aItem ) const
+    {
+        return m_entries.count( aItem ) > 0;
+    }
+
+    size_t GetCount() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * Function Query
+     * @return the items of type \a aType whose bounding box intersects \a aArea, in draw list
+     *         order.  If \a aType is not a type of draw list item, all the types are searched.
+     */
+    std::vector<SCH_ITEM*> Query( const EDA_RECT& aArea, KICAD_T aType = SCH_LOCATE_ANY_T ) const;
+
+    /**
+     * Function Query
+     * @return the items whose bounding box contains \a aPosition, inflated by \a aAccuracy.
+     */
+    std::vector<SCH_ITEM*> Query( const wxPoint& aPosition, int aAccuracy = 0,
+                                  KICAD_T aType = SCH_LOCATE_ANY_T ) const;
+
+    /**
+     * Function GetIndexedBox
+     * @return the bounding box used to index \a aItem: its own bounding box, grown by the
+     *         children which are hit tested separately (the pins of a sheet).
+     */
+    static EDA_RECT GetIndexedBox( SCH_ITEM* aItem );
+
+private:
+    struct ENTRY
+    {
+        SCH_ITEM* m_item;
+        EDA_RECT  m_box;        ///< The box the item is indexed with
+        size_t    m_order;      ///< Insertion order
+        bool      m_indexed;    ///< Tells if the item is in the tree
+    };
+
+    typedef RTree<ENTRY*, int, 3, double> TREE;
+
+    void insertInTree( ENTRY* aEntry );
+    void removeFromTree( ENTRY* aEntry );
+
+    ///> Indexes the inserted and updated items.  Called by the queries.
+    void flush() const;
+
+    TREE*                                   m_tree;
+    std::unordered_map<SCH_ITEM*, ENTRY>    m_entries;
+    size_t                                  m_nextOrder;
+
+    ///> The items waiting to be (re)indexed
+    mutable std::unordered_set<ENTRY*>      m_dirty;
+    mutable std::mutex                      m_flushMutex;
+};
+
+
+#endif // EESCHEMA_SCH_RTREE_H_
@@ -33,6 +33,7 @@
 #include <gr_basic.h>
 #include <common.h>
 #include <kicad_string.h>
+#include <trigo.h>
 #include <eeschema_id.h>
 #include <pgm_base.h>
 #include <kiway.h>
@@ -56,10 +57,9 @@
 #include <lib_pin.h>
 #include <symbol_lib_table.h>
 #include <tool/common_tools.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <algorithm>
-#include <future>
 #include <array>
 
 // TODO(JE) Debugging only
@@ -161,6 +161,15 @@ void SCH_SCREEN::Append( SCH_SCREEN* aScreen )
 
     // No need to decend the hierarchy.  Once the top level screen is copied, all of it's
     // children are copied as well.
+    for( SCH_ITEM* item = aScreen->m_drawList.begin(); item; item = item->Next() )
+    {
+        m_rtree.Insert( item );
+        forgetDanglingEnds( item );
+    }
+
+    aScreen->m_rtree.Clear();
+    aScreen->m_danglingEnds.clear();
+    aScreen->m_staleDanglingEnds.clear();
     m_drawList.Append( aScreen->m_drawList );
 
     // This screen owns the objects now.  This prevents the object from being delete when
@@ -182,16 +191,36 @@ void SCH_SCREEN::Clear()
 
 void SCH_SCREEN::FreeDrawList()
 {
+    m_rtree.Clear();
+    m_danglingEnds.clear();
+    m_staleDanglingEnds.clear();
     m_drawList.DeleteAll();
 }
 
 
 void SCH_SCREEN::Remove( SCH_ITEM* aItem )
 {
+    m_rtree.Remove( aItem );
     m_drawList.Remove( aItem );
 }
 
 
+void SCH_SCREEN::Update( SCH_ITEM* aItem )
+{
+    wxCHECK_RET( aItem, wxT( "Cannot update invalid item." ) );
+
+    // Fields and pins are indexed with their parent
+    if( aItem->Type() == SCH_FIELD_T || aItem->Type() == SCH_PIN_T
+            || aItem->Type() == SCH_SHEET_PIN_T )
+    {
+        if( SCH_ITEM* parent = dynamic_cast<SCH_ITEM*>( aItem->GetParent() ) )
+            aItem = parent;
+    }
+
+    m_rtree.Update( aItem );
+}
+
+
 void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
 {
     wxCHECK_RET( aItem, wxT( "Cannot delete invalid item from screen." ) );
@@ -205,11 +234,12 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
         SCH_SHEET* sheet = sheetPin->GetParent();
         wxCHECK_RET( sheet, wxT( "Sheet label parent not properly set, bad programmer!" ) );
         sheet->RemovePin( sheetPin );
+        Update( sheet );
         return;
     }
     else
     {
-        m_drawList.Remove( aItem );
+        Remove( aItem );
         delete aItem;
     }
 }
@@ -217,17 +247,7 @@ void SCH_SCREEN::DeleteItem( SCH_ITEM* aItem )
 
 bool SCH_SCREEN::CheckIfOnDrawList( SCH_ITEM* aItem )
 {
-    SCH_ITEM* itemList = m_drawList.begin();
-
-    while( itemList )
-    {
-        if( itemList == aItem )
-            return true;
-
-        itemList = itemList->Next();
-    }
-
-    return false;
+    return m_rtree.Contains( aItem );
 }
 
 
@@ -235,7 +255,7 @@ SCH_ITEM* SCH_SCREEN::GetItem( const wxPoint& aPosition, int aAccuracy, KICAD_T
 {
     KICAD_T types[] = { aType, EOT };
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, aAccuracy ) )
     {
         switch( item->Type() )
         {
@@ -298,6 +318,12 @@ void SCH_SCREEN::ReplaceWires( DLIST< SCH_ITEM >& aWireList )
         }
     }
 
+    for( item = aWireList.begin(); item; item = item->Next() )
+    {
+        m_rtree.Insert( item );
+        forgetDanglingEnds( item );
+    }
+
     m_drawList.Append( aWireList );
 }
 
@@ -307,7 +333,13 @@ void SCH_SCREEN::MarkConnections( SCH_LINE* aSegment )
     wxCHECK_RET( (aSegment) && (aSegment->Type() == SCH_LINE_T),
                  wxT( "Invalid object pointer." ) );
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    // Only the items touching the ends of aSegment can be marked
+    std::vector<SCH_ITEM*> items = m_rtree.Query( aSegment->GetStartPoint() );
+    std::vector<SCH_ITEM*> endItems = m_rtree.Query( aSegment->GetEndPoint() );
+
+    items.insert( items.end(), endItems.begin(), endItems.end() );
+
+    for( SCH_ITEM* item : items )
     {
         if( item->GetFlags() & CANDIDATE )
             continue;
@@ -354,7 +386,7 @@ bool SCH_SCREEN::IsJunctionNeeded( const wxPoint& aPosition, bool aNew )
 
     std::vector<SCH_LINE*> lines[ sizeof( layers ) ];
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition ) )
     {
         if( item->GetEditFlags() & STRUCT_DELETED )
             continue;
@@ -514,6 +546,10 @@ void SCH_SCREEN::UpdateSymbolLinks( bool aForce )
         {
             SCH_COMPONENT::ResolveAll( c, *libs, Prj().SchLibs()->GetCacheLibrary() );
 
+            // The new symbols may have a different size
+            for( int ii = 0; ii < c.GetCount(); ++ii )
+                m_rtree.Update( (SCH_ITEM*) c[ii] );
+
             m_modification_sync = mod_hash;     // note the last mod_hash
         }
         // Resolving will update the pin caches but we must ensure that this happens
@@ -608,15 +644,11 @@ void SCH_SCREEN::ClearDrawingState()
 LIB_PIN* SCH_SCREEN::GetPin( const wxPoint& aPosition, SCH_COMPONENT** aComponent,
                              bool aEndPointOnly ) const
 {
-    SCH_ITEM*       item;
     SCH_COMPONENT*  component = NULL;
     LIB_PIN*        pin = NULL;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, 0, SCH_COMPONENT_T ) )
     {
-        if( item->Type() != SCH_COMPONENT_T )
-            continue;
-
         component = (SCH_COMPONENT*) item;
 
         if( aEndPointOnly )
@@ -682,11 +714,8 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 {
     SCH_SHEET_PIN* sheetPin = NULL;
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, 0, SCH_SHEET_T ) )
     {
-        if( item->Type() != SCH_SHEET_T )
-            continue;
-
         SCH_SHEET* sheet = (SCH_SHEET*) item;
         sheetPin = sheet->GetPin( aPosition );
 
@@ -700,10 +729,9 @@ SCH_SHEET_PIN* SCH_SCREEN::GetSheetLabel( const wxPoint& aPosition )
 
 int SCH_SCREEN::CountConnectedItems( const wxPoint& aPos, bool aTestJunctions ) const
 {
-    SCH_ITEM* item;
-    int       count = 0;
+    int count = 0;
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPos ) )
     {
         if( item->Type() == SCH_JUNCTION_T  && !aTestJunctions )
             continue;
@@ -766,20 +794,239 @@ void SCH_SCREEN::GetHierarchicalItems( EDA_ITEMS& aItems )
 }
 
 
-bool SCH_SCREEN::TestDanglingEnds()
+/**
+ * @return true for the connection points of wires and buses, which come in start/end pairs.
+ */
+static bool isSegmentEnd( DANGLING_END_T aType )
 {
-    SCH_ITEM* item;
-    std::vector< DANGLING_END_ITEM > endPoints;
-    bool hasStateChanged = false;
+    return aType == WIRE_START_END || aType == WIRE_END_END
+            || aType == BUS_START_END || aType == BUS_END_END;
+}
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+
+static bool isSameEnds( const std::vector<DANGLING_END_ITEM>& aEnds,
+                        std::vector<DANGLING_END_ITEM>::const_iterator aBegin,
+                        std::vector<DANGLING_END_ITEM>::const_iterator aEnd )
+{
+    if( aEnds.size() != (size_t) std::distance( aBegin, aEnd ) )
+        return false;
+
+    return std::equal( aEnds.begin(), aEnds.end(), aBegin,
+                       []( const DANGLING_END_ITEM& aA, const DANGLING_END_ITEM& aB )
+                       {
+                           return aA.GetType() == aB.GetType()
+                                  && aA.GetPosition() == aB.GetPosition();
+                       } );
+}
+
+
+void SCH_SCREEN::forgetDanglingEnds( SCH_ITEM* aItem )
+{
+    auto it = m_danglingEnds.find( aItem );
+
+    if( it == m_danglingEnds.end() )
+        return;
+
+    m_staleDanglingEnds.insert( m_staleDanglingEnds.end(), it->second.begin(), it->second.end() );
+    m_danglingEnds.erase( it );
+}
+
+
+bool SCH_SCREEN::TestDanglingEnds( const std::function<void( SCH_ITEM* )>& aChangedHandler )
+{
+    std::vector<SCH_ITEM*>          items;
+    std::vector<DANGLING_END_ITEM>  endPoints;
+    std::vector<size_t>             firstEnd;   // The ends of items[i] are in
+                                                // [firstEnd[i], firstEnd[i+1]) of endPoints
+    bool                            hasStateChanged = false;
+
+    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    {
+        items.push_back( item );
+        firstEnd.push_back( endPoints.size() );
         item->GetEndPoints( endPoints );
+    }
+
+    firstEnd.push_back( endPoints.size() );
+
+    std::unordered_map<SCH_ITEM*, size_t>           indexOf;
+    std::unordered_map<wxPoint, std::vector<size_t>> endsAt;
+    std::vector<size_t>                             ownerOf( endPoints.size() );
+
+    for( size_t ii = 0; ii < items.size(); ++ii )
+    {
+        indexOf[ items[ii] ] = ii;
+
+        for( size_t jj = firstEnd[ii]; jj < firstEnd[ii + 1]; ++jj )
+        {
+            endsAt[ endPoints[jj].GetPosition() ].push_back( jj );
+            ownerOf[jj] = ii;
+        }
+    }
+
+    // Find the new and changed items, and gather the connection points which appeared or
+    // disappeared since the last test: the items around them must be tested again too.
+    std::vector<bool>              changed( items.size(), false );
+    std::vector<DANGLING_END_ITEM> changedEnds;
+
+    changedEnds.swap( m_staleDanglingEnds );
+
+    for( size_t ii = 0; ii < items.size(); ++ii )
+    {
+        auto begin = endPoints.cbegin() + firstEnd[ii];
+        auto end = endPoints.cbegin() + firstEnd[ii + 1];
+        auto it = m_danglingEnds.find( items[ii] );
+
+        if( it != m_danglingEnds.end() )
+        {
+            if( isSameEnds( it->second, begin, end ) )
+                continue;
+
+            changedEnds.insert( changedEnds.end(), it->second.begin(), it->second.end() );
+        }
+
+        changed[ii] = true;
+        changedEnds.insert( changedEnds.end(), begin, end );
+
+        // The spatial index may not have been told yet
+        m_rtree.Update( items[ii] );
+    }
 
-    for( item = m_drawList.begin(); item; item = item->Next() )
+    // The items removed from the screen since the last test
+    for( auto it = m_danglingEnds.begin(); it != m_danglingEnds.end(); )
     {
-        if( item->UpdateDanglingState( endPoints ) )
+        if( indexOf.count( it->first ) )
+        {
+            ++it;
+        }
+        else
+        {
+            changedEnds.insert( changedEnds.end(), it->second.begin(), it->second.end() );
+            it = m_danglingEnds.erase( it );
+        }
+    }
+
+    std::vector<bool> toTest( changed );
+
+    for( size_t ii = 0; ii < changedEnds.size(); ++ii )
+    {
+        const DANGLING_END_ITEM& changedEnd = changedEnds[ii];
+        auto                     it = endsAt.find( changedEnd.GetPosition() );
+
+        if( it != endsAt.end() )
+        {
+            for( size_t jj : it->second )
+                toTest[ ownerOf[jj] ] = true;
+        }
+
+        // Labels and bus entries connect anywhere along the wires and buses
+        if( ( changedEnd.GetType() == WIRE_START_END || changedEnd.GetType() == BUS_START_END )
+                && ii + 1 < changedEnds.size() )
+        {
+            EDA_RECT area( changedEnd.GetPosition(), wxSize( 0, 0 ) );
+            area.Merge( changedEnds[ii + 1].GetPosition() );
+
+            for( SCH_ITEM* item : m_rtree.Query( area ) )
+            {
+                auto index = indexOf.find( item );
+
+                if( index != indexOf.end() )
+                    toTest[ index->second ] = true;
+            }
+        }
+    }
+
+    // Each item is tested against the connection points which can affect it, in their
+    // original order: the ones at its own connection points, and the wires and buses going
+    // through them.
+    std::vector<size_t>            candidateIds;
+    std::vector<DANGLING_END_ITEM> candidates;
+
+    auto addCandidate = [&]( size_t aEnd )
+    {
+        DANGLING_END_T type = endPoints[aEnd].GetType();
+
+        if( !isSegmentEnd( type ) )
+        {
+            candidateIds.push_back( aEnd );
+            return;
+        }
+
+        // Keep the start and end of segments together
+        size_t start = ( type == WIRE_START_END || type == BUS_START_END ) ? aEnd : aEnd - 1;
+
+        candidateIds.push_back( start );
+        candidateIds.push_back( start + 1 );
+    };
+
+    for( size_t ii = 0; ii < items.size(); ++ii )
+    {
+        if( !toTest[ii] )
+            continue;
+
+        candidateIds.clear();
+
+        for( size_t jj = firstEnd[ii]; jj < firstEnd[ii + 1]; ++jj )
+        {
+            const wxPoint& pos = endPoints[jj].GetPosition();
+
+            for( size_t kk : endsAt[pos] )
+                addCandidate( kk );
+
+            for( SCH_ITEM* line : m_rtree.Query( pos, 0, SCH_LINE_T ) )
+            {
+                size_t index = indexOf[line];
+
+                if( firstEnd[index + 1] > firstEnd[index] )
+                    addCandidate( firstEnd[index] );
+            }
+        }
+
+        std::sort( candidateIds.begin(), candidateIds.end() );
+        candidateIds.erase( std::unique( candidateIds.begin(), candidateIds.end() ),
+                            candidateIds.end() );
+
+        candidates.clear();
+
+        for( size_t jj : candidateIds )
+            candidates.push_back( endPoints[jj] );
+
+        if( items[ii]->UpdateDanglingState( candidates ) )
         {
             hasStateChanged = true;
+
+            if( aChangedHandler )
+                aChangedHandler( items[ii] );
+        }
+
+        if( changed[ii] )
+        {
+            m_danglingEnds[ items[ii] ].assign( endPoints.begin() + firstEnd[ii],
+                                                endPoints.begin() + firstEnd[ii + 1] );
+        }
+    }
+
+    // Testing a label connects it to the wires and buses it lies on.  The connection graph
+    // clears these links before each update and counts on this function to restore them,
+    // so they are restored for the labels which were not tested again too.
+    for( SCH_ITEM* item : items )
+    {
+        if( item->Type() != SCH_LABEL_T && item->Type() != SCH_GLOBAL_LABEL_T
+                && item->Type() != SCH_HIER_LABEL_T )
+            continue;
+
+        wxPoint pos = static_cast<SCH_TEXT*>( item )->GetTextPos();
+
+        for( SCH_ITEM* candidate : m_rtree.Query( pos, 0, SCH_LINE_T ) )
+        {
+            SCH_LINE* line = static_cast<SCH_LINE*>( candidate );
+
+            if( ( line->GetLayer() == LAYER_WIRE || line->GetLayer() == LAYER_BUS )
+                    && IsPointOnSegment( line->GetStartPoint(), line->GetEndPoint(), pos ) )
+            {
+                item->AddConnectionTo( line );
+                line->AddConnectionTo( item );
+            }
         }
     }
 
@@ -791,7 +1038,7 @@ SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 {
     static KICAD_T types[] = { SCH_LINE_LOCATE_WIRE_T, SCH_LINE_LOCATE_BUS_T, EOT };
 
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, 0, SCH_LINE_T ) )
     {
         if( item->IsType( types ) && item->HitTest( aPosition ) )
             return (SCH_LINE*) item;
@@ -804,11 +1051,8 @@ SCH_LINE* SCH_SCREEN::GetWireOrBus( const wxPoint& aPosition )
 SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLayer,
                                SCH_LINE_TEST_T aSearchType )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, aAccuracy, SCH_LINE_T ) )
     {
-        if( item->Type() != SCH_LINE_T )
-            continue;
-
         if( item->GetLayer() != aLayer )
             continue;
 
@@ -837,7 +1081,7 @@ SCH_LINE* SCH_SCREEN::GetLine( const wxPoint& aPosition, int aAccuracy, int aLay
 
 SCH_TEXT* SCH_SCREEN::GetLabel( const wxPoint& aPosition, int aAccuracy )
 {
-    for( SCH_ITEM* item = m_drawList.begin(); item; item = item->Next() )
+    for( SCH_ITEM* item : m_rtree.Query( aPosition, aAccuracy ) )
     {
         switch( item->Type() )
         {
@@ -1215,32 +1459,7 @@ void SCH_SCREENS::TestDanglingEnds()
     for( SCH_SCREEN* screen = GetFirst(); screen; screen = GetNext() )
         screens.push_back( screen );
 
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            screens.size() );
-
-    std::atomic<size_t> nextScreen( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
-
-    auto update_lambda = [&screens, &nextScreen]() -> size_t
-    {
-        for( auto i = nextScreen++; i < screens.size(); i = nextScreen++ )
-            screens[i]->TestDanglingEnds();
-
-        return 1;
-    };
-
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
-
-        // Finalize the threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
-
+    ParallelFor( screens.size(), [&screens]( size_t i ) { screens[i]->TestDanglingEnds(); } );
 }
 
 
@@ -30,11 +30,14 @@
 #ifndef SCREEN_H
 #define SCREEN_H
 
+#include <functional>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <macros.h>
 #include <dlist.h>
 #include <sch_item.h>
+#include <sch_rtree.h>
 #include <lib_draw_item.h>
 #include <base_screen.h>
 #include <title_block.h>
@@ -94,12 +97,27 @@ private:
 
     DLIST< SCH_ITEM > m_drawList;       ///< Object list for the screen.
 
+    EE_RTREE    m_rtree;                ///< Spatial index of m_drawList, for the hit tests.
+
     int     m_modification_sync;        ///< inequality with PART_LIBS::GetModificationHash()
                                         ///< will trigger ResolveAll().
 
     /// List of bus aliases stored in this screen
     std::unordered_set< std::shared_ptr< BUS_ALIAS > > m_aliases;
 
+    /// The connection points of each item at the last dangling end test, to only test again
+    /// the items near the changes.
+    std::unordered_map< SCH_ITEM*, std::vector< DANGLING_END_ITEM > > m_danglingEnds;
+
+    /// The connection points of the items replaced since the last dangling end test
+    std::vector< DANGLING_END_ITEM > m_staleDanglingEnds;
+
+    /**
+     * Make the next dangling end test handle \a aItem as a new item.  Needed when an item is
+     * appended, because it may have the address of an item deleted since the last test.
+     */
+    void forgetDanglingEnds( SCH_ITEM* aItem );
+
 public:
 
     /**
@@ -155,6 +173,8 @@ public:
     void Append( SCH_ITEM* aItem )
     {
         m_drawList.Append( aItem );
+        m_rtree.Insert( aItem );
+        forgetDanglingEnds( aItem );
         --m_modification_sync;
     }
 
@@ -177,10 +197,44 @@ public:
      */
     void Append( DLIST< SCH_ITEM >& aList )
     {
+        for( SCH_ITEM* item = aList.begin(); item; item = item->Next() )
+        {
+            m_rtree.Insert( item );
+            forgetDanglingEnds( item );
+        }
+
         m_drawList.Append( aList );
         --m_modification_sync;
     }
 
+    /**
+     * Tell the screen that the geometry of \a aItem has changed, or is about to change, so
+     * that the hit tests find it at its new place.
+     *
+     * The item is reindexed by the next hit test, so this can be called before the change.
+     * Changing a field or a sheet pin changes the geometry of its parent.
+     *
+     * @param aItem is an item of the screen.  Other items are ignored.
+     */
+    void Update( SCH_ITEM* aItem );
+
+    /**
+     * Check the indexed geometry of all the items of the screen, to catch the changes which
+     * were not reported by Update().
+     */
+    void RevalidateIndex()
+    {
+        m_rtree.Revalidate();
+    }
+
+    /**
+     * @return the spatial index of the draw list items.
+     */
+    const EE_RTREE& Items() const
+    {
+        return m_rtree;
+    }
+
     /**
      * Delete all draw items and clears the project settings.
      */
@@ -264,9 +318,14 @@ public:
 
     /**
      * Test all of the connectable objects in the schematic for unused connection points.
+     *
+     * Only the items which changed since the last test, and the items connected to them
+     * before or after the change, are tested again.
+     *
+     * @param aChangedHandler is called for each item whose connection state changed.
      * @return True if any connection state changes were made.
      */
-    bool TestDanglingEnds();
+    bool TestDanglingEnds( const std::function<void( SCH_ITEM* )>& aChangedHandler = nullptr );
 
     /**
      * Replace all of the wires, buses, and junctions in the screen with \a aWireList.
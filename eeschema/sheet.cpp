@@ -308,6 +308,7 @@ bool SCH_EDIT_FRAME::EditSheet( SCH_SHEET* aSheet, SCH_SHEET_PATH* aHierarchy,
     m_canvas->SetIgnoreMouseEvents( false );
 
     GetCanvas()->GetView()->Update( aSheet );
+    GetScreen()->Update( aSheet );
 
     OnModify();
 
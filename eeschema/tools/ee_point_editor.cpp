@@ -522,6 +522,7 @@ void EE_POINT_EDITOR::updateItem() const
                 connection->SetEndPoint( line->GetPosition() );
 
             getView()->Update( connection, KIGFX::GEOMETRY );
+            m_frame->GetScreen()->Update( connection );
         }
 
         connection = (SCH_LINE*) ( m_editPoints->Point( LINE_END ).GetConnection() );
@@ -534,6 +535,7 @@ void EE_POINT_EDITOR::updateItem() const
                 connection->SetEndPoint( line->GetEndPoint() );
 
             getView()->Update( connection, KIGFX::GEOMETRY );
+            m_frame->GetScreen()->Update( connection );
         }
 
         break;
@@ -104,6 +104,7 @@ public:
 
 protected:
     ///> Similar to getView()->Update(), but handles items that are redrawn by their parents.
+    ///> Schematic items are also reindexed for the hit tests of the screen.
     void updateView( EDA_ITEM* aItem ) const
     {
         KICAD_T itemType = aItem->Type();
@@ -112,6 +113,9 @@ protected:
             getView()->Update( aItem->GetParent() );
 
         getView()->Update( aItem );
+
+        if( SCH_ITEM* item = dynamic_cast<SCH_ITEM*>( aItem ) )
+            m_frame->GetScreen()->Update( item );
     }
 
 
@@ -908,7 +908,7 @@ int SCH_EDITOR_CONTROL::Paste( const TOOL_EVENT& aEvent )
     for( SCH_ITEM* item = last ? last->Next() : dlist.GetFirst(); item; item = next )
     {
         next = item->Next();
-        dlist.Remove( item );
+        m_frame->GetScreen()->Remove( item );
 
         loadedItems.push_back( item );
 
@@ -24,6 +24,8 @@
 #ifndef ADVANCED_CFG__H
 #define ADVANCED_CFG__H
 
+#include <wx/string.h>
+
 class wxConfigBase;
 
 /**
@@ -78,6 +80,17 @@ public:
      */
     bool m_realTimeConnectivity;
 
+    /**
+     * Verify the incremental connectivity updates against a full rebuild
+     */
+    bool m_checkIncrementalConnectivity;
+
+    /**
+     * File the interactive router writes the input events of its sessions to, for the
+     * router replay benchmark.  Empty to not record them.
+     */
+    wxString m_routerEventLog;
+
     /**
      * Helper to determine if legacy canvas is allowed (according to platform
      * and config)
@@ -102,6 +102,10 @@ protected:
 
     bool                commentsAreTokens;      ///< true if should return comments as tokens
 
+    bool                inPlaceLines;           ///< true if lines are tokenized where the
+                                                ///< LINE_READER stores them, without copy
+    std::string         curLine;                ///< nul terminated copy of an in place line
+
     int                 prevTok;                ///< curTok from previous NextTok() call.
     int                 curOffset;              ///< offset within current line of the current token
 
@@ -118,13 +122,13 @@ protected:
     {
         if( reader )
         {
-            reader->ReadLine();
+            const char* line = inPlaceLines ? reader->ReadLineInPlace() : reader->ReadLine();
 
             unsigned len = reader->Length();
 
             // start may have changed in ReadLine(), which can resize and
             // relocate reader's line buffer.
-            start = reader->Line();
+            start = line ? line : reader->Line();
 
             next  = start;
             limit = next + len;
@@ -239,6 +243,18 @@ public:
      */
     void SetSpecctraMode( bool aMode );
 
+    /**
+     * Function SetInPlaceLines
+     * enables reading the lines with LINE_READER::ReadLineInPlace(): readers which
+     * hold their whole text in memory, such as MAPPED_FILE_LINE_READER, are then
+     * tokenized without copying each line.  Do not use when something else than this
+     * lexer reads the line buffer of the LINE_READER.
+     */
+    void SetInPlaceLines( bool aInPlace )
+    {
+        inPlaceLines = aInPlace;
+    }
+
     /**
      * Function PushReader
      * manages a stack of LINE_READERs in order to handle nested file inclusion.
@@ -516,6 +532,13 @@ public:
      */
     const char* CurLine()
     {
+        if( inPlaceLines )
+        {
+            // Lines read in place are not nul terminated
+            curLine.assign( start, reader->Length() );
+            return curLine.c_str();
+        }
+
         return (const char*)(*reader);
     }
 
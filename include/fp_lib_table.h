@@ -203,6 +203,18 @@ public:
      */
     const MODULE* GetEnumeratedFootprint( const wxString& aNickname,
                                           const wxString& aFootprintName );
+
+    /**
+     * Function GetEnumeratedFootprintMetadata
+     *
+     * fetches the chooser fields of a footprint found by FootprintEnumerate(), which
+     * plugins with a library index can supply without loading the footprint.
+     *
+     * @return true if the footprint was found.
+     */
+    bool GetEnumeratedFootprintMetadata( const wxString& aNickname,
+                                         const wxString& aFootprintName,
+                                         FOOTPRINT_METADATA& aMetadata );
     /**
      * Enum SAVE_T
      * is the set of return values from FootprintSave() below.
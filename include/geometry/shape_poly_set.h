@@ -26,9 +26,11 @@
 #ifndef __SHAPE_POLY_SET_H
 #define __SHAPE_POLY_SET_H
 
+#include <atomic>
 #include <vector>
 #include <cstdio>
 #include <memory>
+#include <functional>
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 
@@ -49,7 +51,12 @@
  *      outline or a hole.
  *      - Vertex (or corner): each one of the points that define a contour.
  *
- * TODO: add convex partitioning & spatial index
+ * Contains(), Collide() and DistanceToPolygon() use a spatial index of the edges, built
+ * lazily on the first query of a large set and dropped by every non-const method,
+ * including the non-const accessors.  References obtained from those accessors must
+ * therefore not be used to modify the set after it has been queried.
+ *
+ * TODO: add convex partitioning
  */
 class SHAPE_POLY_SET : public SHAPE
 {
@@ -348,7 +355,7 @@ class SHAPE_POLY_SET : public SHAPE
 
             T Get()
             {
-                return m_poly->Polygon( m_currentPolygon )[m_currentContour].Segment( m_currentSegment );
+                return m_poly->CPolygon( m_currentPolygon )[m_currentContour].Segment( m_currentSegment );
             }
 
             T operator*()
@@ -574,6 +581,7 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Returns the reference to aIndex-th outline in the set
         SHAPE_LINE_CHAIN& Outline( int aIndex )
         {
+            markIndexUnverified();
             return m_polys[aIndex][0];
         }
 
@@ -596,12 +604,14 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Returns the reference to aHole-th hole in the aIndex-th outline
         SHAPE_LINE_CHAIN& Hole( int aOutline, int aHole )
         {
+            markIndexUnverified();
             return m_polys[aOutline][aHole + 1];
         }
 
         ///> Returns the aIndex-th subpolygon in the set
         POLYGON& Polygon( int aIndex )
         {
+            markIndexUnverified();
             return m_polys[aIndex];
         }
 
@@ -644,6 +654,8 @@ class SHAPE_POLY_SET : public SHAPE
         {
             ITERATOR iter;
 
+            markIndexUnverified();
+
             iter.m_poly = this;
             iter.m_currentPolygon = aFirst;
             iter.m_lastPolygon = aLast < 0 ? OutlineCount() - 1 : aLast;
@@ -1143,21 +1155,49 @@ class SHAPE_POLY_SET : public SHAPE
                         const SHAPE_POLY_SET& aShape,
                         const SHAPE_POLY_SET& aOtherShape, POLYGON_MODE aFastMode );
 
-        bool pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const;
+        class SEGMENT_INDEX;
+
+        ///> Edge visitor: gets the edge, its polygon and its contour; returns false to stop.
+        typedef std::function<bool( const SEG&, int, int )> EDGE_VISITOR;
 
         /**
-         * containsSingle function
-         * Checks whether the point aP is inside the aSubpolyIndex-th polygon of the polyset. If
-         * the points lies on an edge, the polygon is considered to contain it.
-         * @param  aP            is the VECTOR2I point whose position with respect to the inside of
-         *                       the aSubpolyIndex-th polygon will be tested.
-         * @param  aSubpolyIndex is an integer specifying which polygon in the set has to be
-         *                       checked.
-         * @param  aIgnoreHoles  can be set to true to ignore internal holes in the polygon
-         * @return bool - true if aP is inside aSubpolyIndex-th polygon; false in any other
-         *         case.
+         * Function segmentIndex
+         * returns the spatial index of the edges, building it if needed, or an empty pointer
+         * for sets too small to benefit from one.
          */
-        bool containsSingle( const VECTOR2I& aP, int aSubpolyIndex, bool aIgnoreHoles = false ) const;
+        std::shared_ptr<const SEGMENT_INDEX> segmentIndex() const;
+
+        ///> Drops the spatial index; called by everything that modifies the set.
+        void invalidateIndex()
+        {
+            std::atomic_store( &m_segmentIndex, std::shared_ptr<const SEGMENT_INDEX>() );
+            m_segmentIndexUnverified = false;
+        }
+
+        ///> Called by the accessors handing out modifiable contours, which are mostly only
+        ///> read: the index is checked against the set checksum before its next use.
+        void markIndexUnverified()
+        {
+            m_segmentIndexUnverified = true;
+        }
+
+        /**
+         * Function visitEdges
+         * calls \p aVisitor for the edges whose bounding box intersects the box between
+         * \p aMin and \p aMax.  Without an index, every edge is visited.
+         */
+        void visitEdges( const VECTOR2I& aMin, const VECTOR2I& aMax,
+                         const EDGE_VISITOR& aVisitor ) const;
+
+        /**
+         * Function squaredDistanceToEdges
+         * returns the smallest \p aDistance of the edges of the aPolygonIndex-th polygon,
+         * \p aDistance being a squared distance to an object whose bounding box lies between
+         * \p aMin and \p aMax.
+         */
+        SEG::ecoord squaredDistanceToEdges( const VECTOR2I& aMin, const VECTOR2I& aMax,
+                                            int aPolygonIndex,
+                                            const std::function<SEG::ecoord( const SEG& )>& aDistance ) const;
 
         /**
          * Operations ChamferPolygon and FilletPolygon are computed under the private chamferFillet
@@ -1213,6 +1253,12 @@ class SHAPE_POLY_SET : public SHAPE
         bool m_triangulationValid = false;
         MD5_HASH m_hash;
 
+        ///> Lazily built edge index, shared between copies since it is never modified
+        mutable std::shared_ptr<const SEGMENT_INDEX> m_segmentIndex;
+
+        ///> True when m_segmentIndex may no longer match the contours
+        mutable std::atomic<bool> m_segmentIndexUnverified;
+
 };
 
 #endif
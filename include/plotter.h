@@ -32,8 +32,10 @@
 #ifndef PLOT_COMMON_H_
 #define PLOT_COMMON_H_
 
+#include <unordered_map>
 #include <vector>
 #include <math/box2.h>
+#include <richio.h>
 #include <draw_graphic_text.h>
 #include <page_info.h>
 #include <eda_text.h>       // FILL_T
@@ -1228,18 +1230,31 @@ protected:
     // The last aperture attribute generated (only one aperture attribute can be set)
     int           m_apertureAttribute;
 
-    FILE* workFile;
-    FILE* finalFile;
-    wxString m_workFilename;
+    // The plot commands, written to the file after the aperture list by EndPlot()
+    STRING_FORMATTER m_body;
 
     /**
      * Generate the table of D codes
      */
     void writeApertureList();
 
+    /// Hash and equality of the apertures by size, type and attribute, ignoring the D code
+    struct APERTURE_KEY_HASH
+    {
+        size_t operator()( const APERTURE& aAperture ) const;
+    };
+
+    struct APERTURE_KEY_EQUAL
+    {
+        bool operator()( const APERTURE& aFirst, const APERTURE& aSecond ) const;
+    };
+
     std::vector<APERTURE>           apertures;
     std::vector<APERTURE>::iterator currentAperture;
 
+    // Index in apertures of each aperture, to find the existing ones
+    std::unordered_map<APERTURE, size_t, APERTURE_KEY_HASH, APERTURE_KEY_EQUAL> m_apertureIndex;
+
     bool     m_gerberUnitInch;  // true if the gerber units are inches, false for mm
     int      m_gerberUnitFmt;   // number of digits in mantissa.
                                 // usually 6 in Inches and 5 or 6  in mm
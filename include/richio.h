@@ -120,6 +120,20 @@ public:
      */
     virtual char* ReadLine() = 0;
 
+    /**
+     * Function ReadLineInPlace
+     * reads a line like ReadLine(), but a reader holding all its text in memory may
+     * return the line where it is stored instead of copying it into the line buffer.
+     * In that case the line is not nul terminated and Line() is not updated: only the
+     * returned pointer and Length() are valid, until the next read.
+     * @return const char* - The beginning of the read line, or NULL if EOF.
+     * @throw IO_ERROR when a line is too long.
+     */
+    virtual const char* ReadLineInPlace()
+    {
+        return ReadLine();
+    }
+
     /**
      * Function GetSource
      * returns the name of the source of the lines in an abstract sense.
@@ -247,6 +261,96 @@ public:
 };
 
 
+/**
+ * Class MEMORY_LINE_READER
+ * is a LINE_READER that reads from a block of memory it does not own, such as a part of
+ * a mapped file.  ReadLineInPlace() returns the lines where they are stored, without
+ * any copy.
+ */
+class MEMORY_LINE_READER : public LINE_READER
+{
+protected:
+    const char* m_data;     ///< the text to read, may be NULL if m_size is 0.
+    size_t      m_size;     ///< the size of the text.
+    size_t      m_ndx;      ///< offset of the next line in the text.
+
+public:
+
+    /**
+     * Constructor MEMORY_LINE_READER
+     *
+     * @param aData is the text to read, which must stay valid while it is read.
+     * @param aSize is the size of the text.  The last line does not necessarily
+     *  need a trailing '\n'.
+     * @param aSource describes the source of the text for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error, see
+     *  FILE_LINE_READER.
+     * @param aMaxLineLength is the maximum supported line length.
+     */
+    MEMORY_LINE_READER( const char* aData, size_t aSize, const wxString& aSource,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    char* ReadLine() override;
+
+    const char* ReadLineInPlace() override;
+
+    /**
+     * Function Data
+     * returns the text read by this reader: the lines returned by ReadLineInPlace()
+     * are in the range [Data(), Data() + Size()).
+     */
+    const char* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the text and resets the line number back to zero.
+     */
+    void Rewind()
+    {
+        m_ndx = 0;
+        m_lineNum = 0;
+    }
+};
+
+
+/**
+ * Class MAPPED_FILE_LINE_READER
+ * is a MEMORY_LINE_READER on a whole file mapped in memory, used instead of reading
+ * the file through a FILE.  Unlike FILE_LINE_READER, line ends are not translated:
+ * lines read from a file with CR LF line ends keep their CR.
+ */
+class MAPPED_FILE_LINE_READER : public MEMORY_LINE_READER
+{
+public:
+
+    /**
+     * Constructor MAPPED_FILE_LINE_READER
+     * maps @a aFileName in memory.  The file is not locked, and must not be modified
+     * while it is read.
+     *
+     * @param aFileName is the name of the file to map and to use for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error.
+     * @param aMaxLineLength is the maximum supported line length.
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened or mapped.
+     */
+    MAPPED_FILE_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~MAPPED_FILE_LINE_READER();
+};
+
+
 /**
  * Class STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
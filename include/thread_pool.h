@@ -0,0 +1,226 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PROGRESS_REPORTER;
+class TASK_GROUP;
+
+/**
+ * A process-wide pool of worker threads, shared by all the parallel algorithms so that
+ * concurrent jobs (e.g. a zone refill during a ratsnest update) do not oversubscribe the CPU
+ * and do not pay the thread creation cost on each call.
+ *
+ * Each worker owns a deque of tasks: it runs its own tasks from the back and, when it runs
+ * dry, steals tasks from the front of the other deques.  Tasks submitted by threads outside
+ * the pool go to a shared queue.  A thread waiting for a TASK_GROUP runs the pending tasks
+ * of that group instead of blocking, so parallel loops can be nested.  It does not pick up
+ * the tasks of other groups, which could keep it busy long after its own group is done.
+ *
+ * Tasks are submitted through a TASK_GROUP.
+ */
+class THREAD_POOL
+{
+public:
+    /**
+     * Function GetInstance
+     * @return the pool shared by the whole process, created on first use with one worker
+     * per hardware thread.
+     */
+    static THREAD_POOL& GetInstance();
+
+    THREAD_POOL( size_t aThreadCount );
+    ~THREAD_POOL();
+
+    THREAD_POOL( const THREAD_POOL& ) = delete;
+    THREAD_POOL& operator=( const THREAD_POOL& ) = delete;
+
+    /**
+     * @return the number of worker threads of the pool.
+     */
+    size_t GetThreadCount() const
+    {
+        return m_workers.size();
+    }
+
+    /**
+     * @return true if the calling thread is one of the workers of this pool.
+     */
+    bool IsWorkerThread() const;
+
+private:
+    friend class TASK_GROUP;
+
+    struct TASK
+    {
+        std::function<void()> m_func;
+        TASK_GROUP*           m_group;
+    };
+
+    struct TASK_QUEUE
+    {
+        std::mutex       m_mutex;
+        std::deque<TASK> m_tasks;
+    };
+
+    /**
+     * Queues aTask: on the deque of the calling worker, or on the shared queue when
+     * called from outside the pool.
+     */
+    void submit( TASK&& aTask );
+
+    /**
+     * Runs one pending task, if any.
+     * @param aGroup if not null, only a task of this group is run.
+     * @return false if there was nothing to run.
+     */
+    bool runPendingTask( TASK_GROUP* aGroup = nullptr );
+
+    bool popTask( TASK& aTask, TASK_GROUP* aGroup );
+
+    void workerLoop( size_t aIndex );
+
+    ///> One deque per worker, followed by the queue of the tasks submitted from outside
+    std::vector<std::unique_ptr<TASK_QUEUE>> m_queues;
+
+    std::vector<std::thread> m_workers;
+
+    ///> Number of tasks sitting in the queues
+    std::atomic<size_t>     m_queuedCount;
+
+    std::mutex              m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    bool                    m_quit;
+};
+
+
+/**
+ * A set of tasks running on a THREAD_POOL, which can be waited for and cancelled together.
+ *
+ * Cancellation is cooperative: the tasks not started yet are dropped, ParallelFor() stops
+ * handing out indices and the running tasks may poll IsCancelled().
+ *
+ * The first exception thrown by a task is rethrown by Wait().  The destructor waits for the
+ * remaining tasks.
+ */
+class TASK_GROUP
+{
+public:
+    TASK_GROUP( THREAD_POOL& aPool = THREAD_POOL::GetInstance() );
+    ~TASK_GROUP();
+
+    TASK_GROUP( const TASK_GROUP& ) = delete;
+    TASK_GROUP& operator=( const TASK_GROUP& ) = delete;
+
+    /**
+     * Queues aTask on the pool.
+     */
+    void Run( std::function<void()> aTask );
+
+    /**
+     * Queues the calls aFunc( i ) for i in [0, aCount), in chunks of aGrain indices handed
+     * out in increasing order to as many tasks as the pool has workers.
+     */
+    void ParallelFor( size_t aCount, std::function<void( size_t )> aFunc, size_t aGrain = 1 );
+
+    /**
+     * Waits until all the tasks are finished, running the pending tasks of the group
+     * meanwhile.
+     */
+    void Wait();
+
+    /**
+     * Waits until all the tasks are finished, keeping aReporter refreshed.  Unlike Wait(),
+     * the calling thread does not run any task, so that it can be the GUI thread.
+     * @param aReporter may be null, in which case this is the same as Wait().
+     * @param aCanCancel tells if the group is cancelled when the user aborts.
+     * @return false if the group was cancelled.
+     */
+    bool Wait( PROGRESS_REPORTER* aReporter, bool aCanCancel = true );
+
+    /**
+     * Waits at most aTimeout for the tasks to finish, without running any of them, so that
+     * a GUI thread can refresh its own progress display in between.  Call Wait() once this
+     * returns true to get the exceptions of the tasks.
+     * @return true if all the tasks are finished.
+     */
+    bool WaitFor( std::chrono::milliseconds aTimeout );
+
+    void Cancel()
+    {
+        m_cancelled = true;
+    }
+
+    bool IsCancelled() const
+    {
+        return m_cancelled;
+    }
+
+    /**
+     * @return true if there are no more pending or running tasks.
+     */
+    bool IsDone() const
+    {
+        return m_pending == 0;
+    }
+
+    /**
+     * @return the number of threads a job of this group can run on.
+     */
+    size_t GetThreadCount() const
+    {
+        return m_pool.GetThreadCount();
+    }
+
+private:
+    friend class THREAD_POOL;
+
+    void execute( THREAD_POOL::TASK& aTask );
+    void waitForTasks();
+    void rethrowException();
+
+    THREAD_POOL&            m_pool;
+    std::atomic<size_t>     m_pending;
+    std::atomic<bool>       m_cancelled;
+    std::exception_ptr      m_exception;
+    std::mutex              m_mutex;
+    std::condition_variable m_finished;
+};
+
+
+/**
+ * Function ParallelFor
+ * calls aFunc( i ) for i in [0, aCount) on the shared thread pool and waits for completion.
+ * May be called from inside another parallel loop.
+ */
+void ParallelFor( size_t aCount, std::function<void( size_t )> aFunc, size_t aGrain = 1 );
+
+#endif // THREAD_POOL_H
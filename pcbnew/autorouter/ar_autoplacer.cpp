@@ -25,6 +25,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <atomic>
+
 #include <fctsys.h>
 #include <class_drawpanel.h>
 #include <confirm.h>
@@ -46,6 +48,7 @@
 #include <ratsnest_data.h>
 
 #include <widgets/progress_reporter.h>
+#include <thread_pool.h>
 
 #include "ar_matrix.h"
 #include "ar_cell.h"
@@ -156,8 +159,7 @@ int AR_AUTOPLACER::genPlacementRoutingMatrix()
 
 bool AR_AUTOPLACER::fillMatrix()
 {
-    std::vector <int> x_coordinates;
-    bool success = true;
+    std::atomic<bool> success( true );
     int step = m_matrix.m_GridRouting;
     wxPoint coord_orgin = m_matrix.GetBrdCoordOrigin(); // Board coordinate of matruix cell (0,0)
 
@@ -167,23 +169,27 @@ bool AR_AUTOPLACER::fillMatrix()
     const SHAPE_LINE_CHAIN& outline = brd_shape.Outline(0);
     const BOX2I& rect = outline.BBox();
 
+    m_matrix.SetCellOperation( AR_MATRIX::WRITE_CELL );
+
     // Creates the horizontal segments
     // Calculate the y limits of the area
-    for( int refy = rect.GetY(), endy = rect.GetBottom(); refy < endy; refy += step )
+    int starty = rect.GetY();
+    int scanCount = ( rect.GetBottom() - starty + step - 1 ) / step;
+
+    // Each line scan fills its own row of the matrix: the lines are scanned in parallel
+    ParallelFor( std::max( scanCount, 0 ), [&]( size_t aScan )
     {
+        int refy = starty + (int) aScan * step;
+
         // The row index (vertical position) of current line scan inside the placement matrix
         int idy = (refy - coord_orgin.y) / step;
 
-        // Ensure we are still inside the placement matrix
-        if( idy >= m_matrix.m_Nrows )
-            break;
-
         // Ensure we are inside the placement matrix
-        if( idy <= 0 )
-            continue;
+        if( idy <= 0 || idy >= m_matrix.m_Nrows )
+            return;
 
         // find all intersection points of an infinite line with polyline sides
-        x_coordinates.clear();
+        std::vector <int> x_coordinates;
 
         for( int v = 0; v < outline.PointCount(); v++ )
         {
@@ -240,7 +246,7 @@ bool AR_AUTOPLACER::fillMatrix()
         if( ( x_coordinates.size() & 1 ) != 0 )
         {
             success = false;
-            break;
+            return;
         }
 
         // Fill cells having the same Y coordinate
@@ -250,20 +256,18 @@ bool AR_AUTOPLACER::fillMatrix()
         {
             int seg_start_x = x_coordinates[ii] - coord_orgin.x;
             int seg_end_x = x_coordinates[ii + 1] - coord_orgin.x;
-            // Fill cells at y coord = idy,
-            // and at x cood >= seg_start_x and <= seg_end_x
 
-            for( int idx = seg_start_x / step; idx < m_matrix.m_Ncols; idx++ )
-            {
-                if( idx * step > seg_end_x )
-                    break;
+            if( seg_end_x < 0 )
+                continue;
 
-                if( idx * step >= seg_start_x )
-                    m_matrix.SetCell( idy, idx, AR_SIDE_BOTTOM, CELL_IS_ZONE );
-            }
+            // Fill cells at y coord = idy,
+            // and at x cood >= seg_start_x and <= seg_end_x
+            int col_min = seg_start_x > 0 ? ( seg_start_x + step - 1 ) / step : 0;
+            int col_max = seg_end_x / step;
 
+            m_matrix.FillSpan( idy, col_min, col_max, AR_SIDE_BOTTOM, CELL_IS_ZONE );
         }
-    }   // End examine segments in one area
+    } );
 
     return success;
 }
@@ -472,19 +476,11 @@ int AR_AUTOPLACER::testRectangle( const EDA_RECT& aRect, int side )
     if( col_max >= ( m_matrix.m_Ncols - 1 ) )
         col_max = m_matrix.m_Ncols - 1;
 
-    for( int row = row_min; row <= row_max; row++ )
-    {
-        for( int col = col_min; col <= col_max; col++ )
-        {
-            unsigned int data = m_matrix.GetCell( row, col, side );
-
-            if( ( data & CELL_IS_ZONE ) == 0 )
-                return AR_OUT_OF_BOARD;
+    if( m_matrix.CountOutOfBoardCells( row_min, col_min, row_max, col_max, side ) > 0 )
+        return AR_OUT_OF_BOARD;
 
-            if( (data & CELL_IS_MODULE) )
-                return AR_OCCUIPED_BY_MODULE;
-        }
-    }
+    if( m_matrix.CountModuleCells( row_min, col_min, row_max, col_max, side ) > 0 )
+        return AR_OCCUIPED_BY_MODULE;
 
     return AR_FREE_CELL;
 }
@@ -541,21 +537,8 @@ unsigned int AR_AUTOPLACER::calculateKeepOutArea( const EDA_RECT& aRect, int sid
     if( col_max >= ( m_matrix.m_Ncols - 1 ) )
         col_max = m_matrix.m_Ncols - 1;
 
-    unsigned int keepOutCost = 0;
-
-    for( int row = row_min; row <= row_max; row++ )
-    {
-        for( int col = col_min; col <= col_max; col++ )
-        {
-            // m_matrix.GetDist returns the "cost" of the cell
-            // at position (row, col)
-            // in autoplace this is the cost of the cell, if it is
-            // inside aRect
-            keepOutCost += m_matrix.GetDist( row, col, side );
-        }
-    }
-
-    return keepOutCost;
+    // m_matrix.SumDist returns the sum of the "cost" of the cells inside aRect
+    return (unsigned int) m_matrix.SumDist( row_min, col_min, row_max, col_max, side );
 }
 
 
@@ -576,8 +559,6 @@ int AR_AUTOPLACER::testModuleOnBoard( MODULE* aModule, bool TstOtherSide, const
     EDA_RECT    fpBBox = aModule->GetFootprintRect();
     fpBBox.Move( -aOffset );
 
-    buildFpAreas( aModule, 0 );
-
     int diag = //testModuleByPolygon( aModule, side, aOffset );
         testRectangle( fpBBox, side );
 //printf("test %p diag %d\n", aModule, diag);fflush(0);
@@ -652,6 +633,9 @@ int AR_AUTOPLACER::getOptimalModulePlacement(MODULE* aModule)
 
     fpBBox.SetOrigin( fpBBoxOrg + m_curPosition );
 
+    // The footprint areas do not depend on the tested position: build them once
+    buildFpAreas( aModule, 0 );
+
     min_cost = -1.0;
 //    m_frame->SetStatusText( wxT( "Score ??, pos ??" ) );
 
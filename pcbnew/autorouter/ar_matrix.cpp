@@ -28,8 +28,12 @@
 #include "ar_matrix.h"
 #include "ar_cell.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <common.h>
 #include <math_for_graphics.h>
+#include <thread_pool.h>
 #include <trigo.h>
 
 #include <class_drawsegment.h>
@@ -41,7 +45,8 @@ AR_MATRIX::AR_MATRIX()
     m_BoardSide[0] = m_BoardSide[1] = nullptr;
     m_DistSide[0] = m_DistSide[1] = nullptr;
     m_DirSide[0] = m_DirSide[1] = nullptr;
-    m_opWriteCell = nullptr;
+    m_cellOp = WRITE_CELL;
+    invalidateSummedAreaTables();
     m_InitMatrixDone = false;
     m_Nrows = 0;
     m_Ncols = 0;
@@ -95,6 +100,7 @@ int AR_MATRIX::InitRoutingMatrix()
         return 0;
 
     m_InitMatrixDone = true; // we have been called
+    invalidateSummedAreaTables();
 
     // give a small margin for memory allocation:
     int ii = ( m_Nrows + 1 ) * ( m_Ncols + 1 );
@@ -142,9 +148,15 @@ void AR_MATRIX::UnInitRoutingMatrix()
     int ii;
 
     m_InitMatrixDone = false;
+    invalidateSummedAreaTables();
 
     for( ii = 0; ii < AR_MAX_ROUTING_LAYERS_COUNT; ii++ )
     {
+        // de-allocate summed-area tables
+        std::vector<uint16_t>().swap( m_outOfBoardSat[ii] );
+        std::vector<uint16_t>().swap( m_moduleSat[ii] );
+        std::vector<uint32_t>().swap( m_distSat[ii] );
+
         // de-allocate Dir matrix
         if( m_DirSide[ii] )
         {
@@ -170,22 +182,197 @@ void AR_MATRIX::UnInitRoutingMatrix()
     m_Nrows = m_Ncols = 0;
 }
 
-// Initialize m_opWriteCell member to make the aLogicOp
+// Initialize m_cellOp member to make the aLogicOp
 void AR_MATRIX::SetCellOperation( AR_MATRIX::CELL_OP aLogicOp )
 {
-    switch( aLogicOp )
+    m_cellOp = aLogicOp;
+    invalidateSummedAreaTables();
+}
+
+
+void AR_MATRIX::FillSpan( int aRow, int aColMin, int aColMax, int aSide, MATRIX_CELL aCell )
+{
+    if( aRow < 0 || aRow >= m_Nrows )
+        return;
+
+    aColMin = std::max( aColMin, 0 );
+    aColMax = std::min( aColMax, m_Ncols - 1 );
+
+    if( aColMin > aColMax )
+        return;
+
+    invalidateSummedAreaTables();
+
+    MATRIX_CELL* p = m_BoardSide[aSide] + aRow * m_Ncols;
+    int          col;
+
+    // One loop per operation, so that the compiler can vectorize each of them
+    switch( m_cellOp )
     {
     default:
-    case WRITE_CELL: m_opWriteCell = &AR_MATRIX::SetCell; break;
+    case WRITE_CELL:
+        memset( p + aColMin, aCell, ( aColMax - aColMin + 1 ) * sizeof( MATRIX_CELL ) );
+        break;
+
+    case WRITE_OR_CELL:
+        for( col = aColMin; col <= aColMax; col++ )
+            p[col] |= aCell;
+        break;
+
+    case WRITE_XOR_CELL:
+        for( col = aColMin; col <= aColMax; col++ )
+            p[col] ^= aCell;
+        break;
+
+    case WRITE_AND_CELL:
+        for( col = aColMin; col <= aColMax; col++ )
+            p[col] &= aCell;
+        break;
+
+    case WRITE_ADD_CELL:
+        for( col = aColMin; col <= aColMax; col++ )
+            p[col] += aCell;
+        break;
+    }
+}
+
+
+void AR_MATRIX::BuildSummedAreaTables()
+{
+    const size_t stride = m_Ncols + 1;
+    const size_t size = ( m_Nrows + 1 ) * stride;
+
+    // The first row and the first column stay null
+    for( int side = 0; side < AR_MAX_ROUTING_LAYERS_COUNT; side++ )
+    {
+        m_outOfBoardSat[side].assign( size, 0 );
+        m_moduleSat[side].assign( size, 0 );
+        m_distSat[side].assign( size, 0 );
+    }
+
+    // Prefix sums along each row, the rows in parallel
+    ParallelFor( m_Nrows, [&]( size_t aRow )
+    {
+        for( int side = 0; side < AR_MAX_ROUTING_LAYERS_COUNT; side++ )
+        {
+            if( !m_BoardSide[side] )
+                continue;
+
+            const MATRIX_CELL* cells = m_BoardSide[side] + aRow * m_Ncols;
+            const DIST_CELL*   dists = m_DistSide[side] + aRow * m_Ncols;
+            uint16_t*          outOfBoard = &m_outOfBoardSat[side][( aRow + 1 ) * stride];
+            uint16_t*          module = &m_moduleSat[side][( aRow + 1 ) * stride];
+            uint32_t*          dist = &m_distSat[side][( aRow + 1 ) * stride];
+
+            for( int col = 0; col < m_Ncols; col++ )
+            {
+                outOfBoard[col + 1] = outOfBoard[col] + ( ( cells[col] & CELL_IS_ZONE ) == 0 );
+                module[col + 1] = module[col] + ( ( cells[col] & CELL_IS_MODULE ) != 0 );
+                dist[col + 1] = dist[col] + dists[col];
+            }
+        }
+    }, 16 );
+
+    // Accumulate the rows downwards, by blocks of columns in parallel so that each task
+    // works on contiguous memory
+    const size_t blockSize = 256;
+
+    ParallelFor( ( stride + blockSize - 1 ) / blockSize, [&]( size_t aBlock )
+    {
+        size_t colMin = aBlock * blockSize;
+        size_t colMax = std::min( stride, colMin + blockSize );
+
+        for( int side = 0; side < AR_MAX_ROUTING_LAYERS_COUNT; side++ )
+        {
+            if( !m_BoardSide[side] )
+                continue;
+
+            for( size_t prev = 0, cur = stride; cur < size; prev = cur, cur += stride )
+            {
+                for( size_t col = colMin; col < colMax; col++ )
+                {
+                    m_outOfBoardSat[side][cur + col] += m_outOfBoardSat[side][prev + col];
+                    m_moduleSat[side][cur + col] += m_moduleSat[side][prev + col];
+                    m_distSat[side][cur + col] += m_distSat[side][prev + col];
+                }
+            }
+        }
+    } );
+
+    m_satValid = true;
+}
+
 
-    case WRITE_OR_CELL: m_opWriteCell = &AR_MATRIX::OrCell; break;
+// Sum of the cells in rows aRowMin..aRowMax and columns aColMin..aColMax, given the
+// summed-area table aSat of a matrix having aStride - 1 columns.  The entries wrap around,
+// so the sum is exact modulo the range of T.
+template <typename T>
+static T rectSum( const std::vector<T>& aSat, size_t aStride,
+                  int aRowMin, int aColMin, int aRowMax, int aColMax )
+{
+    if( aRowMin > aRowMax || aColMin > aColMax )
+        return 0;
+
+    size_t top = aRowMin * aStride;
+    size_t bottom = ( aRowMax + 1 ) * aStride;
 
-    case WRITE_XOR_CELL: m_opWriteCell = &AR_MATRIX::XorCell; break;
+    return static_cast<T>( aSat[bottom + aColMax + 1] - aSat[bottom + aColMin]
+                           - aSat[top + aColMax + 1] + aSat[top + aColMin] );
+}
 
-    case WRITE_AND_CELL: m_opWriteCell = &AR_MATRIX::AndCell; break;
 
-    case WRITE_ADD_CELL: m_opWriteCell = &AR_MATRIX::AddCell; break;
+int AR_MATRIX::countCells( const std::vector<uint16_t>& aSat,
+                           int aRowMin, int aColMin, int aRowMax, int aColMax )
+{
+    if( aRowMin > aRowMax || aColMin > aColMax )
+        return 0;
+
+    // Blocks of at most 0xFFFF cells: their count is below the range of the entries
+    const int maxCells = std::numeric_limits<uint16_t>::max();
+    const int colStep = std::min( aColMax - aColMin + 1, maxCells );
+    const int rowStep = maxCells / colStep;
+    int       count = 0;
+
+    for( int row = aRowMin; row <= aRowMax; row += rowStep )
+    {
+        int lastRow = std::min( aRowMax, row + rowStep - 1 );
+
+        for( int col = aColMin; col <= aColMax; col += colStep )
+        {
+            count += rectSum( aSat, m_Ncols + 1, row, col, lastRow,
+                              std::min( aColMax, col + colStep - 1 ) );
+        }
     }
+
+    return count;
+}
+
+
+int AR_MATRIX::CountOutOfBoardCells( int aRowMin, int aColMin, int aRowMax, int aColMax,
+                                     int aSide )
+{
+    if( !m_satValid )
+        BuildSummedAreaTables();
+
+    return countCells( m_outOfBoardSat[aSide], aRowMin, aColMin, aRowMax, aColMax );
+}
+
+
+int AR_MATRIX::CountModuleCells( int aRowMin, int aColMin, int aRowMax, int aColMax, int aSide )
+{
+    if( !m_satValid )
+        BuildSummedAreaTables();
+
+    return countCells( m_moduleSat[aSide], aRowMin, aColMin, aRowMax, aColMax );
+}
+
+
+uint32_t AR_MATRIX::SumDist( int aRowMin, int aColMin, int aRowMax, int aColMax, int aSide )
+{
+    if( !m_satValid )
+        BuildSummedAreaTables();
+
+    return rectSum( m_distSat[aSide], m_Ncols + 1, aRowMin, aColMin, aRowMax, aColMax );
 }
 
 
@@ -208,6 +395,7 @@ void AR_MATRIX::SetCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 
     p = m_BoardSide[aSide];
     p[aRow * m_Ncols + aCol] = x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -219,6 +407,7 @@ void AR_MATRIX::OrCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 
     p = m_BoardSide[aSide];
     p[aRow * m_Ncols + aCol] |= x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -230,6 +419,7 @@ void AR_MATRIX::XorCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 
     p = m_BoardSide[aSide];
     p[aRow * m_Ncols + aCol] ^= x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -241,6 +431,7 @@ void AR_MATRIX::AndCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 
     p = m_BoardSide[aSide];
     p[aRow * m_Ncols + aCol] &= x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -252,6 +443,7 @@ void AR_MATRIX::AddCell( int aRow, int aCol, int aSide, MATRIX_CELL x )
 
     p = m_BoardSide[aSide];
     p[aRow * m_Ncols + aCol] += x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -272,6 +464,7 @@ void AR_MATRIX::SetDist( int aRow, int aCol, int aSide, DIST_CELL x )
 
     p = m_DistSide[aSide];
     p[aRow * m_Ncols + aCol] = x;
+    invalidateSummedAreaTables();
 }
 
 
@@ -882,7 +1075,7 @@ void AR_MATRIX::TraceFilledRectangle( int ux0, int uy0, int ux1, int uy1, double
 void AR_MATRIX::TraceFilledRectangle( int ux0, int uy0, int ux1, int uy1, LSET aLayerMask,
         int color, AR_MATRIX::CELL_OP op_logic )
 {
-    int row, col;
+    int row;
     int row_min, row_max, col_min, col_max;
     int trace = 0;
 
@@ -929,14 +1122,11 @@ void AR_MATRIX::TraceFilledRectangle( int ux0, int uy0, int ux1, int uy1, LSET a
 
     for( row = row_min; row <= row_max; row++ )
     {
-        for( col = col_min; col <= col_max; col++ )
-        {
-            if( trace & 1 )
-                WriteCell( row, col, AR_SIDE_BOTTOM, color );
+        if( trace & 1 )
+            FillSpan( row, col_min, col_max, AR_SIDE_BOTTOM, color );
 
-            if( trace & 2 )
-                WriteCell( row, col, AR_SIDE_TOP, color );
-        }
+        if( trace & 2 )
+            FillSpan( row, col_min, col_max, AR_SIDE_TOP, color );
     }
 }
 
@@ -997,10 +1187,11 @@ void AR_MATRIX::tracePcbLine(
         if( lim >= m_Ncols )
             lim = m_Ncols - 1;
 
-        for( ; dx <= lim; dx++ )
-        {
-            OP_CELL( layer, dy, dx );
-        }
+        if( layer == UNDEFINED_LAYER || layer == m_routeLayerBottom )
+            FillSpan( dy, dx, lim, AR_SIDE_BOTTOM, color );
+
+        if( m_RoutingLayersCount > 1 && ( layer == UNDEFINED_LAYER || layer == m_routeLayerTop ) )
+            FillSpan( dy, dx, lim, AR_SIDE_TOP, color );
 
         return;
     }
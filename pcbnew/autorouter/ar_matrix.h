@@ -29,6 +29,10 @@
 #ifndef __AR_MATRIX_H
 #define __AR_MATRIX_H
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
 #include <eda_rect.h>
 #include <layers_id_colors_and_visibility.h>
 
@@ -69,11 +73,6 @@ public:
     PCB_LAYER_ID m_routeLayerTop;
     PCB_LAYER_ID m_routeLayerBottom;
 
-private:
-    // a pointer to the current selected cell operation
-    void ( AR_MATRIX::*m_opWriteCell )( int aRow, int aCol, int aSide, MATRIX_CELL aCell );
-
-public:
     enum CELL_OP
     {
         WRITE_CELL = 0,
@@ -83,14 +82,61 @@ public:
         WRITE_ADD_CELL = 4
     };
 
+private:
+    // the current selected cell operation
+    CELL_OP m_cellOp;
+
+    // Summed-area tables of the two sides, (m_Nrows + 1) x (m_Ncols + 1) entries:
+    // the entry (row, col) is the sum over the cells above and at the left of (row, col).
+    // The entries wrap around: a rectangle sum is exact modulo 2^16 (counts) or 2^32 (dist)
+    std::vector<uint16_t> m_outOfBoardSat[AR_MAX_ROUTING_LAYERS_COUNT]; // not CELL_IS_ZONE
+    std::vector<uint16_t> m_moduleSat[AR_MAX_ROUTING_LAYERS_COUNT];     // CELL_IS_MODULE
+    std::vector<uint32_t> m_distSat[AR_MAX_ROUTING_LAYERS_COUNT];       // distance map
+
+    // false when the matrix changed since the last build.  Atomic, because FillSpan() is
+    // called from several threads
+    std::atomic<bool>     m_satValid;
+
+    void invalidateSummedAreaTables()
+    {
+        m_satValid.store( false, std::memory_order_relaxed );
+    }
+
+    // Number of cells in rows aRowMin to aRowMax and columns aColMin to aColMax of aSat,
+    // summed by blocks small enough for the 16 bit entries not to wrap
+    int countCells( const std::vector<uint16_t>& aSat,
+                    int aRowMin, int aColMin, int aRowMax, int aColMax );
+
+public:
     AR_MATRIX();
     ~AR_MATRIX();
 
     void WriteCell( int aRow, int aCol, int aSide, MATRIX_CELL aCell )
     {
-        ( *this.*m_opWriteCell )( aRow, aCol, aSide, aCell );
+        MATRIX_CELL& cell = m_BoardSide[aSide][aRow * m_Ncols + aCol];
+
+        invalidateSummedAreaTables();
+
+        switch( m_cellOp )
+        {
+        default:
+        case WRITE_CELL:     cell = aCell;  break;
+        case WRITE_OR_CELL:  cell |= aCell; break;
+        case WRITE_XOR_CELL: cell ^= aCell; break;
+        case WRITE_AND_CELL: cell &= aCell; break;
+        case WRITE_ADD_CELL: cell += aCell; break;
+        }
     }
 
+    /**
+     * Function FillSpan
+     * writes aCell with the current cell operation in the cells aColMin to aColMax of the
+     * row aRow, clipped to the matrix.  Much faster than WriteCell() for each cell, the
+     * compiler turns the loops into word-wide writes.  Spans of different rows can be
+     * filled concurrently.
+     */
+    void FillSpan( int aRow, int aColMin, int aColMax, int aSide, MATRIX_CELL aCell );
+
     /**
      * function GetBrdCoordOrigin
      * @return the board coordinate corresponding to the
@@ -121,7 +167,8 @@ public:
 
     void UnInitRoutingMatrix();
 
-    // Initialize WriteCell to make the aLogicOp
+    // Initialize WriteCell and FillSpan to make the aLogicOp.
+    // Also drops the summed-area tables, as cells are about to be written.
     void SetCellOperation( CELL_OP aLogicOp );
 
     // functions to read/write one cell ( point on grid routing matrix:
@@ -136,6 +183,26 @@ public:
     int         GetDir( int aRow, int aCol, int aSide );
     void        SetDir( int aRow, int aCol, int aSide, int aDir );
 
+    /**
+     * Function BuildSummedAreaTables
+     * builds the summed-area tables of both sides, giving in constant time the number of
+     * cells outside the board, the number of cells occupied by a footprint and the sum of
+     * the distances inside a rectangle.  Rows are processed in parallel.
+     * The queries below call it when the matrix changed since the last build.
+     */
+    void BuildSummedAreaTables();
+
+    /**
+     * Functions CountOutOfBoardCells, CountModuleCells and SumDist
+     * @return the number of cells without CELL_IS_ZONE, the number of cells with
+     * CELL_IS_MODULE, or the sum of the distances of the cells in rows aRowMin to aRowMax
+     * and columns aColMin to aColMax (inclusive) of aSide.  The range must be inside the
+     * matrix; an empty range gives 0.  The sum of the distances is given modulo 2^32.
+     */
+    int      CountOutOfBoardCells( int aRowMin, int aColMin, int aRowMax, int aColMax, int aSide );
+    int      CountModuleCells( int aRowMin, int aColMin, int aRowMax, int aColMax, int aSide );
+    uint32_t SumDist( int aRowMin, int aColMin, int aRowMax, int aColMax, int aSide );
+
     // calculate distance (with penalty) of a trace through a cell
     int CalcDist( int x, int y, int z, int side );
 
@@ -32,6 +32,7 @@
 #include <tools/pcb_tool_base.h>
 #include <tools/pcb_actions.h>
 #include <connectivity/connectivity_data.h>
+#include <zone_filler.h>
 
 #include <functional>
 using namespace std::placeholders;
@@ -101,7 +102,7 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                     ITEM_PICKER itemWrapper( ent.m_item, UR_CHANGED );
                     itemWrapper.SetLink( ent.m_copy );
                     undoList.PushItem( itemWrapper );
-                    frame->SaveCopyInUndoList( undoList, UR_CHANGED );
+                    frame->SaveCommittedCopyInUndoList( undoList, UR_CHANGED );
                 }
 
                 savedModules.insert( ent.m_item );
@@ -109,6 +110,12 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
             }
         }
 
+        if( !m_editModules )
+        {
+            ZONE_FILLER::InvalidateDependentZones( board, boardItem,
+                                                   static_cast<BOARD_ITEM*>( ent.m_copy ) );
+        }
+
         switch( changeType )
         {
             case CHT_ADD:
@@ -236,6 +243,7 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                 connectivity->Update( boardItem );
                 view->Update( boardItem );
+                board->OnItemChanged( boardItem );
 
                 // if no undo entry is needed, the copy would create a memory leak
                 if( !aCreateUndoEntry )
@@ -276,6 +284,9 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
 
                 auto boardItem = static_cast<BOARD_ITEM*>( ent.m_item );
 
+                ZONE_FILLER::InvalidateDependentZones( board, boardItem,
+                                                       static_cast<BOARD_ITEM*>( ent.m_copy ) );
+
                 if( aCreateUndoEntry )
                 {
                     ITEM_PICKER itemWrapper( boardItem, UR_CHANGED );
@@ -289,12 +300,13 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
                 }
 
                 view->Update( boardItem );
+                board->OnItemChanged( boardItem );
             }
         }
     }
 
     if( !m_editModules && aCreateUndoEntry )
-        frame->SaveCopyInUndoList( undoList, UR_UNSPECIFIED );
+        frame->SaveCommittedCopyInUndoList( undoList, UR_UNSPECIFIED );
 
     if( TOOL_MANAGER* toolMgr = frame->GetToolManager() )
         toolMgr->PostEvent( { TC_MESSAGE, TA_MODEL_CHANGE, AS_GLOBAL } );
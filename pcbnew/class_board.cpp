@@ -149,6 +149,13 @@ BOARD::BOARD() :
 
 BOARD::~BOARD()
 {
+    // a listener may remove itself while notified
+    std::vector<BOARD_LISTENER*> listeners( m_listeners );
+    m_listeners.clear();
+
+    for( BOARD_LISTENER* listener : listeners )
+        listener->OnBoardDeleted( *this );
+
     while( m_ZoneDescriptorList.size() )
     {
         ZONE_CONTAINER* area_to_remove = m_ZoneDescriptorList[0];
@@ -939,6 +946,9 @@ void BOARD::Add( BOARD_ITEM* aBoardItem, ADD_MODE aMode )
 
     aBoardItem->SetParent( this );
     m_connectivity->Add( aBoardItem );
+
+    for( BOARD_LISTENER* listener : m_listeners )
+        listener->OnBoardItemAdded( *this, aBoardItem );
 }
 
 
@@ -1004,6 +1014,39 @@ void BOARD::Remove( BOARD_ITEM* aBoardItem )
     }
 
     m_connectivity->Remove( aBoardItem );
+
+    for( BOARD_LISTENER* listener : m_listeners )
+        listener->OnBoardItemRemoved( *this, aBoardItem );
+}
+
+
+void BOARD::AddListener( BOARD_LISTENER* aListener )
+{
+    if( std::find( m_listeners.begin(), m_listeners.end(), aListener ) == m_listeners.end() )
+        m_listeners.push_back( aListener );
+}
+
+
+void BOARD::RemoveListener( BOARD_LISTENER* aListener )
+{
+    auto it = std::find( m_listeners.begin(), m_listeners.end(), aListener );
+
+    if( it != m_listeners.end() )
+        m_listeners.erase( it );
+}
+
+
+void BOARD::OnItemChanged( BOARD_ITEM* aItem )
+{
+    for( BOARD_LISTENER* listener : m_listeners )
+        listener->OnBoardItemChanged( *this, aItem );
+}
+
+
+void BOARD::OnBoardChanged()
+{
+    for( BOARD_LISTENER* listener : m_listeners )
+        listener->OnBoardChanged( *this );
 }
 
 
@@ -158,6 +158,31 @@ protected:
 };
 
 
+/**
+ * Class BOARD_LISTENER
+ * is notified of the items added to, removed from or changed on a board, so a client
+ * keeping data derived from the board can update it instead of rebuilding it.
+ *
+ * Removed items are notified before they may be deleted; a listener must not keep
+ * using them afterwards.
+ */
+class BOARD_LISTENER
+{
+public:
+    virtual ~BOARD_LISTENER() {}
+
+    virtual void OnBoardItemAdded( BOARD& aBoard, BOARD_ITEM* aBoardItem ) {}
+    virtual void OnBoardItemRemoved( BOARD& aBoard, BOARD_ITEM* aBoardItem ) {}
+    virtual void OnBoardItemChanged( BOARD& aBoard, BOARD_ITEM* aBoardItem ) {}
+
+    /// The design rules or the net classes have changed
+    virtual void OnBoardChanged( BOARD& aBoard ) {}
+
+    /// The board is being destroyed; the listener is unregistered by the board
+    virtual void OnBoardDeleted( BOARD& aBoard ) {}
+};
+
+
 DECL_VEC_FOR_SWIG(MARKERS, MARKER_PCB*)
 DECL_VEC_FOR_SWIG(ZONE_CONTAINERS, ZONE_CONTAINER*)
 DECL_VEC_FOR_SWIG(TRACKS, TRACK*)
@@ -199,6 +224,8 @@ private:
     PCB_PLOT_PARAMS         m_plotOptions;
     NETINFO_LIST            m_NetInfo;              ///< net info list (name, design constraints ..
 
+    std::vector<BOARD_LISTENER*> m_listeners;
+
     /**
      * Function chainMarkedSegments
      * is used by MarkTrace() to set the BUSY flag of connected segments of the trace
@@ -282,6 +309,27 @@ public:
 
     BOARD_ITEM* GetItem( void* aWeakReference );
 
+    /**
+     * Function AddListener
+     * registers a listener notified of the changes of the board; Add() and Remove()
+     * notify it, the editors notify the modified items with OnItemChanged().
+     */
+    void AddListener( BOARD_LISTENER* aListener );
+
+    void RemoveListener( BOARD_LISTENER* aListener );
+
+    /**
+     * Function OnItemChanged
+     * notifies the listeners that an item of the board was modified in place.
+     */
+    void OnItemChanged( BOARD_ITEM* aItem );
+
+    /**
+     * Function OnBoardChanged
+     * notifies the listeners of a change not bound to an item, like the design rules.
+     */
+    void OnBoardChanged();
+
     BOARD_ITEM* Duplicate( const BOARD_ITEM* aItem, bool aAddToBoard = false );
 
     /**
@@ -117,6 +117,7 @@ ZONE_CONTAINER::ZONE_CONTAINER( const ZONE_CONTAINER& aZone ) :
     SetLocalFlags( aZone.GetLocalFlags() );
 
     SetNeedRefill( aZone.NeedRefill() );
+    m_fillDependencyArea = aZone.m_fillDependencyArea;
 }
 
 
@@ -187,6 +187,14 @@ public:
     bool NeedRefill() const { return m_needRefill; }
     void SetNeedRefill( bool aNeedRefill ) { m_needRefill = aNeedRefill; }
 
+    /**
+     * The area used to collect the board items subtracted from the zone during its last fill.
+     * Changes to items outside this area cannot modify the filled areas.
+     * An empty area means the zone was not filled since it was loaded.
+     */
+    const EDA_RECT& GetFillDependencyArea() const { return m_fillDependencyArea; }
+    void SetFillDependencyArea( const EDA_RECT& aArea ) { m_fillDependencyArea = aArea; }
+
     int GetZoneClearance() const { return m_ZoneClearance; }
     void SetZoneClearance( int aZoneClearance ) { m_ZoneClearance = aZoneClearance; }
 
@@ -758,6 +766,9 @@ private:
      */
     bool                  m_needRefill;
 
+    /// Area of the board items the last fill depends on (see GetFillDependencyArea())
+    EDA_RECT              m_fillDependencyArea;
+
     ///< Width of the gap in thermal reliefs.
     int                   m_ThermalReliefGap;
 
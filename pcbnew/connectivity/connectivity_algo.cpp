@@ -26,11 +26,11 @@
 #include <widgets/progress_reporter.h>
 #include <geometry/geometry_utils.h>
 #include <board_commit.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <mutex>
 #include <algorithm>
-#include <future>
+#include <unordered_set>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -45,48 +45,113 @@ bool CN_CONNECTIVITY_ALGO::Remove( BOARD_ITEM* aItem )
     {
     case PCB_MODULE_T:
         for( auto pad : static_cast<MODULE*>( aItem ) -> Pads() )
-        {
-            m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( pad ) ].MarkItemsAsInvalid();
-            m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( pad ) );
-        }
+            removeEntry( pad );
 
         m_itemList.SetDirty( true );
         break;
 
     case PCB_PAD_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
+    case PCB_TRACE_T:
+    case PCB_VIA_T:
+    case PCB_ZONE_AREA_T:
+        removeEntry( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
         m_itemList.SetDirty( true );
         break;
 
+    default:
+        return false;
+    }
+
+    // Once we delete an item, it may connect between lists, so mark both as potentially invalid
+    m_itemList.SetHasInvalid( true );
+
+    return true;
+}
+
+
+void CN_CONNECTIVITY_ALGO::removeEntry( const BOARD_CONNECTED_ITEM* aItem )
+{
+    auto it = m_itemMap.find( aItem );
+
+    if( it == m_itemMap.end() )
+        return;
+
+    // The item may have changed net since it was added: the clusters of its old net are
+    // affected too
+    MarkNetAsDirty( it->second.m_net );
+
+    it->second.MarkItemsAsInvalid();
+    m_itemMap.erase( it );
+}
+
+
+/**
+ * Returns a hash of everything that affects the connections of aItem, except its net.
+ */
+static size_t itemSignature( const BOARD_CONNECTED_ITEM* aItem )
+{
+    size_t seed = std::hash<int>{}( aItem->Type() );
+
+    auto combine = [&seed]( size_t aValue )
+    {
+        seed ^= aValue + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+    };
+
+    auto combinePoint = [&combine]( const wxPoint& aPoint )
+    {
+        combine( std::hash<int>{}( aPoint.x ) );
+        combine( std::hash<int>{}( aPoint.y ) );
+    };
+
+    combine( std::hash<unsigned long long>{}( aItem->GetLayerSet().to_ullong() ) );
+
+    switch( aItem->Type() )
+    {
     case PCB_TRACE_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
+    case PCB_VIA_T:
+    {
+        auto track = static_cast<const TRACK*>( aItem );
+        combinePoint( track->GetStart() );
+        combinePoint( track->GetEnd() );
+        combine( std::hash<int>{}( track->GetWidth() ) );
         break;
+    }
 
-    case PCB_VIA_T:
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
+    case PCB_PAD_T:
+    {
+        auto pad = static_cast<const D_PAD*>( aItem );
+        combinePoint( pad->GetPosition() );
+        combine( std::hash<double>{}( pad->GetOrientation() ) );
+        combine( std::hash<int>{}( pad->GetShape() ) );
+        combinePoint( wxPoint( pad->GetSize().x, pad->GetSize().y ) );
+        combinePoint( wxPoint( pad->GetOffset().x, pad->GetOffset().y ) );
+        combinePoint( wxPoint( pad->GetDelta().x, pad->GetDelta().y ) );
         break;
+    }
 
     case PCB_ZONE_AREA_T:
     {
-        m_itemMap[ static_cast<BOARD_CONNECTED_ITEM*>( aItem ) ].MarkItemsAsInvalid();
-        m_itemMap.erase ( static_cast<BOARD_CONNECTED_ITEM*>( aItem ) );
-        m_itemList.SetDirty( true );
+        auto zone = static_cast<const ZONE_CONTAINER*>( aItem );
+        combine( std::hash<std::string>{}( zone->GetFilledPolysList().GetHash().Format() ) );
         break;
     }
 
     default:
-        return false;
+        break;
     }
 
-    // Once we delete an item, it may connect between lists, so mark both as potentially invalid
-    m_itemList.SetHasInvalid( true );
+    EDA_RECT bbox = aItem->GetBoundingBox();
+    combinePoint( bbox.GetOrigin() );
+    combinePoint( bbox.GetEnd() );
 
-    return true;
+    return seed;
+}
+
+
+void CN_CONNECTIVITY_ALGO::stampEntry( ITEM_MAP_ENTRY& aEntry, const BOARD_CONNECTED_ITEM* aItem )
+{
+    aEntry.m_net = aItem->GetNetCode();
+    aEntry.m_signature = itemSignature( aItem );
 }
 
 
@@ -173,6 +238,8 @@ bool CN_CONNECTIVITY_ALGO::Add( BOARD_ITEM* aItem )
         for( auto zitem : m_itemList.Add( zone ) )
             m_itemMap[zone].Link(zitem);
 
+        stampEntry( m_itemMap[zone], zone );
+
         break;
     }
 
@@ -184,6 +251,68 @@ bool CN_CONNECTIVITY_ALGO::Add( BOARD_ITEM* aItem )
 }
 
 
+int CN_CONNECTIVITY_ALGO::Sync( BOARD* aBoard )
+{
+    std::unordered_set<const BOARD_CONNECTED_ITEM*> onBoard;
+    int changes = 0;
+
+    auto syncItem = [&]( BOARD_CONNECTED_ITEM* aItem )
+    {
+        onBoard.insert( aItem );
+
+        auto it = m_itemMap.find( aItem );
+
+        if( it == m_itemMap.end() )
+        {
+            if( Add( aItem ) )
+                changes++;
+        }
+        else if( it->second.m_net != aItem->GetNetCode()
+                 || it->second.m_signature != itemSignature( aItem ) )
+        {
+            Remove( aItem );
+            Add( aItem );
+            changes++;
+        }
+    };
+
+    for( int i = 0; i < aBoard->GetAreaCount(); i++ )
+        syncItem( aBoard->GetArea( i ) );
+
+    for( auto tv : aBoard->Tracks() )
+        syncItem( tv );
+
+    for( auto mod : aBoard->Modules() )
+    {
+        for( auto pad : mod->Pads() )
+            syncItem( pad );
+    }
+
+    // Whatever is left in the map is no longer on the board and may already be deleted
+    std::vector<const BOARD_CONNECTED_ITEM*> stale;
+
+    for( const auto& entry : m_itemMap )
+    {
+        if( onBoard.find( entry.first ) == onBoard.end() )
+            stale.push_back( entry.first );
+    }
+
+    for( auto item : stale )
+        removeEntry( item );
+
+    if( !stale.empty() )
+    {
+        m_itemList.SetDirty( true );
+        m_itemList.SetHasInvalid( true );
+        changes += stale.size();
+    }
+
+    wxLogTrace( "CN", "Sync: %d items changed\n", changes );
+
+    return changes;
+}
+
+
 void CN_CONNECTIVITY_ALGO::searchConnections()
 {
 #ifdef CONNECTIVITY_DEBUG
@@ -218,48 +347,20 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
 
     if( m_itemList.IsDirty() )
     {
-        size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-                ( dirtyItems.size() + 7 ) / 8 );
-
-        std::atomic<size_t> nextItem( 0 );
-        std::vector<std::future<size_t>> returns( parallelThreadCount );
+        TASK_GROUP searchTasks;
 
-        auto conn_lambda = [&nextItem, &dirtyItems]
-                            ( CN_LIST* aItemList, PROGRESS_REPORTER* aReporter) -> size_t
+        // Items are cheap to process, so hand them out in batches
+        searchTasks.ParallelFor( dirtyItems.size(), [&] ( size_t i )
         {
-            for( size_t i = nextItem++; i < dirtyItems.size(); i = nextItem++ )
-            {
-                CN_VISITOR visitor( dirtyItems[i] );
-                aItemList->FindNearby( dirtyItems[i], visitor );
-
-                if( aReporter )
-                    aReporter->AdvanceProgress();
-            }
+            CN_VISITOR visitor( dirtyItems[i] );
+            m_itemList.FindNearby( dirtyItems[i], visitor );
 
-            return 1;
-        };
+            if( m_progressReporter )
+                m_progressReporter->AdvanceProgress();
+        }, 8 );
 
-        if( parallelThreadCount <= 1 )
-            conn_lambda( &m_itemList, m_progressReporter );
-        else
-        {
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-                returns[ii] = std::async( std::launch::async, conn_lambda,
-                        &m_itemList, m_progressReporter );
-
-            for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            {
-                // Here we balance returns with a 100ms timeout to allow UI updating
-                std::future_status status;
-                do
-                {
-                    if( m_progressReporter )
-                        m_progressReporter->KeepRefreshing();
-
-                    status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-                } while( status != std::future_status::ready );
-            }
-        }
+        // The propagation needs all the connections, so the search cannot be cancelled
+        searchTasks.Wait( m_progressReporter, false );
 
         if( m_progressReporter )
             m_progressReporter->KeepRefreshing();
@@ -291,7 +392,7 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
 
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUSTER_SEARCH_MODE aMode,
-        const KICAD_T aTypes[], int aSingleNet )
+        const KICAD_T aTypes[], int aSingleNet, bool aDirtyNetsOnly )
 {
     bool withinAnyNet = ( aMode != CSM_PROPAGATE );
 
@@ -302,7 +403,8 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
     if( m_itemList.IsDirty() )
         searchConnections();
 
-    auto addToSearchList = [&head, withinAnyNet, aSingleNet, aTypes] ( CN_ITEM *aItem )
+    auto addToSearchList = [this, &head, withinAnyNet, aSingleNet, aDirtyNetsOnly, aTypes]
+                           ( CN_ITEM *aItem )
     {
         if( withinAnyNet && aItem->Net() <= 0 )
             return;
@@ -313,6 +415,9 @@ const CN_CONNECTIVITY_ALGO::CLUSTERS CN_CONNECTIVITY_ALGO::SearchClusters( CLUST
         if( aSingleNet >=0 && aItem->Net() != aSingleNet )
             return;
 
+        if( aDirtyNetsOnly && withinAnyNet && isNetClean( aItem->Net() ) )
+            return;
+
         bool found = false;
 
         for( int i = 0; aTypes[i] != EOT; i++ )
@@ -477,6 +582,11 @@ void CN_CONNECTIVITY_ALGO::propagateConnections( BOARD_COMMIT* aCommit )
 
                         item->Parent()->SetNetCode( cluster->OriginNet() );
                         n_changed++;
+
+                        auto entry = m_itemMap.find( item->Parent() );
+
+                        if( entry != m_itemMap.end() )
+                            entry->second.m_net = cluster->OriginNet();
                     }
                 }
             }
@@ -502,6 +612,10 @@ void CN_CONNECTIVITY_ALGO::PropagateNets( BOARD_COMMIT* aCommit )
 }
 
 
+static const KICAD_T islandSearchTypes[] = { PCB_TRACE_T, PCB_PAD_T, PCB_VIA_T, PCB_ZONE_AREA_T,
+                                              PCB_MODULE_T, EOT };
+
+
 void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( ZONE_CONTAINER* aZone, std::vector<int>& aIslands )
 {
     if( aZone->GetFilledPolysList().IsEmpty() )
@@ -512,7 +626,8 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( ZONE_CONTAINER* aZone, std
     Remove( aZone );
     Add( aZone );
 
-    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK );
+    // Only the net of the zone was touched, the other nets need no search
+    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK, islandSearchTypes, -1, true );
 
     for( const auto& cluster : m_connClusters )
     {
@@ -542,7 +657,7 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLAT
             Add( z.m_zone );
     }
 
-    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK );
+    m_connClusters = SearchClusters( CSM_CONNECTIVITY_CHECK, islandSearchTypes, -1, true );
 
     for ( auto& zone : aZones )
     {
@@ -568,7 +683,23 @@ void CN_CONNECTIVITY_ALGO::FindIsolatedCopperIslands( std::vector<CN_ZONE_ISOLAT
 
 const CN_CONNECTIVITY_ALGO::CLUSTERS& CN_CONNECTIVITY_ALGO::GetClusters()
 {
-    m_ratsnestClusters = SearchClusters( CSM_RATSNEST );
+    constexpr KICAD_T types[] = { PCB_TRACE_T, PCB_PAD_T, PCB_VIA_T, PCB_ZONE_AREA_T, PCB_MODULE_T, EOT };
+
+    // Ratsnest clusters never span several nets, so the clusters of the nets that did not
+    // change since the previous search are still valid
+    CLUSTERS clusters = SearchClusters( CSM_RATSNEST, types, -1, true );
+
+    for( const auto& cluster : m_ratsnestClusters )
+    {
+        if( isNetClean( cluster->OriginNet() ) )
+            clusters.push_back( cluster );
+    }
+
+    std::sort( clusters.begin(), clusters.end(), []( CN_CLUSTER_PTR a, CN_CLUSTER_PTR b ) {
+        return a->OriginNet() < b->OriginNet();
+    } );
+
+    m_ratsnestClusters = std::move( clusters );
     return m_ratsnestClusters;
 }
 
@@ -116,7 +116,9 @@ private:
     class ITEM_MAP_ENTRY
     {
     public:
-        ITEM_MAP_ENTRY( CN_ITEM* aItem = nullptr )
+        ITEM_MAP_ENTRY( CN_ITEM* aItem = nullptr ) :
+            m_net( -1 ),
+            m_signature( 0 )
         {
             if( aItem )
                 m_items.push_back( aItem );
@@ -141,6 +143,12 @@ private:
         }
 
         std::list<CN_ITEM*> m_items;
+
+        ///> net code of the parent when it was added (the parent may be gone when it is removed)
+        int m_net;
+
+        ///> geometry signature of the parent when it was added, see Sync()
+        size_t m_signature;
     };
 
     CN_LIST m_itemList;
@@ -164,10 +172,23 @@ private:
         auto item = c.Add( brditem );
 
         m_itemMap[ brditem ] = ITEM_MAP_ENTRY( item );
+        stampEntry( m_itemMap[ brditem ], brditem );
     }
 
     void markItemNetAsDirty( const BOARD_ITEM* aItem );
 
+    ///> Records the net and geometry signature of aItem in its map entry.
+    void stampEntry( ITEM_MAP_ENTRY& aEntry, const BOARD_CONNECTED_ITEM* aItem );
+
+    ///> Drops the map entry of aItem without dereferencing it, the item may already be deleted.
+    void removeEntry( const BOARD_CONNECTED_ITEM* aItem );
+
+    ///> True if aNet is known and none of its items changed since the last ratsnest update.
+    bool isNetClean( int aNet ) const
+    {
+        return aNet >= 0 && aNet < (int) m_dirtyNets.size() && !m_dirtyNets[aNet];
+    }
+
 public:
 
     CN_CONNECTIVITY_ALGO() {}
@@ -185,7 +206,7 @@ public:
 
     bool IsNetDirty( int aNet ) const
     {
-        if( aNet < 0 )
+        if( aNet < 0 || aNet >= (int) m_dirtyNets.size() )
             return false;
 
         return m_dirtyNets[ aNet ];
@@ -221,7 +242,23 @@ public:
     bool    Remove( BOARD_ITEM* aItem );
     bool    Add( BOARD_ITEM* aItem );
 
-    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[], int aSingleNet );
+    /**
+     * Function Sync()
+     * Brings the item database in line with the copper items of aBoard by applying only the
+     * differences: items missing from the database are added, items no longer on the board are
+     * removed and items whose net or geometry changed are updated. The nets of all touched
+     * items are marked as dirty.
+     * @return the number of items that were added, removed or updated.
+     */
+    int     Sync( BOARD* aBoard );
+
+    /**
+     * Searches the connected clusters.
+     * @param aDirtyNetsOnly restricts the search to the items of the nets marked as dirty.  Only
+     * meaningful for the modes that do not cross nets (CSM_CONNECTIVITY_CHECK, CSM_RATSNEST).
+     */
+    const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode, const KICAD_T aTypes[],
+                                    int aSingleNet, bool aDirtyNetsOnly = false );
     const CLUSTERS  SearchClusters( CLUSTER_SEARCH_MODE aMode );
 
     /**
@@ -242,6 +279,10 @@ public:
 
     bool    CheckConnectivity( std::vector<CN_DISJOINT_NET_ENTRY>& aReport );
 
+    /**
+     * Returns the ratsnest clusters.  Only the clusters of dirty nets are searched again, the
+     * clusters of the clean nets are reused from the previous call.
+     */
     const CLUSTERS& GetClusters();
     int             GetUnconnectedCount();
 
@@ -27,9 +27,10 @@
 #include <profile.h>
 #endif
 
-#include <thread>
 #include <algorithm>
-#include <future>
+#include <map>
+
+#include <thread_pool.h>
 
 #include <connectivity/connectivity_data.h>
 #include <connectivity/connectivity_algo.h>
@@ -94,6 +95,87 @@ void CONNECTIVITY_DATA::Build( const std::vector<BOARD_ITEM*>& aItems )
 }
 
 
+void CONNECTIVITY_DATA::Sync( BOARD* aBoard )
+{
+    m_connAlgo->Sync( aBoard );
+    RecalculateRatsnest();
+}
+
+
+/**
+ * Canonical form of a set of ratsnest clusters: for each net, the sorted list of its clusters,
+ * each cluster being the sorted list of its items (parent and zone outline index).
+ */
+using CLUSTER_CONTENTS = std::vector<std::pair<const BOARD_CONNECTED_ITEM*, int>>;
+using NET_CLUSTERS = std::map<int, std::vector<CLUSTER_CONTENTS>>;
+
+
+static NET_CLUSTERS clusterContents( const CN_CONNECTIVITY_ALGO::CLUSTERS& aClusters )
+{
+    NET_CLUSTERS rv;
+
+    for( const auto& cluster : aClusters )
+    {
+        CLUSTER_CONTENTS contents;
+
+        for( auto item : *cluster )
+        {
+            int subpoly = 0;
+
+            if( item->Parent()->Type() == PCB_ZONE_AREA_T )
+                subpoly = static_cast<CN_ZONE*>( item )->SubpolyIndex();
+
+            contents.emplace_back( item->Parent(), subpoly );
+        }
+
+        std::sort( contents.begin(), contents.end() );
+        rv[ cluster->OriginNet() ].push_back( std::move( contents ) );
+    }
+
+    for( auto& net : rv )
+        std::sort( net.second.begin(), net.second.end() );
+
+    return rv;
+}
+
+
+bool CONNECTIVITY_DATA::CheckConsistency( BOARD* aBoard )
+{
+    CN_CONNECTIVITY_ALGO reference;
+    reference.Build( aBoard );
+
+    const NET_CLUSTERS expected = clusterContents( reference.GetClusters() );
+    const NET_CLUSTERS actual = clusterContents( m_connAlgo->GetClusters() );
+
+    bool consistent = true;
+
+    for( const auto& net : expected )
+    {
+        auto it = actual.find( net.first );
+
+        if( it == actual.end() || it->second != net.second )
+        {
+            wxLogTrace( "CN", "Net %d: %u clusters, %u expected\n", net.first,
+                        it == actual.end() ? 0u : (unsigned) it->second.size(),
+                        (unsigned) net.second.size() );
+            consistent = false;
+        }
+    }
+
+    for( const auto& net : actual )
+    {
+        if( expected.find( net.first ) == expected.end() )
+        {
+            wxLogTrace( "CN", "Net %d: %u clusters, none expected\n", net.first,
+                        (unsigned) net.second.size() );
+            consistent = false;
+        }
+    }
+
+    return consistent;
+}
+
+
 void CONNECTIVITY_DATA::updateRatsnest()
 {
     #ifdef PROFILE
@@ -106,32 +188,12 @@ void CONNECTIVITY_DATA::updateRatsnest()
     std::copy_if( m_nets.begin() + 1, m_nets.end(), std::back_inserter( dirty_nets ),
             [] ( RN_NET* aNet ) { return aNet->IsDirty() && aNet->GetNodeCount() > 0; } );
 
-    // We don't want to spin up a new thread for fewer than 8 nets (overhead costs)
-    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
-            ( dirty_nets.size() + 7 ) / 8 );
-
-    std::atomic<size_t> nextNet( 0 );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    // Hand out the largest nets first, so that a big net picked up last does not leave the
+    // other threads idle
+    std::sort( dirty_nets.begin(), dirty_nets.end(), [] ( RN_NET* aNet1, RN_NET* aNet2 )
+            { return aNet1->GetNodeCount() > aNet2->GetNodeCount(); } );
 
-    auto update_lambda = [&nextNet, &dirty_nets]() -> size_t
-    {
-        for( size_t i = nextNet++; i < dirty_nets.size(); i = nextNet++ )
-            dirty_nets[i]->Update();
-
-        return 1;
-    };
-
-    if( parallelThreadCount == 1 )
-        update_lambda();
-    else
-    {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, update_lambda );
-
-        // Finalize the ratsnest threads
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii].wait();
-    }
+    ParallelFor( dirty_nets.size(), [&dirty_nets]( size_t i ) { dirty_nets[i]->Update(); } );
 
     #ifdef PROFILE
     rnUpdate.Show();
@@ -96,6 +96,22 @@ public:
      */
     void Build( const std::vector<BOARD_ITEM*>& aItems );
 
+    /**
+     * Function Sync()
+     * Updates the connectivity database after aBoard was modified without notifying it.
+     * Only the items that were added, removed or changed are processed and only the ratsnest
+     * of their nets is recomputed, which is much cheaper than Clear() followed by Build().
+     */
+    void Sync( BOARD* aBoard );
+
+    /**
+     * Function CheckConsistency()
+     * Debugging aid: compares the clusters of the connectivity database with the ones of
+     * a database built from scratch for aBoard.  Differences are reported on the "CN" trace.
+     * @return true if both are identical.
+     */
+    bool CheckConsistency( BOARD* aBoard );
+
     /**
      * Function Add()
      * Adds an item to the connectivity data.
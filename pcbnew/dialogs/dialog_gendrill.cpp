@@ -32,6 +32,7 @@
 #include <pcbnew.h>
 #include <pcb_edit_frame.h>
 #include <pcbplot.h>
+#include <plotcontroller.h>
 #include <gendrill_Excellon_writer.h>
 #include <gendrill_gerber_writer.h>
 #include <bitmaps.h>
@@ -408,8 +409,11 @@ void DIALOG_GENDRILL::GenDrillAndMapFiles( bool aGenDrill, bool aGenMap )
         excellonWriter.SetRouteModeForOvalHoles( m_UseRouteModeForOvalHoles );
         excellonWriter.SetMapFileFormat( filefmt[choice] );
 
-        excellonWriter.CreateDrillandMapFilesSet( outputDir.GetFullPath(),
-                                                  aGenDrill, aGenMap, &reporter );
+        // The drill files and the map files are written by a plot job, like the fab
+        // output scripts do together with the layer plots
+        PLOT_JOB drillJob( m_board );
+        drillJob.AddDrillFiles( &excellonWriter, outputDir.GetFullPath(), aGenDrill, aGenMap );
+        drillJob.Run( &reporter );
     }
     else
     {
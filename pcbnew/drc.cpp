@@ -53,6 +53,7 @@
 #include <pcbnew.h>
 #include <drc.h>
 #include <pcb_netlist.h>
+#include <advanced_config.h>
 
 #include <dialog_drc.h>
 #include <wx/progdlg.h>
@@ -61,6 +62,12 @@
 #include <geometry/shape_arc.h>
 
 #include <drc/courtyard_overlap.h>
+#include <drc/drc_rtree.h>
+
+#include <thread_pool.h>
+
+#include <atomic>
+#include <unordered_map>
 
 void DRC::ShowDRCDialog( wxWindow* aParent )
 {
@@ -105,7 +112,11 @@ void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 {
     // In legacy routing mode, do not add markers to the board.
     // only shows the drc error message
-    if( m_drcInLegacyRoutingMode )
+    if( m_markerSink )
+    {
+        m_markerSink->push_back( aMarker );
+    }
+    else if( m_drcInLegacyRoutingMode )
     {
         m_pcbEditorFrame->SetMsgPanel( aMarker );
         delete aMarker;
@@ -120,6 +131,32 @@ void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
 }
 
 
+void DRC::addMarkersToPcb( std::vector<MARKER_PCB*>& aMarkers )
+{
+    if( m_markerSink )
+    {
+        m_markerSink->insert( m_markerSink->end(), aMarkers.begin(), aMarkers.end() );
+    }
+    else if( !aMarkers.empty() )
+    {
+        BOARD_COMMIT commit( m_pcbEditorFrame );
+
+        for( MARKER_PCB* marker : aMarkers )
+            commit.Add( marker );
+
+        commit.Push( wxEmptyString, false, false );
+    }
+
+    aMarkers.clear();
+}
+
+
+EDA_UNITS_T DRC::userUnits() const
+{
+    return m_pcbEditorFrame ? m_pcbEditorFrame->GetUserUnits() : MILLIMETRES;
+}
+
+
 void DRC::DestroyDRCDialog( int aReason )
 {
     if( m_drcDialog )
@@ -132,10 +169,19 @@ void DRC::DestroyDRCDialog( int aReason )
 }
 
 
-DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
+DRC::DRC( PCB_EDIT_FRAME* aPcbWindow ) :
+    DRC( aPcbWindow->GetBoard() )
 {
     m_pcbEditorFrame = aPcbWindow;
-    m_pcb = aPcbWindow->GetBoard();
+
+    m_markerFactory.SetUnitsProvider( [=]() { return aPcbWindow->GetUserUnits(); } );
+}
+
+
+DRC::DRC( BOARD* aBoard )
+{
+    m_pcbEditorFrame = NULL;
+    m_pcb = aBoard;
     m_drcDialog  = NULL;
 
     // establish initial values for everything:
@@ -164,7 +210,42 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_xcliphi = 0;
     m_ycliphi = 0;
 
-    m_markerFactory.SetUnitsProvider( [=]() { return aPcbWindow->GetUserUnits(); } );
+    m_markerSink = nullptr;
+}
+
+
+DRC::DRC( const DRC* aParent ) :
+    m_markerFactory( aParent->m_markerFactory )
+{
+    m_pcbEditorFrame = aParent->m_pcbEditorFrame;
+    m_pcb = aParent->m_pcb;
+    m_board_outlines = aParent->m_board_outlines;
+    m_drcDialog = NULL;
+
+    m_drcInLegacyRoutingMode = false;
+    m_doPad2PadTest     = aParent->m_doPad2PadTest;
+    m_doUnconnectedTest = aParent->m_doUnconnectedTest;
+    m_doZonesTest       = aParent->m_doZonesTest;
+    m_doKeepoutTest     = aParent->m_doKeepoutTest;
+    m_refillZones       = false;
+    m_reportAllTrackErrors = aParent->m_reportAllTrackErrors;
+    m_testFootprints    = false;
+
+    m_drcRun = false;
+    m_footprintsTested = false;
+    m_doCreateRptFile = false;
+
+    m_currentMarker = NULL;
+
+    m_segmAngle  = 0;
+    m_segmLength = 0;
+
+    m_xcliplo = 0;
+    m_ycliplo = 0;
+    m_xcliphi = 0;
+    m_ycliphi = 0;
+
+    m_markerSink = nullptr;
 }
 
 
@@ -225,8 +306,8 @@ int DRC::DrcOnCreatingTrack( TRACK* aRefSegm, TRACK* aList )
 
 int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
-    BOARD_COMMIT commit( m_pcbEditorFrame );
+    BOARD* board = m_pcbEditorFrame ? m_pcbEditorFrame->GetBoard() : m_pcb;
+    std::vector<MARKER_PCB*> markers;
     int nerrors = 0;
 
     std::vector<SHAPE_POLY_SET> smoothed_polys;
@@ -361,7 +442,7 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
             for( wxPoint pt : conflictPoints )
             {
                 if( aCreateMarkers )
-                    commit.Add( m_markerFactory.NewMarker(
+                    markers.push_back( m_markerFactory.NewMarker(
                             pt, zoneRef, zoneToTest, DRCE_ZONES_TOO_CLOSE ) );
 
                 nerrors++;
@@ -370,7 +451,7 @@ int DRC::TestZoneToZoneOutline( ZONE_CONTAINER* aZone, bool aCreateMarkers )
     }
 
     if( aCreateMarkers )
-        commit.Push( wxEmptyString, false, false );
+        addMarkersToPcb( markers );
 
     return nerrors;
 }
@@ -583,6 +664,85 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 }
 
 
+size_t DRC::RunTest( TEST_PHASE aPhase, std::vector<MARKER_PCB*>& aMarkers )
+{
+    size_t tested = 0;
+
+    m_markerSink = &aMarkers;
+
+    switch( aPhase )
+    {
+    case TEST_OUTLINE:
+        testOutline();
+        tested = m_pcb->m_Drawings.GetCount();
+        break;
+
+    case TEST_NETCLASSES:
+        testNetClasses();
+        tested = m_pcb->GetDesignSettings().m_NetClasses.GetCount() + 1;  // + the default one
+        break;
+
+    case TEST_PAD_TO_PAD:
+        testPad2Pad();
+        tested = m_pcb->GetPadCount();
+        break;
+
+    case TEST_DRILLED_HOLES:
+        testDrilledHoles();
+        tested = m_pcb->GetPadCount() + m_pcb->m_Track.GetCount();
+        break;
+
+    case TEST_TRACKS:
+        testTracks( NULL, false );
+        tested = m_pcb->m_Track.GetCount();
+        break;
+
+    case TEST_ZONES:
+        testZones();
+        tested = m_pcb->GetAreaCount();
+        break;
+
+    case TEST_UNCONNECTED:
+        testUnconnected();
+        tested = m_pcb->GetPadCount() + m_pcb->m_Track.GetCount();
+
+        // Unconnected items are not board markers: report them as markers to the caller
+        for( DRC_ITEM* item : m_unconnected )
+        {
+            aMarkers.push_back( new MARKER_PCB( item->GetErrorCode(), item->GetPointA(),
+                                                item->GetTextA(), item->GetPointA(),
+                                                item->GetTextB(), item->GetPointB() ) );
+        }
+        break;
+
+    case TEST_KEEPOUT_AREAS:
+        testKeepoutAreas();
+        tested = m_pcb->GetAreaCount();
+        break;
+
+    case TEST_TEXT_AND_GRAPHICS:
+        testCopperTextAndGraphics();
+        tested = m_pcb->m_Drawings.GetCount() + m_pcb->m_Modules.GetCount();
+        break;
+
+    case TEST_COURTYARDS:
+        doFootprintOverlappingDrc();
+        tested = m_pcb->m_Modules.GetCount();
+        break;
+
+    case TEST_DISABLED_LAYERS:
+        testDisabledLayers();
+        tested = m_pcb->m_Track.GetCount() + m_pcb->m_Modules.GetCount()
+                 + m_pcb->GetAreaCount();
+        break;
+    }
+
+    m_markerSink = nullptr;
+
+    return tested;
+}
+
+
 void DRC::updatePointers()
 {
     // update my pointers, m_pcbEditorFrame is the only unchangeable one
@@ -608,7 +768,7 @@ bool DRC::doNetClass( const NETCLASSPTR& nc, wxString& msg )
 
     const BOARD_DESIGN_SETTINGS& g = m_pcb->GetDesignSettings();
 
-#define FmtVal( x ) GetChars( StringFromValue( m_pcbEditorFrame->GetUserUnits(), x ) )
+#define FmtVal( x ) GetChars( StringFromValue( userUnits(), x ) )
 
 #if 0   // set to 1 when (if...) BOARD_DESIGN_SETTINGS has a m_MinClearance value
     if( nc->GetClearance() < g.m_MinClearance )
@@ -817,7 +977,7 @@ void DRC::testDrilledHoles()
             if( KiROUND( GetLineLength( checkHole.m_location, refHole.m_location ) )
                     <  checkHole.m_drillRadius + refHole.m_drillRadius + holeToHoleMin )
             {
-                addMarkerToPcb( new MARKER_PCB( m_pcbEditorFrame->GetUserUnits(),
+                addMarkerToPcb( new MARKER_PCB( userUnits(),
                                                 DRCE_DRILLED_HOLES_TOO_CLOSE, refHole.m_location,
                                                 refHole.m_owner, refHole.m_location,
                                                 checkHole.m_owner, checkHole.m_location ) );
@@ -832,12 +992,44 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
     wxProgressDialog * progressDialog = NULL;
     const int delta = 500;  // This is the number of tests between 2 calls to the
                             // progress bar
-    int count = 0;
 
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
-        count++;
+    std::vector<TRACK*> tracks;
+    std::vector<D_PAD*> pads = m_pcb->GetPads();
+
+    // Position of tracks and pads in the board lists: the tests are run in this order
+    std::unordered_map<const BOARD_ITEM*, size_t> order;
+
+    DRC_RTREE trackIndex;
+    DRC_RTREE padIndex;
+    int       maxClearance = m_pcb->GetDesignSettings().GetBiggestClearanceValue();
+
+    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+    {
+        order[ segm ] = tracks.size();
+        tracks.push_back( segm );
+        trackIndex.Insert( segm, segm->GetBoundingBox(), segm->GetLayerSet() );
+    }
+
+    for( size_t ii = 0; ii < pads.size(); ++ii )
+    {
+        D_PAD* pad = pads[ii];
+        order[ pad ] = ii;
+
+        EDA_RECT bbox( pad->ShapePos(), wxSize( 0, 0 ) );
+        bbox.Inflate( pad->GetBoundingRadius() );
+
+        EDA_RECT hole( pad->GetPosition(), wxSize( 0, 0 ) );
+        hole.Inflate( std::max( pad->GetDrillSize().x, pad->GetDrillSize().y ) / 2 );
+        bbox.Merge( hole );
+
+        // Pad holes are tested against tracks on all copper layers
+        padIndex.Insert( pad, bbox, pad->GetDrillSize().x ? LSET::AllCuMask()
+                                                          : pad->GetLayerSet() );
 
-    int deltamax = count/delta;
+        maxClearance = std::max( maxClearance, pad->GetClearance() );
+    }
+
+    int deltamax = tracks.size() / delta;
 
     if( aShowProgressBar && deltamax > 3 )
     {
@@ -849,39 +1041,90 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
         progressDialog->Update( 0, wxEmptyString );
     }
 
-    int ii = 0;
-    count = 0;
+    // Markers found by each track test, added to the board in the track order
+    std::vector<std::vector<MARKER_PCB*>> markers( tracks.size() );
+    std::atomic<size_t> nextItem( 0 );
+    std::atomic<size_t> testedCount( 0 );
+    TASK_GROUP          drcTasks;
 
-    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+    auto byBoardOrder = [&]( const BOARD_ITEM* aFirst, const BOARD_ITEM* aSecond )
     {
-        if( ii++ > delta )
+        return order.at( aFirst ) < order.at( aSecond );
+    };
+
+    auto drc_lambda = [&]()
+    {
+        DRC                      worker( this );
+        std::vector<BOARD_ITEM*> found;
+        std::vector<TRACK*>      nearTracks;
+        std::vector<D_PAD*>      nearPads;
+
+        for( size_t i = nextItem++; i < tracks.size() && !drcTasks.IsCancelled(); i = nextItem++ )
         {
-            ii = 0;
-            count++;
+            TRACK*   segm = tracks[i];
+            EDA_RECT area = segm->GetBoundingBox();
+            area.Inflate( maxClearance + 1 );
 
-            if( progressDialog )
+            // Each pair of tracks is tested once, from the first track of the pair
+            nearTracks.clear();
+            trackIndex.Query( area, segm->GetLayerSet(), found );
+
+            for( BOARD_ITEM* item : found )
             {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
-#ifdef __WXMAC__
-                // Work around a dialog z-order issue on OS X
-                if( count == deltamax )
-                    aActiveWindow->Raise();
-#endif
+                if( order.at( item ) > i )
+                    nearTracks.push_back( static_cast<TRACK*>( item ) );
             }
+
+            std::sort( nearTracks.begin(), nearTracks.end(), byBoardOrder );
+
+            nearPads.clear();
+            padIndex.Query( area, segm->GetLayerSet(), found );
+
+            for( BOARD_ITEM* item : found )
+                nearPads.push_back( static_cast<D_PAD*>( item ) );
+
+            std::sort( nearPads.begin(), nearPads.end(), byBoardOrder );
+
+            // Test new segment against tracks and pads, optionally against copper zones
+            worker.m_markerSink = &markers[i];
+            worker.doTrackDrc( segm, nearTracks, nearPads, m_doZonesTest );
+
+            testedCount++;
         }
+    };
 
-        // Test new segment against tracks and pads, optionally against copper zones
-        if( !doTrackDrc( segm, segm->Next(), true, m_doZonesTest ) )
+    // Each task keeps its own DRC worker, so run one per pool thread rather than one per track
+    size_t taskCount = std::max<size_t>( 1, std::min( drcTasks.GetThreadCount(), tracks.size() ) );
+
+    for( size_t ii = 0; ii < taskCount; ++ii )
+        drcTasks.Run( drc_lambda );
+
+    // Here we balance the wait with a 100ms timeout to allow UI updating
+    while( !drcTasks.WaitFor( std::chrono::milliseconds( 100 ) ) )
+    {
+        if( progressDialog && !drcTasks.IsCancelled() )
         {
-            if( m_currentMarker )
-            {
-                addMarkerToPcb ( m_currentMarker );
-                m_currentMarker = nullptr;
-            }
+            int count = std::min<int>( testedCount / delta, deltamax );
+
+            if( !progressDialog->Update( count, wxEmptyString ) )
+                drcTasks.Cancel();   // Aborted by user
+#ifdef __WXMAC__
+            // Work around a dialog z-order issue on OS X
+            if( count == deltamax )
+                aActiveWindow->Raise();
+#endif
         }
     }
 
+    drcTasks.Wait();
+
+    std::vector<MARKER_PCB*> allMarkers;
+
+    for( auto& trackMarkers : markers )
+        allMarkers.insert( allMarkers.end(), trackMarkers.begin(), trackMarkers.end() );
+
+    addMarkersToPcb( allMarkers );
+
     if( progressDialog )
         progressDialog->Destroy();
 }
@@ -896,9 +1139,17 @@ void DRC::testUnconnected()
 
     auto connectivity = m_pcb->GetConnectivity();
 
-    connectivity->Clear();
-    connectivity->Build( m_pcb ); // just in case. This really needs to be reliable.
-    connectivity->RecalculateRatsnest();
+    // Catch up with the changes the board did not report, rather than rebuilding everything
+    connectivity->Sync( m_pcb );
+
+    if( ADVANCED_CFG::GetCfg().m_checkIncrementalConnectivity
+            && !connectivity->CheckConsistency( m_pcb ) )
+    {
+        wxFAIL_MSG( "Incremental connectivity update differs from a full rebuild" );
+
+        connectivity->Clear();
+        connectivity->Build( m_pcb );
+    }
 
     std::vector<CN_EDGE> edges;
     connectivity->GetUnconnectedEdges( edges );
@@ -908,7 +1159,7 @@ void DRC::testUnconnected()
         auto src = edge.GetSourcePos();
         auto dst = edge.GetTargetPos();
 
-        m_unconnected.emplace_back( new DRC_ITEM( m_pcbEditorFrame->GetUserUnits(),
+        m_unconnected.emplace_back( new DRC_ITEM( userUnits(),
                                                   DRCE_UNCONNECTED_ITEMS,
                                                   edge.GetSourceNode()->Parent(),
                                                   wxPoint( src.x, src.y ),
@@ -1249,7 +1500,7 @@ void DRC::testOutline()
 
 void DRC::testDisabledLayers()
 {
-    BOARD* board = m_pcbEditorFrame->GetBoard();
+    BOARD* board = m_pcb;
     wxCHECK( board, /*void*/ );
     LSET disabledLayers = board->GetEnabledLayers().flip();
 
@@ -247,6 +247,17 @@ private:
     bool                m_drcRun;
     bool                m_footprintsTested;
 
+    ///< When not null, new markers are stored here instead of being added to the board
+    std::vector<MARKER_PCB*>* m_markerSink;
+
+    /**
+     * Creates a DRC testing the board of aParent with its settings, to run clearance tests
+     * in a worker thread: the single item tests store the geometry of the item under test
+     * in the DRC instance, so each thread needs its own.
+     * Markers are never added to the board by this instance, see m_markerSink.
+     */
+    explicit DRC( const DRC* aParent );
+
 
     /**
      * Update needed pointers from the one pointer which is known not to change.
@@ -258,6 +269,14 @@ private:
      */
     void addMarkerToPcb( MARKER_PCB* aMarker );
 
+    /**
+     * Adds DRC markers to the PCB in a single commit, and clears aMarkers.
+     */
+    void addMarkersToPcb( std::vector<MARKER_PCB*>& aMarkers );
+
+    ///> Units used in the messages, millimetres without editor frame.
+    EDA_UNITS_T userUnits() const;
+
     //-----<categorical group tests>-----------------------------------------
 
     /**
@@ -274,6 +293,11 @@ private:
     /**
      * Perform the DRC on all tracks.
      *
+     * Each track is only tested against the tracks following it in the board list and the
+     * pads found near it in a spatial index, and the tracks are shared between worker
+     * threads.  Markers are added to the board in the track order, so the results do not
+     * depend on the thread scheduling.
+     *
      * This test can take a while, a progress bar can be displayed
      * @param aActiveWindow = the active window ued as parent for the progress bar
      * @param aShowProgressBar = true to show a progress bar
@@ -337,6 +361,18 @@ private:
     bool doTrackDrc( TRACK* aRefSeg, TRACK* aStart,
                      bool aTestPads, bool aTestZones );
 
+    /**
+     * Test the current segment against a given set of items.
+     *
+     * @param aRefSeg The segment to test
+     * @param aTracks the tracks to test against, in board order
+     * @param aPads the pads to test against, in board order
+     * @param aTestZones true if should do copper zones test
+     * @return bool - true if no problems, else false
+     */
+    bool doTrackDrc( TRACK* aRefSeg, const std::vector<TRACK*>& aTracks,
+                     const std::vector<D_PAD*>& aPads, bool aTestZones );
+
     /**
      * Test the current segment or via.
      *
@@ -418,8 +454,32 @@ private:
     //-----</single tests>---------------------------------------------
 
 public:
+    /**
+     * The DRC phases which can be run alone by RunTest().
+     */
+    enum TEST_PHASE
+    {
+        TEST_OUTLINE,
+        TEST_NETCLASSES,
+        TEST_PAD_TO_PAD,
+        TEST_DRILLED_HOLES,
+        TEST_TRACKS,
+        TEST_ZONES,
+        TEST_UNCONNECTED,
+        TEST_KEEPOUT_AREAS,
+        TEST_TEXT_AND_GRAPHICS,
+        TEST_COURTYARDS,
+        TEST_DISABLED_LAYERS
+    };
+
     DRC( PCB_EDIT_FRAME* aPcbWindow );
 
+    /**
+     * Creates a DRC working on aBoard without board editor, for command line tools.
+     * Only RunTest() can be used.
+     */
+    explicit DRC( BOARD* aBoard );
+
     ~DRC();
 
     /**
@@ -498,6 +558,15 @@ public:
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
 
+    /**
+     * Function RunTest
+     * runs a single DRC phase, with the settings of the board and without user interface.
+     * The markers are not added to the board but stored in aMarkers, and the caller owns
+     * them.  Zones are not refilled: this phase uses the current zone fills.
+     * @return the number of board items examined by the phase.
+     */
+    size_t RunTest( TEST_PHASE aPhase, std::vector<MARKER_PCB*>& aMarkers );
+
     /**
      * @return a pointer to the current marker (last created marker
      */
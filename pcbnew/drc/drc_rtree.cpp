@@ -0,0 +1,81 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+
+#include <drc/drc_rtree.h>
+
+
+void DRC_RTREE::Insert( BOARD_ITEM* aItem, const EDA_RECT& aBBox, const LSET& aLayers )
+{
+    EDA_RECT  bbox = aBBox;
+    bbox.Normalize();
+
+    const int mmin[2] = { bbox.GetX(), bbox.GetY() };
+    const int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+    for( PCB_LAYER_ID layer : ( aLayers & LSET::AllCuMask() ).Seq() )
+        m_trees[layer].Insert( mmin, mmax, aItem );
+
+    m_count++;
+}
+
+
+void DRC_RTREE::RemoveAll()
+{
+    for( TREE& tree : m_trees )
+        tree.RemoveAll();
+
+    m_count = 0;
+}
+
+
+void DRC_RTREE::Query( const EDA_RECT& aArea, const LSET& aLayers,
+                       std::vector<BOARD_ITEM*>& aItems ) const
+{
+    EDA_RECT  area = aArea;
+    area.Normalize();
+
+    const int mmin[2] = { area.GetX(), area.GetY() };
+    const int mmax[2] = { area.GetRight(), area.GetBottom() };
+
+    std::function<bool( BOARD_ITEM* const& )> visitor = [&]( BOARD_ITEM* const& aItem )
+    {
+        aItems.push_back( aItem );
+        return true;
+    };
+
+    aItems.clear();
+
+    LSEQ layers = ( aLayers & LSET::AllCuMask() ).Seq();
+
+    for( PCB_LAYER_ID layer : layers )
+        m_trees[layer].Search( mmin, mmax, visitor );
+
+    // Items on several of the queried layers were found once per layer
+    if( layers.size() > 1 )
+    {
+        std::sort( aItems.begin(), aItems.end() );
+        aItems.erase( std::unique( aItems.begin(), aItems.end() ), aItems.end() );
+    }
+}
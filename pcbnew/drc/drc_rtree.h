@@ -0,0 +1,84 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_RTREE__H
+#define DRC_RTREE__H
+
+#include <vector>
+
+#include <eda_rect.h>
+#include <layers_id_colors_and_visibility.h>
+#include <geometry/rtree.h>
+
+class BOARD_ITEM;
+
+/**
+ * Class DRC_RTREE
+ * Implements one R-tree per copper layer for fast lookup of the board items close to
+ * an item under clearance test.  Non-owning.
+ *
+ * Items are indexed by their bounding box; the query area must be inflated by the
+ * largest clearance in use to find every potential violation.
+ */
+class DRC_RTREE
+{
+public:
+    DRC_RTREE() {}
+
+    /**
+     * Function Insert
+     * Indexes aItem on each copper layer of aLayers.
+     * @param aBBox is the area covered by the item (for instance including its hole).
+     */
+    void Insert( BOARD_ITEM* aItem, const EDA_RECT& aBBox, const LSET& aLayers );
+
+    /**
+     * Function RemoveAll
+     * Removes all the items from the index.
+     */
+    void RemoveAll();
+
+    /**
+     * Function Query
+     * Collects the items indexed on one of aLayers whose area intersects aArea.
+     * Thread-safe as long as the index is not modified.
+     * @param aItems is filled with the items, each reported once, in no particular order.
+     */
+    void Query( const EDA_RECT& aArea, const LSET& aLayers,
+                std::vector<BOARD_ITEM*>& aItems ) const;
+
+    /**
+     * @return the number of items inserted since the last RemoveAll(), counting only
+     * once an item indexed on several layers.
+     */
+    size_t Size() const { return m_count; }
+
+private:
+    // Copper layers only: other layers do not have clearance rules
+    typedef RTree<BOARD_ITEM*, int, 2, double> TREE;
+
+    TREE   m_trees[B_Cu + 1];
+    size_t m_count = 0;
+};
+
+#endif // DRC_RTREE__H
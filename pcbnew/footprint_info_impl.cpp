@@ -37,8 +37,8 @@
 #include <pgm_base.h>
 #include <wildcards_and_files_ext.h>
 #include <widgets/progress_reporter.h>
+#include <thread_pool.h>
 
-#include <thread>
 #include <mutex>
 
 
@@ -48,20 +48,15 @@ void FOOTPRINT_INFO_IMPL::load()
 
     wxASSERT( fptable );
 
-    const MODULE* footprint = fptable->GetEnumeratedFootprint( m_nickname, m_fpname );
+    FOOTPRINT_METADATA metadata;
 
-    if( footprint == NULL ) // Should happen only with malformed/broken libraries
-    {
-        m_pad_count = 0;
-        m_unique_pad_count = 0;
-    }
-    else
-    {
-        m_pad_count = footprint->GetPadCount( DO_NOT_INCLUDE_NPTH );
-        m_unique_pad_count = footprint->GetUniquePadCount( DO_NOT_INCLUDE_NPTH );
-        m_keywords = footprint->GetKeywords();
-        m_doc = footprint->GetDescription();
-    }
+    // Should fail only with malformed/broken libraries, leaving the pad counts at zero
+    fptable->GetEnumeratedFootprintMetadata( m_nickname, m_fpname, metadata );
+
+    m_pad_count = metadata.m_PadCount;
+    m_unique_pad_count = metadata.m_UniquePadCount;
+    m_keywords = metadata.m_Keywords;
+    m_doc = metadata.m_Description;
 
     m_loaded = true;
 }
@@ -184,7 +179,6 @@ void FOOTPRINT_LIST_IMPL::StartWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     m_count_finished.store( 0 );
     m_errors.clear();
     m_list.clear();
-    m_threads.clear();
     m_queue_in.clear();
     m_queue_out.clear();
 
@@ -199,9 +193,7 @@ void FOOTPRINT_LIST_IMPL::StartWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     m_loader->m_total_libs = m_queue_in.size();
 
     for( unsigned i = 0; i < aNThreads; ++i )
-    {
-        m_threads.push_back( std::thread( &FOOTPRINT_LIST_IMPL::loader_job, this ) );
-    }
+        m_loader_tasks.Run( [this]() { loader_job(); } );
 }
 
 void FOOTPRINT_LIST_IMPL::StopWorkers()
@@ -212,10 +204,8 @@ void FOOTPRINT_LIST_IMPL::StopWorkers()
     // exit on their next safe loop location when this is set).  Then we need to wait
     // for all threads to finish as closing the implementation will free the queues
     // that the threads write to.
-    for( auto& i : m_threads )
-        i.join();
+    m_loader_tasks.Wait();
 
-    m_threads.clear();
     m_queue_in.clear();
     m_count_finished.store( 0 );
 
@@ -229,10 +219,8 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     {
         std::lock_guard<std::mutex> lock1( m_join );
 
-        for( auto& i : m_threads )
-            i.join();
+        m_loader_tasks.Wait();
 
-        m_threads.clear();
         m_queue_in.clear();
         m_count_finished.store( 0 );
     }
@@ -249,11 +237,11 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
     // TODO: blast LOCALE_IO into the sun
 
     SYNC_QUEUE<std::unique_ptr<FOOTPRINT_INFO>> queue_parsed;
-    std::vector<std::thread>                    threads;
+    TASK_GROUP                                  parse_tasks;
 
-    for( size_t ii = 0; ii < std::thread::hardware_concurrency() + 1; ++ii )
+    for( size_t ii = 0; ii < parse_tasks.GetThreadCount(); ++ii )
     {
-        threads.push_back( std::thread( [this, &queue_parsed]() {
+        parse_tasks.Run( [this, &queue_parsed]() {
             wxString nickname;
 
             while( this->m_queue_out.pop( nickname ) && !m_cancelled )
@@ -294,7 +282,7 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
 
                 m_count_finished.fetch_add( 1 );
             }
-        } ) );
+        } );
     }
 
     while( !m_cancelled && (size_t)m_count_finished.load() < total_count )
@@ -305,8 +293,7 @@ bool FOOTPRINT_LIST_IMPL::JoinWorkers()
         wxMilliSleep( 30 );
     }
 
-    for( auto& thr : threads )
-        thr.join();
+    parse_tasks.Wait();
 
     std::unique_ptr<FOOTPRINT_INFO> fpi;
 
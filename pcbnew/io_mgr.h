@@ -246,6 +246,25 @@ public:
 };
 
 
+/**
+ * Struct FOOTPRINT_METADATA
+ * holds the footprint fields needed by the footprint chooser.  A #PLUGIN may be able
+ * to supply them from an index without parsing the footprint itself.
+ */
+struct FOOTPRINT_METADATA
+{
+    wxString    m_Description;
+    wxString    m_Keywords;
+    unsigned    m_PadCount;             ///< pad count, not including NPTH pads
+    unsigned    m_UniquePadCount;       ///< unique pad count, not including NPTH pads
+
+    FOOTPRINT_METADATA() :
+        m_PadCount( 0 ),
+        m_UniquePadCount( 0 )
+    {}
+};
+
+
 /**
  * Class PLUGIN
  * is a base class that BOARD loading and saving plugins should derive from.
@@ -420,6 +439,21 @@ public:
                                                   const wxString& aFootprintName,
                                                   const PROPERTIES* aProperties = NULL );
 
+    /**
+     * Function GetEnumeratedFootprintMetadata
+     * fetches the description, keywords and pad counts of a footprint found by
+     * FootprintEnumerate().  The default implementation reads them from
+     * GetEnumeratedFootprint(); plugins keeping an index may answer without parsing
+     * the footprint.
+     *
+     * @return bool - true if the footprint was found, else false and \a aMetadata is
+     *                left untouched.
+     */
+    virtual bool GetEnumeratedFootprintMetadata( const wxString& aLibraryPath,
+                                                 const wxString& aFootprintName,
+                                                 FOOTPRINT_METADATA& aMetadata,
+                                                 const PROPERTIES* aProperties = NULL );
+
     /**
      * Function FootprintSave
      * will write @a aModule to an existing library located at @a aLibraryPath.
@@ -48,8 +48,12 @@
 #include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/wfstream.h>
+#include <wx/stdpaths.h>
+#include <wx/textfile.h>
 #include <boost/ptr_container/ptr_map.hpp>
 #include <memory.h>
+#include <functional>
+#include <map>
 #include <connectivity/connectivity_data.h>
 #include <convert_basic_shapes_to_polygon.h>    // for enum RECT_CHAMFER_POSITIONS definition
 
@@ -80,31 +84,92 @@ void filterNetClass( const BOARD& aBoard, NETCLASS& aNetClass )
  * that contain a single module per file.  This class is a helper only for the
  * footprint portion of the PLUGIN API, and only for the #PCB_IO plugin.  It is
  * private to this implementation file so it is not placed into a header.
+ *
+ * Items restored from the library index carry only the footprint metadata; the
+ * MODULE itself is parsed on first access by FP_CACHE::LoadModule().
  */
 class FP_CACHE_ITEM
 {
     WX_FILENAME             m_filename;
-    std::unique_ptr<MODULE> m_module;
+    long long               m_fileTimestamp;    // modification time of the file when indexed
+    long long               m_fileSize;         // size of the file when indexed
+    FOOTPRINT_METADATA      m_metadata;
+    std::unique_ptr<MODULE> m_module;           // NULL until parsed
 
 public:
     FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName );
+    FP_CACHE_ITEM( const WX_FILENAME& aFileName, const FOOTPRINT_METADATA& aMetadata,
+                   long long aFileTimestamp, long long aFileSize );
+
+    const WX_FILENAME&        GetFileName() const { return m_filename; }
+    const MODULE*             GetModule()   const { return m_module.get(); }
+    const FOOTPRINT_METADATA& GetMetadata() const { return m_metadata; }
+    long long                 GetFileTimestamp() const { return m_fileTimestamp; }
+    long long                 GetFileSize() const { return m_fileSize; }
 
-    const WX_FILENAME& GetFileName() const { return m_filename; }
-    const MODULE*      GetModule()   const { return m_module.get(); }
+    /**
+     * Function SetModule
+     * takes ownership of \a aModule and refreshes the metadata from it.
+     */
+    void SetModule( MODULE* aModule );
+
+    void SetFileStat( long long aFileTimestamp, long long aFileSize )
+    {
+        m_fileTimestamp = aFileTimestamp;
+        m_fileSize = aFileSize;
+    }
 };
 
 
 FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const WX_FILENAME& aFileName ) :
     m_filename( aFileName ),
-    m_module( aModule )
+    m_fileTimestamp( 0 ),
+    m_fileSize( 0 )
+{
+    SetModule( aModule );
+}
+
+
+FP_CACHE_ITEM::FP_CACHE_ITEM( const WX_FILENAME& aFileName, const FOOTPRINT_METADATA& aMetadata,
+                              long long aFileTimestamp, long long aFileSize ) :
+    m_filename( aFileName ),
+    m_fileTimestamp( aFileTimestamp ),
+    m_fileSize( aFileSize ),
+    m_metadata( aMetadata )
 { }
 
 
+void FP_CACHE_ITEM::SetModule( MODULE* aModule )
+{
+    m_module.reset( aModule );
+
+    m_metadata.m_Description = aModule->GetDescription();
+    m_metadata.m_Keywords = aModule->GetKeywords();
+    m_metadata.m_PadCount = aModule->GetPadCount( DO_NOT_INCLUDE_NPTH );
+    m_metadata.m_UniquePadCount = aModule->GetUniquePadCount( DO_NOT_INCLUDE_NPTH );
+}
+
+
 typedef boost::ptr_map< wxString, FP_CACHE_ITEM >   MODULE_MAP;
 typedef MODULE_MAP::iterator                        MODULE_ITER;
 typedef MODULE_MAP::const_iterator                  MODULE_CITER;
 
 
+/**
+ * Struct FP_INDEX_ENTRY
+ * is a footprint record read back from a library index file.
+ */
+struct FP_INDEX_ENTRY
+{
+    long long           m_fileTimestamp;
+    long long           m_fileSize;
+    FOOTPRINT_METADATA  m_metadata;
+};
+
+/// Index records keyed by footprint file name (with extension).
+typedef std::map< wxString, FP_INDEX_ENTRY >        FP_INDEX;
+
+
 class FP_CACHE
 {
     PCB_IO*         m_owner;            // Plugin object that owns the cache.
@@ -117,6 +182,27 @@ class FP_CACHE
     long long       m_cache_timestamp;  // A hash of the timestamps for all the footprint
                                         // files.
 
+    /**
+     * Function indexFileName
+     * returns the full path of the index file of this library in the user's cache
+     * directory, or an empty string if that directory is not usable.
+     */
+    wxString indexFileName() const;
+
+    /**
+     * Function readIndex
+     * fills \a aIndex with the records of the library index file.  A missing, stale or
+     * unreadable index leaves \a aIndex empty; the index is only an accelerator.
+     */
+    void readIndex( FP_INDEX& aIndex ) const;
+
+    /**
+     * Function writeIndex
+     * records the file stamps and metadata of every cached footprint in the library
+     * index file.  Failures are ignored.
+     */
+    void writeIndex() const;
+
 public:
     FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath );
 
@@ -137,8 +223,22 @@ public:
      */
     void Save( MODULE* aModule = NULL );
 
+    /**
+     * Function Load
+     * populates the cache from the library directory.  Footprint files whose modification
+     * time and size match the library index are not parsed: only their metadata is restored
+     * and the MODULE is parsed by LoadModule() when first needed.
+     */
     void Load();
 
+    /**
+     * Function LoadModule
+     * returns the MODULE of \a aItem, parsing its file first if it came from the index.
+     *
+     * @throw PARSE_ERROR if the file of a footprint restored from the index does not parse.
+     */
+    const MODULE* LoadModule( FP_CACHE_ITEM* aItem );
+
     void Remove( const wxString& aFootprintName );
 
     /**
@@ -171,6 +271,157 @@ public:
 };
 
 
+///> First line of a footprint library index file, bumped whenever the layout changes.
+static const wxChar FP_INDEX_HEADER[] = wxT( "kicad_fp_index 2" );
+
+///> Number of lines per footprint record in a library index file.
+static const size_t FP_INDEX_RECORD_LINES = 7;
+
+
+/**
+ * Function footprintIndexDir
+ * returns the directory holding the footprint library index files, creating it if
+ * needed, or an empty string if it cannot be created.
+ */
+static wxString footprintIndexDir()
+{
+    // Like the 3D model cache, the index belongs in the user's cache directory:
+    //
+    // 1. OSX: ~/Library/Caches/kicad/footprints/
+    // 2. Linux: ${XDG_CACHE_HOME}/kicad/footprints ~/.cache/kicad/footprints/
+    // 3. MSWin: AppData\Local\kicad\footprints
+    wxString cacheDir;
+
+#if defined(_WIN32)
+    wxStandardPaths::Get().UseAppInfo( wxStandardPaths::AppInfo_None );
+    cacheDir = wxStandardPaths::Get().GetUserLocalDataDir();
+    cacheDir.append( "\\kicad\\footprints" );
+#elif defined(__APPLE__)
+    cacheDir = "${HOME}/Library/Caches/kicad/footprints";
+#else   // assume Linux
+    cacheDir = ExpandEnvVarSubstitutions( "${XDG_CACHE_HOME}" );
+
+    if( cacheDir.empty() || cacheDir == "${XDG_CACHE_HOME}" )
+        cacheDir = "${HOME}/.cache";
+
+    cacheDir.append( "/kicad/footprints" );
+#endif
+
+    wxFileName dir;
+    dir.AssignDir( ExpandEnvVarSubstitutions( cacheDir ) );
+
+    if( !dir.DirExists() && !dir.Mkdir( wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL ) )
+    {
+        wxLogTrace( traceKicadPcbPlugin, wxT( "Cannot create footprint index directory '%s'." ),
+                    dir.GetPath() );
+        return wxEmptyString;
+    }
+
+    return dir.GetPathWithSep();
+}
+
+
+/**
+ * Function fileSize
+ * returns the size in bytes of \a aFilePath, or -1 if it cannot be read.
+ */
+static long long fileSize( const wxString& aFilePath )
+{
+    wxULongLong size = wxFileName::GetSize( aFilePath );
+
+    if( size == wxInvalidSize )
+        return -1;
+
+    return (long long) size.GetValue();
+}
+
+
+/**
+ * Function escapeIndexField
+ * returns \a aSource with backslashes and control characters written as backslash
+ * sequences, so that it fits on a single line of an index file.  unescapeIndexField()
+ * restores it exactly.
+ */
+static wxString escapeIndexField( const wxString& aSource )
+{
+    wxString result;
+
+    for( wxString::const_iterator it = aSource.begin();  it != aSource.end();  ++it )
+    {
+        wxUniChar c = *it;
+
+        if( c == '\\' )
+            result += wxT( "\\\\" );
+        else if( c == '\n' )
+            result += wxT( "\\n" );
+        else if( c == '\r' )
+            result += wxT( "\\r" );
+        else if( c == '\t' )
+            result += wxT( "\\t" );
+        else if( c.GetValue() < 0x20 || c.GetValue() == 0x7F )
+            result += wxString::Format( wxT( "\\x%02x" ), (unsigned) c.GetValue() );
+        else
+            result += c;
+    }
+
+    return result;
+}
+
+
+/**
+ * Function unescapeIndexField
+ * reverts escapeIndexField().  Malformed sequences are kept as they are.
+ */
+static wxString unescapeIndexField( const wxString& aSource )
+{
+    wxString result;
+
+    for( wxString::const_iterator it = aSource.begin();  it != aSource.end();  ++it )
+    {
+        wxString::const_iterator next = it + 1;
+
+        if( *it != '\\' || next == aSource.end() )
+        {
+            result += *it;
+            continue;
+        }
+
+        wxUniChar c = *next;
+
+        if( c == '\\' )
+            result += '\\';
+        else if( c == 'n' )
+            result += '\n';
+        else if( c == 'r' )
+            result += '\r';
+        else if( c == 't' )
+            result += '\t';
+        else if( c == 'x' && aSource.end() - next > 2 )
+        {
+            unsigned long value;
+
+            if( !wxString( next + 1, next + 3 ).ToULong( &value, 16 ) )
+            {
+                result += *it;
+                continue;
+            }
+
+            result += wxUniChar( (unsigned) value );
+            it += 2;
+        }
+        else
+        {
+            result += *it;
+            continue;
+        }
+
+        ++it;
+    }
+
+    return result;
+}
+
+
 FP_CACHE::FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath )
 {
     m_owner = aOwner;
@@ -202,6 +453,9 @@ void FP_CACHE::Save( MODULE* aModule )
         if( aModule && aModule != it->second->GetModule() )
             continue;
 
+        // Footprints restored from the index have to be parsed before they can be written.
+        LoadModule( it->second );
+
         WX_FILENAME fn = it->second->GetFileName();
 
         wxString tempFileName =
@@ -239,7 +493,10 @@ void FP_CACHE::Save( MODULE* aModule )
             THROW_IO_ERROR( msg );
         }
 #endif
-        m_cache_timestamp += fn.GetTimestamp();
+        long long timestamp = fn.GetTimestamp();
+
+        it->second->SetFileStat( timestamp, fileSize( fn.GetFullPath() ) );
+        m_cache_timestamp += timestamp;
     }
 
     m_cache_timestamp += m_lib_path.GetModificationTime().GetValue().GetValue();
@@ -247,6 +504,8 @@ void FP_CACHE::Save( MODULE* aModule )
     // If we've saved the full cache, we clear the dirty flag.
     if( !aModule )
         m_cache_dirty = false;
+
+    writeIndex();
 }
 
 
@@ -264,6 +523,11 @@ void FP_CACHE::Load()
         THROW_IO_ERROR( msg );
     }
 
+    FP_INDEX index;
+    bool     indexChanged = false;
+
+    readIndex( index );
+
     wxString fullName;
     wxString fileSpec = wxT( "*." ) + KiCadFootprintFileExtension;
 
@@ -279,6 +543,31 @@ void FP_CACHE::Load()
         {
             fn.SetFullName( fullName );
 
+            wxString            fpName = fn.GetName();
+            long long           timestamp = fn.GetTimestamp();
+            long long           size = fileSize( fn.GetFullPath() );
+            FP_INDEX::iterator  entry = index.find( fullName );
+
+            if( entry != index.end() )
+            {
+                bool unchanged = entry->second.m_fileTimestamp == timestamp
+                                 && entry->second.m_fileSize == size;
+
+                if( unchanged )
+                {
+                    m_modules.insert( fpName, new FP_CACHE_ITEM( fn, entry->second.m_metadata,
+                                                                 timestamp, size ) );
+                    m_cache_timestamp += timestamp;
+                }
+
+                index.erase( entry );
+
+                if( unchanged )
+                    continue;
+            }
+
+            indexChanged = true;
+
             // Queue I/O errors so only files that fail to parse don't get loaded.
             try
             {
@@ -286,13 +575,16 @@ void FP_CACHE::Load()
 
                 m_owner->m_parser->SetLineReader( &reader );
 
-                MODULE*     footprint = (MODULE*) m_owner->m_parser->Parse();
-                wxString    fpName = fn.GetName();
+                MODULE* footprint = (MODULE*) m_owner->m_parser->Parse();
 
                 footprint->SetFPID( LIB_ID( wxEmptyString, fpName ) );
-                m_modules.insert( fpName, new FP_CACHE_ITEM( footprint, fn ) );
 
-                m_cache_timestamp += fn.GetTimestamp();
+                FP_CACHE_ITEM* item = new FP_CACHE_ITEM( footprint, fn );
+
+                item->SetFileStat( timestamp, size );
+                m_modules.insert( fpName, item );
+
+                m_cache_timestamp += timestamp;
             }
             catch( const IO_ERROR& ioe )
             {
@@ -303,9 +595,133 @@ void FP_CACHE::Load()
             }
         } while( dir.GetNext( &fullName ) );
 
+        // Anything left in the index belongs to footprint files which no longer exist.
+        if( indexChanged || !index.empty() )
+            writeIndex();
+
         if( !cacheError.IsEmpty() )
             THROW_IO_ERROR( cacheError );
     }
+    else if( !index.empty() )
+    {
+        writeIndex();
+    }
+}
+
+
+const MODULE* FP_CACHE::LoadModule( FP_CACHE_ITEM* aItem )
+{
+    if( !aItem->GetModule() )
+    {
+        const WX_FILENAME&  fn = aItem->GetFileName();
+        FILE_LINE_READER    reader( fn.GetFullPath() );
+
+        m_owner->m_parser->SetLineReader( &reader );
+
+        MODULE* footprint = (MODULE*) m_owner->m_parser->Parse();
+
+        footprint->SetFPID( LIB_ID( wxEmptyString, fn.GetName() ) );
+        aItem->SetModule( footprint );
+    }
+
+    return aItem->GetModule();
+}
+
+
+wxString FP_CACHE::indexFileName() const
+{
+    wxString dir = footprintIndexDir();
+
+    if( dir.IsEmpty() )
+        return wxEmptyString;
+
+    // The library path is also stored in the file, so a hash collision only costs a re-parse.
+    size_t hash = std::hash<std::string>()( std::string( TO_UTF8( m_lib_raw_path ) ) );
+
+    return dir + wxString::Format( wxT( "%016llx.idx" ), (unsigned long long) hash );
+}
+
+
+void FP_CACHE::readIndex( FP_INDEX& aIndex ) const
+{
+    wxString fileName = indexFileName();
+
+    if( fileName.IsEmpty() || !wxFileName::FileExists( fileName ) )
+        return;
+
+    wxTextFile file( fileName );
+
+    if( !file.Open() )
+        return;
+
+    if( file.GetLineCount() >= 2 && file.GetFirstLine() == FP_INDEX_HEADER
+            && unescapeIndexField( file.GetNextLine() ) == m_lib_raw_path )
+    {
+        while( file.GetCurrentLine() + FP_INDEX_RECORD_LINES < file.GetLineCount() )
+        {
+            FP_INDEX_ENTRY entry;
+            wxString       fullName = unescapeIndexField( file.GetNextLine() );
+
+            if( !file.GetNextLine().ToLongLong( &entry.m_fileTimestamp )
+                    || !file.GetNextLine().ToLongLong( &entry.m_fileSize ) )
+            {
+                aIndex.clear();     // a corrupt index is as good as none
+                break;
+            }
+
+            entry.m_metadata.m_Description = unescapeIndexField( file.GetNextLine() );
+            entry.m_metadata.m_Keywords = unescapeIndexField( file.GetNextLine() );
+            entry.m_metadata.m_PadCount = (unsigned) wxAtoi( file.GetNextLine() );
+            entry.m_metadata.m_UniquePadCount = (unsigned) wxAtoi( file.GetNextLine() );
+
+            aIndex[ fullName ] = entry;
+        }
+    }
+
+    file.Close();
+}
+
+
+void FP_CACHE::writeIndex() const
+{
+    wxString fileName = indexFileName();
+
+    if( fileName.IsEmpty() )
+        return;
+
+    wxTextFile file( fileName );
+
+    if( file.Exists() )
+    {
+        if( !file.Open() )
+            return;
+
+        file.Clear();
+    }
+    else if( !file.Create() )
+    {
+        return;
+    }
+
+    file.AddLine( FP_INDEX_HEADER );
+    file.AddLine( escapeIndexField( m_lib_raw_path ) );
+
+    for( MODULE_CITER it = m_modules.begin();  it != m_modules.end();  ++it )
+    {
+        const FP_CACHE_ITEM*      item = it->second;
+        const FOOTPRINT_METADATA& metadata = item->GetMetadata();
+
+        file.AddLine( escapeIndexField( item->GetFileName().GetFullName() ) );
+        file.AddLine( wxString::Format( "%lld", item->GetFileTimestamp() ) );
+        file.AddLine( wxString::Format( "%lld", item->GetFileSize() ) );
+        file.AddLine( escapeIndexField( metadata.m_Description ) );
+        file.AddLine( escapeIndexField( metadata.m_Keywords ) );
+        file.AddLine( wxString::Format( "%u", metadata.m_PadCount ) );
+        file.AddLine( wxString::Format( "%u", metadata.m_UniquePadCount ) );
+    }
+
+    file.Write();
+    file.Close();
 }
 
 
@@ -325,6 +741,7 @@ void FP_CACHE::Remove( const wxString& aFootprintName )
     wxString fullPath = it->second->GetFileName().GetFullPath();
     m_modules.erase( aFootprintName );
     wxRemoveFile( fullPath );
+    writeIndex();
 }
 
 
@@ -1927,10 +2344,12 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
+    // Boards can be large: tokenize them straight from the mapped file
+    MAPPED_FILE_LINE_READER reader( aFileName );
 
     init( aProperties );
 
+    m_parser->SetInPlaceLines( true );
     m_parser->SetLineReader( &reader );
     m_parser->SetBoard( aAppendToMe );
 
@@ -2043,16 +2462,25 @@ const MODULE* PCB_IO::getFootprint( const wxString& aLibraryPath,
         // do nothing with the error
     }
 
-    const MODULE_MAP& mods = m_cache->GetModules();
+    MODULE_MAP& mods = m_cache->GetModules();
 
-    MODULE_CITER it = mods.find( aFootprintName );
+    MODULE_ITER it = mods.find( aFootprintName );
 
     if( it == mods.end() )
     {
         return NULL;
     }
 
-    return it->second->GetModule();
+    try
+    {
+        return m_cache->LoadModule( it->second );
+    }
+    catch( const IO_ERROR& )
+    {
+        // Load() skips the files which do not parse and its errors are ignored above, so
+        // a footprint parsed later from the index is not found either.
+        return NULL;
+    }
 }
 
 
@@ -2064,6 +2492,37 @@ const MODULE* PCB_IO::GetEnumeratedFootprint( const wxString& aLibraryPath,
 }
 
 
+bool PCB_IO::GetEnumeratedFootprintMetadata( const wxString& aLibraryPath,
+                                             const wxString& aFootprintName,
+                                             FOOTPRINT_METADATA& aMetadata,
+                                             const PROPERTIES* aProperties )
+{
+    LOCALE_IO   toggle;     // toggles on, then off, the C locale.
+
+    init( aProperties );
+
+    try
+    {
+        validateCache( aLibraryPath, false );
+    }
+    catch( const IO_ERROR& )
+    {
+        // do nothing with the error
+    }
+
+    const MODULE_MAP& mods = m_cache->GetModules();
+
+    MODULE_CITER it = mods.find( aFootprintName );
+
+    if( it == mods.end() )
+        return false;
+
+    // The index already knows, no need to parse the footprint.
+    aMetadata = it->second->GetMetadata();
+    return true;
+}
+
+
 MODULE* PCB_IO::FootprintLoad( const wxString& aLibraryPath, const wxString& aFootprintName,
                                const PROPERTIES* aProperties )
 {
@@ -128,6 +128,11 @@ public:
                                           const wxString& aFootprintName,
                                           const PROPERTIES* aProperties = NULL ) override;
 
+    bool GetEnumeratedFootprintMetadata( const wxString& aLibraryPath,
+                                         const wxString& aFootprintName,
+                                         FOOTPRINT_METADATA& aMetadata,
+                                         const PROPERTIES* aProperties = NULL ) override;
+
     MODULE* FootprintLoad( const wxString& aLibraryPath, const wxString& aFootprintName,
                            const PROPERTIES* aProperties = NULL ) override;
 
@@ -102,6 +102,16 @@ public:
     void SaveCopyInUndoList( const PICKED_ITEMS_LIST& aItemsList, UNDO_REDO_T aTypeCommand,
                             const wxPoint& aTransformPoint = wxPoint( 0, 0 ) ) override;
 
+    /**
+     * Function SaveCommittedCopyInUndoList
+     * Same as SaveCopyInUndoList(), for the changes pushed by a BOARD_COMMIT.  Unlike
+     * SaveCopyInUndoList(), it does not consider that the items are about to be modified
+     * in place: the commit notifies the changes itself.
+     */
+    void SaveCommittedCopyInUndoList( const PICKED_ITEMS_LIST& aItemsList,
+                                      UNDO_REDO_T aTypeCommand,
+                                      const wxPoint& aTransformPoint = wxPoint( 0, 0 ) );
+
     /**
      * Function RestoreCopyFromRedoList
      *  Redo the last edit:
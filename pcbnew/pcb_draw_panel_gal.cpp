@@ -38,11 +38,11 @@
 #include <class_marker_pcb.h>
 #include <pcb_base_frame.h>
 #include <confirm.h>
+#include <thread_pool.h>
 
 #include <gal/graphics_abstraction_layer.h>
 
 #include <functional>
-#include <thread>
 using namespace std::placeholders;
 
 const LAYER_NUM GAL_LAYER_ORDER[] =
@@ -145,22 +145,11 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
     m_view->Clear();
 
     auto zones = aBoard->Zones();
-    std::atomic<size_t> next( 0 );
-    std::atomic<size_t> count_done( 0 );
-    size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    TASK_GROUP triangulationTasks;
 
-    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-    {
-        std::thread t = std::thread( [ &count_done, &next, &zones ]( )
-        {
-            for( size_t i = next.fetch_add( 1 ); i < zones.size(); i = next.fetch_add( 1 ) )
-                zones[i]->CacheTriangulation();
-
-            count_done++;
-        } );
-
-        t.detach();
-    }
+    // Triangulate the zones while the other items are loaded
+    triangulationTasks.ParallelFor( zones.size(),
+            [&zones]( size_t i ) { zones[i]->CacheTriangulation(); } );
 
     if( m_worksheet )
         m_worksheet->SetFileName( TO_UTF8( aBoard->GetFileName() ) );
@@ -183,9 +172,8 @@ void PCB_DRAW_PANEL_GAL::DisplayBoard( BOARD* aBoard )
         m_view->Add( aBoard->GetMARKER( marker_idx ) );
     }
 
-    // Finalize the triangulation threads
-    while( count_done < parallelThreadCount )
-        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    // Finalize the triangulation
+    triangulationTasks.Wait();
 
     // Load zones
     for( auto zone : aBoard->Zones() )
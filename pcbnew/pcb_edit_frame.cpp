@@ -55,6 +55,7 @@
 #include <class_track.h>
 #include <class_board.h>
 #include <class_module.h>
+#include <class_zone.h>
 #include <ws_proxy_view_item.h>
 #include <connectivity/connectivity_data.h>
 #include <ratsnest_viewitem.h>
@@ -661,8 +662,14 @@ void PCB_EDIT_FRAME::DoShowBoardSetupDialog( const wxString& aInitialPage,
         for( MODULE* module = GetBoard()->m_Modules; module; module = module->Next() )
             GetGalCanvas()->GetView()->Update( module );
 
+        // Clearances may have changed: all zone fills are potentially out of date
+        for( ZONE_CONTAINER* zone : GetBoard()->Zones() )
+            zone->SetNeedRefill( true );
+
         GetGalCanvas()->Refresh();
 
+        GetBoard()->OnBoardChanged();
+
         //this event causes the routing tool to reload its design rules information
         TOOL_EVENT toolEvent( TC_COMMAND, TA_MODEL_CHANGE, AS_ACTIVE );
         m_toolManager->ProcessEvent( toolEvent );
@@ -28,6 +28,8 @@
  */
 
 #include <errno.h>
+#include <atomic>
+#include <exception>
 #include <common.h>
 #include <confirm.h>
 #include <macros.h>
@@ -49,6 +51,7 @@
 #include <pcb_plot_params.h>
 #include <zones.h>
 #include <pcb_parser.h>
+#include <thread_pool.h>
 #include <convert_basic_shapes_to_polygon.h>    // for RECT_CHAMFER_POSITIONS definition
 
 using namespace PCB_KEYS_T;
@@ -496,89 +499,386 @@ BOARD* PCB_PARSER::parseBOARD()
 }
 
 
-BOARD* PCB_PARSER::parseBOARD_unchecked()
+/**
+ * Tracks and vias are inserted in the board, other items are appended.
+ */
+static ADD_MODE boardAddMode( const BOARD_ITEM* aItem )
 {
-    T token;
+    return ( aItem->Type() == PCB_TRACE_T || aItem->Type() == PCB_VIA_T ) ? ADD_INSERT
+                                                                          : ADD_APPEND;
+}
 
-    parseHeader();
 
-    for( token = NextTok();  token != T_RIGHT;  token = NextTok() )
+BOARD_ITEM* PCB_PARSER::parseBoardElement( T aToken )
+{
+    switch( aToken )
     {
-        if( token != T_LEFT )
-            Expecting( T_LEFT );
+    case T_general:
+        parseGeneralSection();
+        break;
 
-        token = NextTok();
+    case T_page:
+        parsePAGE_INFO();
+        break;
 
-        switch( token )
+    case T_title_block:
+        parseTITLE_BLOCK();
+        break;
+
+    case T_layers:
+        parseLayers();
+        break;
+
+    case T_setup:
+        parseSetup();
+        break;
+
+    case T_net:
+        parseNETINFO_ITEM();
+        break;
+
+    case T_net_class:
+        parseNETCLASS();
+        break;
+
+    case T_gr_arc:
+    case T_gr_circle:
+    case T_gr_curve:
+    case T_gr_line:
+    case T_gr_poly:
+        return parseDRAWSEGMENT();
+
+    case T_gr_text:
+        return parseTEXTE_PCB();
+
+    case T_dimension:
+        return parseDIMENSION();
+
+    case T_module:
+        return parseMODULE();
+
+    case T_segment:
+        return parseTRACK();
+
+    case T_via:
+        return parseVIA();
+
+    case T_zone:
+        return parseZONE_CONTAINER();
+
+    case T_target:
+        return parsePCB_TARGET();
+
+    default:
+        wxString err;
+        err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
+        THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+    }
+
+    return NULL;
+}
+
+
+/// Minimum count of board items per thread to parse a board in parallel
+static const size_t s_minElementsPerThread = 200;
+
+
+/**
+ * A top level element of a board file, found by scanBoardElements().
+ */
+struct BOARD_FILE_ELEMENT
+{
+    const char*  m_begin;       ///< start of the element, including its indentation
+    const char*  m_end;         ///< end of the element, after its closing parenthesis
+    unsigned     m_line;        ///< line number of m_begin
+    std::string  m_keyword;     ///< the first token of the element, e.g. "module"
+};
+
+
+/**
+ * Finds the top level elements of a board file in [aBegin, aEnd), which must start
+ * after the board header, without tokenizing them: only parentheses, quoted strings and
+ * comment lines (whose first non blank character is '#', as for DSNLEXER) are looked at.
+ *
+ * @param aFirstLine is the line number of aBegin.
+ * @param aBoardEnd is set to the closing parenthesis of the board.
+ * @return false if the end of the board was not found.
+ */
+static bool scanBoardElements( const char* aBegin, const char* aEnd, unsigned aFirstLine,
+                               std::vector<BOARD_FILE_ELEMENT>& aElements,
+                               const char*& aBoardEnd )
+{
+    BOARD_FILE_ELEMENT element;
+    const char*        lineStart = aBegin;
+    unsigned           line = aFirstLine;
+    int                depth = 0;
+    bool               leadingBlanks = false;  // only blanks so far on the current line
+
+    for( const char* cp = aBegin;  cp < aEnd;  ++cp )
+    {
+        if( leadingBlanks )
         {
-        case T_general:
-            parseGeneralSection();
-            break;
+            if( *cp == '#' )
+            {
+                // A comment line: skip it up to its line end
+                while( cp + 1 < aEnd && cp[1] != '\n' )
+                    ++cp;
 
-        case T_page:
-            parsePAGE_INFO();
-            break;
+                continue;
+            }
 
-        case T_title_block:
-            parseTITLE_BLOCK();
-            break;
+            leadingBlanks = ( *cp == ' ' || *cp == '\t' || *cp == '\r' );
+        }
 
-        case T_layers:
-            parseLayers();
+        switch( *cp )
+        {
+        case '\n':
+            ++line;
+            lineStart = cp + 1;
+            leadingBlanks = true;
             break;
 
-        case T_setup:
-            parseSetup();
-            break;
+        case '"':
+            // Skip quoted strings, which may contain escaped delimiters and parentheses
+            for( ++cp;  cp < aEnd && *cp != '"';  ++cp )
+            {
+                if( *cp == '\\' )
+                    ++cp;
+                else if( *cp == '\n' )
+                    ++line;
+            }
 
-        case T_net:
-            parseNETINFO_ITEM();
-            break;
+            if( cp >= aEnd )
+                return false;
 
-        case T_net_class:
-            parseNETCLASS();
             break;
 
-        case T_gr_arc:
-        case T_gr_circle:
-        case T_gr_curve:
-        case T_gr_line:
-        case T_gr_poly:
-            m_board->Add( parseDRAWSEGMENT(), ADD_APPEND );
-            break;
+        case '(':
+            if( depth++ == 0 )
+            {
+                // Start at the indentation: the error messages then give the right offsets
+                element.m_begin = cp;
 
-        case T_gr_text:
-            m_board->Add( parseTEXTE_PCB(), ADD_APPEND );
-            break;
+                while( element.m_begin > lineStart
+                        && ( element.m_begin[-1] == ' ' || element.m_begin[-1] == '\t' ) )
+                    --element.m_begin;
 
-        case T_dimension:
-            m_board->Add( parseDIMENSION(), ADD_APPEND );
-            break;
+                const char* keywordEnd = cp + 1;
 
-        case T_module:
-            m_board->Add( parseMODULE(), ADD_APPEND );
-            break;
+                while( keywordEnd < aEnd && !strchr( " \t\r\n()\"", *keywordEnd ) )
+                    ++keywordEnd;
 
-        case T_segment:
-            m_board->Add( parseTRACK(), ADD_INSERT );
+                element.m_keyword.assign( cp + 1, keywordEnd );
+                element.m_line = line;
+            }
             break;
 
-        case T_via:
-            m_board->Add( parseVIA(), ADD_INSERT );
-            break;
+        case ')':
+            if( depth == 0 )
+            {
+                aBoardEnd = cp;     // the end of the board
+                return true;
+            }
 
-        case T_zone:
-            m_board->Add( parseZONE_CONTAINER(), ADD_APPEND );
+            if( --depth == 0 )
+            {
+                element.m_end = cp + 1;
+                aElements.push_back( element );
+            }
             break;
 
-        case T_target:
-            m_board->Add( parsePCB_TARGET(), ADD_APPEND );
+        default:
             break;
+        }
+    }
 
-        default:
-            wxString err;
-            err.Printf( _( "Unknown token \"%s\"" ), GetChars( FromUTF8() ) );
-            THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+    return false;
+}
+
+
+bool PCB_PARSER::parseBoardElementsInParallel()
+{
+    MEMORY_LINE_READER* memReader = dynamic_cast<MEMORY_LINE_READER*>( reader );
+
+    // The current position in the file is only known when the lines are read in place
+    if( !inPlaceLines || !memReader || readerStack.size() != 1 )
+        return false;
+
+    const char* end = memReader->Data() + memReader->Size();
+
+    if( next < memReader->Data() || next > end )
+        return false;
+
+    std::vector<BOARD_FILE_ELEMENT> elements;
+    const char*                     boardEnd = nullptr;
+
+    if( !scanBoardElements( next, end, CurLineNumber(), elements, boardEnd ) )
+        return false;
+
+    TASK_GROUP parseTasks;
+    size_t     parallelThreadCount = std::min<size_t>( parseTasks.GetThreadCount(),
+                                                       elements.size() / s_minElementsPerThread );
+
+    if( parallelThreadCount < 2 )
+        return false;
+
+    std::vector<std::unique_ptr<BOARD_ITEM>> items( elements.size() );
+    std::vector<std::exception_ptr>          errors( elements.size() );
+    std::vector<size_t>                      itemElements;
+    std::vector<size_t>                      zoneElements;
+
+    auto parseElement = [&]( PCB_PARSER& aParser, const BOARD_FILE_ELEMENT& aElement )
+    {
+        MEMORY_LINE_READER elementReader( aElement.m_begin, aElement.m_end - aElement.m_begin,
+                                          memReader->GetSource(), aElement.m_line - 1 );
+        BOARD_ITEM*        item;
+
+        aParser.PushReader( &elementReader );
+
+        try
+        {
+            aParser.NeedLEFT();
+            item = aParser.parseBoardElement( aParser.NextTok() );
+        }
+        catch( ... )
+        {
+            aParser.PopReader();
+            throw;
+        }
+
+        aParser.PopReader();
+        return item;
+    };
+
+    // The sections setting up the board and the parser (layers, nets, etc.) are parsed
+    // first: the items can then be parsed with read only access to the board.
+    for( size_t ii = 0; ii < elements.size(); ++ii )
+    {
+        const std::string& keyword = elements[ii].m_keyword;
+
+        if( keyword == "general" || keyword == "page" || keyword == "title_block"
+                || keyword == "layers" || keyword == "setup" || keyword == "net"
+                || keyword == "net_class" )
+        {
+            items[ii].reset( parseElement( *this, elements[ii] ) );
+        }
+        else if( keyword == "zone" )
+        {
+            // Zones can add nets to the board and ask the user questions
+            zoneElements.push_back( ii );
+        }
+        else
+        {
+            itemElements.push_back( ii );
+        }
+    }
+
+    std::vector<std::unique_ptr<PCB_PARSER>> workers( parallelThreadCount );
+    std::atomic<size_t>                      nextElement( 0 );
+
+    for( std::unique_ptr<PCB_PARSER>& worker : workers )
+    {
+        worker.reset( new PCB_PARSER() );
+        worker->SetInPlaceLines( true );
+        worker->m_board = m_board;
+        worker->m_layerIndices = m_layerIndices;
+        worker->m_layerMasks = m_layerMasks;
+        worker->m_netCodes = m_netCodes;
+        worker->m_requiredVersion = m_requiredVersion;
+        worker->m_tooRecent = m_tooRecent;
+    }
+
+    auto parse_lambda = [&]( PCB_PARSER* aWorker )
+    {
+        for( size_t i = nextElement++; i < itemElements.size() && !parseTasks.IsCancelled();
+                i = nextElement++ )
+        {
+            size_t ndx = itemElements[i];
+
+            try
+            {
+                items[ndx].reset( parseElement( *aWorker, elements[ndx] ) );
+            }
+            catch( ... )
+            {
+                errors[ndx] = std::current_exception();
+                parseTasks.Cancel();
+            }
+        }
+    };
+
+    for( std::unique_ptr<PCB_PARSER>& worker : workers )
+    {
+        PCB_PARSER* parser = worker.get();
+        parseTasks.Run( [&parse_lambda, parser]() { parse_lambda( parser ); } );
+    }
+
+    parseTasks.Wait();
+
+    for( std::unique_ptr<PCB_PARSER>& worker : workers )
+    {
+        m_undefinedLayers.insert( worker->m_undefinedLayers.begin(),
+                                  worker->m_undefinedLayers.end() );
+        m_requiredVersion = std::max( m_requiredVersion, worker->m_requiredVersion );
+        m_tooRecent = m_tooRecent || worker->m_tooRecent;
+    }
+
+    // Report the first error in file order
+    for( size_t ndx : itemElements )
+    {
+        if( errors[ndx] )
+            std::rethrow_exception( errors[ndx] );
+    }
+
+    for( size_t ndx : zoneElements )
+        items[ndx].reset( parseElement( *this, elements[ndx] ) );
+
+    for( std::unique_ptr<BOARD_ITEM>& item : items )
+    {
+        if( item )
+        {
+            BOARD_ITEM* boardItem = item.release();
+            m_board->Add( boardItem, boardAddMode( boardItem ) );
+        }
+    }
+
+    // Consume the elements and the closing parenthesis of the board, as the sequential
+    // loop does: the lexer is left just after the board.  The lines are contiguous in
+    // the reader's memory.
+    while( boardEnd < start || boardEnd >= limit )
+    {
+        if( readLine() == 0 )
+            break;      // cannot happen: the scan found the end of the board
+    }
+
+    next = boardEnd + 1;
+    prevTok = curTok;
+    curTok = DSN_RIGHT;
+    curText = ")";
+
+    return true;
+}
+
+
+BOARD* PCB_PARSER::parseBOARD_unchecked()
+{
+    T token;
+
+    parseHeader();
+
+    // Large boards are split up between several parsers.  Otherwise, or when the board
+    // cannot be split, its elements are parsed here.
+    if( !parseBoardElementsInParallel() )
+    {
+        for( token = NextTok();  token != T_RIGHT;  token = NextTok() )
+        {
+            if( token != T_LEFT )
+                Expecting( T_LEFT );
+
+            token = NextTok();
+
+            if( BOARD_ITEM* item = parseBoardElement( token ) )
+                m_board->Add( item, boardAddMode( item ) );
         }
     }
 
@@ -154,6 +154,25 @@ class PCB_PARSER : public PCB_LEXER
      */
     BOARD*          parseBOARD_unchecked();
 
+    /**
+     * Function parseBoardElement
+     * parses a top level element of a board, whose token has just been read.
+     * @return the item to add to the board, or NULL for the sections which only set up
+     *         the board or the parser (layers, nets, setup, ...).
+     */
+    BOARD_ITEM*     parseBoardElement( PCB_KEYS_T::T aToken );
+
+    /**
+     * Function parseBoardElementsInParallel
+     * parses the board elements following the header with several worker parsers, when
+     * the board is read in place from memory and is large enough.  The top level elements
+     * are first located without tokenizing them, the sections setting up the board are
+     * parsed, then the items are shared between workers having a copy of the layer and
+     * net maps, and are added to the board in file order.
+     * @return false if nothing was parsed: the elements must then be parsed sequentially.
+     */
+    bool            parseBoardElementsInParallel();
+
 
     /**
      * Function lookUpLayer
@@ -43,6 +43,8 @@
 #include <macros.h>
 #include <build_version.h>
 #include <gbr_metadata.h>
+#include <thread_pool.h>
+#include <gendrill_Excellon_writer.h>
 
 
 const wxString GetGerberProtelExtension( LAYER_NUM aLayer )
@@ -431,6 +433,35 @@ void PLOT_CONTROLLER::ClosePlot()
 }
 
 
+bool PLOT_CONTROLLER::buildPlotFileName( const wxString &aSuffix, PlotFormat aFormat )
+{
+    // Compute the full filename for the output
+    // (after ensuring the output directory is OK)
+    wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
+    wxFileName outputDir = wxFileName::DirName( outputDirName );
+    wxString boardFilename = m_board->GetFileName();
+
+    if( !EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+        return false;
+
+    // outputDir contains now the full path of plot files
+    m_plotFile = boardFilename;
+    m_plotFile.SetPath( outputDir.GetPath() );
+    wxString fileExt = GetDefaultPlotExtension( aFormat );
+
+    // Gerber format can use specific file ext, depending on layers
+    // (now not a good practice, because the official file ext is .gbr)
+    if( aFormat == PLOT_FORMAT_GERBER &&
+        GetPlotOptions().GetUseGerberProtelExtensions() )
+        fileExt = GetGerberProtelExtension( GetLayer() );
+
+    // Build plot filenames from the board name and layer names:
+    BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
+
+    return true;
+}
+
+
 bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
                                     PlotFormat     aFormat,
                                     const wxString &aSheetDesc )
@@ -445,28 +476,8 @@ bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
     // Ensure that the previous plot is closed
     ClosePlot();
 
-    // Now compute the full filename for the output and start the plot
-    // (after ensuring the output directory is OK)
-    wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
-    wxFileName outputDir = wxFileName::DirName( outputDirName );
-    wxString boardFilename = m_board->GetFileName();
-
-    if( EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+    if( buildPlotFileName( aSuffix, aFormat ) )
     {
-        // outputDir contains now the full path of plot files
-        m_plotFile = boardFilename;
-        m_plotFile.SetPath( outputDir.GetPath() );
-        wxString fileExt = GetDefaultPlotExtension( aFormat );
-
-        // Gerber format can use specific file ext, depending on layers
-        // (now not a good practice, because the official file ext is .gbr)
-        if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
-            GetPlotOptions().GetUseGerberProtelExtensions() )
-            fileExt = GetGerberProtelExtension( GetLayer() );
-
-        // Build plot filenames from the board name and layer names:
-        BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
-
         m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
                                     m_plotFile.GetFullPath(), aSheetDesc );
     }
@@ -475,6 +486,21 @@ bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
 }
 
 
+bool PLOT_CONTROLLER::AddToJob( PLOT_JOB& aJob, const wxString &aSuffix, PlotFormat aFormat,
+                                const wxString &aSheetDesc )
+{
+    if( !buildPlotFileName( aSuffix, aFormat ) )
+        return false;
+
+    PCB_PLOT_PARAMS plotOptions = GetPlotOptions();
+    plotOptions.SetFormat( aFormat );
+
+    aJob.AddLayer( ToLAYER_ID( GetLayer() ), plotOptions, m_plotFile.GetFullPath(), aSheetDesc );
+
+    return true;
+}
+
+
 bool PLOT_CONTROLLER::PlotLayer()
 {
     LOCALE_IO toggle;
@@ -506,3 +532,118 @@ bool PLOT_CONTROLLER::GetColorMode()
 
     return m_plotter->GetColorMode();
 }
+
+
+PLOT_JOB::PLOT_JOB( BOARD* aBoard ) :
+    m_board( aBoard )
+{
+}
+
+
+void PLOT_JOB::AddLayer( PCB_LAYER_ID aLayer, const PCB_PLOT_PARAMS& aPlotOptions,
+                         const wxString& aFullFilename, const wxString& aSheetDesc )
+{
+    LAYER_PLOT plot;
+    plot.m_layer = aLayer;
+    plot.m_plotOptions = aPlotOptions;
+    plot.m_fullFilename = aFullFilename;
+    plot.m_sheetDesc = aSheetDesc;
+
+    m_layerPlots.push_back( plot );
+}
+
+
+void PLOT_JOB::AddDrillFiles( EXCELLON_WRITER* aWriter, const wxString& aPlotDirectory,
+                              bool aGenDrill, bool aGenMap )
+{
+    DRILL_FILES drill;
+    drill.m_writer = aWriter;
+    drill.m_plotDirectory = aPlotDirectory;
+    drill.m_genDrill = aGenDrill;
+    drill.m_genMap = aGenMap;
+
+    m_drillFiles.push_back( drill );
+}
+
+
+bool PLOT_JOB::Run( REPORTER* aReporter )
+{
+    // The locale is global: switch it once for all the plots
+    LOCALE_IO toggle;
+
+    size_t            layerCount = m_layerPlots.size();
+    std::vector<char> plotted( layerCount, false );
+
+    // The drill writers report to a string, read once they are done
+    std::vector<wxString> drillMessages( m_drillFiles.size() );
+
+    // Each layer has its own plotter and its own file, and only reads the board
+    ParallelFor( layerCount + m_drillFiles.size(), [&]( size_t ii )
+    {
+        if( ii < layerCount )
+        {
+            LAYER_PLOT& plot = m_layerPlots[ii];
+
+            PLOTTER* plotter = StartPlotBoard( m_board, &plot.m_plotOptions, plot.m_layer,
+                                               plot.m_fullFilename, plot.m_sheetDesc );
+
+            if( plotter )
+            {
+                PlotOneBoardLayer( m_board, plotter, plot.m_layer, plot.m_plotOptions );
+                plotter->EndPlot();
+                delete plotter;
+
+                plotted[ii] = true;
+            }
+        }
+        else
+        {
+            DRILL_FILES&       drill = m_drillFiles[ii - layerCount];
+            WX_STRING_REPORTER reporter( &drillMessages[ii - layerCount] );
+
+            drill.m_writer->CreateDrillandMapFilesSet( drill.m_plotDirectory, drill.m_genDrill,
+                                                       drill.m_genMap, &reporter );
+        }
+    } );
+
+    bool success = true;
+
+    for( size_t ii = 0; ii < layerCount; ++ii )
+    {
+        const wxString& fullFilename = m_layerPlots[ii].m_fullFilename;
+        wxString        msg;
+
+        if( plotted[ii] )
+        {
+            if( aReporter )
+            {
+                msg.Printf( _( "Plot file \"%s\" created." ), GetChars( fullFilename ) );
+                aReporter->Report( msg, REPORTER::RPT_ACTION );
+            }
+        }
+        else
+        {
+            success = false;
+
+            if( aReporter )
+            {
+                msg.Printf( _( "Unable to create file \"%s\"." ), GetChars( fullFilename ) );
+                aReporter->Report( msg, REPORTER::RPT_ERROR );
+            }
+        }
+    }
+
+    if( aReporter )
+    {
+        for( const wxString& msg : drillMessages )
+        {
+            if( !msg.IsEmpty() )
+                aReporter->Report( msg );
+        }
+    }
+
+    m_layerPlots.clear();
+    m_drillFiles.clear();
+
+    return success;
+}
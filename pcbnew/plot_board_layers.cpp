@@ -53,6 +53,8 @@
 #include <pcbplot.h>
 #include <gbr_metadata.h>
 
+#include <memory>
+
 // Local
 /* Plot a solder mask layer.
  * Solder mask layers have a minimum thickness value and cannot be drawn like standard layers,
@@ -362,7 +364,7 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             wxSize extraSize = margin * 2;
             extraSize.x += width_adj;
             extraSize.y += width_adj;
-            wxSize deltaSize = pad->GetDelta(); // has meaning only for trapezoidal pads
+            wxSize plotDelta = pad->GetDelta(); // has meaning only for trapezoidal pads
 
             if( pad->GetShape() == PAD_SHAPE_TRAPEZOID )
             {   // The easy way is to use BuildPadPolygon to calculate
@@ -388,14 +390,12 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
 
                 // calculate the delta ( difference of lenght between 2 opposite edges )
                 // The delta.x is the delta along the X axis, therefore the delta of Y lenghts
-                wxSize delta;
+                plotDelta = wxSize( 0, 0 );
 
                 if( coord[0].y != coord[3].y )
-                    delta.x = coord[0].y - coord[3].y;
+                    plotDelta.x = coord[0].y - coord[3].y;
                 else
-                    delta.y = coord[1].x - coord[0].x;
-
-                pad->SetDelta( delta );
+                    plotDelta.y = coord[1].x - coord[0].x;
             }
             else
                 padPlotsSize = pad->GetSize() + extraSize;
@@ -412,45 +412,54 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             if( pad->GetLayerSet()[F_Cu] )
                 color = color.LegacyMix( aBoard->Colors().GetItemColor( LAYER_PAD_FR ) );
 
-            // Temporary set the pad size to the required plot size:
-            wxSize tmppadsize = pad->GetSize();
+            // Several layers can be plotted at once from the same board (see PLOT_JOB), so
+            // the pad is never resized in place: a copy with the plot size is plotted instead.
+            std::unique_ptr<D_PAD> sizedPad;
+            D_PAD*                 plotPad = pad;
+
+            if( pad->GetShape() != PAD_SHAPE_CUSTOM
+                    && ( padPlotsSize != pad->GetSize() || plotDelta != pad->GetDelta() ) )
+            {
+                sizedPad.reset( new D_PAD( *pad ) );
+                sizedPad->SetSize( padPlotsSize );
+                sizedPad->SetDelta( plotDelta );
+                plotPad = sizedPad.get();
+            }
 
             switch( pad->GetShape() )
             {
             case PAD_SHAPE_CIRCLE:
             case PAD_SHAPE_OVAL:
-                pad->SetSize( padPlotsSize );
-
                 if( aPlotOpt.GetSkipPlotNPTH_Pads() &&
-                    ( pad->GetSize() == pad->GetDrillSize() ) &&
+                    ( padPlotsSize == pad->GetDrillSize() ) &&
                     ( pad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED ) )
                     break;
 
-                itemplotter.PlotPad( pad, color, plotMode );
+                itemplotter.PlotPad( plotPad, color, plotMode );
                 break;
 
             case PAD_SHAPE_TRAPEZOID:
             case PAD_SHAPE_RECT:
             case PAD_SHAPE_ROUNDRECT:
             case PAD_SHAPE_CHAMFERED_RECT:
-                pad->SetSize( padPlotsSize );
-                itemplotter.PlotPad( pad, color, plotMode );
+                itemplotter.PlotPad( plotPad, color, plotMode );
                 break;
 
             case PAD_SHAPE_CUSTOM:
                 // inflate/deflate a custom shape is a bit complex.
                 // so build a similar pad shape, and inflate/deflate the polygonal shape
                 {
+                D_PAD dummy( *pad );
+
                 // we expect margin.x = margin.y for custom pads
                 if( margin.x < 0 )
                     // be sure the anchor pad is not bigger than the deflated shape
                     // because this anchor will be added to the pad shape when plotting
                     // the pad
-                    pad->SetSize( padPlotsSize );
+                    dummy.SetSize( padPlotsSize );
 
-                D_PAD dummy( *pad );
                 SHAPE_POLY_SET shape;
-                pad->MergePrimitivesAsPolygon( &shape );
+                dummy.MergePrimitivesAsPolygon( &shape );
                 // shape polygon can have holes linked to the main outline.
                 // So use InflateWithLinkedHoles(), not Inflate() that can create
                 // bad shapes if margin.x is < 0
@@ -466,9 +475,6 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
                 }
                 break;
             }
-
-            pad->SetSize( tmppadsize );     // Restore the pad size
-            pad->SetDelta( deltaSize );
         }
 
         aPlotter->EndBlock( NULL );
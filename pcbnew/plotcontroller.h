@@ -30,11 +30,16 @@
 #ifndef PLOTCONTROLLER_H_
 #define PLOTCONTROLLER_H_
 
+#include <vector>
+
 #include <pcb_plot_params.h>
 #include <layers_id_colors_and_visibility.h>
 
 class PLOTTER;
 class BOARD;
+class EXCELLON_WRITER;
+class REPORTER;
+class PLOT_JOB;
 
 
 /**
@@ -84,6 +89,17 @@ public:
      */
     bool PlotLayer();
 
+    /** Add the plot of the current layer to a batch of plots, with the current options.
+     * The plot file is named as by OpenPlotfile(), but only created by PLOT_JOB::Run().
+     * @param aJob is the batch of plots
+     * @param aSuffix is a string added to the base filename (derived from
+     * the board filename) to identify the plot file
+     * @param aFormat is the plot file format identifier
+     * @param aSheetDesc
+     */
+    bool AddToJob( PLOT_JOB& aJob, const wxString &aSuffix, PlotFormat aFormat,
+                   const wxString &aSheetDesc );
+
     /**
      * @return the current plot full filename, set by OpenPlotfile
      */
@@ -108,6 +124,12 @@ public:
     bool GetColorMode();
 
 private:
+    /** Build the full filename of a plot of the current layer in m_plotFile,
+     * and ensure the output directory exists
+     * @return true if the output directory is OK
+     */
+    bool buildPlotFileName( const wxString &aSuffix, PlotFormat aFormat );
+
     /// the layer to plot
     LAYER_NUM m_plotLayer;
 
@@ -125,5 +147,67 @@ private:
     wxFileName m_plotFile;
 };
 
+
+/**
+ * A batch of plots, run concurrently: board layers, each one plotted to its own file by its
+ * own plotter, and drill files.  The plots only read the board, which must not be changed
+ * until Run() returns.
+ */
+class PLOT_JOB
+{
+public:
+    PLOT_JOB( BOARD* aBoard );
+
+    /**
+     * Add the plot of a layer
+     * @param aLayer is the layer to plot
+     * @param aPlotOptions are the plot options, including the plot file format
+     * @param aFullFilename is the full name of the plot file
+     * @param aSheetDesc is the sheet description, for the title block
+     */
+    void AddLayer( PCB_LAYER_ID aLayer, const PCB_PLOT_PARAMS& aPlotOptions,
+                   const wxString& aFullFilename,
+                   const wxString& aSheetDesc = wxEmptyString );
+
+    /**
+     * Add the creation of drill files and drill map files
+     * @param aWriter is the drill file writer, already set up, which must not be used
+     * until Run() returns
+     * @param aPlotDirectory is the output directory
+     * @param aGenDrill = true to create the drill files
+     * @param aGenMap = true to create the drill map files
+     */
+    void AddDrillFiles( EXCELLON_WRITER* aWriter, const wxString& aPlotDirectory,
+                        bool aGenDrill, bool aGenMap );
+
+    /**
+     * Run all the plots, and forget them.
+     * @param aReporter receives the messages of the plots, in the order they were added
+     * @return true if all the layer plot files were created
+     */
+    bool Run( REPORTER* aReporter = NULL );
+
+private:
+    struct LAYER_PLOT
+    {
+        PCB_LAYER_ID    m_layer;
+        PCB_PLOT_PARAMS m_plotOptions;
+        wxString        m_fullFilename;
+        wxString        m_sheetDesc;
+    };
+
+    struct DRILL_FILES
+    {
+        EXCELLON_WRITER* m_writer;
+        wxString         m_plotDirectory;
+        bool             m_genDrill;
+        bool             m_genMap;
+    };
+
+    BOARD*                   m_board;
+    std::vector<LAYER_PLOT>  m_layerPlots;
+    std::vector<DRILL_FILES> m_drillFiles;
+};
+
 #endif
 
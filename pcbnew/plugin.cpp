@@ -24,6 +24,7 @@
 
 #include <io_mgr.h>
 #include <properties.h>
+#include <class_module.h>
 
 
 #define FMT_UNIMPLEMENTED   _( "Plugin \"%s\" does not implement the \"%s\" function." )
@@ -81,6 +82,26 @@ const MODULE* PLUGIN::GetEnumeratedFootprint( const wxString& aLibraryPath,
 }
 
 
+bool PLUGIN::GetEnumeratedFootprintMetadata( const wxString& aLibraryPath,
+                                             const wxString& aFootprintName,
+                                             FOOTPRINT_METADATA& aMetadata,
+                                             const PROPERTIES* aProperties )
+{
+    // default implementation
+    const MODULE* footprint = GetEnumeratedFootprint( aLibraryPath, aFootprintName, aProperties );
+
+    if( !footprint )
+        return false;
+
+    aMetadata.m_Description = footprint->GetDescription();
+    aMetadata.m_Keywords = footprint->GetKeywords();
+    aMetadata.m_PadCount = footprint->GetPadCount( DO_NOT_INCLUDE_NPTH );
+    aMetadata.m_UniquePadCount = footprint->GetUniquePadCount( DO_NOT_INCLUDE_NPTH );
+
+    return true;
+}
+
+
 MODULE* PLUGIN::FootprintLoad( const wxString& aLibraryPath, const wxString& aFootprintName,
                                const PROPERTIES* aProperties )
 {
@@ -49,136 +49,141 @@ static uint64_t getDistance( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& a
 }
 
 
-static bool sortWeight( const CN_EDGE& aEdge1, const CN_EDGE& aEdge2 )
+/**
+ * Candidate edge of the spanning tree.  The nodes are indices in the node list of the net, so
+ * that the candidates can be stored and sorted without touching the anchor reference counts.
+ */
+struct RN_CANDIDATE_EDGE
+{
+    int m_source;
+    int m_target;
+    int m_weight;
+};
+
+
+/**
+ * Finds the representative of a node in a disjoint set forest, halving the path on the way.
+ */
+static int findSet( std::vector<int>& aParents, int aNode )
 {
-    return aEdge1.GetWeight() < aEdge2.GetWeight();
+    while( aParents[aNode] != aNode )
+    {
+        aParents[aNode] = aParents[aParents[aNode]];
+        aNode = aParents[aNode];
+    }
+
+    return aNode;
 }
 
 
-static const std::vector<CN_EDGE> kruskalMST( std::list<CN_EDGE>& aEdges,
-        std::vector<CN_ANCHOR_PTR>& aNodes )
+/**
+ * Kruskal algorithm: fills aMst with the ratsnest edges (the ones with a non-zero weight)
+ * of the minimum spanning tree of aEdges.
+ * @param aEdges are the candidate edges, they are sorted by the call.
+ * @param aParents is a scratch buffer for the disjoint set forest.
+ */
+static void kruskalMST( std::vector<RN_CANDIDATE_EDGE>& aEdges,
+        const std::vector<CN_ANCHOR_PTR>& aNodes, std::vector<int>& aParents,
+        std::vector<CN_EDGE>& aMst )
 {
     unsigned int    nodeNumber = aNodes.size();
     unsigned int    mstExpectedSize = nodeNumber - 1;
     unsigned int    mstSize = 0;
-    bool ratsnestLines = false;
-
-    // The output
-    std::vector<CN_EDGE> mst;
-
-    // Set tags for marking cycles
-    std::unordered_map<CN_ANCHOR_PTR, int> tags;
-    unsigned int tag = 0;
 
-    for( auto& node : aNodes )
-    {
-        node->SetTag( tag );
-        tags[node] = tag++;
-    }
+    aMst.clear();
 
-    // Lists of nodes connected together (subtrees) to detect cycles in the graph
-    std::vector<std::list<int> > cycles( nodeNumber );
+    aParents.resize( nodeNumber );
 
     for( unsigned int i = 0; i < nodeNumber; ++i )
-        cycles[i].push_back( i );
+        aParents[i] = i;
 
-    // Kruskal algorithm requires edges to be sorted by their weight
-    aEdges.sort( sortWeight );
+    // Kruskal algorithm requires edges to be sorted by their weight.  The sort is stable so
+    // that the result does not depend on the sort implementation.
+    std::stable_sort( aEdges.begin(), aEdges.end(),
+            []( const RN_CANDIDATE_EDGE& aEdge1, const RN_CANDIDATE_EDGE& aEdge2 )
+            {
+                return aEdge1.m_weight < aEdge2.m_weight;
+            } );
 
-    while( mstSize < mstExpectedSize && !aEdges.empty() )
+    for( const auto& dt : aEdges )
     {
-        //printf("mstSize %d %d\n", mstSize, mstExpectedSize);
-        auto& dt = aEdges.front();
+        if( mstSize >= mstExpectedSize )
+            break;
 
-        int srcTag  = tags[dt.GetSourceNode()];
-        int trgTag  = tags[dt.GetTargetNode()];
+        int srcTag = findSet( aParents, dt.m_source );
+        int trgTag = findSet( aParents, dt.m_target );
 
         // Check if by adding this edge we are going to join two different forests
-        if( srcTag != trgTag )
-        {
-            // Because edges are sorted by their weight, first we always process connected
-            // items (weight == 0). Once we stumble upon an edge with non-zero weight,
-            // it means that the rest of the lines are ratsnest.
-            if( !ratsnestLines && dt.GetWeight() != 0 )
-                ratsnestLines = true;
-
-            // Update tags
-            if( ratsnestLines )
-            {
-                for( auto it = cycles[trgTag].begin(); it != cycles[trgTag].end(); ++it )
-                {
-                    tags[aNodes[*it]] = srcTag;
-                }
+        if( srcTag == trgTag )
+            continue;
 
-                // Do a copy of edge, but make it RN_EDGE_MST. In contrary to RN_EDGE,
-                // RN_EDGE_MST saves both source and target node and does not require any other
-                // edges to exist for getting source/target nodes
-                CN_EDGE newEdge ( dt.GetSourceNode(), dt.GetTargetNode(), dt.GetWeight() );
+        aParents[trgTag] = srcTag;
 
-                assert( newEdge.GetSourceNode()->GetTag() != newEdge.GetTargetNode()->GetTag() );
-                assert( newEdge.GetWeight() > 0 );
-
-                mst.push_back( newEdge );
-                ++mstSize;
-            }
-            else
-            {
-                // for( it = cycles[trgTag].begin(), itEnd = cycles[trgTag].end(); it != itEnd; ++it )
-                // for( auto it : cycles[trgTag] )
-                for( auto it = cycles[trgTag].begin(); it != cycles[trgTag].end(); ++it )
-                {
-                    tags[aNodes[*it]] = srcTag;
-                    aNodes[*it]->SetTag( srcTag );
-                }
-
-                // Processing a connection, decrease the expected size of the ratsnest MST
-                --mstExpectedSize;
-            }
-
-            // Move nodes that were marked with old tag to the list marked with the new tag
-            cycles[srcTag].splice( cycles[srcTag].end(), cycles[trgTag] );
+        // Because edges are sorted by their weight, first we always process connected
+        // items (weight == 0). The rest of the edges are ratsnest lines.
+        if( dt.m_weight != 0 )
+        {
+            aMst.emplace_back( aNodes[dt.m_source], aNodes[dt.m_target], dt.m_weight );
+            ++mstSize;
+        }
+        else
+        {
+            // Processing a connection, decrease the expected size of the ratsnest MST
+            --mstExpectedSize;
         }
-
-        // Remove the edge that was just processed
-        aEdges.erase( aEdges.begin() );
     }
+}
 
-    // Probably we have discarded some of edges, so reduce the size
-    mst.resize( mstSize );
 
-    return mst;
-}
+/**
+ * Nets with up to this number of distinct node positions use the complete graph of their
+ * nodes instead of a triangulation: it is small enough, and it does not allocate anything.
+ * The Delaunay triangulation contains the euclidean minimum spanning tree, so both give the
+ * same spanning tree length.
+ */
+static const unsigned int RN_COMPLETE_GRAPH_MAX_NODES = 16;
 
 
+/**
+ * Scratch space of the ratsnest computation of a net.  It lives as long as the net, so the
+ * buffers keep their capacity from one update to the next one and are not reallocated.
+ */
 class RN_NET::TRIANGULATOR_STATE
 {
 private:
-    std::vector<CN_ANCHOR_PTR>  m_allNodes;
+    ///> Node indices sorted by position
+    std::vector<int> m_order;
 
-    std::list<hed::EDGE_PTR> hedTriangulation( std::vector<hed::NODE_PTR>& aNodes )
-    {
-        hed::TRIANGULATION triangulator;
-        triangulator.CreateDelaunay( aNodes.begin(), aNodes.end() );
-        std::list<hed::EDGE_PTR> edges;
-        triangulator.GetEdges( edges );
+    ///> Indices in m_order of the first node of each distinct position
+    std::vector<int> m_distinct;
 
-        return edges;
-    }
+    ///> Triangulation input, sorted by position and kept for the next update
+    std::vector<hed::NODE_PTR> m_triNodes;
 
+    ///> Triangulation input of the previous update
+    std::vector<hed::NODE_PTR> m_prevTriNodes;
 
-    // Checks if all nodes in aNodes lie on a single line. Requires the nodes to
-    // have unique coordinates!
-    bool areNodesColinear( const std::vector<hed::NODE_PTR>& aNodes ) const
+    ///> Triangulation output
+    std::list<hed::EDGE_PTR> m_triangEdges;
+
+    ///> Candidate edges of the spanning tree
+    std::vector<RN_CANDIDATE_EDGE> m_edges;
+
+    ///> Disjoint set forest of the Kruskal algorithm
+    std::vector<int> m_parents;
+
+    // Checks if all the distinct positions lie on a single line.
+    bool areNodesColinear( const std::vector<CN_ANCHOR_PTR>& aNodes ) const
     {
-        if ( aNodes.size() <= 2 )
+        if ( m_distinct.size() <= 2 )
             return true;
 
-        const auto p0 = aNodes[0]->Pos();
-        const auto v0 = aNodes[1]->Pos() - p0;
+        const auto p0 = aNodes[m_order[m_distinct[0]]]->Pos();
+        const auto v0 = aNodes[m_order[m_distinct[1]]]->Pos() - p0;
 
-        for( unsigned i = 2; i < aNodes.size(); i++ )
+        for( unsigned i = 2; i < m_distinct.size(); i++ )
         {
-            const auto v1 = aNodes[i]->Pos() - p0;
+            const auto v1 = aNodes[m_order[m_distinct[i]]]->Pos() - p0;
 
             if( v0.Cross( v1 ) != 0 )
             {
@@ -191,130 +196,150 @@ private:
 
 public:
 
-    void Clear()
-    {
-        m_allNodes.clear();
-    }
-
-    void AddNode( CN_ANCHOR_PTR aNode )
+    std::vector<int>& Parents()
     {
-        m_allNodes.push_back( aNode );
+        return m_parents;
     }
 
-    const std::list<CN_EDGE> Triangulate()
+    /**
+     * Computes the candidate edges of the spanning tree of aNodes: the edges of the Delaunay
+     * triangulation of the node positions (or all the edges for small nets), plus the edges
+     * joining the nodes sharing a position.  The tag of each node is set to its index in aNodes.
+     */
+    std::vector<RN_CANDIDATE_EDGE>& Triangulate( const std::vector<CN_ANCHOR_PTR>& aNodes )
     {
-        std::list<CN_EDGE> mstEdges;
-        std::list<hed::EDGE_PTR> triangEdges;
-        std::vector<hed::NODE_PTR> triNodes;
+        m_edges.clear();
+        m_order.resize( aNodes.size() );
 
-        using ANCHOR_LIST = std::vector<CN_ANCHOR_PTR>;
-        std::vector<ANCHOR_LIST> anchorChains;
-
-        triNodes.reserve( m_allNodes.size() );
-        anchorChains.reserve( m_allNodes.size() );
+        for( unsigned int i = 0; i < aNodes.size(); i++ )
+        {
+            aNodes[i]->SetTag( i );
+            m_order[i] = i;
+        }
 
-        std::sort( m_allNodes.begin(), m_allNodes.end(),
-                [] ( const CN_ANCHOR_PTR& aNode1, const CN_ANCHOR_PTR& aNode2 )
+        std::sort( m_order.begin(), m_order.end(),
+                [&aNodes] ( int aNode1, int aNode2 )
         {
-            if( aNode1->Pos().y < aNode2->Pos().y )
-                return true;
-            else if( aNode1->Pos().y == aNode2->Pos().y )
-            {
-                return aNode1->Pos().x < aNode2->Pos().x;
-            }
+            const VECTOR2I& p1 = aNodes[aNode1]->Pos();
+            const VECTOR2I& p2 = aNodes[aNode2]->Pos();
+
+            if( p1.y != p2.y )
+                return p1.y < p2.y;
+            else if( p1.x != p2.x )
+                return p1.x < p2.x;
 
-            return false;
+            return aNode1 < aNode2;
         }
                 );
 
-        CN_ANCHOR_PTR prev, last;
-        int id = 0;
+        // Nodes sharing a position are contiguous in m_order
+        m_distinct.clear();
 
-        for( auto n : m_allNodes )
+        for( unsigned int i = 0; i < m_order.size(); i++ )
         {
-            anchorChains.push_back( ANCHOR_LIST() );
+            if( i == 0 || aNodes[m_order[i - 1]]->Pos() != aNodes[m_order[i]]->Pos() )
+                m_distinct.push_back( i );
         }
 
-        for( auto n : m_allNodes )
+        if( m_distinct.size() == 1 )
         {
-            if( !prev || prev->Pos() != n->Pos() )
-            {
-                auto tn = std::make_shared<hed::NODE> ( n->Pos().x, n->Pos().y );
-
-                tn->SetId( id );
-                triNodes.push_back( tn );
-            }
-
-            id++;
-            prev = n;
+            return m_edges;
         }
 
-        int prevId = 0;
-
-        for( auto n : triNodes )
+        auto addEdge = [&] ( int aSource, int aTarget )
         {
-            for( int i = prevId; i < n->Id(); i++ )
-                anchorChains[prevId].push_back( m_allNodes[ i ] );
+            int src = m_order[aSource];
+            int dst = m_order[aTarget];
+            m_edges.push_back( { src, dst, (int) getDistance( aNodes[src], aNodes[dst] ) } );
+        };
 
-            prevId = n->Id();
-        }
-
-        for( int i = prevId; i < id; i++ )
-            anchorChains[prevId].push_back( m_allNodes[ i ] );
-
-        if( triNodes.size() == 1 )
+        if( m_distinct.size() <= RN_COMPLETE_GRAPH_MAX_NODES )
         {
-            return mstEdges;
+            for( unsigned int i = 0; i < m_distinct.size(); i++ )
+            {
+                for( unsigned int j = i + 1; j < m_distinct.size(); j++ )
+                    addEdge( m_distinct[i], m_distinct[j] );
+            }
         }
-        else if( areNodesColinear( triNodes ) )
+        else if( areNodesColinear( aNodes ) )
         {
             // special case: all nodes are on the same line - there's no
             // triangulation for such set. In this case, we sort along any coordinate
             // and chain the nodes together.
-            for(int i = 0; i < (int)triNodes.size() - 1; i++ )
-            {
-                auto src = m_allNodes[ triNodes[i]->Id() ];
-                auto dst = m_allNodes[ triNodes[i + 1]->Id() ];
-                mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
-            }
+            for(int i = 0; i < (int)m_distinct.size() - 1; i++ )
+                addEdge( m_distinct[i], m_distinct[i + 1] );
         }
         else
         {
-            hed::TRIANGULATION triangulator;
-            triangulator.CreateDelaunay( triNodes.begin(), triNodes.end() );
-            triangulator.GetEdges( triangEdges );
+            // Triangulation nodes cannot be moved, but most of them keep their position
+            // from one update to the next one.  Both lists are sorted like m_order, so the
+            // nodes still in place are found by a merge.
+            m_prevTriNodes.swap( m_triNodes );
+            m_triNodes.clear();
+
+            auto prev = m_prevTriNodes.begin();
 
-            for( auto e : triangEdges )
+            for( int first : m_distinct )
             {
-                auto    src = m_allNodes[ e->GetSourceNode()->Id() ];
-                auto    dst = m_allNodes[ e->GetTargetNode()->Id() ];
+                const VECTOR2I& pos = aNodes[m_order[first]]->Pos();
+
+                while( prev != m_prevTriNodes.end() && ( (*prev)->GetY() < pos.y
+                        || ( (*prev)->GetY() == pos.y && (*prev)->GetX() < pos.x ) ) )
+                {
+                    ++prev;
+                }
 
-                mstEdges.emplace_back( src, dst, getDistance( src, dst ) );
+                hed::NODE_PTR tn;
+
+                if( prev != m_prevTriNodes.end()
+                        && (*prev)->GetX() == pos.x && (*prev)->GetY() == pos.y )
+                    tn = *prev++;
+                else
+                    tn = std::make_shared<hed::NODE> ( pos.x, pos.y );
+
+                tn->SetId( first );
+                m_triNodes.push_back( tn );
             }
+
+            m_prevTriNodes.clear();
+
+            hed::TRIANGULATION triangulator;
+            triangulator.CreateDelaunay( m_triNodes.begin(), m_triNodes.end() );
+
+            m_triangEdges.clear();
+            triangulator.GetEdges( m_triangEdges );
+
+            for( const auto& e : m_triangEdges )
+                addEdge( e->GetSourceNode()->Id(), e->GetTargetNode()->Id() );
+
+            // The triangulation is not needed any more
+            m_triangEdges.clear();
         }
 
-        for( unsigned int i = 0; i < anchorChains.size(); i++ )
+        // Chain together the nodes sharing a position, ordered by cluster
+        for( unsigned int i = 0; i < m_distinct.size(); i++ )
         {
-            auto& chain = anchorChains[i];
+            unsigned int first = m_distinct[i];
+            unsigned int last = ( i + 1 < m_distinct.size() ) ? m_distinct[i + 1] : m_order.size();
 
-            if( chain.size() < 2 )
+            if( last - first < 2 )
                 continue;
 
-            std::sort( chain.begin(), chain.end(),
-                    [] ( const CN_ANCHOR_PTR& a, const CN_ANCHOR_PTR& b ) {
-                return a->GetCluster().get() < b->GetCluster().get();
+            std::sort( m_order.begin() + first, m_order.begin() + last,
+                    [&aNodes] ( int a, int b ) {
+                return aNodes[a]->GetCluster().get() < aNodes[b]->GetCluster().get();
             } );
 
-            for( unsigned int j = 1; j < chain.size(); j++ )
+            for( unsigned int j = first + 1; j < last; j++ )
             {
-                const auto& prevNode    = chain[j - 1];
-                const auto& curNode     = chain[j];
+                const auto& prevNode    = aNodes[m_order[j - 1]];
+                const auto& curNode     = aNodes[m_order[j]];
                 int weight = prevNode->GetCluster() != curNode->GetCluster() ? 1 : 0;
-                mstEdges.push_back( CN_EDGE ( prevNode, curNode, weight ) );
+                m_edges.push_back( { m_order[j - 1], m_order[j], weight } );
             }
         }
 
-        return mstEdges;
+        return m_edges;
     }
 };
 
@@ -355,37 +380,32 @@ void RN_NET::compute()
         return;
     }
 
-
-    m_triangulator->Clear();
-
-    for( auto n : m_nodes )
-    {
-        m_triangulator->AddNode( n );
-    }
-
     #ifdef PROFILE
     PROF_COUNTER cnt("triangulate");
     #endif
-    auto triangEdges = m_triangulator->Triangulate();
+    auto& candidates = m_triangulator->Triangulate( m_nodes );
     #ifdef PROFILE
     cnt.Show();
     #endif
 
+    // Triangulate() tagged the nodes with their index
     for( const auto& e : m_boardEdges )
-        triangEdges.push_back( e );
+    {
+        candidates.push_back( { e.GetSourceNode()->GetTag(), e.GetTargetNode()->GetTag(),
+                                e.GetWeight() } );
+    }
 
 // Get the minimal spanning tree
 #ifdef PROFILE
     PROF_COUNTER cnt2("mst");
 #endif
-    m_rnEdges = kruskalMST( triangEdges, m_nodes );
+    kruskalMST( candidates, m_nodes, m_triangulator->Parents(), m_rnEdges );
 #ifdef PROFILE
     cnt2.Show();
 #endif
 }
 
 
-
 void RN_NET::Update()
 {
     compute();
@@ -78,6 +78,7 @@ public:
     virtual int DpNetPolarity( int aNet ) override;
     virtual bool DpNetPair( PNS::ITEM* aItem, int& aNetP, int& aNetN ) override;
     virtual wxString NetName( int aNet ) override;
+    virtual PNS::RULE_RESOLVER* Clone() const override;
 
 private:
     struct CLEARANCE_ENT
@@ -94,7 +95,7 @@ private:
     BOARD*       m_board;
 
     std::vector<CLEARANCE_ENT> m_netClearanceCache;
-    std::unordered_map<const D_PAD*, int> m_localClearanceCache;
+    std::unordered_map<const BOARD_ITEM*, int> m_localClearanceCache;
     int m_defaultClearance;
 };
 
@@ -168,12 +169,12 @@ PNS_PCBNEW_RULE_RESOLVER::~PNS_PCBNEW_RULE_RESOLVER()
 
 int PNS_PCBNEW_RULE_RESOLVER::localPadClearance( const PNS::ITEM* aItem ) const
 {
-    if( !aItem->Parent() || aItem->Parent()->Type() != PCB_PAD_T )
+    // Only pads are in the cache.  The parent is not dereferenced, as the item may be
+    // from a snapshot of the world outliving it.
+    if( !aItem->Parent() )
         return 0;
 
-    const D_PAD* pad = static_cast<D_PAD*>( aItem->Parent() );
-
-    auto i = m_localClearanceCache.find( pad );
+    auto i = m_localClearanceCache.find( aItem->Parent() );
 
     if( i == m_localClearanceCache.end() )
         return 0;
@@ -203,6 +204,12 @@ int PNS_PCBNEW_RULE_RESOLVER::Clearance( const PNS::ITEM* aA, const PNS::ITEM* a
 }
 
 
+PNS::RULE_RESOLVER* PNS_PCBNEW_RULE_RESOLVER::Clone() const
+{
+    return new PNS_PCBNEW_RULE_RESOLVER( *this );
+}
+
+
 int PNS_PCBNEW_RULE_RESOLVER::Clearance( int aNetCode ) const
 {
     if( aNetCode > 0 && aNetCode < (int) m_netClearanceCache.size() )
@@ -432,6 +439,9 @@ public:
 
     void AddLine( const SHAPE_LINE_CHAIN& aLine, int aType, int aWidth ) override
     {
+        if( !m_view )
+            return;
+
         ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( NULL, m_view );
 
         pitem->Line( aLine, aWidth, aType );
@@ -468,13 +478,19 @@ PNS_KICAD_IFACE::PNS_KICAD_IFACE()
     m_view = nullptr;
     m_previewItems = nullptr;
     m_router = nullptr;
-    m_debugDecorator = nullptr;
+    m_debugDecorator = new PNS_PCBNEW_DEBUG_DECORATOR();
     m_dispOptions = nullptr;
+    m_world = nullptr;
+    m_rulesDirty = false;
+    m_worstPadClearance = 0;
 }
 
 
 PNS_KICAD_IFACE::~PNS_KICAD_IFACE()
 {
+    if( m_board )
+        m_board->RemoveListener( this );
+
     delete m_ruleResolver;
     delete m_debugDecorator;
 
@@ -827,7 +843,7 @@ bool PNS_KICAD_IFACE::syncZone( PNS::NODE* aWorld, ZONE_CONTAINER* aZone )
                 solid->SetShape( triShape );
                 solid->SetRoutable( false );
 
-                aWorld->Add( std::move( solid ) );
+                addSolid( aWorld, aZone, std::move( solid ) );
             }
         }
     }
@@ -836,7 +852,8 @@ bool PNS_KICAD_IFACE::syncZone( PNS::NODE* aWorld, ZONE_CONTAINER* aZone )
 }
 
 
-bool PNS_KICAD_IFACE::syncTextItem( PNS::NODE* aWorld, EDA_TEXT* aText, PCB_LAYER_ID aLayer )
+bool PNS_KICAD_IFACE::syncTextItem( PNS::NODE* aWorld, const BOARD_ITEM* aOwner, EDA_TEXT* aText,
+                                    PCB_LAYER_ID aLayer )
 {
     if( !IsCopperLayer( aLayer ) )
         return false;
@@ -861,7 +878,7 @@ bool PNS_KICAD_IFACE::syncTextItem( PNS::NODE* aWorld, EDA_TEXT* aText, PCB_LAYE
         solid->SetShape( new SHAPE_SEGMENT( start, end, textWidth ) );
         solid->SetRoutable( false );
 
-        aWorld->Add( std::move( solid ) );
+        addSolid( aWorld, aOwner, std::move( solid ) );
     }
 
     return true;
@@ -888,7 +905,8 @@ bool PNS_KICAD_IFACE::syncTextItem( PNS::NODE* aWorld, EDA_TEXT* aText, PCB_LAYE
 }
 
 
-bool PNS_KICAD_IFACE::syncGraphicalItem( PNS::NODE* aWorld, DRAWSEGMENT* aItem )
+bool PNS_KICAD_IFACE::syncGraphicalItem( PNS::NODE* aWorld, const BOARD_ITEM* aOwner,
+                                         DRAWSEGMENT* aItem )
 {
     std::vector<SHAPE_SEGMENT*> segs;
 
@@ -975,22 +993,233 @@ bool PNS_KICAD_IFACE::syncGraphicalItem( PNS::NODE* aWorld, DRAWSEGMENT* aItem )
         solid->SetShape( seg );
         solid->SetRoutable( false );
 
-        aWorld->Add( std::move( solid ) );
+        addSolid( aWorld, aOwner, std::move( solid ) );
     }
 
     return true;
 }
 
+
+void PNS_KICAD_IFACE::addSolid( PNS::NODE* aWorld, const BOARD_ITEM* aOwner,
+                                std::unique_ptr<PNS::SOLID> aSolid )
+{
+    m_worldSolids[ aOwner ].push_back( aSolid.get() );
+    aWorld->Add( std::move( aSolid ) );
+}
+
+
+void PNS_KICAD_IFACE::syncModule( PNS::NODE* aWorld, MODULE* aModule )
+{
+    for( auto pad : aModule->Pads() )
+    {
+        if( auto solid = syncPad( pad ) )
+            addSolid( aWorld, aModule, std::move( solid ) );
+
+        m_worstPadClearance = std::max( m_worstPadClearance, pad->GetLocalClearance() );
+    }
+
+    syncTextItem( aWorld, aModule, &aModule->Reference(), aModule->Reference().GetLayer() );
+    syncTextItem( aWorld, aModule, &aModule->Value(), aModule->Value().GetLayer() );
+
+    if( aModule->IsNetTie() )
+        return;
+
+    for( auto mgitem : aModule->GraphicalItems() )
+    {
+        if( mgitem->Type() == PCB_MODULE_EDGE_T )
+        {
+            syncGraphicalItem( aWorld, aModule, static_cast<DRAWSEGMENT*>( mgitem ) );
+        }
+        else if( mgitem->Type() == PCB_MODULE_TEXT_T )
+        {
+            syncTextItem( aWorld, aModule, dynamic_cast<TEXTE_MODULE*>( mgitem ),
+                          mgitem->GetLayer() );
+        }
+    }
+}
+
+
+void PNS_KICAD_IFACE::syncItem( PNS::NODE* aWorld, BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case PCB_TRACE_T:
+        if( auto segment = syncTrack( static_cast<TRACK*>( aItem ) ) )
+            aWorld->Add( std::move( segment ) );
+
+        break;
+
+    case PCB_VIA_T:
+        if( auto via = syncVia( static_cast<VIA*>( aItem ) ) )
+            aWorld->Add( std::move( via ) );
+
+        break;
+
+    case PCB_MODULE_T:
+        syncModule( aWorld, static_cast<MODULE*>( aItem ) );
+        break;
+
+    case PCB_ZONE_AREA_T:
+        syncZone( aWorld, static_cast<ZONE_CONTAINER*>( aItem ) );
+        break;
+
+    case PCB_LINE_T:
+        syncGraphicalItem( aWorld, aItem, static_cast<DRAWSEGMENT*>( aItem ) );
+        break;
+
+    case PCB_TEXT_T:
+        syncTextItem( aWorld, aItem, static_cast<TEXTE_PCB*>( aItem ), aItem->GetLayer() );
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void PNS_KICAD_IFACE::removeItem( PNS::NODE* aWorld, const BOARD_ITEM* aItem,
+                                  const PENDING_CHANGE& aChange )
+{
+    auto solids = m_worldSolids.find( aItem );
+
+    if( solids != m_worldSolids.end() )
+    {
+        for( PNS::ITEM* solid : solids->second )
+            aWorld->Remove( solid );
+
+        m_worldSolids.erase( solids );
+        return;
+    }
+
+    if( aChange.m_type != PCB_TRACE_T && aChange.m_type != PCB_VIA_T )
+        return;
+
+    // A removed item may be deleted already: it is only compared to the parents.  A track
+    // dropped as redundant when synced has no item in the world.
+    auto track = static_cast<const TRACK*>( aItem );
+
+    if( PNS::ITEM* item = aWorld->FindItemByParent( track, aChange.m_oldNet ) )
+        aWorld->Remove( item );
+}
+
+
+void PNS_KICAD_IFACE::updateRules( PNS::NODE* aWorld )
+{
+    int worstRuleClearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
+
+    delete m_ruleResolver;
+    m_ruleResolver = new PNS_PCBNEW_RULE_RESOLVER( m_board, m_router );
+
+    aWorld->SetRuleResolver( m_ruleResolver );
+    aWorld->SetMaxClearance( 4 * std::max( m_worstPadClearance, worstRuleClearance ) );
+
+    m_rulesDirty = false;
+}
+
+
 void PNS_KICAD_IFACE::SetBoard( BOARD* aBoard )
 {
+    if( m_board )
+        m_board->RemoveListener( this );
+
     m_board = aBoard;
+    m_world = nullptr;
     wxLogTrace( "PNS", "m_board = %p", m_board );
+
+    if( m_board )
+        m_board->AddListener( this );
+}
+
+
+void PNS_KICAD_IFACE::queueChange( BOARD_ITEM* aItem, bool aOnBoard, bool aInWorld )
+{
+    if( !m_world || m_committedItems.count( aItem ) )
+        return;
+
+    switch( aItem->Type() )
+    {
+    case PCB_NETINFO_T:
+        m_rulesDirty = true;
+        return;
+
+    case PCB_MODULE_T:
+        // the local clearances of the pads are cached by the rule resolver
+        m_rulesDirty = true;
+        break;
+
+    case PCB_TRACE_T:
+    case PCB_VIA_T:
+    case PCB_ZONE_AREA_T:
+    case PCB_LINE_T:
+    case PCB_TEXT_T:
+        break;
+
+    default:
+        return;
+    }
+
+    auto it = m_pendingChanges.find( aItem );
+
+    if( it == m_pendingChanges.end() )
+    {
+        PENDING_CHANGE change;
+
+        // only the first notification tells if the world holds the item
+        change.m_type = aItem->Type();
+        change.m_onBoard = aOnBoard;
+        change.m_inWorld = aInWorld;
+        change.m_oldNet = -1;
+        it = m_pendingChanges.emplace( aItem, change ).first;
+    }
+
+    it->second.m_onBoard = aOnBoard;
+
+    // The world holds a track under the net it had when synced.  The editors which do not
+    // use a BOARD_COMMIT notify the items before changing them, so the first net seen is
+    // the best guess.
+    if( it->second.m_inWorld && it->second.m_oldNet < 0
+            && ( aItem->Type() == PCB_TRACE_T || aItem->Type() == PCB_VIA_T ) )
+        it->second.m_oldNet = static_cast<TRACK*>( aItem )->GetNetCode();
+}
+
+
+void PNS_KICAD_IFACE::OnBoardItemAdded( BOARD& aBoard, BOARD_ITEM* aBoardItem )
+{
+    queueChange( aBoardItem, true, false );
+}
+
+
+void PNS_KICAD_IFACE::OnBoardItemRemoved( BOARD& aBoard, BOARD_ITEM* aBoardItem )
+{
+    queueChange( aBoardItem, false, true );
+}
+
+
+void PNS_KICAD_IFACE::OnBoardItemChanged( BOARD& aBoard, BOARD_ITEM* aBoardItem )
+{
+    queueChange( aBoardItem, true, true );
+}
+
+
+void PNS_KICAD_IFACE::OnBoardChanged( BOARD& aBoard )
+{
+    m_rulesDirty = true;
+}
+
+
+void PNS_KICAD_IFACE::OnBoardDeleted( BOARD& aBoard )
+{
+    m_board = nullptr;
+    m_world = nullptr;
 }
 
 
 void PNS_KICAD_IFACE::SyncWorld( PNS::NODE *aWorld )
 {
-    int worstPadClearance = 0;
+    m_world = nullptr;
+    m_worldSolids.clear();
+    m_pendingChanges.clear();
+    m_worstPadClearance = 0;
 
     if( !m_board )
     {
@@ -999,79 +1228,63 @@ void PNS_KICAD_IFACE::SyncWorld( PNS::NODE *aWorld )
     }
 
     for( auto gitem : m_board->Drawings() )
-    {
-        if ( gitem->Type() == PCB_LINE_T )
-        {
-            syncGraphicalItem( aWorld, static_cast<DRAWSEGMENT*>( gitem ) );
-        }
-        else if( gitem->Type() == PCB_TEXT_T )
-        {
-            syncTextItem( aWorld, static_cast<TEXTE_PCB*>( gitem ), gitem->GetLayer() );
-        }
-    }
+        syncItem( aWorld, gitem );
 
     for( auto zone : m_board->Zones() )
-    {
         syncZone( aWorld, zone );
-    }
 
     for( auto module : m_board->Modules() )
-    {
-        for( auto pad : module->Pads() )
-        {
-            if( auto solid = syncPad( pad ) )
-                aWorld->Add( std::move( solid ) );
+        syncModule( aWorld, module );
 
-            worstPadClearance = std::max( worstPadClearance, pad->GetLocalClearance() );
-        }
+    for( auto t : m_board->Tracks() )
+        syncItem( aWorld, t );
 
-        syncTextItem( aWorld, &module->Reference(), module->Reference().GetLayer() );
-        syncTextItem( aWorld, &module->Value(), module->Value().GetLayer() );
+    updateRules( aWorld );
 
-        if( module->IsNetTie() )
-            continue;
+    m_world = aWorld;
+}
 
-        for( auto mgitem : module->GraphicalItems() )
-        {
-            if( mgitem->Type() == PCB_MODULE_EDGE_T )
-            {
-                syncGraphicalItem( aWorld, static_cast<DRAWSEGMENT*>( mgitem ) );
-            }
-            else if( mgitem->Type() == PCB_MODULE_TEXT_T )
-            {
-                syncTextItem( aWorld, dynamic_cast<TEXTE_MODULE*>( mgitem ), mgitem->GetLayer() );
-            }
-        }
-    }
 
-    for( auto t : m_board->Tracks() )
+bool PNS_KICAD_IFACE::UpdateWorld( PNS::NODE* aWorld )
+{
+    if( !m_board || aWorld != m_world )
+        return false;
+
+    wxLogTrace( "PNS", "Update world: %d changed items", (int) m_pendingChanges.size() );
+
+    for( auto& ent : m_pendingChanges )
     {
-        KICAD_T type = t->Type();
+        BOARD_ITEM* item = ent.first;
+        PENDING_CHANGE& change = ent.second;
 
-        if( type == PCB_TRACE_T )
+        if( change.m_inWorld )
         {
-            if( auto segment = syncTrack( t ) )
-                aWorld->Add( std::move( segment ) );
-        }
-        else if( type == PCB_VIA_T )
-        {
-            if( auto via = syncVia( static_cast<VIA*>( t ) ) )
-                aWorld->Add( std::move( via ) );
+            // a track changed in place may still be in the world with its previous net
+            if( change.m_onBoard && change.m_oldNet < 0
+                    && ( change.m_type == PCB_TRACE_T || change.m_type == PCB_VIA_T ) )
+                change.m_oldNet = static_cast<TRACK*>( item )->GetNetCode();
+
+            removeItem( aWorld, item, change );
         }
+
+        if( change.m_onBoard )
+            syncItem( aWorld, item );
     }
 
-    int worstRuleClearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
+    m_pendingChanges.clear();
 
-    delete m_ruleResolver;
-    m_ruleResolver = new PNS_PCBNEW_RULE_RESOLVER( m_board, m_router );
+    if( m_rulesDirty )
+        updateRules( aWorld );
 
-    aWorld->SetRuleResolver( m_ruleResolver );
-    aWorld->SetMaxClearance( 4 * std::max(worstPadClearance, worstRuleClearance ) );
+    return true;
 }
 
 
 void PNS_KICAD_IFACE::EraseView()
 {
+    if( !m_view )
+        return;
+
     for( auto item : m_hiddenItems )
         m_view->SetVisible( item, true );
 
@@ -1092,6 +1305,9 @@ void PNS_KICAD_IFACE::DisplayItem( const PNS::ITEM* aItem, int aColor, int aClea
 {
     wxLogTrace( "PNS", "DisplayItem %p", aItem );
 
+    if( !m_view )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( aItem, m_view );
 
     if( aColor >= 0 )
@@ -1138,7 +1354,7 @@ void PNS_KICAD_IFACE::HideItem( PNS::ITEM* aItem )
 {
     BOARD_CONNECTED_ITEM* parent = aItem->Parent();
 
-    if( parent )
+    if( parent && m_view )
     {
         if( m_view->IsVisible( parent ) )
             m_hiddenItems.insert( parent );
@@ -1153,8 +1369,9 @@ void PNS_KICAD_IFACE::RemoveItem( PNS::ITEM* aItem )
 {
     BOARD_CONNECTED_ITEM* parent = aItem->Parent();
 
-    if( parent )
+    if( parent && m_commit )
     {
+        m_committedItems.insert( parent );
         m_commit->Remove( parent );
     }
 }
@@ -1164,6 +1381,10 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
 {
     BOARD_CONNECTED_ITEM* newBI = NULL;
 
+    // Without a host tool the routed items are only committed to the world of the router
+    if( !m_commit )
+        return;
+
     switch( aItem->Kind() )
     {
     case PNS::ITEM::SEGMENT_T:
@@ -1204,6 +1425,7 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
         aItem->SetParent( newBI );
         newBI->ClearFlags();
 
+        m_committedItems.insert( newBI );
         m_commit->Add( newBI );
     }
 }
@@ -1212,7 +1434,14 @@ void PNS_KICAD_IFACE::AddItem( PNS::ITEM* aItem )
 void PNS_KICAD_IFACE::Commit()
 {
     EraseView();
+
+    if( !m_commit )
+        return;
+
+    // the router commits the same changes to its world
     m_commit->Push( _( "Added a track" ) );
+    m_committedItems.clear();
+
     m_commit.reset( new BOARD_COMMIT( m_tool ) );
 }
 
@@ -1232,8 +1461,6 @@ void PNS_KICAD_IFACE::SetView( KIGFX::VIEW* aView )
     m_previewItems->SetLayer( LAYER_SELECT_OVERLAY ) ;
     m_view->Add( m_previewItems );
 
-    delete m_debugDecorator;
-    m_debugDecorator = new PNS_PCBNEW_DEBUG_DECORATOR();
     m_debugDecorator->SetView( m_view );
 }
 
@@ -22,14 +22,16 @@
 #ifndef __PNS_KICAD_IFACE_H
 #define __PNS_KICAD_IFACE_H
 
+#include <unordered_map>
 #include <unordered_set>
 
+#include <class_board.h>
+
 #include "pns_router.h"
 
 class PNS_PCBNEW_RULE_RESOLVER;
 class PNS_PCBNEW_DEBUG_DECORATOR;
 
-class BOARD;
 class BOARD_COMMIT;
 class PCB_DISPLAY_OPTIONS;
 class PCB_TOOL_BASE;
@@ -39,7 +41,13 @@ namespace KIGFX
     class VIEW;
 }
 
-class PNS_KICAD_IFACE : public PNS::ROUTER_IFACE {
+/**
+ * Class PNS_KICAD_IFACE
+ * connects the router to a board.  It listens to the board, so the world built by
+ * SyncWorld() is kept by the router and UpdateWorld() only syncs again the items changed
+ * since then.
+ */
+class PNS_KICAD_IFACE : public PNS::ROUTER_IFACE, public BOARD_LISTENER {
 public:
     PNS_KICAD_IFACE();
     ~PNS_KICAD_IFACE();
@@ -49,8 +57,10 @@ public:
     void SetDisplayOptions( PCB_DISPLAY_OPTIONS* aDispOptions );
 
     void SetBoard( BOARD* aBoard );
+    BOARD* GetBoard() const { return m_board; }
     void SetView( KIGFX::VIEW* aView );
     void SyncWorld( PNS::NODE* aWorld ) override;
+    bool UpdateWorld( PNS::NODE* aWorld ) override;
     void EraseView() override;
     void HideItem( PNS::ITEM* aItem ) override;
     void DisplayItem( const PNS::ITEM* aItem, int aColor = 0, int aClearance = 0, bool aEdit = false ) override;
@@ -63,16 +73,40 @@ public:
     PNS::RULE_RESOLVER* GetRuleResolver() override;
     PNS::DEBUG_DECORATOR* GetDebugDecorator() override;
 
+    void OnBoardItemAdded( BOARD& aBoard, BOARD_ITEM* aBoardItem ) override;
+    void OnBoardItemRemoved( BOARD& aBoard, BOARD_ITEM* aBoardItem ) override;
+    void OnBoardItemChanged( BOARD& aBoard, BOARD_ITEM* aBoardItem ) override;
+    void OnBoardChanged( BOARD& aBoard ) override;
+    void OnBoardDeleted( BOARD& aBoard ) override;
+
 private:
+    ///> A board item changed since the world was synced
+    struct PENDING_CHANGE
+    {
+        KICAD_T m_type;         ///< type of the item, which may be deleted when removed
+        bool    m_onBoard;      ///< the item is on the board now
+        bool    m_inWorld;      ///< the world may hold items synced from it
+        int     m_oldNet;       ///< net of a removed track or via, where to look for it
+    };
+
+
     PNS_PCBNEW_RULE_RESOLVER* m_ruleResolver;
     PNS_PCBNEW_DEBUG_DECORATOR* m_debugDecorator;
 
     std::unique_ptr<PNS::SOLID> syncPad( D_PAD* aPad );
     std::unique_ptr<PNS::SEGMENT> syncTrack( TRACK* aTrack );
     std::unique_ptr<PNS::VIA> syncVia( VIA* aVia );
-    bool syncTextItem( PNS::NODE* aWorld, EDA_TEXT* aText, PCB_LAYER_ID aLayer );
-    bool syncGraphicalItem( PNS::NODE* aWorld, DRAWSEGMENT* aItem );
+    bool syncTextItem( PNS::NODE* aWorld, const BOARD_ITEM* aOwner, EDA_TEXT* aText,
+                       PCB_LAYER_ID aLayer );
+    bool syncGraphicalItem( PNS::NODE* aWorld, const BOARD_ITEM* aOwner, DRAWSEGMENT* aItem );
     bool syncZone( PNS::NODE* aWorld, ZONE_CONTAINER* aZone );
+    void syncModule( PNS::NODE* aWorld, MODULE* aModule );
+    void syncItem( PNS::NODE* aWorld, BOARD_ITEM* aItem );
+    void addSolid( PNS::NODE* aWorld, const BOARD_ITEM* aOwner,
+                   std::unique_ptr<PNS::SOLID> aSolid );
+    void removeItem( PNS::NODE* aWorld, const BOARD_ITEM* aItem, const PENDING_CHANGE& aChange );
+    void updateRules( PNS::NODE* aWorld );
+    void queueChange( BOARD_ITEM* aItem, bool aOnBoard, bool aInWorld );
 
     KIGFX::VIEW* m_view;
     KIGFX::VIEW_GROUP* m_previewItems;
@@ -83,6 +117,20 @@ private:
     PCB_TOOL_BASE* m_tool;
     std::unique_ptr<BOARD_COMMIT> m_commit;
     PCB_DISPLAY_OPTIONS* m_dispOptions;
+
+    ///> The world built by the last SyncWorld(), which UpdateWorld() can update
+    PNS::NODE* m_world;
+
+    ///> The solids of the world, by the board item they were synced from
+    std::unordered_map<const BOARD_ITEM*, std::vector<PNS::ITEM*>> m_worldSolids;
+
+    std::unordered_map<BOARD_ITEM*, PENDING_CHANGE> m_pendingChanges;
+
+    ///> Items of the commit being pushed, already in the world
+    std::unordered_set<const BOARD_ITEM*> m_committedItems;
+
+    bool m_rulesDirty;
+    int  m_worstPadClearance;
 };
 
 #endif
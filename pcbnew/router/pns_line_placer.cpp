@@ -578,7 +578,7 @@ bool LINE_PLACER::rhShoveOnly( const VECTOR2I& aP, LINE& aNewHead )
     WALKAROUND walkaround( m_currentNode, Router() );
 
     walkaround.SetSolidsOnly( true );
-    walkaround.SetIterationLimit( 10 );
+    walkaround.SetIterationLimit( Settings().WalkaroundIterationLimit() );
     walkaround.SetDebugDecorator( Dbg() );
     WALKAROUND::WALKAROUND_STATUS stat_solids = walkaround.Route( initTrack, walkSolids );
 
@@ -644,7 +644,7 @@ bool LINE_PLACER::rhShoveOnly( const VECTOR2I& aP, LINE& aNewHead )
     {
         walkaround.SetWorld( m_currentNode );
         walkaround.SetSolidsOnly( false );
-        walkaround.SetIterationLimit( 10 );
+        walkaround.SetIterationLimit( Settings().WalkaroundIterationLimit() );
         walkaround.SetApproachCursor( true, aP );
         walkaround.Route( initTrack, l2 );
         aNewHead = l2.ClipToNearestObstacle( m_shove->CurrentNode() );
@@ -26,6 +26,8 @@
 #include "pns_segment.h"
 #include "pns_solid.h"
 
+#include <fstream>
+
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_rect.h>
@@ -139,6 +141,79 @@ void LOGGER::Log( const VECTOR2I& aStart, const VECTOR2I& aEnd,
 }
 
 
+void LOGGER::LogEvent( EVENT_TYPE aType, const VECTOR2I& aP, const ITEM* aItem, int aArg )
+{
+    m_theLog << "event " << aType << " " << aP.x << " " << aP.y << " " << aArg << " ";
+
+    if( aItem )
+    {
+        m_theLog << aItem->Kind() << " " << aItem->Net() << " " << aItem->Layers().Start()
+                 << " " << aItem->Layers().End() << std::endl;
+    }
+    else
+    {
+        m_theLog << "0 0 0 0" << std::endl;
+    }
+}
+
+
+void LOGGER::LogSetting( const std::string& aName, int aValue )
+{
+    m_theLog << "setting " << aName << " " << aValue << std::endl;
+}
+
+
+bool LOGGER::LoadEvents( const std::string& aFilename, std::vector<EVENT_ENTRY>& aEvents )
+{
+    std::ifstream f( aFilename );
+
+    if( !f )
+        return false;
+
+    std::string line;
+
+    while( std::getline( f, line ) )
+    {
+        std::istringstream ss( line );
+        std::string tag;
+        EVENT_ENTRY ent;
+
+        ss >> tag;
+
+        if( tag == "event" )
+        {
+            int type;
+
+            ss >> type >> ent.p.x >> ent.p.y >> ent.arg >> ent.itemKind >> ent.itemNet
+               >> ent.itemLayerStart >> ent.itemLayerEnd;
+
+            if( !ss || type < EVT_START_ROUTE || type >= EVT_SETTING )
+                return false;
+
+            ent.type = (EVENT_TYPE) type;
+        }
+        else if( tag == "setting" )
+        {
+            ss >> ent.name >> ent.arg;
+
+            if( !ss )
+                return false;
+
+            ent.type = EVT_SETTING;
+            ent.itemKind = ent.itemNet = ent.itemLayerStart = ent.itemLayerEnd = 0;
+        }
+        else
+        {
+            continue;
+        }
+
+        aEvents.push_back( ent );
+    }
+
+    return true;
+}
+
+
 void LOGGER::dumpShape( const SHAPE* aSh )
 {
     switch( aSh->Type() )
@@ -194,15 +269,20 @@ void LOGGER::dumpShape( const SHAPE* aSh )
 }
 
 
-void LOGGER::Save( const std::string& aFilename )
+bool LOGGER::Save( const std::string& aFilename )
 {
     EndGroup();
 
     FILE* f = fopen( aFilename.c_str(), "wb" );
     wxLogTrace( "PNS", "Saving to '%s' [%p]", aFilename.c_str(), f );
+
+    if( !f )
+        return false;
+
     const std::string s = m_theLog.str();
-    fwrite( s.c_str(), 1, s.length(), f );
-    fclose( f );
+    bool ok = fwrite( s.c_str(), 1, s.length(), f ) == s.length();
+
+    return fclose( f ) == 0 && ok;
 }
 
 }
@@ -39,10 +39,36 @@ class ITEM;
 class LOGGER
 {
 public:
+    ///> Input events of the router, logged so a routing session can be replayed
+    enum EVENT_TYPE
+    {
+        EVT_START_ROUTE = 0,
+        EVT_START_DRAG,
+        EVT_MOVE,
+        EVT_FIX,
+        EVT_STOP,
+        EVT_SWITCH_LAYER,
+        EVT_TOGGLE_VIA,
+        EVT_FLIP_POSTURE,
+        EVT_SETTING
+    };
+
+    struct EVENT_ENTRY
+    {
+        EVENT_TYPE  type;
+        VECTOR2I    p;
+        int         arg;            ///< layer, drag mode, force finish flag or setting value
+        int         itemKind;       ///< ITEM::PnsKind of the item under the cursor, 0 if none
+        int         itemNet;
+        int         itemLayerStart;
+        int         itemLayerEnd;
+        std::string name;           ///< name of the setting
+    };
+
     LOGGER();
     ~LOGGER();
 
-    void Save( const std::string& aFilename );
+    bool Save( const std::string& aFilename );
     void Clear();
 
     void NewGroup( const std::string& aName, int aIter = 0 );
@@ -53,6 +79,21 @@ public:
     void Log( const VECTOR2I& aStart, const VECTOR2I& aEnd, int aKind = 0,
               const std::string& aName = std::string() );
 
+    /**
+     * Logs an input event of the router.  The item is identified by its kind, net and layers,
+     * as its address is meaningless when the log is replayed.
+     */
+    void LogEvent( EVENT_TYPE aType, const VECTOR2I& aP, const ITEM* aItem, int aArg = 0 );
+
+    ///> Logs the value of a setting, in effect for the next events
+    void LogSetting( const std::string& aName, int aValue );
+
+    /**
+     * Reads the events and settings of a log written by Save(), skipping the groups.
+     * @return false if the file can't be read or holds a malformed event
+     */
+    static bool LoadEvents( const std::string& aFilename, std::vector<EVENT_ENTRY>& aEvents );
+
 private:
     void dumpShape( const SHAPE* aSh );
 
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <cassert>
+#include <mutex>
 
 #include <math/vector2d.h>
 
@@ -43,6 +44,9 @@ namespace PNS {
 
 #ifdef DEBUG
 static std::unordered_set<NODE*> allocNodes;
+
+// snapshots are queried and freed by other threads
+static std::mutex allocNodesLock;
 #endif
 
 NODE::NODE()
@@ -54,8 +58,11 @@ NODE::NODE()
     m_maxClearance = 800000;    // fixme: depends on how thick traces are.
     m_ruleResolver = NULL;
     m_index = new INDEX;
+    m_revision = 0;
+    m_frozenRevision = -1;
 
 #ifdef DEBUG
+    std::lock_guard<std::mutex> lock( allocNodesLock );
     allocNodes.insert( this );
 #endif
 }
@@ -72,13 +79,17 @@ NODE::~NODE()
     }
 
 #ifdef DEBUG
-    if( allocNodes.find( this ) == allocNodes.end() )
     {
-        wxLogTrace( "PNS", "attempting to free an already-free'd node." );
-        assert( false );
-    }
+        std::lock_guard<std::mutex> lock( allocNodesLock );
+
+        if( allocNodes.find( this ) == allocNodes.end() )
+        {
+            wxLogTrace( "PNS", "attempting to free an already-free'd node." );
+            assert( false );
+        }
 
-    allocNodes.erase( this );
+        allocNodes.erase( this );
+    }
 #endif
 
     m_joints.clear();
@@ -139,9 +150,81 @@ NODE* NODE::Branch()
 }
 
 
-void NODE::unlinkParent()
+std::shared_ptr<const NODE> NODE::Snapshot()
 {
+    if( !m_root->m_frozenRoot || m_root->m_frozenRevision != m_root->m_revision )
+        m_root->freezeRoot();
+
     if( isRoot() )
+        return m_frozenRoot;
+
+    // A branch of the frozen root, which is not listed in its children: the frozen root
+    // is never modified, whichever thread frees the snapshot.
+    std::shared_ptr<NODE> snapshot = std::make_shared<NODE>();
+
+    snapshot->m_frozenRoot = m_root->m_frozenRoot;
+    snapshot->m_parent = snapshot->m_root = m_root->m_frozenRoot.get();
+    snapshot->m_depth = 1;
+    snapshot->m_ruleResolver = m_root->m_frozenRoot->m_ruleResolver;
+    snapshot->m_maxClearance = m_maxClearance;
+
+    for( ITEM* item : *m_index )
+    {
+        ITEM* copy = item->Clone();
+
+        copy->SetParent( item->Parent() );
+        copy->SetOwner( snapshot.get() );
+        snapshot->m_index->Add( copy );
+    }
+
+    for( ITEM* item : m_override )
+    {
+        auto frozen = m_root->m_frozenItems.find( item );
+
+        if( frozen != m_root->m_frozenItems.end() )
+            snapshot->m_override.insert( frozen->second );
+    }
+
+    return snapshot;
+}
+
+
+void NODE::freezeRoot()
+{
+    assert( isRoot() );
+
+    std::shared_ptr<NODE> frozen = std::make_shared<NODE>();
+
+    if( m_ruleResolver )
+    {
+        frozen->m_frozenRuleResolver.reset( m_ruleResolver->Clone() );
+        frozen->m_ruleResolver = frozen->m_frozenRuleResolver.get();
+    }
+
+    frozen->m_maxClearance = m_maxClearance;
+
+    m_frozenItems.clear();
+
+    for( ITEM* item : *m_index )
+    {
+        ITEM* copy = item->Clone();
+
+        copy->SetParent( item->Parent() );
+        copy->SetOwner( frozen.get() );
+        frozen->m_index->Add( copy );
+        m_frozenItems[item] = copy;
+    }
+
+    // the previous frozen root lives on as long as snapshots use it
+    m_frozenRoot = frozen;
+    m_frozenRevision = m_revision;
+}
+
+
+void NODE::unlinkParent()
+{
+    // a snapshot is not listed in the children of its frozen root
+    if( isRoot() || m_frozenRoot )
         return;
 
     m_parent->m_children.erase( this );
@@ -258,7 +341,7 @@ struct NODE::DEFAULT_OBSTACLE_VISITOR : public OBSTACLE_VISITOR
 };
 
 
-int NODE::QueryColliding( const ITEM* aItem, OBSTACLE_VISITOR& aVisitor )
+int NODE::QueryColliding( const ITEM* aItem, OBSTACLE_VISITOR& aVisitor ) const
 {
     aVisitor.SetWorld( this, NULL );
     m_index->Query( aItem, m_maxClearance, aVisitor );
@@ -275,12 +358,15 @@ int NODE::QueryColliding( const ITEM* aItem, OBSTACLE_VISITOR& aVisitor )
 
 
 int NODE::QueryColliding( const ITEM* aItem,
-        NODE::OBSTACLES& aObstacles, int aKindMask, int aLimitCount, bool aDifferentNetsOnly, int aForceClearance )
+        NODE::OBSTACLES& aObstacles, int aKindMask, int aLimitCount, bool aDifferentNetsOnly, int aForceClearance ) const
 {
     DEFAULT_OBSTACLE_VISITOR visitor( aObstacles, aItem, aKindMask, aDifferentNetsOnly );
 
 #ifdef DEBUG
-    assert( allocNodes.find( this ) != allocNodes.end() );
+    {
+        std::lock_guard<std::mutex> lock( allocNodesLock );
+        assert( allocNodes.find( const_cast<NODE*>( this ) ) != allocNodes.end() );
+    }
 #endif
 
     visitor.SetCountLimit( aLimitCount );
@@ -301,7 +387,7 @@ int NODE::QueryColliding( const ITEM* aItem,
 
 
 NODE::OPT_OBSTACLE NODE::NearestObstacle( const LINE* aItem, int aKindMask,
-                                                  const std::set<ITEM*>* aRestrictedSet )
+                                                  const std::set<ITEM*>* aRestrictedSet ) const
 {
     OBSTACLES obs_list;
     bool found_isects = false;
@@ -409,7 +495,7 @@ NODE::OPT_OBSTACLE NODE::NearestObstacle( const LINE* aItem, int aKindMask,
 }
 
 
-NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM_SET& aSet, int aKindMask )
+NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM_SET& aSet, int aKindMask ) const
 {
     for( const ITEM* item : aSet.CItems() )
     {
@@ -423,7 +509,7 @@ NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM_SET& aSet, int aKindMask )
 }
 
 
-NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM* aItemA, int aKindMask )
+NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM* aItemA, int aKindMask ) const
 {
     OBSTACLES obs;
 
@@ -459,7 +545,7 @@ NODE::OPT_OBSTACLE NODE::CheckColliding( const ITEM* aItemA, int aKindMask )
 }
 
 
-bool NODE::CheckColliding( const ITEM* aItemA, const ITEM* aItemB, int aKindMask, int aForceClearance )
+bool NODE::CheckColliding( const ITEM* aItemA, const ITEM* aItemB, int aKindMask, int aForceClearance ) const
 {
     assert( aItemB );
     int clearance;
@@ -535,6 +621,7 @@ void NODE::addSolid( SOLID* aSolid )
 {
     linkJoint( aSolid->Pos(), aSolid->Layers(), aSolid->Net(), aSolid );
     m_index->Add( aSolid );
+    m_revision++;
 }
 
 void NODE::Add( std::unique_ptr< SOLID > aSolid )
@@ -547,6 +634,7 @@ void NODE::addVia( VIA* aVia )
 {
     linkJoint( aVia->Pos(), aVia->Layers(), aVia->Net(), aVia );
     m_index->Add( aVia );
+    m_revision++;
 }
 
 void NODE::Add( std::unique_ptr< VIA > aVia )
@@ -590,6 +678,7 @@ void NODE::addSegment( SEGMENT* aSeg )
     linkJoint( aSeg->Seg().B, aSeg->Layers(), aSeg->Net(), aSeg );
 
     m_index->Add( aSeg );
+    m_revision++;
 }
 
 bool NODE::Add( std::unique_ptr< SEGMENT > aSegment, bool aAllowRedundant )
@@ -647,6 +736,8 @@ void NODE::doRemove( ITEM* aItem )
     else if( !aItem->BelongsTo( m_root ) || isRoot() )
         m_index->Remove( aItem );
 
+    m_revision++;
+
     // the item belongs to this particular branch: un-reference it
     if( aItem->BelongsTo( this ) )
     {
@@ -1331,6 +1422,9 @@ ITEM *NODE::FindItemByParent( const BOARD_CONNECTED_ITEM* aParent )
 {
     INDEX::NET_ITEMS_LIST* l_cur = m_index->GetItemsForNet( aParent->GetNetCode() );
 
+    if( !l_cur )
+        return NULL;
+
     for( ITEM*item : *l_cur )
         if( item->Parent() == aParent )
             return item;
@@ -1338,4 +1432,23 @@ ITEM *NODE::FindItemByParent( const BOARD_CONNECTED_ITEM* aParent )
     return NULL;
 }
 
+
+ITEM* NODE::FindItemByParent( const BOARD_CONNECTED_ITEM* aParent, int aNet )
+{
+    INDEX::NET_ITEMS_LIST* l_cur = m_index->GetItemsForNet( aNet );
+
+    if( l_cur )
+    {
+        for( ITEM* item : *l_cur )
+            if( item->Parent() == aParent )
+                return item;
+    }
+
+    for( ITEM* item : *m_index )
+        if( item->Parent() == aParent )
+            return item;
+
+    return NULL;
+}
+
 }
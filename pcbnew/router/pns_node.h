@@ -22,6 +22,7 @@
 #ifndef __PNS_NODE_H
 #define __PNS_NODE_H
 
+#include <memory>
 #include <vector>
 #include <list>
 #include <unordered_set>
@@ -64,6 +65,14 @@ public:
     virtual int DpNetPolarity( int aNet ) = 0;
     virtual bool DpNetPair( ITEM* aItem, int& aNetP, int& aNetN ) = 0;
     virtual wxString NetName( int aNet ) = 0;
+
+    /**
+     * Function Clone()
+     *
+     * Returns a copy of the rules, which does not change when the board does.  The
+     * Clearance() functions of the copy may be called from any thread.
+     */
+    virtual RULE_RESOLVER* Clone() const = 0;
 };
 
 /**
@@ -156,12 +165,14 @@ public:
     void SetMaxClearance( int aClearance )
     {
         m_maxClearance = aClearance;
+        m_revision++;
     }
 
     ///> Assigns a clerance resolution function object
     void SetRuleResolver( RULE_RESOLVER* aFunc )
     {
         m_ruleResolver = aFunc;
+        m_revision++;
     }
 
     RULE_RESOLVER* GetRuleResolver()
@@ -196,11 +207,11 @@ public:
                         int          aKindMask = ITEM::ANY_T,
                         int          aLimitCount = -1,
                         bool         aDifferentNetsOnly = true,
-                        int          aForceClearance = -1 );
+                        int          aForceClearance = -1 ) const;
 
     int QueryColliding( const ITEM* aItem,
                          OBSTACLE_VISITOR& aVisitor
-                      );
+                      ) const;
 
     /**
      * Function NearestObstacle()
@@ -213,7 +224,7 @@ public:
      */
     OPT_OBSTACLE NearestObstacle( const LINE*             aItem,
                                   int                     aKindMask = ITEM::ANY_T,
-                                  const std::set<ITEM*>*  aRestrictedSet = NULL );
+                                  const std::set<ITEM*>*  aRestrictedSet = NULL ) const;
 
     /**
      * Function CheckColliding()
@@ -225,7 +236,7 @@ public:
      * @return the obstacle, if found, otherwise empty.
      */
     OPT_OBSTACLE CheckColliding( const ITEM*     aItem,
-                                 int             aKindMask = ITEM::ANY_T );
+                                 int             aKindMask = ITEM::ANY_T ) const;
 
 
     /**
@@ -238,7 +249,7 @@ public:
      * @return the obstacle, if found, otherwise empty.
      */
     OPT_OBSTACLE CheckColliding( const ITEM_SET&  aSet,
-                                 int              aKindMask = ITEM::ANY_T );
+                                 int              aKindMask = ITEM::ANY_T ) const;
 
 
     /**
@@ -254,7 +265,7 @@ public:
     bool CheckColliding( const ITEM*    aItemA,
                          const ITEM*    aItemB,
                          int            aKindMask = ITEM::ANY_T,
-                         int            aForceClearance = -1 );
+                         int            aForceClearance = -1 ) const;
 
     /**
      * Function HitTest()
@@ -323,6 +334,18 @@ public:
      */
     NODE* Branch();
 
+    /**
+     * Function Snapshot()
+     *
+     * Returns a frozen copy of the items and rules of this node, which any number of threads
+     * can query for collisions (QueryColliding(), NearestObstacle(), CheckColliding() and
+     * HitTest()) while this node and its branches keep changing.  The copy of the root is
+     * shared by the snapshots taken as long as the root does not change, so the snapshot of
+     * a branch only copies the items changed in the branch.  Joints are not copied.
+     * @return the snapshot, freed by whichever thread releases it last
+     */
+    std::shared_ptr<const NODE> Snapshot();
+
     /**
      * Function AssembleLine()
      *
@@ -406,6 +429,14 @@ public:
 
     ITEM* FindItemByParent( const BOARD_CONNECTED_ITEM* aParent );
 
+    /**
+     * Function FindItemByParent()
+     *
+     * Finds the item of this node whose parent is aParent, looking first in the net aNet
+     * and then in all the nets, for an item whose parent has changed net since it was added.
+     */
+    ITEM* FindItemByParent( const BOARD_CONNECTED_ITEM* aParent, int aNet );
+
     bool HasChildren() const
     {
         return !m_children.empty();
@@ -449,6 +480,7 @@ private:
     void removeViaIndex( VIA* aVia );
 
     void doRemove( ITEM* aItem );
+    void freezeRoot();
     void unlinkParent();
     void releaseChildren();
     void releaseGarbage();
@@ -501,6 +533,18 @@ private:
     int m_depth;
 
     std::unordered_set<ITEM*> m_garbageItems;
+
+    ///> number of changes of the items and rules of this node
+    int m_revision;
+
+    ///> For the root: the frozen copy of its items made by Snapshot(), with the revision it
+    ///> was made at and the copy of each item.  For a snapshot: the frozen root it is based on.
+    std::shared_ptr<NODE> m_frozenRoot;
+    int m_frozenRevision;
+    std::unordered_map<ITEM*, ITEM*> m_frozenItems;
+
+    ///> Copy of the rules owned by a frozen root
+    std::unique_ptr<RULE_RESOLVER> m_frozenRuleResolver;
 };
 
 }
@@ -560,6 +560,9 @@ bool OPTIMIZER::Optimize( LINE* aLine, LINE* aResult )
 
     m_keepPostures = false;
 
+    if( ROUTER* router = ROUTER::GetInstance() )
+        router->Stats().m_optimizerPasses++;
+
     bool rv = false;
 
     if( m_effortLevel & MERGE_SEGMENTS )
@@ -595,6 +598,9 @@ bool OPTIMIZER::mergeStep( LINE* aLine, SHAPE_LINE_CHAIN& aCurrentPath, int step
 
     restr.Build( m_world, aLine, aCurrentPath, m_restrictArea, m_restrictAreaActive );
 
+    if( ROUTER* router = ROUTER::GetInstance() )
+        router->Stats().m_optimizerMergeSteps++;
+
     while( n < n_segs - step )
     {
         const SEG s1    = aCurrentPath.CSegment( n );
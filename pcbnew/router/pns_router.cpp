@@ -90,6 +90,15 @@ ROUTER::~ROUTER()
 
 void ROUTER::SyncWorld()
 {
+    if( m_world )
+    {
+        m_world->KillChildren();
+        m_placer.reset();
+
+        if( m_iface->UpdateWorld( m_world.get() ) )
+            return;
+    }
+
     ClearWorld();
 
     m_world = std::unique_ptr<NODE>( new NODE );
@@ -126,6 +135,8 @@ const ITEM_SET ROUTER::QueryHoverItems( const VECTOR2I& aP )
 
 bool ROUTER::StartDragging( const VECTOR2I& aP, ITEM* aStartItem, int aDragMode )
 {
+    logSettings();
+    logEvent( LOGGER::EVT_START_DRAG, aP, aStartItem, aDragMode );
 
     if( aDragMode & DM_FREE_ANGLE )
         m_forceMarkObstaclesMode = true;
@@ -175,6 +186,8 @@ bool ROUTER::isStartingPointRoutable( const VECTOR2I& aWhere, int aLayer )
 
 bool ROUTER::StartRouting( const VECTOR2I& aP, ITEM* aStartItem, int aLayer )
 {
+    logSettings();
+    logEvent( LOGGER::EVT_START_ROUTE, aP, aStartItem, aLayer );
 
     if( ! isStartingPointRoutable( aP, aLayer ) )
     {
@@ -230,6 +243,9 @@ void ROUTER::DisplayItems( const ITEM_SET& aItems )
 
 void ROUTER::Move( const VECTOR2I& aP, ITEM* endItem )
 {
+    if( RoutingInProgress() )
+        logEvent( LOGGER::EVT_MOVE, aP, endItem );
+
     m_currentEnd = aP;
 
     switch( m_state )
@@ -375,6 +391,8 @@ bool ROUTER::FixRoute( const VECTOR2I& aP, ITEM* aEndItem, bool aForceFinish )
 {
     bool rv = false;
 
+    logEvent( LOGGER::EVT_FIX, aP, aEndItem, aForceFinish ? 1 : 0 );
+
     switch( m_state )
     {
     case ROUTE_TRACK:
@@ -413,6 +431,11 @@ void ROUTER::StopRouting()
     if( !RoutingInProgress() )
         return;
 
+    logEvent( LOGGER::EVT_STOP, m_currentEnd, nullptr );
+
+    if( m_eventLog && !m_eventLog->Save( m_eventLogFile ) )
+        wxLogTrace( "PNS", "Cannot write the event log to '%s'", m_eventLogFile.c_str() );
+
     m_placer.reset();
     m_dragger.reset();
 
@@ -426,6 +449,8 @@ void ROUTER::StopRouting()
 
 void ROUTER::FlipPosture()
 {
+    logEvent( LOGGER::EVT_FLIP_POSTURE, m_currentEnd, nullptr );
+
     if( m_state == ROUTE_TRACK )
     {
         m_placer->FlipPosture();
@@ -435,6 +460,8 @@ void ROUTER::FlipPosture()
 
 void ROUTER::SwitchLayer( int aLayer )
 {
+    logEvent( LOGGER::EVT_SWITCH_LAYER, m_currentEnd, nullptr, aLayer );
+
     switch( m_state )
     {
     case ROUTE_TRACK:
@@ -448,6 +475,8 @@ void ROUTER::SwitchLayer( int aLayer )
 
 void ROUTER::ToggleViaPlacement()
 {
+    logEvent( LOGGER::EVT_TOGGLE_VIA, m_currentEnd, nullptr );
+
     if( m_state == ROUTE_TRACK )
     {
         bool toggle = !m_placer->IsPlacingVia();
@@ -496,6 +525,47 @@ void ROUTER::DumpLog()
 }
 
 
+void ROUTER::EnableEventLog( const std::string& aFilename )
+{
+    m_eventLogFile = aFilename;
+
+    if( m_eventLogFile.empty() )
+        m_eventLog.reset();
+    else if( !m_eventLog )
+        m_eventLog.reset( new LOGGER );
+}
+
+
+void ROUTER::logEvent( LOGGER::EVENT_TYPE aType, const VECTOR2I& aP, const ITEM* aItem,
+                       int aArg )
+{
+    if( m_eventLog )
+        m_eventLog->LogEvent( aType, aP, aItem, aArg );
+}
+
+
+void ROUTER::logSettings()
+{
+    if( !m_eventLog )
+        return;
+
+    m_eventLog->LogSetting( "router_mode", m_mode );
+    m_eventLog->LogSetting( "mode", m_settings.Mode() );
+    m_eventLog->LogSetting( "optimizer_effort", m_settings.OptimizerEffort() );
+    m_eventLog->LogSetting( "shove_vias", m_settings.ShoveVias() );
+    m_eventLog->LogSetting( "remove_loops", m_settings.RemoveLoops() );
+    m_eventLog->LogSetting( "smart_pads", m_settings.SmartPads() );
+    m_eventLog->LogSetting( "free_angle", m_settings.GetFreeAngleMode() );
+    m_eventLog->LogSetting( "can_violate_drc", m_settings.CanViolateDRC() );
+    m_eventLog->LogSetting( "track_width", m_sizes.TrackWidth() );
+    m_eventLog->LogSetting( "via_diameter", m_sizes.ViaDiameter() );
+    m_eventLog->LogSetting( "via_drill", m_sizes.ViaDrill() );
+    m_eventLog->LogSetting( "via_type", m_sizes.ViaType() );
+    m_eventLog->LogSetting( "diff_pair_width", m_sizes.DiffPairWidth() );
+    m_eventLog->LogSetting( "diff_pair_gap", m_sizes.DiffPairGap() );
+}
+
+
 bool ROUTER::IsPlacingVia() const
 {
     if( !m_placer )
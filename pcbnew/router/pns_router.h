@@ -22,6 +22,7 @@
 #ifndef __PNS_ROUTER_H
 #define __PNS_ROUTER_H
 
+#include <atomic>
 #include <list>
 
 #include <memory>
@@ -35,6 +36,7 @@
 #include "pns_item.h"
 #include "pns_itemset.h"
 #include "pns_node.h"
+#include "pns_logger.h"
 
 namespace KIGFX
 {
@@ -91,6 +93,14 @@ enum DRAG_MODE
 
         virtual void SetRouter( ROUTER* aRouter ) = 0;
         virtual void SyncWorld( NODE* aNode ) = 0;
+
+        /**
+         * Brings a world built by a previous SyncWorld() up to date with the changes made
+         * to the board since then.
+         * @return false if the world can't be updated and must be built again
+         */
+        virtual bool UpdateWorld( NODE* aNode ) { return false; }
+
         virtual void AddItem( ITEM* aItem ) = 0;
         virtual void RemoveItem( ITEM* aItem ) = 0;
         virtual void DisplayItem( const ITEM* aItem, int aColor = -1, int aClearance = -1, bool aEdit = false ) = 0;
@@ -105,6 +115,33 @@ enum DRAG_MODE
         virtual DEBUG_DECORATOR* GetDebugDecorator() = 0;
 };
 
+/**
+ * Struct ROUTER_STATS
+ *
+ * Counts the iterations of the routing algorithms, for profiling.  The counters are atomic
+ * as the algorithms may run on several threads.
+ */
+struct ROUTER_STATS
+{
+    ROUTER_STATS()
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        m_shoveIterations = 0;
+        m_walkaroundIterations = 0;
+        m_optimizerPasses = 0;
+        m_optimizerMergeSteps = 0;
+    }
+
+    std::atomic<int> m_shoveIterations;
+    std::atomic<int> m_walkaroundIterations;
+    std::atomic<int> m_optimizerPasses;
+    std::atomic<int> m_optimizerMergeSteps;
+};
+
 class ROUTER
 {
 private:
@@ -160,6 +197,16 @@ public:
 
     void DumpLog();
 
+    /**
+     * Logs the input events of the routing sessions and the settings they use, so they
+     * can be replayed without the editor (see the pns_replay qa tool).  The file is written
+     * again at the end of each session.
+     * @param aFilename is the file of the log, empty to stop logging
+     */
+    void EnableEventLog( const std::string& aFilename );
+
+    ROUTER_STATS& Stats() { return m_stats; }
+
     RULE_RESOLVER* GetRuleResolver() const
     {
         return m_iface->GetRuleResolver();
@@ -247,6 +294,10 @@ private:
     void markViolations( NODE* aNode, ITEM_SET& aCurrent, NODE::ITEM_VECTOR& aRemoved );
     bool isStartingPointRoutable( const VECTOR2I& aWhere, int aLayer );
 
+    void logEvent( LOGGER::EVENT_TYPE aType, const VECTOR2I& aP, const ITEM* aItem,
+                   int aArg = 0 );
+    void logSettings();
+
     VECTOR2I m_currentEnd;
     RouterState m_state;
 
@@ -271,6 +322,10 @@ private:
 
     wxString m_toolStatusbarName;
     wxString m_failureReason;
+
+    std::unique_ptr<LOGGER> m_eventLog;
+    std::string m_eventLogFile;
+    ROUTER_STATS m_stats;
 };
 
 }
@@ -39,7 +39,8 @@ ROUTING_SETTINGS::ROUTING_SETTINGS()
     m_startDiagonal = false;
     m_shoveIterationLimit = 250;
     m_shoveTimeLimit = 1000;
-    m_walkaroundIterationLimit = 40;
+    m_walkaroundIterationLimit = 50;
+    m_shoveWalkaroundIterationLimit = 50;
     m_jumpOverObstacles = false;
     m_smoothDraggedSegments = true;
     m_canViolateDRC = false;
@@ -61,6 +62,7 @@ void ROUTING_SETTINGS::Save( TOOL_SETTINGS& aSettings ) const
     aSettings.Set( "ShoveTimeLimit", m_shoveTimeLimit.Get() );
     aSettings.Set( "ShoveIterationLimit", m_shoveIterationLimit );
     aSettings.Set( "WalkaroundIterationLimit", m_walkaroundIterationLimit );
+    aSettings.Set( "ShoveWalkaroundIterationLimit", m_shoveWalkaroundIterationLimit );
     aSettings.Set( "JumpOverObstacles", m_jumpOverObstacles );
     aSettings.Set( "SmoothDraggedSegments", m_smoothDraggedSegments );
     aSettings.Set( "CanViolateDRC", m_canViolateDRC );
@@ -81,6 +83,7 @@ void ROUTING_SETTINGS::Load( const TOOL_SETTINGS& aSettings )
     m_shoveTimeLimit.Set( aSettings.Get( "ShoveTimeLimit", 1000 ) );
     m_shoveIterationLimit = aSettings.Get( "ShoveIterationLimit", 250 );
     m_walkaroundIterationLimit = aSettings.Get( "WalkaroundIterationLimit", 50 );
+    m_shoveWalkaroundIterationLimit = aSettings.Get( "ShoveWalkaroundIterationLimit", 50 );
     m_jumpOverObstacles = aSettings.Get( "JumpOverObstacles", false  );
     m_smoothDraggedSegments = aSettings.Get( "SmoothDraggedSegments", true );
     m_canViolateDRC = aSettings.Get( "CanViolateDRC", false );
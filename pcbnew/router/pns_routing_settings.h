@@ -131,6 +131,7 @@ public:
     TIME_LIMIT ShoveTimeLimit() const;
 
     int WalkaroundIterationLimit() const { return m_walkaroundIterationLimit; };
+    int ShoveWalkaroundIterationLimit() const { return m_shoveWalkaroundIterationLimit; };
     TIME_LIMIT WalkaroundTimeLimit() const;
 
     void SetInlineDragEnabled ( bool aEnable ) { m_inlineDragEnabled = aEnable; }
@@ -161,6 +162,7 @@ private:
     PNS_OPTIMIZATION_EFFORT m_optimizerEffort;
 
     int m_walkaroundIterationLimit;
+    int m_shoveWalkaroundIterationLimit;
     int m_shoveIterationLimit;
     TIME_LIMIT m_shoveTimeLimit;
     TIME_LIMIT m_walkaroundTimeLimit;
@@ -455,7 +455,7 @@ SHOVE::SHOVE_STATUS SHOVE::onCollidingSolid( LINE& aCurrent, ITEM* aObstacle )
 
     walkaround.SetSolidsOnly( false );
     walkaround.RestrictToSet( true, cluster );
-    walkaround.SetIterationLimit( 16 ); // fixme: make configurable
+    walkaround.SetIterationLimit( Settings().ShoveWalkaroundIterationLimit() );
 
     int currentRank = aCurrent.Rank();
     int nextRank;
@@ -1055,6 +1055,7 @@ SHOVE::SHOVE_STATUS SHOVE::shoveMainLoop()
         st = shoveIteration( m_iter );
 
         m_iter++;
+        Router()->Stats().m_shoveIterations++;
 
         if( st == SH_INCOMPLETE || timeLimit.Expired() || m_iter >= iterLimit )
         {
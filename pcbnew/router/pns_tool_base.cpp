@@ -37,6 +37,7 @@ using namespace std::placeholders;
 #include <dialogs/dialog_pns_diff_pair_dimensions.h>
 #include <dialogs/dialog_pns_length_tuning_settings.h>
 #include <dialogs/dialog_track_via_size.h>
+#include <advanced_config.h>
 #include <base_units.h>
 #include <bitmaps.h>
 #include <hotkeys.h>
@@ -89,6 +90,16 @@ TOOL_BASE::~TOOL_BASE()
 
 void TOOL_BASE::Reset( RESET_REASON aReason )
 {
+    // The router keeps its world from a session to the next one on the same board and
+    // brings it up to date with the changes made since, instead of building it again.
+    if( m_router && m_iface->GetBoard() == board() )
+    {
+        m_router->SyncWorld();
+        m_router->LoadSettings( m_savedSettings );
+        m_router->UpdateSizes( m_savedSizes );
+        return;
+    }
+
     delete m_gridHelper;
     delete m_iface;
     delete m_router;
@@ -101,6 +112,7 @@ void TOOL_BASE::Reset( RESET_REASON aReason )
 
     m_router = new ROUTER;
     m_router->SetInterface( m_iface );
+    m_router->EnableEventLog( ADVANCED_CFG::GetCfg().m_routerEventLog.ToStdString() );
     m_router->ClearWorld();
     m_router->SyncWorld();
     m_router->LoadSettings( m_savedSettings );
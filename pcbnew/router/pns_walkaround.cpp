@@ -19,7 +19,10 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <climits>
+
 #include <core/optional.h>
+#include <thread_pool.h>
 
 #include <geometry/shape_line_chain.h>
 
@@ -30,13 +33,6 @@
 
 namespace PNS {
 
-void WALKAROUND::start( const LINE& aInitialPath )
-{
-    m_iteration = 0;
-    m_iterationLimit = 50;
-}
-
-
 NODE::OPT_OBSTACLE WALKAROUND::nearestObstacle( const LINE& aPath )
 {
     NODE::OPT_OBSTACLE obs = m_world->NearestObstacle( &aPath, m_itemMask, m_restrictedSet.empty() ? NULL : &m_restrictedSet );
@@ -51,44 +47,43 @@ NODE::OPT_OBSTACLE WALKAROUND::nearestObstacle( const LINE& aPath )
 }
 
 
-WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
+WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( WALK_STATE& aState,
                                                               bool aWindingDirection )
 {
-    OPT<OBSTACLE>& current_obs =
-        aWindingDirection ? m_currentObstacle[0] : m_currentObstacle[1];
-
-    bool& prev_recursive = aWindingDirection ? m_recursiveCollision[0] : m_recursiveCollision[1];
+    LINE& path = aState.m_path;
+    OPT<OBSTACLE>& current_obs = aState.m_currentObstacle;
+    bool& prev_recursive = aState.m_recursiveCollision;
 
     if( !current_obs )
         return DONE;
 
     SHAPE_LINE_CHAIN path_pre[2], path_walk[2], path_post[2];
 
-    VECTOR2I last = aPath.CPoint( -1 );
+    VECTOR2I last = path.CPoint( -1 );
 
     if( ( current_obs->m_hull ).PointInside( last ) || ( current_obs->m_hull ).PointOnEdge( last ) )
     {
-        m_recursiveBlockageCount++;
+        aState.m_recursiveBlockageCount++;
 
-        if( m_recursiveBlockageCount < 3 )
-            aPath.Line().Append( current_obs->m_hull.NearestPoint( last ) );
+        if( aState.m_recursiveBlockageCount < 3 )
+            path.Line().Append( current_obs->m_hull.NearestPoint( last ) );
         else
         {
-            aPath = aPath.ClipToNearestObstacle( m_world );
+            path = path.ClipToNearestObstacle( m_world );
             return DONE;
         }
     }
 
-    if( ! aPath.Walkaround( current_obs->m_hull, path_pre[0], path_walk[0],
+    if( ! path.Walkaround( current_obs->m_hull, path_pre[0], path_walk[0],
                       path_post[0], aWindingDirection ) )
         return STUCK;
 
-    if( ! aPath.Walkaround( current_obs->m_hull, path_pre[1], path_walk[1],
+    if( ! path.Walkaround( current_obs->m_hull, path_pre[1], path_walk[1],
                       path_post[1], !aWindingDirection ) )
         return STUCK;
 
 #ifdef DEBUG
-    m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", m_iteration );
+    m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", aState.m_iteration );
     m_logger.Log( &path_walk[0], 0, "path-walk" );
     m_logger.Log( &path_pre[0], 1, "path-pre" );
     m_logger.Log( &path_post[0], 4, "path-post" );
@@ -99,7 +94,7 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
     int len_pre = path_walk[0].Length();
     int len_alt = path_walk[1].Length();
 
-    LINE walk_path( aPath, path_walk[1] );
+    LINE walk_path( path, path_walk[1] );
 
     bool alt_collides = static_cast<bool>( m_world->CheckColliding( &walk_path, m_itemMask ) );
 
@@ -112,9 +107,9 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
         pnew.Append( path_post[1] );
 
         if( !path_post[1].PointCount() || !path_walk[1].PointCount() )
-            current_obs = nearestObstacle( LINE( aPath, path_pre[1] ) );
+            current_obs = nearestObstacle( LINE( path, path_pre[1] ) );
         else
-            current_obs = nearestObstacle( LINE( aPath, path_post[1] ) );
+            current_obs = nearestObstacle( LINE( path, path_post[1] ) );
         prev_recursive = false;
     }
     else
@@ -124,32 +119,87 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::singleStep( LINE& aPath,
         pnew.Append( path_post[0] );
 
         if( !path_post[0].PointCount() || !path_walk[0].PointCount() )
-            current_obs = nearestObstacle( LINE( aPath, path_pre[0] ) );
+            current_obs = nearestObstacle( LINE( path, path_pre[0] ) );
         else
-            current_obs = nearestObstacle( LINE( aPath, path_walk[0] ) );
+            current_obs = nearestObstacle( LINE( path, path_walk[0] ) );
 
         if( !current_obs )
         {
             prev_recursive = false;
-            current_obs = nearestObstacle( LINE( aPath, path_post[0] ) );
+            current_obs = nearestObstacle( LINE( path, path_post[0] ) );
         }
         else
             prev_recursive = true;
     }
 
     pnew.Simplify();
-    aPath.SetShape( pnew );
+    path.SetShape( pnew );
 
     return IN_PROGRESS;
 }
 
 
+bool WALKAROUND::advance( WALK_STATE& aState, bool aWindingDirection,
+                          std::atomic<int>& aDoneIteration )
+{
+    if( aState.m_status != IN_PROGRESS || aState.m_iteration >= m_iterationLimit )
+        return false;
+
+    // the other direction got around the obstacles in less steps, this one has lost
+    if( aState.m_iteration > aDoneIteration )
+        return false;
+
+    Router()->Stats().m_walkaroundIterations++;
+
+    aState.m_status = singleStep( aState, aWindingDirection );
+
+    if( aState.m_status == IN_PROGRESS )
+    {
+        aState.m_iteration++;
+        return true;
+    }
+
+    if( aState.m_status == DONE && !m_forceLongerPath )
+    {
+        int done = aDoneIteration;
+
+        while( aState.m_iteration < done
+                && !aDoneIteration.compare_exchange_weak( done, aState.m_iteration ) )
+        {
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Chooses between the paths walked around the same obstacles in both directions: the one
+ * with less corners, unless it is much longer, else the shortest one.
+ */
+static LINE& betterPath( LINE& aCw, LINE& aCcw )
+{
+    // how much longer a path with less corners may be
+    const double lengthTolerance = 1.1;
+
+    COST_ESTIMATOR cost_cw, cost_ccw;
+
+    cost_cw.Add( aCw );
+    cost_ccw.Add( aCcw );
+
+    if( cost_cw.IsBetter( cost_ccw, lengthTolerance, 1.0 ) )
+        return aCcw;
+    else if( cost_ccw.IsBetter( cost_cw, lengthTolerance, 1.0 ) )
+        return aCw;
+
+    return aCw.CLine().Length() < aCcw.CLine().Length() ? aCw : aCcw;
+}
+
+
 WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
         LINE& aWalkPath, bool aOptimize )
 {
-    LINE path_cw( aInitialPath ), path_ccw( aInitialPath );
-    WALKAROUND_STATUS s_cw = IN_PROGRESS, s_ccw = IN_PROGRESS;
-    SHAPE_LINE_CHAIN best_path;
+    WALK_STATE cw( aInitialPath ), ccw( aInitialPath );
 
     // special case for via-in-the-middle-of-track placement
     if( aInitialPath.PointCount() <= 1 )
@@ -161,65 +211,83 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
         return DONE;
     }
 
-    start( aInitialPath );
-
-    m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    cw.m_currentObstacle = ccw.m_currentObstacle = nearestObstacle( aInitialPath );
 
     aWalkPath = aInitialPath;
 
     if( m_forceWinding )
     {
-        s_cw = m_forceCw ? IN_PROGRESS : STUCK;
-        s_ccw = m_forceCw ? STUCK : IN_PROGRESS;
+        cw.m_status = m_forceCw ? IN_PROGRESS : STUCK;
+        ccw.m_status = m_forceCw ? STUCK : IN_PROGRESS;
         m_forceSingleDirection = true;
     } else {
         m_forceSingleDirection = false;
     }
 
-    while( m_iteration < m_iterationLimit )
-    {
-        if( s_cw != STUCK )
-            s_cw = singleStep( path_cw, true );
+    // Lowest step count at which a direction got around all the obstacles.  Once a path is
+    // found, the other direction has only as many steps to find a path too.
+    std::atomic<int> doneIteration( INT_MAX );
 
-        if( s_ccw != STUCK )
-            s_ccw = singleStep( path_ccw, false );
+    bool parallel = cw.m_status == IN_PROGRESS && ccw.m_status == IN_PROGRESS
+                    && THREAD_POOL::GetInstance().GetThreadCount() > 1;
 
-        if( ( s_cw == DONE && s_ccw == DONE ) || ( s_cw == STUCK && s_ccw == STUCK ) )
-        {
-            int len_cw  = path_cw.CLine().Length();
-            int len_ccw = path_ccw.CLine().Length();
+#ifdef DEBUG
+    // both directions write to the same log
+    parallel = false;
+#endif
 
-            if( m_forceLongerPath )
-                aWalkPath = ( len_cw > len_ccw ? path_cw : path_ccw );
-            else
-                aWalkPath = ( len_cw < len_ccw ? path_cw : path_ccw );
+    if( parallel )
+    {
+        // Both directions only query m_world, which is not modified while they run.
+        TASK_GROUP tasks;
 
-            break;
-        }
-        else if( s_cw == DONE && !m_forceLongerPath )
+        tasks.Run( [&]()
+                {
+                    while( advance( cw, true, doneIteration ) )
+                    {
+                    }
+                } );
+
+        while( advance( ccw, false, doneIteration ) )
         {
-            aWalkPath = path_cw;
-            break;
         }
-        else if( s_ccw == DONE && !m_forceLongerPath )
+
+        tasks.Wait();
+    }
+    else
+    {
+        bool cw_active = true, ccw_active = true;
+
+        while( cw_active || ccw_active )
         {
-            aWalkPath = path_ccw;
-            break;
-        }
+            if( cw_active )
+                cw_active = advance( cw, true, doneIteration );
 
-        m_iteration++;
+            if( ccw_active )
+                ccw_active = advance( ccw, false, doneIteration );
+        }
     }
 
-    if( m_iteration == m_iterationLimit )
+    // Unless the longest path is wanted, the direction done in less steps wins whatever
+    // the other one did meanwhile, so the result does not depend on the thread scheduling.
+    if( m_forceLongerPath )
     {
-        int len_cw  = path_cw.CLine().Length();
-        int len_ccw = path_ccw.CLine().Length();
+        int len_cw  = cw.m_path.CLine().Length();
+        int len_ccw = ccw.m_path.CLine().Length();
 
-        if( m_forceLongerPath )
-            aWalkPath = ( len_cw > len_ccw ? path_cw : path_ccw );
-        else
-            aWalkPath = ( len_cw < len_ccw ? path_cw : path_ccw );
+        aWalkPath = ( len_cw > len_ccw ? cw.m_path : ccw.m_path );
+    }
+    else if( cw.m_status == DONE && ( ccw.m_status != DONE || cw.m_iteration < ccw.m_iteration ) )
+    {
+        aWalkPath = cw.m_path;
+    }
+    else if( ccw.m_status == DONE && ( cw.m_status != DONE || ccw.m_iteration < cw.m_iteration ) )
+    {
+        aWalkPath = ccw.m_path;
+    }
+    else
+    {
+        aWalkPath = betterPath( cw.m_path, ccw.m_path );
     }
 
     if( m_cursorApproachMode )
@@ -265,7 +333,7 @@ WALKAROUND::WALKAROUND_STATUS WALKAROUND::Route( const LINE& aInitialPath,
     if( aWalkPath.CPoint( 0 ) != aInitialPath.CPoint( 0 ) )
         return STUCK;
 
-    WALKAROUND_STATUS st = s_ccw == DONE || s_cw == DONE ? DONE : STUCK;
+    WALKAROUND_STATUS st = ccw.m_status == DONE || cw.m_status == DONE ? DONE : STUCK;
 
     if( st == DONE )
     {
@@ -22,6 +22,7 @@
 #ifndef __PNS_WALKAROUND_H
 #define __PNS_WALKAROUND_H
 
+#include <atomic>
 #include <set>
 
 #include "pns_line.h"
@@ -49,9 +50,6 @@ public:
         m_itemMask = ITEM::ANY_T;
 
         // Initialize other members, to avoid uninitialized variables.
-        m_recursiveBlockageCount = 0;
-        m_recursiveCollision[0] = m_recursiveCollision[1] = false;
-        m_iteration = 0;
         m_forceCw = false;
     }
 
@@ -118,6 +116,13 @@ public:
             m_restrictedSet.clear();
     }
 
+    /**
+     * Function Route()
+     *
+     * Walks aInitialPath around the obstacles clockwise and counterclockwise and returns
+     * the better of both paths in aWalkPath.  The two directions are independent and run
+     * on two threads of the pool when there are several.
+     */
     WALKAROUND_STATUS Route( const LINE& aInitialPath, LINE& aWalkPath,
             bool aOptimize = true );
 
@@ -127,15 +132,32 @@ public:
     }
 
 private:
-    void start( const LINE& aInitialPath );
+    ///> The path walked around the obstacles in one winding direction
+    struct WALK_STATE
+    {
+        WALK_STATE( const LINE& aInitialPath ) :
+            m_path( aInitialPath ),
+            m_status( IN_PROGRESS ),
+            m_recursiveCollision( false ),
+            m_recursiveBlockageCount( 0 ),
+            m_iteration( 0 )
+        {}
+
+        LINE m_path;
+        WALKAROUND_STATUS m_status;
+        NODE::OPT_OBSTACLE m_currentObstacle;
+        bool m_recursiveCollision;
+        int m_recursiveBlockageCount;
+        int m_iteration;
+    };
 
-    WALKAROUND_STATUS singleStep( LINE& aPath, bool aWindingDirection );
+    ///> Walks one more step in a direction, returns false when it is finished
+    bool advance( WALK_STATE& aState, bool aWindingDirection, std::atomic<int>& aDoneIteration );
+    WALKAROUND_STATUS singleStep( WALK_STATE& aState, bool aWindingDirection );
     NODE::OPT_OBSTACLE nearestObstacle( const LINE& aPath );
 
     NODE* m_world;
 
-    int m_recursiveBlockageCount;
-    int m_iteration;
     int m_iterationLimit;
     int m_itemMask;
     bool m_forceSingleDirection, m_forceLongerPath;
@@ -143,8 +165,6 @@ private:
     bool m_forceWinding;
     bool m_forceCw;
     VECTOR2I m_cursorPos;
-    NODE::OPT_OBSTACLE m_currentObstacle[2];
-    bool m_recursiveCollision[2];
     LOGGER m_logger;
     std::set<ITEM*> m_restrictedSet;
 };
@@ -966,12 +966,9 @@ int ROUTER_TOOL::mainLoop( PNS::ROUTER_MODE aMode )
         {
             break; // Finish
         }
-        else if( evt->Action() == TA_UNDO_REDO_PRE )
-        {
-            m_router->ClearWorld();
-        }
         else if( evt->Action() == TA_UNDO_REDO_POST || evt->Action() == TA_MODEL_CHANGE )
         {
+            // the undo notifies the board items it changes: the world is updated afterwards
             m_router->SyncWorld();
         }
         else if( evt->IsMotion() )
@@ -52,6 +52,7 @@ using namespace std::placeholders;
 #include <tools/pcb_editor_control.h>
 #include <view/view.h>
 #include <ws_proxy_undo_item.h>
+#include <zone_filler.h>
 
 /* Functions to undo and redo edit commands.
  *  commands to undo are stored in CurrentScreen->m_UndoList
@@ -204,6 +205,49 @@ void PCB_BASE_EDIT_FRAME::SaveCopyInUndoList( const PICKED_ITEMS_LIST& aItemsLis
 {
     static KICAD_T moduleChildren[] = { PCB_MODULE_TEXT_T, PCB_MODULE_EDGE_T, PCB_PAD_T, EOT };
 
+    // The items are about to be modified in place, outside a BOARD_COMMIT: the zones
+    // filled over their new state must be checked again, and the board listeners (e.g.
+    // the router world) must read them again
+    for( unsigned ii = 0; ii < aItemsList.GetCount(); ii++ )
+    {
+        UNDO_REDO_T command = aItemsList.GetPickedItemStatus( ii );
+
+        if( command == UR_UNSPECIFIED )
+            command = aTypeCommand;
+
+        if( command == UR_DRILLORIGIN || command == UR_GRIDORIGIN
+                || command == UR_PAGESETTINGS )
+            continue;
+
+        auto item = dynamic_cast<BOARD_ITEM*>( aItemsList.GetPickedItem( ii ) );
+
+        if( !item )
+            continue;
+
+        if( IsType( FRAME_PCB ) )
+            ZONE_FILLER::InvalidateZonesForUncommittedChange( GetBoard(), item );
+
+        // BOARD::Add() and BOARD::Remove() notify the new and deleted items
+        if( command == UR_NEW || command == UR_DELETED )
+            continue;
+
+        // The listeners know the footprints, not their pads and texts
+        if( item->IsType( moduleChildren ) && item->GetParent() )
+            item = item->GetParent();
+
+        GetBoard()->OnItemChanged( item );
+    }
+
+    SaveCommittedCopyInUndoList( aItemsList, aTypeCommand, aTransformPoint );
+}
+
+
+void PCB_BASE_EDIT_FRAME::SaveCommittedCopyInUndoList( const PICKED_ITEMS_LIST& aItemsList,
+                                                       UNDO_REDO_T aTypeCommand,
+                                                       const wxPoint& aTransformPoint )
+{
+    static KICAD_T moduleChildren[] = { PCB_MODULE_TEXT_T, PCB_MODULE_EDGE_T, PCB_PAD_T, EOT };
+
     PICKED_ITEMS_LIST* commandToUndo = new PICKED_ITEMS_LIST();
 
     commandToUndo->m_TransformPoint = aTransformPoint;
@@ -472,6 +516,15 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             break;
         }
 
+        // Zones filled over the item, before and after the change, must be refilled
+        bool invalidateZones = IsType( FRAME_PCB )
+                               && status != UR_DRILLORIGIN
+                               && status != UR_GRIDORIGIN
+                               && status != UR_PAGESETTINGS;
+
+        if( invalidateZones )
+            ZONE_FILLER::InvalidateDependentZones( GetBoard(), (BOARD_ITEM*) eda_item );
+
         switch( aList->GetPickedItemStatus( ii ) )
         {
         case UR_CHANGED:    /* Exchange old and new data for each item */
@@ -488,6 +541,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
 
             view->Add( eda_item );
             connectivity->Add( item );
+            GetBoard()->OnItemChanged( item );
         }
         break;
 
@@ -510,6 +564,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             item->Move( aRedoCommand ? aList->m_TransformPoint : -aList->m_TransformPoint );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+            GetBoard()->OnItemChanged( item );
         }
             break;
 
@@ -520,6 +575,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
                           aRedoCommand ? m_rotationAngle : -m_rotationAngle );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+            GetBoard()->OnItemChanged( item );
         }
             break;
 
@@ -530,6 +586,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
                           aRedoCommand ? -m_rotationAngle : m_rotationAngle );
             view->Update( item, KIGFX::GEOMETRY );
             connectivity->Update( item );
+            GetBoard()->OnItemChanged( item );
         }
             break;
 
@@ -539,6 +596,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
             item->Flip( aList->m_TransformPoint );
             view->Update( item, KIGFX::LAYERS );
             connectivity->Update( item );
+            GetBoard()->OnItemChanged( item );
         }
             break;
 
@@ -573,6 +631,9 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
                         aList->GetPickedItemStatus( ii ) );
             break;
         }
+
+        if( invalidateZones )
+            ZONE_FILLER::InvalidateDependentZones( GetBoard(), (BOARD_ITEM*) eda_item );
     }
 
     if( not_found )
@@ -24,10 +24,8 @@
  */
 
 #include <cstdint>
-#include <thread>
 #include <mutex>
 #include <algorithm>
-#include <future>
 
 #include <class_board.h>
 #include <class_zone.h>
@@ -42,6 +40,7 @@
 #include <board_commit.h>
 
 #include <widgets/progress_reporter.h>
+#include <thread_pool.h>
 
 #include <geometry/shape_poly_set.h>
 #include <geometry/shape_file_io.h>
@@ -81,6 +80,16 @@ extern void CreateThermalReliefPadPolygon( SHAPE_POLY_SET& aCornerBuffer, const
 static double s_thermalRot = 450;   // angle of stubs in thermal reliefs for round pads
 static const bool s_DumpZonesWhenFilling = false;
 
+// Large zones are filled in square tiles of this size.  The tiles depend only on the zone,
+// so the fill is the same whatever the number of threads.  Zones smaller than a tile (in
+// both directions) are filled in one piece: the cost of the extra clipping and of the final
+// union would exceed the gain.
+static const double s_zoneTileSizeMM = 20.0;
+
+// Filled areas differing by less than this width are the same for the out-of-date check.
+// The tiled and the serial fills of a zone differ by less than 1nm along the tile borders.
+static const double s_fillCheckToleranceMM = 0.001;
+
 
 ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
     m_board( aBoard ), m_commit( aCommit ), m_progressReporter( nullptr )
@@ -99,9 +108,33 @@ void ZONE_FILLER::SetProgressReporter( WX_PROGRESS_REPORTER* aReporter )
 }
 
 
+bool ZONE_FILLER::SameFilledAreas( const SHAPE_POLY_SET& aPrevious,
+                                   const SHAPE_POLY_SET& aNew )
+{
+    if( aPrevious.GetHash() == aNew.GetHash() )
+        return true;
+
+    // The polygons can differ without the areas differing: the fill of a large zone is
+    // built from tiles, so its vertices and its fracture lines are not the ones a serial
+    // fill (e.g. the fill read from a file saved by an older version) gives.  Compare the
+    // areas: what is left of their differences once the slivers are removed.
+    SHAPE_POLY_SET diff;
+    SHAPE_POLY_SET added;
+
+    diff.BooleanSubtract( aPrevious, aNew, SHAPE_POLY_SET::PM_FAST );
+    added.BooleanSubtract( aNew, aPrevious, SHAPE_POLY_SET::PM_FAST );
+    diff.Append( added );
+
+    diff.Inflate( -Millimeter2iu( s_fillCheckToleranceMM ) / 2, 6 );
+
+    return diff.IsEmpty();
+}
+
+
 bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck )
 {
     std::vector<CN_ZONE_ISOLATED_ISLAND_LIST> toFill;
+    std::vector<SHAPE_POLY_SET>               previousFills;
     auto connectivity = m_board->GetConnectivity();
 
     std::unique_lock<std::mutex> lock( connectivity->GetLock(), std::try_to_lock );
@@ -124,9 +157,10 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         if( m_commit )
             m_commit->Modify( zone );
 
-        // calculate the hash value for filled areas. it will be used later
-        // to know if the current filled areas are up to date
-        zone->BuildHashValue();
+        // keep the filled areas: they will be used later to know if the
+        // current filled areas are up to date
+        if( aCheck )
+            previousFills.push_back( zone->GetFilledPolysList() );
 
         // Add the zone to the list of zones to test or refill
         toFill.emplace_back( CN_ZONE_ISOLATED_ISLAND_LIST(zone) );
@@ -136,53 +170,29 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         zone->UnFill();
     }
 
-    std::atomic<size_t> nextItem( 0 );
-    size_t              parallelThreadCount =
-            std::min<size_t>( std::thread::hardware_concurrency(), aZones.size() );
-    std::vector<std::future<size_t>> returns( parallelThreadCount );
+    TASK_GROUP fillTasks;
 
-    auto fill_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
+    fillTasks.ParallelFor( toFill.size(), [&] ( size_t i )
     {
-        size_t num = 0;
+        ZONE_CONTAINER* zone = toFill[i].m_zone;
+        SHAPE_POLY_SET rawPolys, finalPolys;
+        fillSingleZone( zone, rawPolys, finalPolys );
 
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            ZONE_CONTAINER* zone = toFill[i].m_zone;
-            SHAPE_POLY_SET rawPolys, finalPolys;
-            fillSingleZone( zone, rawPolys, finalPolys );
-
-            zone->SetRawPolysList( rawPolys );
-            zone->SetFilledPolysList( finalPolys );
-            zone->SetIsFilled( true );
-
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
-
-            num++;
-        }
+        zone->SetRawPolysList( rawPolys );
+        zone->SetFilledPolysList( finalPolys );
+        zone->SetFillDependencyArea( fillDependencyArea( zone ) );
+        zone->SetIsFilled( true );
 
-        return num;
-    };
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
+    } );
 
-    if( parallelThreadCount <= 1 )
-        fill_lambda( m_progressReporter );
-    else
+    if( !fillTasks.Wait( m_progressReporter ) )
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, fill_lambda, m_progressReporter );
-
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
+        if( m_commit )
+            m_commit->Revert();
 
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
+        return false;
     }
 
     // Now update the connectivity to check for copper islands
@@ -201,8 +211,10 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     SHAPE_POLY_SET boardOutline;
     bool clip_to_brd_outlines = m_board->GetBoardPolygonOutlines( boardOutline );
 
-    for( auto& zone : toFill )
+    for( size_t ii = 0; ii < toFill.size(); ii++ )
     {
+        CN_ZONE_ISOLATED_ISLAND_LIST& zone = toFill[ii];
+
         std::sort( zone.m_islands.begin(), zone.m_islands.end(), std::greater<int>() );
         SHAPE_POLY_SET poly = zone.m_zone->GetFilledPolysList();
 
@@ -239,7 +251,7 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
 
         zone.m_zone->SetFilledPolysList( poly );
 
-        if( aCheck && zone.m_zone->GetHashValue() != poly.GetHash() )
+        if( aCheck && !SameFilledAreas( previousFills[ii], poly ) )
             outOfDate = true;
     }
 
@@ -270,44 +282,18 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
     }
 
 
-    nextItem = 0;
-
-    auto tri_lambda = [&] ( PROGRESS_REPORTER* aReporter ) -> size_t
-    {
-        size_t num = 0;
-
-        for( size_t i = nextItem++; i < toFill.size(); i = nextItem++ )
-        {
-            toFill[i].m_zone->CacheTriangulation();
-            num++;
-
-            if( m_progressReporter )
-                m_progressReporter->AdvanceProgress();
-        }
-
-        return num;
-    };
+    TASK_GROUP triangulationTasks;
 
-    if( parallelThreadCount <= 1 )
-        tri_lambda( m_progressReporter );
-    else
+    triangulationTasks.ParallelFor( toFill.size(), [&] ( size_t i )
     {
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-            returns[ii] = std::async( std::launch::async, tri_lambda, m_progressReporter );
+        toFill[i].m_zone->CacheTriangulation();
 
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
-        {
-            // Here we balance returns with a 100ms timeout to allow UI updating
-            std::future_status status;
-            do
-            {
-                if( m_progressReporter )
-                    m_progressReporter->KeepRefreshing();
+        if( m_progressReporter )
+            m_progressReporter->AdvanceProgress();
+    } );
 
-                status = returns[ii].wait_for( std::chrono::milliseconds( 100 ) );
-            } while( status != std::future_status::ready );
-        }
-    }
+    // The fills are done at this point, so there is nothing left to cancel
+    triangulationTasks.Wait( m_progressReporter, false );
 
     if( m_progressReporter )
     {
@@ -334,7 +320,163 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
 }
 
 
-void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
+bool ZONE_FILLER::FillModified( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck )
+{
+    std::vector<ZONE_CONTAINER*> toFill;
+
+    for( auto zone : aZones )
+    {
+        if( zone->GetIsKeepout() )
+            continue;
+
+        if( zone->NeedRefill() || !zone->IsFilled() || zone->GetFillDependencyArea().GetArea() == 0 )
+            toFill.push_back( zone );
+    }
+
+    if( toFill.empty() )
+        return true;
+
+    return Fill( toFill, aCheck );
+}
+
+
+/**
+ * @return the layers on which aItem can modify a zone fill.  Board outlines clip zones on
+ * all layers, and footprints hold pads and graphics on any layer.
+ */
+static LSET fillAffectingLayers( const BOARD_ITEM* aItem )
+{
+    if( aItem->Type() == PCB_MODULE_T || aItem->IsOnLayer( Edge_Cuts ) )
+        return LSET::AllLayersMask();
+
+    return aItem->GetLayerSet();
+}
+
+
+/**
+ * @return the area in which aItem can modify a zone fill: its bounding box inflated by
+ * its clearance.
+ */
+static EDA_RECT fillAffectingArea( const BOARD_ITEM* aItem )
+{
+    EDA_RECT area = aItem->GetBoundingBox();
+    int      clearance = 0;
+
+    if( aItem->Type() == PCB_MODULE_T )
+    {
+        const MODULE* module = static_cast<const MODULE*>( aItem );
+
+        for( const D_PAD* pad = module->PadsList(); pad; pad = pad->Next() )
+            clearance = std::max( clearance, pad->GetClearance() );
+    }
+    else if( aItem->IsConnected() )
+    {
+        clearance = static_cast<const BOARD_CONNECTED_ITEM*>( aItem )->GetClearance();
+    }
+
+    area.Inflate( clearance );
+    return area;
+}
+
+
+/**
+ * @return true if aZone and aOther remove the same areas from lower priority zones, i.e.
+ * they differ at most by their filled areas.
+ */
+static bool sameFillObstacle( const ZONE_CONTAINER* aZone, const ZONE_CONTAINER* aOther )
+{
+    return aZone->GetLayerSet() == aOther->GetLayerSet()
+        && aZone->GetNetCode() == aOther->GetNetCode()
+        && aZone->GetPriority() == aOther->GetPriority()
+        && aZone->GetIsKeepout() == aOther->GetIsKeepout()
+        && aZone->GetDoNotAllowCopperPour() == aOther->GetDoNotAllowCopperPour()
+        && aZone->GetZoneClearance() == aOther->GetZoneClearance()
+        && aZone->GetMinThickness() == aOther->GetMinThickness()
+        && aZone->Outline()->GetHash() == aOther->Outline()->GetHash();
+}
+
+
+void ZONE_FILLER::InvalidateDependentZones( BOARD* aBoard, const BOARD_ITEM* aItem,
+        const BOARD_ITEM* aOldItem )
+{
+    // Markers and nets have no shape on the board
+    if( aItem->Type() == PCB_MARKER_T || aItem->Type() == PCB_NETINFO_T )
+        return;
+
+    if( aItem->Type() == PCB_ZONE_AREA_T )
+    {
+        auto zone = static_cast<const ZONE_CONTAINER*>( aItem );
+
+        // Refilling a zone modifies it, but not the other zones
+        if( aOldItem && sameFillObstacle( zone, static_cast<const ZONE_CONTAINER*>( aOldItem ) ) )
+            return;
+
+        const_cast<ZONE_CONTAINER*>( zone )->SetNeedRefill( true );
+    }
+
+    std::vector<std::pair<EDA_RECT, LSET>> changedAreas;
+
+    changedAreas.emplace_back( fillAffectingArea( aItem ), fillAffectingLayers( aItem ) );
+
+    if( aOldItem )
+        changedAreas.emplace_back( fillAffectingArea( aOldItem ), fillAffectingLayers( aOldItem ) );
+
+    for( auto zone : aBoard->Zones() )
+    {
+        if( zone == aItem || zone->GetIsKeepout() || zone->NeedRefill() )
+            continue;
+
+        const EDA_RECT& dependencyArea = zone->GetFillDependencyArea();
+
+        for( const auto& changed : changedAreas )
+        {
+            if( ( zone->GetLayerSet() & changed.second ).any()
+                    && dependencyArea.Intersects( changed.first ) )
+            {
+                zone->SetNeedRefill( true );
+                break;
+            }
+        }
+    }
+}
+
+
+void ZONE_FILLER::InvalidateZonesForUncommittedChange( BOARD* aBoard, const BOARD_ITEM* aItem )
+{
+    if( aItem->Type() == PCB_MARKER_T || aItem->Type() == PCB_NETINFO_T )
+        return;
+
+    LSET layers = fillAffectingLayers( aItem );
+
+    layers |= FlipLayerMask( layers );
+
+    for( auto zone : aBoard->Zones() )
+    {
+        if( zone == aItem || ( zone->GetLayerSet() & layers ).any() )
+            zone->SetNeedRefill( true );
+    }
+}
+
+
+int ZONE_FILLER::fillDependencyMargin( const ZONE_CONTAINER* aZone ) const
+{
+    int zone_clearance = aZone->GetClearance() + aZone->GetMinThickness() / 2;
+    int biggest_clearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
+
+    return std::max( biggest_clearance, zone_clearance );
+}
+
+
+EDA_RECT ZONE_FILLER::fillDependencyArea( const ZONE_CONTAINER* aZone ) const
+{
+    EDA_RECT area = aZone->GetBoundingBox();
+    area.Inflate( fillDependencyMargin( aZone ) );
+
+    return area;
+}
+
+
+void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone, const EDA_RECT& aArea,
         SHAPE_POLY_SET& aFeatures ) const
 {
     aFeatures.RemoveAllContours();
@@ -357,10 +499,7 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
      * the bounding box is the zone bounding box + the biggest clearance found in Netclass list
      */
     EDA_RECT    item_boundingbox;
-    EDA_RECT    zone_boundingbox = aZone->GetBoundingBox();
-    int biggest_clearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
-    biggest_clearance = std::max( biggest_clearance, zone_clearance );
-    zone_boundingbox.Inflate( biggest_clearance );
+    EDA_RECT    zone_boundingbox = aArea;
 
     /*
      * First : Add pads. Note: pads having the same net as zone are left in zone.
@@ -729,26 +868,37 @@ void ZONE_FILLER::computeRawFilledAreas( const ZONE_CONTAINER* aZone,
     solidAreas.Inflate( -outline_half_thickness, numSegs );
     solidAreas.Simplify( SHAPE_POLY_SET::PM_FAST );
 
-    SHAPE_POLY_SET holes;
-
     if( s_DumpZonesWhenFilling )
         dumper->Write( &solidAreas, "solid-areas" );
 
-    buildZoneFeatureHoleList( aZone, holes );
+    BOX2I zoneBBox = solidAreas.BBox();
+    int   tileSize = Millimeter2iu( s_zoneTileSizeMM );
 
-    if( s_DumpZonesWhenFilling )
-        dumper->Write( &holes, "feature-holes" );
+    if( !s_DumpZonesWhenFilling
+            && ( zoneBBox.GetWidth() > tileSize || zoneBBox.GetHeight() > tileSize ) )
+    {
+        subtractTiledFeatureHoles( aZone, solidAreas );
+    }
+    else
+    {
+        SHAPE_POLY_SET holes;
 
-    holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+        buildZoneFeatureHoleList( aZone, fillDependencyArea( aZone ), holes );
 
-    if( s_DumpZonesWhenFilling )
-        dumper->Write( &holes, "feature-holes-postsimplify" );
+        if( s_DumpZonesWhenFilling )
+            dumper->Write( &holes, "feature-holes" );
 
-    // Generate the filled areas (currently, without thermal shapes, which will
-    // be created later).
-    // Use SHAPE_POLY_SET::PM_STRICTLY_SIMPLE to generate strictly simple polygons
-    // needed by Gerber files and Fracture()
-    solidAreas.BooleanSubtract( holes, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+        holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+        if( s_DumpZonesWhenFilling )
+            dumper->Write( &holes, "feature-holes-postsimplify" );
+
+        // Generate the filled areas (currently, without thermal shapes, which will
+        // be created later).
+        // Use SHAPE_POLY_SET::PM_STRICTLY_SIMPLE to generate strictly simple polygons
+        // needed by Gerber files and Fracture()
+        solidAreas.BooleanSubtract( holes, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    }
 
     // Now remove the non filled areas due to the hatch pattern
     if( aZone->GetFillMode() == ZFM_HATCH_PATTERN )
@@ -827,6 +977,69 @@ void ZONE_FILLER::computeRawFilledAreas( const ZONE_CONTAINER* aZone,
         dumper->EndGroup();
 }
 
+
+void ZONE_FILLER::subtractTiledFeatureHoles( const ZONE_CONTAINER* aZone,
+        SHAPE_POLY_SET& aSolidAreas ) const
+{
+    // Subtraction is local: (A - H) restricted to a tile T is (A & T) - H, where only the
+    // holes intersecting T matter.  So each tile only needs the items near it, and the
+    // union of all tiles gives back the whole filled area.
+    BOX2I  bbox = aSolidAreas.BBox();
+    int    margin = fillDependencyMargin( aZone );
+
+    // The grid depends only on the zone, never on the thread count, so that the filled
+    // areas (and their hash) do not depend on the machine
+    int    tileSize = Millimeter2iu( s_zoneTileSizeMM );
+    int    cols = std::max( 1, ( bbox.GetWidth() + tileSize - 1 ) / tileSize );
+    int    rows = std::max( 1, ( bbox.GetHeight() + tileSize - 1 ) / tileSize );
+    int    tileWidth = bbox.GetWidth() / cols + 1;
+    int    tileHeight = bbox.GetHeight() / rows + 1;
+
+    std::vector<SHAPE_POLY_SET> tiles( cols * rows );
+
+    // The thread count only decides how the tiles are scheduled: they run on the threads
+    // left idle by the fill of the other zones
+    ParallelFor( tiles.size(), [&]( size_t i )
+    {
+        int      col = (int) i % cols;
+        int      row = (int) i / cols;
+        VECTOR2I origin( bbox.GetX() + col * tileWidth, bbox.GetY() + row * tileHeight );
+        SHAPE_POLY_SET& tile = tiles[i];
+
+        tile.NewOutline();
+        tile.Append( origin.x, origin.y );
+        tile.Append( origin.x + tileWidth, origin.y );
+        tile.Append( origin.x + tileWidth, origin.y + tileHeight );
+        tile.Append( origin.x, origin.y + tileHeight );
+
+        tile.BooleanIntersection( aSolidAreas, SHAPE_POLY_SET::PM_FAST );
+
+        if( tile.IsEmpty() )
+            return;
+
+        EDA_RECT area( wxPoint( origin.x, origin.y ), wxSize( tileWidth, tileHeight ) );
+        area.Inflate( margin );
+
+        SHAPE_POLY_SET holes;
+        buildZoneFeatureHoleList( aZone, area, holes );
+        holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+        tile.BooleanSubtract( holes, SHAPE_POLY_SET::PM_FAST );
+    } );
+
+    // Stitch the tiles back.  Adjacent tiles share their borders exactly, so the union
+    // merges them without seams.
+    // Use SHAPE_POLY_SET::PM_STRICTLY_SIMPLE to generate strictly simple polygons
+    // needed by Gerber files and Fracture()
+    aSolidAreas.RemoveAllContours();
+
+    for( const auto& tile : tiles )
+        aSolidAreas.Append( tile );
+
+    aSolidAreas.Simplify( SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+}
+
+
 /* Build the filled solid areas data from real outlines (stored in m_Poly)
  * The solid areas can be more than one on copper layers, and do not have holes
  * ( holes are linked by overlapping segments to the main outline)
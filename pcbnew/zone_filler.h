@@ -31,6 +31,7 @@
 
 class WX_PROGRESS_REPORTER;
 class BOARD;
+class BOARD_ITEM;
 class COMMIT;
 class SHAPE_POLY_SET;
 class SHAPE_LINE_CHAIN;
@@ -42,13 +43,83 @@ public:
     ~ZONE_FILLER();
 
     void SetProgressReporter( WX_PROGRESS_REPORTER* aReporter );
+
+    /**
+     * Function Fill
+     * Fills aZones.
+     * @param aCheck = true to ask the user whether to keep the new fills when they differ
+     * from the previous ones (see SameFilledAreas()).
+     * @return false if the fill was cancelled, true otherwise
+     */
     bool Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck = false );
 
+    /**
+     * Function SameFilledAreas
+     * Tells whether a zone fill is still up to date, i.e. whether aNew covers the same
+     * area as aPrevious.  The polygons themselves can differ: fills of large zones are
+     * built from tiles, and give other vertices than the serial fill of older versions.
+     */
+    static bool SameFilledAreas( const SHAPE_POLY_SET& aPrevious, const SHAPE_POLY_SET& aNew );
+
+    /**
+     * Function FillModified
+     * Fills only the zones of aZones which may be out of date: zones flagged by
+     * InvalidateDependentZones() or by a change of their own parameters, unfilled zones
+     * and zones not filled since the board was loaded.
+     * @return false if the fill was cancelled, true otherwise (including when nothing
+     * needed to be refilled)
+     */
+    bool FillModified( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck = false );
+
+    /**
+     * Function InvalidateDependentZones
+     * Flags for refill the zones whose last fill used aItem, i.e. zones sharing a layer
+     * with aItem and whose fill dependency area intersects the item area (including its
+     * clearance).
+     * @param aBoard is the board owning the zones.
+     * @param aItem is the added, removed or modified item.
+     * @param aOldItem is the copy of aItem before modification, or nullptr.
+     */
+    static void InvalidateDependentZones( BOARD* aBoard, const BOARD_ITEM* aItem,
+            const BOARD_ITEM* aOldItem = nullptr );
+
+    /**
+     * Function InvalidateZonesForUncommittedChange
+     * Flags for refill the zones which may depend on aItem, which is about to be modified
+     * in place outside a BOARD_COMMIT (i.e. after a call to SaveCopyInUndoList()).  Its new
+     * position is not known: all the zones sharing a layer with the item, or with the item
+     * flipped, are flagged whatever their area.
+     */
+    static void InvalidateZonesForUncommittedChange( BOARD* aBoard, const BOARD_ITEM* aItem );
+
 private:
 
-    void buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
+    /**
+     * @return the area containing all the items buildZoneFeatureHoleList() can subtract
+     * from aZone: the zone bounding box inflated by the biggest clearance.
+     */
+    EDA_RECT fillDependencyArea( const ZONE_CONTAINER* aZone ) const;
+
+    ///> @return the margin around aZone within which items can modify its fill.
+    int fillDependencyMargin( const ZONE_CONTAINER* aZone ) const;
+
+    /**
+     * Function buildZoneFeatureHoleList
+     * Builds the polygons to subtract from the filled areas of aZone: pads, tracks and
+     * graphic items with their clearance, higher priority zones and thermal reliefs.
+     * @param aArea is the area to collect items from; only items intersecting it are used.
+     */
+    void buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone, const EDA_RECT& aArea,
             SHAPE_POLY_SET& aFeatures ) const;
 
+    /**
+     * Function subtractTiledFeatureHoles
+     * Subtracts the feature holes of aZone from aSolidAreas, splitting the job in
+     * spatial tiles of a fixed size handled in parallel and merged by a final union.
+     */
+    void subtractTiledFeatureHoles( const ZONE_CONTAINER* aZone,
+            SHAPE_POLY_SET& aSolidAreas ) const;
+
     /**
      * Function computeRawFilledAreas
      * Add non copper areas polygons (pads and tracks with clearance)
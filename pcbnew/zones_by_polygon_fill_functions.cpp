@@ -77,7 +77,8 @@ void PCB_EDIT_FRAME::Check_All_Zones( wxWindow* aActiveWindow )
     ZONE_FILLER filler( GetBoard(), &commit );
     filler.SetProgressReporter( progressReporter.get() );
 
-    if( filler.Fill( toFill, true ) )
+    // Only zones touched by edits since their last fill need to be checked
+    if( filler.FillModified( toFill, true ) )
     {
         m_ZoneFillsDirty = false;
 
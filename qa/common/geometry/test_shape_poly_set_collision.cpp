@@ -27,6 +27,8 @@
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
 
+#include <cmath>
+
 #include "fixtures_geometry.h"
 
 /**
@@ -193,4 +195,72 @@ BOOST_AUTO_TEST_CASE( CollideVertexWithClearance )
     }
 }
 
+/**
+ * This test checks that sets large enough to get an edge index give the same answers as
+ * a brute force test of every contour.
+ */
+BOOST_AUTO_TEST_CASE( IndexedMatchesLinear )
+{
+    // A star with many teeth and a jagged hole, to get several hundred edges.
+    SHAPE_LINE_CHAIN outline, hole;
+
+    for( int i = 0; i < 360; i += 2 )
+    {
+        double a = i * M_PI / 180.0;
+        int    r = ( i % 4 ) ? 1000 : 800;
+        outline.Append( std::round( r * cos( a ) ), std::round( r * sin( a ) ) );
+
+        if( i % 6 == 0 )
+        {
+            int rh = ( i % 12 ) ? 300 : 250;
+            hole.Append( std::round( rh * cos( a ) ), std::round( rh * sin( a ) ) );
+        }
+    }
+
+    outline.SetClosed( true );
+    hole.SetClosed( true );
+
+    SHAPE_POLY_SET polySet;
+    polySet.AddOutline( outline );
+    polySet.AddHole( hole );
+
+    for( int x = -1100; x <= 1100; x += 37 )
+    {
+        for( int y = -1100; y <= 1100; y += 41 )
+        {
+            VECTOR2I p( x, y );
+
+            bool expected = outline.PointInside( p )
+                            && !( hole.PointInside( p ) && !hole.PointOnEdge( p ) );
+
+            BOOST_CHECK_EQUAL( polySet.Contains( p ), expected );
+
+            int minDist = std::min( outline.Distance( p, true ), hole.Distance( p, true ) );
+
+            BOOST_CHECK_EQUAL( polySet.Collide( p, 20 ), expected || minDist < 20 );
+        }
+    }
+
+    // Points exactly on the outline are not contained
+    BOOST_CHECK( !polySet.Contains( outline.CPoint( 10 ) ) );
+
+    // A copy shares the index, and a modified set must not use a stale one
+    SHAPE_POLY_SET copy( polySet );
+    BOOST_CHECK( copy.Contains( VECTOR2I( 0, 500 ) ) );
+
+    copy.Move( VECTOR2I( 5000, 0 ) );
+    BOOST_CHECK( !copy.Contains( VECTOR2I( 0, 500 ) ) );
+    BOOST_CHECK( copy.Contains( VECTOR2I( 5000, 500 ) ) );
+    BOOST_CHECK( polySet.Contains( VECTOR2I( 0, 500 ) ) );
+
+    // Reading through the modifiable accessors keeps the answers, and changes made through
+    // them are seen by the next query
+    BOOST_CHECK_EQUAL( polySet.Outline( 0 ).PointCount(), outline.PointCount() );
+    BOOST_CHECK( polySet.Contains( VECTOR2I( 0, 500 ) ) );
+
+    polySet.Outline( 0 ).Move( VECTOR2I( 0, 3000 ) );
+    BOOST_CHECK( !polySet.Contains( VECTOR2I( 0, 500 ) ) );
+    BOOST_CHECK( polySet.Contains( VECTOR2I( 0, 3500 ) ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
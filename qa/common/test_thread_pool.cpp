@@ -0,0 +1,188 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file test_thread_pool.cpp
+ * Test suite for THREAD_POOL and TASK_GROUP.
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <thread_pool.h>
+
+#include <stdexcept>
+
+
+/**
+ * Use a private pool with a known number of workers, so that the tests do not depend on
+ * the machine they run on.
+ */
+struct THREAD_POOL_FIXTURE
+{
+    THREAD_POOL_FIXTURE() : m_pool( 4 )
+    {
+    }
+
+    THREAD_POOL m_pool;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ThreadPool, THREAD_POOL_FIXTURE )
+
+
+/**
+ * Every index is visited exactly once, whatever the grain
+ */
+BOOST_AUTO_TEST_CASE( ParallelForVisitsAll )
+{
+    for( size_t grain : { 1, 3, 64, 5000 } )
+    {
+        const size_t                   count = 1000;
+        std::vector<std::atomic<int>>  visits( count );
+        TASK_GROUP                     group( m_pool );
+
+        for( auto& v : visits )
+            v = 0;
+
+        group.ParallelFor( count, [&]( size_t i ) { visits[i]++; }, grain );
+        group.Wait();
+
+        for( size_t i = 0; i < count; ++i )
+            BOOST_CHECK_EQUAL( visits[i], 1 );
+    }
+}
+
+
+/**
+ * Parallel loops can run inside parallel loops without starving the pool
+ */
+BOOST_AUTO_TEST_CASE( Nested )
+{
+    std::atomic<size_t> sum( 0 );
+    TASK_GROUP          outer( m_pool );
+
+    outer.ParallelFor( 16, [&]( size_t i )
+    {
+        TASK_GROUP inner( m_pool );
+
+        inner.ParallelFor( 100, [&]( size_t j ) { sum += j; } );
+        inner.Wait();
+    } );
+
+    outer.Wait();
+
+    BOOST_CHECK_EQUAL( sum, 16 * 4950 );
+}
+
+
+/**
+ * A cancelled group stops handing out work
+ */
+BOOST_AUTO_TEST_CASE( Cancel )
+{
+    std::atomic<size_t> done( 0 );
+    TASK_GROUP          group( m_pool );
+
+    group.ParallelFor( 100000, [&]( size_t i )
+    {
+        if( done++ == 10 )
+            group.Cancel();
+    } );
+
+    group.Wait();
+
+    BOOST_CHECK( group.IsCancelled() );
+    BOOST_CHECK_LT( done, 100000 );
+}
+
+
+/**
+ * Exceptions thrown by the tasks are passed to the waiting thread
+ */
+BOOST_AUTO_TEST_CASE( Exception )
+{
+    std::atomic<int> done( 0 );
+    TASK_GROUP       group( m_pool );
+
+    for( int i = 0; i < 10; ++i )
+    {
+        group.Run( [&done, i]()
+        {
+            done++;
+
+            if( i == 5 )
+                throw std::runtime_error( "task failed" );
+        } );
+    }
+
+    BOOST_CHECK_THROW( group.Wait(), std::runtime_error );
+    BOOST_CHECK( group.IsDone() );
+    BOOST_CHECK_EQUAL( done, 10 );
+}
+
+
+/**
+ * A waiting thread runs the tasks of its own group, not the ones of other groups
+ */
+BOOST_AUTO_TEST_CASE( WaitRunsOwnGroupOnly )
+{
+    THREAD_POOL       pool( 1 );
+    std::atomic<bool> started( false );
+    std::atomic<bool> release( false );
+    std::atomic<int>  done( 0 );
+
+    // Keep the only worker busy, so that the queued tasks are left to the waiting thread
+    TASK_GROUP blocker( pool );
+
+    blocker.Run( [&]()
+    {
+        started = true;
+
+        while( !release )
+            std::this_thread::yield();
+    } );
+
+    while( !started )
+        std::this_thread::yield();
+
+    TASK_GROUP other( pool );
+    other.Run( [&]() { done += 100; } );
+
+    TASK_GROUP mine( pool );
+
+    for( int i = 0; i < 10; ++i )
+        mine.Run( [&]() { done++; } );
+
+    mine.Wait();
+
+    BOOST_CHECK_EQUAL( done, 10 );
+    BOOST_CHECK( !other.IsDone() );
+
+    release = true;
+    other.Wait();
+    blocker.Wait();
+
+    BOOST_CHECK_EQUAL( done, 110 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
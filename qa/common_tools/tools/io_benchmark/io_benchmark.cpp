@@ -25,6 +25,7 @@
 
 #include <wx/wx.h>
 #include <richio.h>
+#include <dsnlexer.h>
 
 #include <chrono>
 #include <ios>
@@ -157,6 +158,51 @@ static void bench_line_reader_reuse( const wxFileName& aFile, int aReps, BENCH_R
 }
 
 
+/**
+ * Benchmark using MAPPED_FILE_LINE_READER, reading the lines in place
+ * in the mapped file rather than copying them.
+ * The LINE_READER is recreated (and the file mapped) for each cycle.
+ */
+static void bench_mapped_in_place( const wxFileName& aFile, int aReps, BENCH_REPORT& report )
+{
+    for( int i = 0; i < aReps; ++i)
+    {
+        MAPPED_FILE_LINE_READER fstr( aFile.GetFullPath() );
+
+        while( const char* line = fstr.ReadLineInPlace() )
+        {
+            report.linesRead++;
+            report.charAcc += (unsigned char) line[0];
+        }
+    }
+}
+
+
+/**
+ * Benchmark tokenizing the file with a DSNLEXER on a given LINE_READER
+ * implementation, with or without in place line reading.
+ * The number of lines is the line count seen by the lexer, and the first
+ * character of each token is accumulated.
+ */
+template<typename LR, bool IN_PLACE>
+static void bench_lexer( const wxFileName& aFile, int aReps, BENCH_REPORT& report )
+{
+    for( int i = 0; i < aReps; ++i)
+    {
+        LR       fstr( aFile.GetFullPath() );
+        DSNLEXER lexer( nullptr, 0, &fstr );
+
+        lexer.SetInPlaceLines( IN_PLACE );
+
+        while( lexer.NextTok() != DSN_EOF )
+            report.charAcc += (unsigned char) lexer.CurText()[0];
+
+        // the lexer reads one more (empty) line at the end of the file
+        report.linesRead += lexer.CurLineNumber() - 1;
+    }
+}
+
+
 /**
  * Benchmark using STRING_LINE_READER on string data read into memory from a file
  * using std::ifstream, but read the data fresh from the file each time
@@ -313,6 +359,9 @@ static std::vector<BENCHMARK> benchmarkList =
     { 'F', bench_fstream_reuse, "std::fstream, reused" },
     { 'r', bench_line_reader<FILE_LINE_READER>, "RichIO FILE_L_R" },
     { 'R', bench_line_reader_reuse<FILE_LINE_READER>, "RichIO FILE_L_R, reused" },
+    { 'm', bench_line_reader<MAPPED_FILE_LINE_READER>, "RichIO MAPPED_FILE_L_R" },
+    { 'M', bench_line_reader_reuse<MAPPED_FILE_LINE_READER>, "RichIO MAPPED_FILE_L_R, reused" },
+    { 'i', bench_mapped_in_place, "RichIO MAPPED_FILE_L_R, in place" },
     { 'n', bench_line_reader<IFSTREAM_LINE_READER>, "std::ifstream L_R" },
     { 'N', bench_line_reader_reuse<IFSTREAM_LINE_READER>, "std::ifstream L_R, reused" },
     { 's', bench_string_lr, "RichIO STRING_L_R"},
@@ -325,6 +374,8 @@ static std::vector<BENCHMARK> benchmarkList =
     { 'B', bench_wxbis_reuse<wxFileInputStream>, "wxFileIStream, buf'd, reused" },
     { 'c', bench_wxbis<wxFFileInputStream>, "wxFFileIStream. buf'd" },
     { 'C', bench_wxbis_reuse<wxFFileInputStream>, "wxFFileIStream, buf'd, reused" },
+    { 'l', bench_lexer<FILE_LINE_READER, false>, "DSNLEXER, FILE_L_R" },
+    { 'L', bench_lexer<MAPPED_FILE_LINE_READER, true>, "DSNLEXER, MAPPED_FILE_L_R, in place" },
 };
 
 
@@ -0,0 +1,149 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for EE_RTREE
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <sch_rtree.h>
+
+#include <sch_junction.h>
+#include <sch_line.h>
+
+
+/**
+ * A horizontal wire from (0, 0) to (1000, 0) and a junction on each of its ends,
+ * indexed in that order.
+ */
+class TEST_EE_RTREE_FIXTURE
+{
+public:
+    TEST_EE_RTREE_FIXTURE() :
+        m_wire( wxPoint( 0, 0 ), LAYER_WIRE ),
+        m_start( wxPoint( 0, 0 ) ),
+        m_end( wxPoint( 1000, 0 ) )
+    {
+        m_wire.SetEndPoint( wxPoint( 1000, 0 ) );
+
+        m_tree.Insert( &m_wire );
+        m_tree.Insert( &m_start );
+        m_tree.Insert( &m_end );
+    }
+
+    SCH_LINE     m_wire;
+    SCH_JUNCTION m_start;
+    SCH_JUNCTION m_end;
+
+    EE_RTREE     m_tree;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( EeRtree, TEST_EE_RTREE_FIXTURE )
+
+
+/**
+ * Items are found by position and type, in insertion order
+ */
+BOOST_AUTO_TEST_CASE( Query )
+{
+    std::vector<SCH_ITEM*> expected = { &m_wire, &m_end };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 1000, 0 ) ) == expected );
+
+    expected = { &m_wire };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 500, 0 ) ) == expected );
+    BOOST_CHECK( m_tree.Query( wxPoint( 0, 0 ), 0, SCH_LINE_T ) == expected );
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 500, 5000 ) ).empty() );
+}
+
+
+/**
+ * Updated items are found at their new position only
+ */
+BOOST_AUTO_TEST_CASE( Update )
+{
+    m_tree.Update( &m_end );
+    m_end.SetPosition( wxPoint( 5000, 5000 ) );
+
+    std::vector<SCH_ITEM*> expected = { &m_end };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 5000, 5000 ) ) == expected );
+
+    expected = { &m_wire };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 1000, 0 ) ) == expected );
+}
+
+
+/**
+ * Changes not reported to the index are caught by Revalidate()
+ */
+BOOST_AUTO_TEST_CASE( Revalidate )
+{
+    // Index the items
+    m_tree.Query( wxPoint( 0, 0 ) );
+
+    m_wire.SetStartPoint( wxPoint( 0, 3000 ) );
+    m_wire.SetEndPoint( wxPoint( 1000, 3000 ) );
+    m_tree.Revalidate();
+
+    std::vector<SCH_ITEM*> expected = { &m_wire };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 500, 3000 ) ) == expected );
+    BOOST_CHECK( m_tree.Query( wxPoint( 500, 0 ) ).empty() );
+}
+
+
+/**
+ * Removed items are not found any more, even if they moved since they were indexed
+ */
+BOOST_AUTO_TEST_CASE( Remove )
+{
+    m_tree.Query( wxPoint( 0, 0 ) );
+
+    m_start.SetPosition( wxPoint( 7000, 7000 ) );
+    m_tree.Remove( &m_start );
+
+    BOOST_CHECK( !m_tree.Contains( &m_start ) );
+    BOOST_CHECK_EQUAL( m_tree.GetCount(), 2 );
+    BOOST_CHECK( m_tree.Query( wxPoint( 7000, 7000 ) ).empty() );
+
+    std::vector<SCH_ITEM*> expected = { &m_wire };
+
+    BOOST_CHECK( m_tree.Query( wxPoint( 0, 0 ) ) == expected );
+
+    // A reinserted item comes last
+    m_tree.Insert( &m_start );
+    expected = { &m_wire, &m_end, &m_start };
+
+    BOOST_CHECK( m_tree.Query( EDA_RECT( wxPoint( -5000, -5000 ), wxSize( 20000, 20000 ) ) )
+                 == expected );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
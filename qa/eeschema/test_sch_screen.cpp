@@ -0,0 +1,139 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for SCH_SCREEN
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <sch_screen.h>
+
+#include <sch_line.h>
+#include <sch_text.h>
+
+
+/**
+ * Two wires joined at (1000, 0), and a label in the middle of the second one.
+ */
+class TEST_SCH_SCREEN_FIXTURE
+{
+public:
+    TEST_SCH_SCREEN_FIXTURE() : m_screen( nullptr )
+    {
+        m_wire1 = addWire( wxPoint( 0, 0 ), wxPoint( 1000, 0 ) );
+        m_wire2 = addWire( wxPoint( 1000, 0 ), wxPoint( 2000, 0 ) );
+
+        m_label = new SCH_LABEL( wxPoint( 1500, 0 ), "A" );
+        m_screen.Append( m_label );
+
+        m_screen.TestDanglingEnds();
+    }
+
+    SCH_LINE* addWire( const wxPoint& aStart, const wxPoint& aEnd )
+    {
+        SCH_LINE* wire = new SCH_LINE( aStart, LAYER_WIRE );
+        wire->SetEndPoint( aEnd );
+        m_screen.Append( wire );
+        return wire;
+    }
+
+    SCH_SCREEN m_screen;
+    SCH_LINE*  m_wire1;
+    SCH_LINE*  m_wire2;
+    SCH_LABEL* m_label;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SchScreen, TEST_SCH_SCREEN_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( DanglingEnds )
+{
+    BOOST_CHECK( m_wire1->IsStartDangling() );
+    BOOST_CHECK( !m_wire1->IsEndDangling() );
+    BOOST_CHECK( !m_wire2->IsStartDangling() );
+    BOOST_CHECK( m_wire2->IsEndDangling() );
+    BOOST_CHECK( !m_label->IsDangling() );
+
+    // Nothing changed
+    BOOST_CHECK( !m_screen.TestDanglingEnds() );
+}
+
+
+/**
+ * Moving an item updates the items it was connected to
+ */
+BOOST_AUTO_TEST_CASE( MovedItem )
+{
+    m_wire2->Move( wxPoint( 0, 5000 ) );
+
+    std::vector<SCH_ITEM*> changedItems;
+
+    BOOST_CHECK( m_screen.TestDanglingEnds( [&]( SCH_ITEM* aItem )
+                                            {
+                                                changedItems.push_back( aItem );
+                                            } ) );
+
+    BOOST_CHECK( m_wire1->IsEndDangling() );
+    BOOST_CHECK( m_wire2->IsStartDangling() );
+    BOOST_CHECK( m_label->IsDangling() );
+
+    std::vector<SCH_ITEM*> expected = { m_wire1, m_wire2, m_label };
+
+    BOOST_CHECK( changedItems == expected );
+
+    // Connect the label again, to the other wire
+    m_label->SetTextPos( wxPoint( 500, 0 ) );
+    m_screen.Update( m_label );
+
+    BOOST_CHECK( m_screen.TestDanglingEnds() );
+    BOOST_CHECK( !m_label->IsDangling() );
+}
+
+
+/**
+ * Removing an item updates the items it was connected to
+ */
+BOOST_AUTO_TEST_CASE( RemovedItem )
+{
+    m_screen.DeleteItem( m_wire2 );
+
+    BOOST_CHECK( m_screen.TestDanglingEnds() );
+
+    BOOST_CHECK( m_wire1->IsEndDangling() );
+    BOOST_CHECK( m_label->IsDangling() );
+
+    // A new wire, possibly at the address of the deleted one
+    SCH_LINE* wire = addWire( wxPoint( 1000, 0 ), wxPoint( 2000, 0 ) );
+
+    BOOST_CHECK( m_screen.TestDanglingEnds() );
+
+    BOOST_CHECK( !wire->IsStartDangling() );
+    BOOST_CHECK( !m_wire1->IsEndDangling() );
+    BOOST_CHECK( !m_label->IsDangling() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_track.h>
+
+#include <drc/drc_rtree.h>
+
+
+struct DRC_RTREE_FIXTURE
+{
+    DRC_RTREE_FIXTURE() :
+            m_front( nullptr ),
+            m_back( nullptr ),
+            m_via( nullptr )
+    {
+        m_front.SetLayer( F_Cu );
+        m_front.SetStart( wxPoint( 0, 0 ) );
+        m_front.SetEnd( wxPoint( 1000000, 0 ) );
+        m_front.SetWidth( 200000 );
+
+        m_back.SetLayer( B_Cu );
+        m_back.SetStart( wxPoint( 0, 0 ) );
+        m_back.SetEnd( wxPoint( 1000000, 0 ) );
+        m_back.SetWidth( 200000 );
+
+        m_via.SetLayerPair( F_Cu, B_Cu );
+        m_via.SetPosition( wxPoint( 5000000, 0 ) );
+        m_via.SetWidth( 600000 );
+
+        for( TRACK* item : { &m_front, &m_back, static_cast<TRACK*>( &m_via ) } )
+            m_index.Insert( item, item->GetBoundingBox(), item->GetLayerSet() );
+    }
+
+    TRACK     m_front;
+    TRACK     m_back;
+    VIA       m_via;
+    DRC_RTREE m_index;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( DrcRtree, DRC_RTREE_FIXTURE )
+
+
+/**
+ * Items on several layers are counted once
+ */
+BOOST_AUTO_TEST_CASE( Size )
+{
+    BOOST_CHECK_EQUAL( m_index.Size(), 3 );
+
+    m_index.RemoveAll();
+    BOOST_CHECK_EQUAL( m_index.Size(), 0 );
+}
+
+
+/**
+ * Only the items of the queried layers are found
+ */
+BOOST_AUTO_TEST_CASE( QueryLayers )
+{
+    std::vector<BOARD_ITEM*> found;
+    EDA_RECT                 area( wxPoint( -100, -100 ), wxSize( 200, 200 ) );
+
+    m_index.Query( area, LSET( F_Cu ), found );
+    BOOST_CHECK( found == std::vector<BOARD_ITEM*>{ &m_front } );
+
+    m_index.Query( area, LSET( In1_Cu ), found );
+    BOOST_CHECK( found.empty() );
+
+    m_index.Query( area, LSET::AllCuMask(), found );
+    BOOST_CHECK_EQUAL( found.size(), 2 );
+}
+
+
+/**
+ * An item indexed on several layers is reported once, and only when near the area
+ */
+BOOST_AUTO_TEST_CASE( QueryArea )
+{
+    std::vector<BOARD_ITEM*> found;
+    EDA_RECT                 area( wxPoint( 4000000, -100 ), wxSize( 800000, 200 ) );
+
+    m_index.Query( area, LSET::AllCuMask(), found );
+    BOOST_CHECK( found == std::vector<BOARD_ITEM*>{ &m_via } );
+
+    area.Move( wxPoint( 0, 2000000 ) );
+    m_index.Query( area, LSET::AllCuMask(), found );
+    BOOST_CHECK( found.empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
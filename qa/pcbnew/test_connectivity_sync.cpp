@@ -0,0 +1,143 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <netinfo.h>
+
+#include <connectivity/connectivity_data.h>
+
+
+/**
+ * Two nets: net 1 is made of two disjoint tracks, net 2 of a single one.
+ */
+struct CONNECTIVITY_SYNC_FIXTURE
+{
+    CONNECTIVITY_SYNC_FIXTURE()
+    {
+        m_board.Add( new NETINFO_ITEM( &m_board, "A", 1 ) );
+        m_board.Add( new NETINFO_ITEM( &m_board, "B", 2 ) );
+
+        m_a1 = addTrack( wxPoint( 0, 0 ), wxPoint( 1000000, 0 ), 1 );
+        m_a2 = addTrack( wxPoint( 2000000, 0 ), wxPoint( 3000000, 0 ), 1 );
+        m_b = addTrack( wxPoint( 0, 5000000 ), wxPoint( 3000000, 5000000 ), 2 );
+
+        m_conn.Build( &m_board );
+    }
+
+    TRACK* addTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet )
+    {
+        TRACK* track = new TRACK( &m_board );
+        track->SetLayer( F_Cu );
+        track->SetStart( aStart );
+        track->SetEnd( aEnd );
+        track->SetWidth( 200000 );
+        m_board.Add( track );
+        track->SetNetCode( aNet );
+        return track;
+    }
+
+    /// The unconnected count of a database built from scratch
+    unsigned int rebuiltUnconnectedCount()
+    {
+        CONNECTIVITY_DATA rebuilt;
+        rebuilt.Build( &m_board );
+        return rebuilt.GetUnconnectedCount();
+    }
+
+    BOARD             m_board;
+    TRACK*            m_a1;
+    TRACK*            m_a2;
+    TRACK*            m_b;
+
+    ///> Not the board's own connectivity, so that it never hears about the changes
+    CONNECTIVITY_DATA m_conn;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ConnectivitySync, CONNECTIVITY_SYNC_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( Unchanged )
+{
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), 1 );
+
+    m_conn.Sync( &m_board );
+
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), 1 );
+    BOOST_CHECK( m_conn.CheckConsistency( &m_board ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( MovedItem )
+{
+    m_a2->SetStart( wxPoint( 1000000, 0 ) );
+
+    m_conn.Sync( &m_board );
+
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), 0 );
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), rebuiltUnconnectedCount() );
+    BOOST_CHECK( m_conn.CheckConsistency( &m_board ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( AddedItem )
+{
+    addTrack( wxPoint( 1000000, 0 ), wxPoint( 2000000, 0 ), 1 );
+
+    m_conn.Sync( &m_board );
+
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), 0 );
+    BOOST_CHECK( m_conn.CheckConsistency( &m_board ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( DeletedItem )
+{
+    // The database must not touch the removed item any more
+    m_board.Remove( m_a2 );
+    delete m_a2;
+
+    m_conn.Sync( &m_board );
+
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), 0 );
+    BOOST_CHECK( m_conn.CheckConsistency( &m_board ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( ChangedNet )
+{
+    m_a2->SetNetCode( 2 );
+
+    // Not synchronized yet, the clusters are out of date
+    BOOST_CHECK( !m_conn.CheckConsistency( &m_board ) );
+
+    m_conn.Sync( &m_board );
+
+    BOOST_CHECK_EQUAL( m_conn.GetUnconnectedCount(), rebuiltUnconnectedCount() );
+    BOOST_CHECK( m_conn.CheckConsistency( &m_board ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
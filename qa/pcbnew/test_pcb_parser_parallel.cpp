@@ -0,0 +1,120 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <sstream>
+
+#include <class_board.h>
+#include <kicad_plugin.h>
+#include <pcb_parser.h>
+#include <richio.h>
+
+
+/**
+ * A board large enough to be parsed by the parallel workers (when the machine has
+ * several cores), with comment lines holding parentheses and data after the board.
+ */
+static std::string makeBoardText()
+{
+    std::ostringstream text;
+
+    text << "(kicad_pcb (version 20190516) (host pcbnew 5.1)\n"
+            "  (general (thickness 1.6))\n"
+            "  (layers\n"
+            "    (0 F.Cu signal)\n"
+            "    (31 B.Cu signal)\n"
+            "  )\n"
+            "  (net 0 \"\")\n"
+            "  (net 1 GND)\n";
+
+    for( int i = 0; i < 2000; i++ )
+    {
+        if( i % 100 == 0 )
+            text << "# a comment line ) with unbalanced ((( parentheses\n";
+
+        text << "  (segment (start " << i << " 0) (end " << i << " 10)\n"
+             << "    # a comment ( inside an element\n"
+             << "    (width 0.25) (layer " << ( i % 2 ? "B.Cu" : "F.Cu" ) << ") (net 1))\n";
+    }
+
+    text << ")\n"
+            "(trailing data)\n";
+
+    return text.str();
+}
+
+
+/**
+ * Parses the board of aParser and returns it formatted.
+ */
+static std::string parseAndFormat( PCB_PARSER& aParser )
+{
+    std::unique_ptr<BOARD_ITEM> board( aParser.Parse() );
+
+    BOOST_REQUIRE( board );
+
+    PCB_IO io;
+    io.Format( board.get() );
+
+    return io.GetStringOutput( true );
+}
+
+
+BOOST_AUTO_TEST_SUITE( PcbParserParallel )
+
+
+/**
+ * A board read in place from memory, which can be parsed in parallel, gives the same
+ * board, and leaves the parser at the same place, as a board read from a string.
+ */
+BOOST_AUTO_TEST_CASE( SameAsSerial )
+{
+    const std::string text = makeBoardText();
+
+    STRING_LINE_READER serialReader( text, "serial" );
+    PCB_PARSER         serialParser( &serialReader );
+
+    MEMORY_LINE_READER parallelReader( text.data(), text.size(), "parallel" );
+    PCB_PARSER         parallelParser( &parallelReader );
+
+    parallelParser.SetInPlaceLines( true );
+
+    const std::string serial = parseAndFormat( serialParser );
+    const std::string parallel = parseAndFormat( parallelParser );
+
+    BOOST_CHECK( serial == parallel );
+
+    // Both parsers stop after the closing parenthesis of the board
+    BOOST_CHECK_EQUAL( serialParser.CurLineNumber(), parallelParser.CurLineNumber() );
+
+    for( PCB_PARSER* parser : { &serialParser, &parallelParser } )
+    {
+        parser->NextTok();
+        BOOST_CHECK_EQUAL( std::string( parser->CurText() ), "(" );
+        parser->NextTok();
+        BOOST_CHECK_EQUAL( std::string( parser->CurText() ), "trailing" );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <atomic>
+#include <thread>
+
+#include <router/pns_node.h>
+#include <router/pns_segment.h>
+
+
+/**
+ * A root node holding two horizontal tracks of net 1, at y = 0 and y = 5mm.
+ */
+struct PNS_NODE_SNAPSHOT_FIXTURE
+{
+    PNS_NODE_SNAPSHOT_FIXTURE()
+    {
+        m_lower = addSegment( m_root, 0 );
+        m_upper = addSegment( m_root, 5000000 );
+    }
+
+    ~PNS_NODE_SNAPSHOT_FIXTURE()
+    {
+        m_root.KillChildren();
+    }
+
+    static PNS::SEGMENT* addSegment( PNS::NODE& aNode, int aY )
+    {
+        std::unique_ptr<PNS::SEGMENT> seg( new PNS::SEGMENT( SEG( VECTOR2I( 0, aY ),
+                                                                  VECTOR2I( 3000000, aY ) ), 1 ) );
+        PNS::SEGMENT* rv = seg.get();
+
+        seg->SetLayer( 0 );
+        seg->SetWidth( 200000 );
+        aNode.Add( std::move( seg ) );
+
+        return rv;
+    }
+
+    /// Tells if a short vertical track of net 2 at height aY collides with aNode
+    static bool collides( const PNS::NODE& aNode, int aY )
+    {
+        PNS::SEGMENT probe( SEG( VECTOR2I( 1000000, aY ), VECTOR2I( 1000000, aY + 100000 ) ), 2 );
+
+        probe.SetLayer( 0 );
+        probe.SetWidth( 200000 );
+
+        return static_cast<bool>( aNode.CheckColliding( &probe ) );
+    }
+
+    PNS::NODE     m_root;
+    PNS::SEGMENT* m_lower;
+    PNS::SEGMENT* m_upper;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsNodeSnapshot, PNS_NODE_SNAPSHOT_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( RootSnapshot )
+{
+    std::shared_ptr<const PNS::NODE> snapshot = m_root.Snapshot();
+
+    BOOST_CHECK( collides( *snapshot, 0 ) );
+    BOOST_CHECK( collides( *snapshot, 5000000 ) );
+    BOOST_CHECK( !collides( *snapshot, 10000000 ) );
+
+    // Unchanged root: the frozen copy is shared
+    BOOST_CHECK( m_root.Snapshot() == snapshot );
+
+    m_root.Remove( m_lower );
+    addSegment( m_root, 10000000 );
+
+    // The old snapshot does not see the changes, a new one does
+    BOOST_CHECK( collides( *snapshot, 0 ) );
+    BOOST_CHECK( !collides( *snapshot, 10000000 ) );
+
+    std::shared_ptr<const PNS::NODE> updated = m_root.Snapshot();
+
+    BOOST_CHECK( updated != snapshot );
+    BOOST_CHECK( !collides( *updated, 0 ) );
+    BOOST_CHECK( collides( *updated, 10000000 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( BranchSnapshot )
+{
+    PNS::NODE* branch = m_root.Branch();
+
+    branch->Remove( m_lower );
+    addSegment( *branch, 10000000 );
+
+    std::shared_ptr<const PNS::NODE> snapshot = branch->Snapshot();
+
+    BOOST_CHECK( !collides( *snapshot, 0 ) );
+    BOOST_CHECK( collides( *snapshot, 5000000 ) );
+    BOOST_CHECK( collides( *snapshot, 10000000 ) );
+
+    // The snapshot outlives the branch and the root items it was taken from
+    m_root.KillChildren();
+    m_root.Remove( m_upper );
+
+    BOOST_CHECK( !collides( *snapshot, 0 ) );
+    BOOST_CHECK( collides( *snapshot, 5000000 ) );
+    BOOST_CHECK( collides( *snapshot, 10000000 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( ConcurrentQueries )
+{
+    PNS::NODE* branch = m_root.Branch();
+
+    std::shared_ptr<const PNS::NODE> snapshot = branch->Snapshot();
+    std::atomic<int> failures( 0 );
+    std::vector<std::thread> readers;
+
+    for( int i = 0; i < 4; i++ )
+    {
+        readers.emplace_back( [&]()
+                {
+                    for( int n = 0; n < 1000; n++ )
+                    {
+                        if( !collides( *snapshot, 0 ) || collides( *snapshot, 10000000 ) )
+                            failures++;
+                    }
+                } );
+    }
+
+    // The branch keeps being edited meanwhile
+    for( int n = 0; n < 100; n++ )
+    {
+        PNS::SEGMENT* seg = addSegment( *branch, 10000000 );
+        branch->Remove( seg );
+    }
+
+    for( std::thread& reader : readers )
+        reader.join();
+
+    BOOST_CHECK_EQUAL( failures.load(), 0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
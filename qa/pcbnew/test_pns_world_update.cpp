@@ -0,0 +1,167 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <set>
+#include <tuple>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <netinfo.h>
+
+#include <router/pns_kicad_iface.h>
+#include <router/pns_node.h>
+#include <router/pns_router.h>
+
+
+///> What a world item is made of: kind, net, layers, parent and bounding box
+typedef std::tuple<int, int, int, int, const BOARD_CONNECTED_ITEM*, int, int, int, int>
+        WORLD_ITEM_DESC;
+
+
+/**
+ * A board with tracks and vias on two nets, and a router world synced from it.
+ */
+struct PNS_WORLD_UPDATE_FIXTURE
+{
+    PNS_WORLD_UPDATE_FIXTURE()
+    {
+        m_board.Add( new NETINFO_ITEM( &m_board, "A", 1 ) );
+        m_board.Add( new NETINFO_ITEM( &m_board, "B", 2 ) );
+
+        m_a = addTrack( wxPoint( 0, 0 ), wxPoint( 1000000, 0 ), 1 );
+        m_b = addTrack( wxPoint( 0, 5000000 ), wxPoint( 3000000, 5000000 ), 2 );
+        m_via = addVia( wxPoint( 1000000, 0 ), 1 );
+
+        m_iface.SetBoard( &m_board );
+        m_router.SetInterface( &m_iface );
+        m_router.SyncWorld();
+    }
+
+    TRACK* addTrack( const wxPoint& aStart, const wxPoint& aEnd, int aNet )
+    {
+        TRACK* track = new TRACK( &m_board );
+        track->SetLayer( F_Cu );
+        track->SetStart( aStart );
+        track->SetEnd( aEnd );
+        track->SetWidth( 200000 );
+        track->SetNetCode( aNet );
+        m_board.Add( track );
+        return track;
+    }
+
+    VIA* addVia( const wxPoint& aPos, int aNet )
+    {
+        VIA* via = new VIA( &m_board );
+        via->SetPosition( aPos );
+        via->SetWidth( 600000 );
+        via->SetDrill( 300000 );
+        via->SetLayerPair( F_Cu, B_Cu );
+        via->SetNetCode( aNet );
+        m_board.Add( via );
+        return via;
+    }
+
+    static std::multiset<WORLD_ITEM_DESC> describe( PNS::NODE* aWorld )
+    {
+        std::multiset<WORLD_ITEM_DESC> desc;
+
+        for( int net = -1; net <= 2; net++ )
+        {
+            std::set<PNS::ITEM*> items;
+            aWorld->AllItemsInNet( net, items );
+
+            for( PNS::ITEM* item : items )
+            {
+                BOX2I bbox = item->Shape()->BBox();
+
+                desc.insert( WORLD_ITEM_DESC( item->Kind(), item->Net(), item->Layers().Start(),
+                                              item->Layers().End(), item->Parent(),
+                                              bbox.GetX(), bbox.GetY(),
+                                              bbox.GetWidth(), bbox.GetHeight() ) );
+            }
+        }
+
+        return desc;
+    }
+
+    /// The world of a router synced from scratch
+    std::multiset<WORLD_ITEM_DESC> rebuiltWorld()
+    {
+        PNS_KICAD_IFACE iface;
+        PNS::ROUTER     router;
+
+        iface.SetBoard( &m_board );
+        router.SetInterface( &iface );
+        router.SyncWorld();
+
+        return describe( router.GetWorld() );
+    }
+
+    // Declared first: the interface unregisters from it when destroyed
+    BOARD           m_board;
+    TRACK*          m_a;
+    TRACK*          m_b;
+    VIA*            m_via;
+
+    PNS_KICAD_IFACE m_iface;
+    PNS::ROUTER     m_router;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( PnsWorldUpdate, PNS_WORLD_UPDATE_FIXTURE )
+
+
+/**
+ * Items changed in place (notified first, as PCB_BASE_EDIT_FRAME::SaveCopyInUndoList()
+ * does), added and removed give the same world as a full sync.
+ */
+BOOST_AUTO_TEST_CASE( UpdatedMatchesSynced )
+{
+    PNS::NODE* world = m_router.GetWorld();
+
+    BOOST_CHECK( describe( world ) == rebuiltWorld() );
+
+    // Moved and widened
+    m_board.OnItemChanged( m_a );
+    m_a->SetEnd( wxPoint( 2000000, 1000000 ) );
+    m_a->SetWidth( 300000 );
+
+    // Moved to the other net
+    m_board.OnItemChanged( m_b );
+    m_b->SetNetCode( 1 );
+
+    m_board.Remove( m_via );
+    delete m_via;
+
+    addTrack( wxPoint( 0, 8000000 ), wxPoint( 1000000, 8000000 ), 2 );
+    addVia( wxPoint( 1000000, 8000000 ), 2 );
+
+    m_router.SyncWorld();
+
+    // The world was updated, not built again
+    BOOST_CHECK( m_router.GetWorld() == world );
+    BOOST_CHECK( describe( m_router.GetWorld() ) == rebuiltWorld() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <wx/filename.h>
+
+#include <class_board.h>
+#include <class_zone.h>
+#include <convert_to_biu.h>
+#include <geometry/geometry_utils.h>
+#include <zone_filler.h>
+
+
+/**
+ * A board with a zone large enough to be filled in tiles.  Its edges are slanted, so
+ * that the tile borders cut them between grid points.
+ */
+static std::unique_ptr<BOARD> makeBoard()
+{
+    std::istringstream text(
+            "(kicad_pcb (version 20171130) (host pcbnew 5.1)\n"
+            "  (general (thickness 1.6))\n"
+            "  (layers\n"
+            "    (0 F.Cu signal)\n"
+            "    (31 B.Cu signal)\n"
+            "    (44 Edge.Cuts user)\n"
+            "  )\n"
+            "  (net 0 \"\")\n"
+            "  (gr_line (start 0 0) (end 100 0) (layer Edge.Cuts) (width 0.05))\n"
+            "  (gr_line (start 100 0) (end 100 100) (layer Edge.Cuts) (width 0.05))\n"
+            "  (gr_line (start 100 100) (end 0 100) (layer Edge.Cuts) (width 0.05))\n"
+            "  (gr_line (start 0 100) (end 0 0) (layer Edge.Cuts) (width 0.05))\n"
+            "  (zone (net 0) (net_name \"\") (layer F.Cu) (tstamp 0) (hatch edge 0.508)\n"
+            "    (connect_pads (clearance 0.508))\n"
+            "    (min_thickness 0.254)\n"
+            "    (fill (arc_segments 32) (thermal_gap 0.508) (thermal_bridge_width 0.508))\n"
+            "    (polygon\n"
+            "      (pts\n"
+            "        (xy 30.1 5) (xy 70.3 5.2) (xy 94.9 29.7) (xy 95 70.1)\n"
+            "        (xy 69.9 94.8) (xy 30.2 95) (xy 5.1 70.3) (xy 5 29.9)\n"
+            "      )\n"
+            "    )\n"
+            "  )\n"
+            ")\n" );
+
+    return KI_TEST::ReadItemFromStream<BOARD>( text );
+}
+
+
+BOOST_AUTO_TEST_SUITE( ZoneFillCheck )
+
+
+/**
+ * A large zone filled by the serial code of older versions, saved and loaded again, is
+ * up to date: the tiled fill gives other polygons, but the same area.
+ */
+BOOST_AUTO_TEST_CASE( SerialFillFromDiskIsUpToDate )
+{
+    std::unique_ptr<BOARD> board = makeBoard();
+    BOOST_REQUIRE( board );
+
+    ZONE_CONTAINER* zone = board->GetArea( 0 );
+    BOOST_REQUIRE( zone );
+
+    // The serial fill: no item cuts the zone, so it is the outline shrunk by half the
+    // minimum thickness, made strictly simple and fractured
+    SHAPE_POLY_SET serialFill;
+    BOOST_REQUIRE( zone->BuildSmoothedPoly( serialFill ) );
+
+    int halfThickness = zone->GetMinThickness() / 2;
+    int numSegs = std::max( GetArcToSegmentCount( halfThickness,
+                                    board->GetDesignSettings().m_MaxError, 360.0 ), 6 );
+
+    serialFill.Inflate( -halfThickness, numSegs );
+    serialFill.Simplify( SHAPE_POLY_SET::PM_FAST );
+    serialFill.Simplify( SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    serialFill.Fracture( SHAPE_POLY_SET::PM_FAST );
+
+    zone->SetFilledPolysList( serialFill );
+    zone->SetIsFilled( true );
+
+    wxString filename = wxFileName::CreateTempFileName( "qa_zone_fill_check" );
+    KI_TEST::DumpBoardToFile( *board, filename.ToStdString() );
+
+    std::ifstream          file( filename.ToStdString() );
+    std::unique_ptr<BOARD> loaded = KI_TEST::ReadItemFromStream<BOARD>( file );
+
+    file.close();
+    wxRemoveFile( filename );
+
+    BOOST_REQUIRE( loaded );
+    loaded->BuildConnectivity();
+
+    zone = loaded->GetArea( 0 );
+    BOOST_REQUIRE( zone );
+
+    const SHAPE_POLY_SET previous = zone->GetFilledPolysList();
+    BOOST_REQUIRE( !previous.IsEmpty() );
+
+    ZONE_FILLER filler( loaded.get() );
+    BOOST_REQUIRE( filler.Fill( { zone } ) );
+
+    const SHAPE_POLY_SET& refilled = zone->GetFilledPolysList();
+
+    BOOST_CHECK( ZONE_FILLER::SameFilledAreas( previous, refilled ) );
+
+    // A real change of the area is still seen
+    SHAPE_POLY_SET notch;
+    int            size = Millimeter2iu( 1 );
+
+    notch.NewOutline();
+    notch.Append( Millimeter2iu( 50 ), Millimeter2iu( 50 ) );
+    notch.Append( Millimeter2iu( 50 ) + size, Millimeter2iu( 50 ) );
+    notch.Append( Millimeter2iu( 50 ) + size, Millimeter2iu( 50 ) + size );
+    notch.Append( Millimeter2iu( 50 ), Millimeter2iu( 50 ) + size );
+
+    SHAPE_POLY_SET changed = previous;
+    changed.BooleanSubtract( notch, SHAPE_POLY_SET::PM_FAST );
+
+    BOOST_CHECK( !ZONE_FILLER::SameFilledAreas( changed, refilled ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,8 +25,11 @@
 
 #include "tools/drc_tool/drc_tool.h"
 #include "tools/pcb_parser/pcb_parser_tool.h"
+#include "tools/pns_replay/pns_replay_tool.h"
 #include "tools/polygon_generator/polygon_generator.h"
 #include "tools/polygon_triangulation/polygon_triangulation.h"
+#include "tools/ratsnest/ratsnest_tool.h"
+#include "tools/raytrace/raytrace_tool.h"
 
 /**
  * List of registered tools.
@@ -37,8 +40,11 @@
 const static std::vector<KI_TEST::UTILITY_PROGRAM*> known_tools = {
     &drc_tool,
     &pcb_parser_tool,
+    &pns_replay_tool,
     &polygon_generator_tool,
     &polygon_triangulation_tool,
+    &ratsnest_tool,
+    &raytrace_tool,
 };
 
 
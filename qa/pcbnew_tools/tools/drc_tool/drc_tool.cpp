@@ -23,7 +23,12 @@
 
 #include "drc_tool.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
 #include <string>
 
 #include <common.h>
@@ -33,6 +38,7 @@
 #include <pcbnew_utils/board_file_utils.h>
 
 // DRC
+#include <drc.h>
 #include <drc/courtyard_overlap.h>
 #include <drc/drc_marker_factory.h>
 
@@ -208,6 +214,228 @@ private:
 };
 
 
+/**
+ * Result of one DRC phase in a benchmark run
+ */
+struct DRC_PHASE_RESULT
+{
+    std::string  m_name;
+    DRC_DURATION m_duration;
+    size_t       m_items;
+    size_t       m_violations;
+};
+
+
+/**
+ * DRC benchmark: runs each phase of the DRC on its own, with the design settings of
+ * the board, and reports the time taken, the number of board items examined and the
+ * number of violations found by each phase.
+ *
+ * The results are written as JSON, and can be compared to the results of a previous
+ * run to catch performance regressions.
+ */
+class DRC_PHASE_BENCHMARK
+{
+public:
+    /**
+     * @param aRepeat the number of times each phase is run: the best time is reported
+     */
+    DRC_PHASE_BENCHMARK( unsigned aRepeat ) : m_repeat( std::max( 1u, aRepeat ) )
+    {
+    }
+
+    void Execute( BOARD& aBoard )
+    {
+        static const std::vector<std::pair<DRC::TEST_PHASE, std::string>> phases = {
+            { DRC::TEST_OUTLINE, "outline" },
+            { DRC::TEST_NETCLASSES, "netclasses" },
+            { DRC::TEST_PAD_TO_PAD, "pad_to_pad" },
+            { DRC::TEST_DRILLED_HOLES, "drilled_holes" },
+            { DRC::TEST_TRACKS, "tracks" },
+            { DRC::TEST_ZONES, "zones" },
+            { DRC::TEST_UNCONNECTED, "unconnected" },
+            { DRC::TEST_KEEPOUT_AREAS, "keepout_areas" },
+            { DRC::TEST_TEXT_AND_GRAPHICS, "text_and_graphics" },
+            { DRC::TEST_COURTYARDS, "courtyards" },
+            { DRC::TEST_DISABLED_LAYERS, "disabled_layers" },
+        };
+
+        aBoard.BuildConnectivity();
+
+        m_results.clear();
+
+        // A single DRC instance: some phases use the results of the previous ones
+        // (e.g. the board outline)
+        DRC drc( &aBoard );
+
+        for( const auto& phase : phases )
+        {
+            DRC_PHASE_RESULT result{ phase.second, DRC_DURATION::max(), 0, 0 };
+
+            for( unsigned run = 0; run < m_repeat; ++run )
+            {
+                std::vector<MARKER_PCB*> markers;
+                DRC_DURATION             duration;
+
+                {
+                    SCOPED_TIMER<DRC_DURATION> timer( duration );
+                    result.m_items = drc.RunTest( phase.first, markers );
+                }
+
+                result.m_duration = std::min( result.m_duration, duration );
+                result.m_violations = markers.size();
+
+                for( MARKER_PCB* marker : markers )
+                    delete marker;
+            }
+
+            m_results.push_back( result );
+        }
+    }
+
+    const std::vector<DRC_PHASE_RESULT>& GetResults() const
+    {
+        return m_results;
+    }
+
+    void WriteJson( std::ostream& aStream, const std::string& aBoardName ) const
+    {
+        aStream << "{\n";
+        aStream << "    \"board\": \"" << escapeJson( aBoardName ) << "\",\n";
+        aStream << "    \"repeat\": " << m_repeat << ",\n";
+        aStream << "    \"phases\": [\n";
+
+        for( size_t i = 0; i < m_results.size(); ++i )
+        {
+            const DRC_PHASE_RESULT& res = m_results[i];
+
+            // One phase per line: this is what ReadJson() expects
+            aStream << "        { \"name\": \"" << res.m_name << "\", \"time_us\": "
+                    << res.m_duration.count() << ", \"items\": " << res.m_items
+                    << ", \"violations\": " << res.m_violations << " }"
+                    << ( i + 1 < m_results.size() ? "," : "" ) << "\n";
+        }
+
+        aStream << "    ]\n";
+        aStream << "}\n";
+    }
+
+    /**
+     * Read the phase results from a file written by WriteJson().
+     *
+     * This is not a general JSON parser: one phase is expected per line.
+     */
+    static bool ReadJson( std::istream& aStream, std::map<std::string, DRC_PHASE_RESULT>& aResults )
+    {
+        static const std::regex phaseRe( "\"name\":\\s*\"(\\w+)\",\\s*\"time_us\":\\s*(\\d+),"
+                                         "\\s*\"items\":\\s*(\\d+),\\s*\"violations\":\\s*(\\d+)" );
+
+        std::string line;
+        std::smatch match;
+
+        while( std::getline( aStream, line ) )
+        {
+            if( !std::regex_search( line, match, phaseRe ) )
+                continue;
+
+            DRC_PHASE_RESULT res{ match[1], DRC_DURATION( std::stoll( match[2] ) ),
+                                  std::stoul( match[3] ), std::stoul( match[4] ) };
+            aResults[res.m_name] = res;
+        }
+
+        return !aResults.empty();
+    }
+
+    /**
+     * Compare the results with a baseline, and print the differences.
+     *
+     * @param aTolerance the allowed slowdown of a phase, in percent
+     * @param aSlower set to true if a phase is slower than the baseline plus tolerance
+     * @param aChanged set to true if the items or violation counts of a phase differ
+     */
+    void Compare( const std::map<std::string, DRC_PHASE_RESULT>& aBaseline, double aTolerance,
+                  bool& aSlower, bool& aChanged ) const
+    {
+        aSlower = false;
+        aChanged = false;
+
+        for( const DRC_PHASE_RESULT& res : m_results )
+        {
+            auto it = aBaseline.find( res.m_name );
+
+            if( it == aBaseline.end() )
+            {
+                std::cerr << res.m_name << ": not in baseline" << std::endl;
+                continue;
+            }
+
+            const DRC_PHASE_RESULT& base = it->second;
+
+            // Very short phases are dominated by noise
+            const auto   minDuration = std::chrono::milliseconds( 1 );
+            const double limit = base.m_duration.count() * ( 1.0 + aTolerance / 100.0 );
+
+            if( res.m_duration > minDuration && res.m_duration.count() > limit )
+            {
+                std::cerr << res.m_name << ": " << res.m_duration.count() << "us, baseline "
+                          << base.m_duration.count() << "us" << std::endl;
+                aSlower = true;
+            }
+
+            if( res.m_items != base.m_items || res.m_violations != base.m_violations )
+            {
+                std::cerr << res.m_name << ": " << res.m_items << " items, "
+                          << res.m_violations << " violations, baseline " << base.m_items
+                          << " items, " << base.m_violations << " violations" << std::endl;
+                aChanged = true;
+            }
+        }
+    }
+
+private:
+    /**
+     * Escape a string for a JSON string literal: quotes, backslashes (e.g. in Windows
+     * paths) and control characters.
+     */
+    static std::string escapeJson( const std::string& aStr )
+    {
+        std::string escaped;
+
+        for( char c : aStr )
+        {
+            switch( c )
+            {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if( static_cast<unsigned char>( c ) < 0x20 )
+                {
+                    char buf[8];
+                    std::snprintf( buf, sizeof( buf ), "\\u%04x", static_cast<int>( c ) );
+                    escaped += buf;
+                }
+                else
+                {
+                    escaped += c;
+                }
+
+                break;
+            }
+        }
+
+        return escaped;
+    }
+
+    const unsigned                m_repeat;
+    std::vector<DRC_PHASE_RESULT> m_results;
+};
+
+
 static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
     {
             wxCMD_LINE_SWITCH,
@@ -253,6 +481,40 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
             "courtyard-missing",
             _( "perform courtyard-missing checking" ).mb_str(),
     },
+    {
+            wxCMD_LINE_SWITCH,
+            "b",
+            "benchmark",
+            _( "run each DRC phase on its own and report timings as JSON" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "o",
+            "output",
+            _( "write the benchmark results to this file instead of stdout" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "repeat",
+            _( "run each benchmark phase N times and keep the best time (default 1)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            nullptr,
+            "baseline",
+            _( "compare the benchmark results to a previous output file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            nullptr,
+            "tolerance",
+            _( "allowed slowdown against the baseline, in percent (default 20)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
     {
             wxCMD_LINE_PARAM,
             nullptr,
@@ -270,9 +532,76 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
 enum PARSER_RET_CODES
 {
     PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+
+    /// The benchmark baseline or output file could not be used
+    BENCHMARK_FILE_ERROR,
+
+    /// A DRC phase was slower than the baseline
+    SLOWER_THAN_BASELINE,
+
+    /// A DRC phase did not give the same results as the baseline
+    BASELINE_MISMATCH,
 };
 
 
+static int runBenchmark( const wxCmdLineParser& aParser, BOARD& aBoard,
+                         const std::string& aFilename )
+{
+    long repeat = 1;
+    long tolerance = 20;
+
+    aParser.Found( "repeat", &repeat );
+    aParser.Found( "tolerance", &tolerance );
+
+    DRC_PHASE_BENCHMARK benchmark( std::max( 1L, repeat ) );
+    benchmark.Execute( aBoard );
+
+    wxString outputName;
+
+    if( aParser.Found( "output", &outputName ) )
+    {
+        std::ofstream output( outputName.ToStdString() );
+
+        if( !output )
+        {
+            std::cerr << "Cannot write " << outputName << std::endl;
+            return BENCHMARK_FILE_ERROR;
+        }
+
+        benchmark.WriteJson( output, aFilename );
+    }
+    else
+    {
+        benchmark.WriteJson( std::cout, aFilename );
+    }
+
+    wxString baselineName;
+
+    if( !aParser.Found( "baseline", &baselineName ) )
+        return KI_TEST::RET_CODES::OK;
+
+    std::ifstream                           baselineFile( baselineName.ToStdString() );
+    std::map<std::string, DRC_PHASE_RESULT> baseline;
+
+    if( !baselineFile || !DRC_PHASE_BENCHMARK::ReadJson( baselineFile, baseline ) )
+    {
+        std::cerr << "Cannot read baseline " << baselineName << std::endl;
+        return BENCHMARK_FILE_ERROR;
+    }
+
+    bool slower, changed;
+    benchmark.Compare( baseline, tolerance, slower, changed );
+
+    if( changed )
+        return BASELINE_MISMATCH;
+
+    if( slower )
+        return SLOWER_THAN_BASELINE;
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
 int drc_main_func( int argc, char** argv )
 {
 #ifdef __AFL_COMPILER
@@ -307,6 +636,9 @@ int drc_main_func( int argc, char** argv )
     if( !board )
         return PARSER_RET_CODES::PARSE_FAILED;
 
+    if( cl_parser.Found( "benchmark" ) )
+        return runBenchmark( cl_parser, *board, filename );
+
     DRC_RUNNER::EXECUTION_CONTEXT exec_context{
         verbose,
         cl_parser.Found( "timings" ),
@@ -337,6 +669,6 @@ int drc_main_func( int argc, char** argv )
  */
 KI_TEST::UTILITY_PROGRAM drc_tool = {
     "drc",
-    "Run selected DRC function on a PCB",
+    "Run selected DRC function on a PCB, or benchmark all DRC phases",
     drc_main_func,
 };
\ No newline at end of file
@@ -0,0 +1,400 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "pns_replay_tool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <common.h>
+
+#include <wx/cmdline.h>
+
+#include <class_board.h>
+
+#include <router/pns_kicad_iface.h>
+#include <router/pns_logger.h>
+#include <router/pns_router.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/scoped_timer.h>
+
+
+using REPLAY_DURATION = std::chrono::microseconds;
+
+
+/**
+ * The latencies of one kind of router step
+ */
+struct REPLAY_STEP_TIMES
+{
+    std::string                  m_name;
+    std::vector<REPLAY_DURATION> m_times;
+
+    void Report() const
+    {
+        if( m_times.empty() )
+            return;
+
+        std::vector<REPLAY_DURATION> sorted( m_times );
+        std::sort( sorted.begin(), sorted.end() );
+
+        // nearest rank percentiles
+        const auto percentile = [&sorted]( double aP ) -> REPLAY_DURATION::rep {
+            size_t rank = (size_t) std::ceil( aP / 100.0 * sorted.size() );
+            return sorted[std::max<size_t>( rank, 1 ) - 1].count();
+        };
+
+        std::cout << "    " << m_name << ": " << sorted.size() << " steps, p50 "
+                  << percentile( 50 ) << "us, p90 " << percentile( 90 ) << "us, p99 "
+                  << percentile( 99 ) << "us, max " << sorted.back().count() << "us"
+                  << std::endl;
+    }
+};
+
+
+/**
+ * Replays the input events logged by the router (see ADVANCED_CFG::m_routerEventLog) on a
+ * board, without a view or a tool, and reports the latency of each step.
+ *
+ * The routed tracks are committed to the world of the router only: the board is not
+ * modified, so each replay starts from the same board.
+ */
+class PNS_REPLAY
+{
+public:
+    PNS_REPLAY( const std::vector<PNS::LOGGER::EVENT_ENTRY>& aEvents ) :
+            m_events( aEvents )
+    {
+    }
+
+    void Execute( BOARD& aBoard, const std::string& aName )
+    {
+        PNS_KICAD_IFACE iface;
+        PNS::ROUTER     router;
+
+        iface.SetBoard( &aBoard );
+        router.SetInterface( &iface );
+
+        REPLAY_DURATION syncTime;
+
+        {
+            SCOPED_TIMER<REPLAY_DURATION> timer( syncTime );
+            router.SyncWorld();
+        }
+
+        PNS::ROUTING_SETTINGS settings;
+        PNS::SIZES_SETTINGS   sizes;
+        PNS::ROUTER_MODE      mode = PNS::PNS_MODE_ROUTE_SINGLE;
+
+        REPLAY_STEP_TIMES starts{ "start" };
+        REPLAY_STEP_TIMES moves{ "move" };
+        REPLAY_STEP_TIMES fixes{ "fix" };
+        REPLAY_STEP_TIMES others{ "other" };
+        int               sessions = 0;
+        int               failedStarts = 0;
+
+        router.Stats().Clear();
+
+        for( const PNS::LOGGER::EVENT_ENTRY& evt : m_events )
+        {
+            if( evt.type == PNS::LOGGER::EVT_SETTING )
+            {
+                applySetting( evt, settings, sizes, mode );
+                continue;
+            }
+
+            // Finding the item is the job of the tool, not of the router: not timed
+            PNS::ITEM* item = findItem( router, evt );
+            REPLAY_DURATION duration;
+
+            {
+                SCOPED_TIMER<REPLAY_DURATION> timer( duration );
+                replayEvent( router, evt, item, settings, sizes, mode, failedStarts );
+            }
+
+            switch( evt.type )
+            {
+            case PNS::LOGGER::EVT_START_ROUTE:
+            case PNS::LOGGER::EVT_START_DRAG:
+                starts.m_times.push_back( duration );
+                sessions++;
+                break;
+
+            case PNS::LOGGER::EVT_MOVE:
+                moves.m_times.push_back( duration );
+                break;
+
+            case PNS::LOGGER::EVT_FIX:
+                fixes.m_times.push_back( duration );
+                break;
+
+            default:
+                others.m_times.push_back( duration );
+                break;
+            }
+        }
+
+        router.StopRouting();
+
+        const PNS::ROUTER_STATS& stats = router.Stats();
+
+        std::cout << aName << ": " << sessions << " sessions (" << failedStarts
+                  << " failed to start), world sync " << syncTime.count() / 1000 << "ms"
+                  << std::endl;
+
+        starts.Report();
+        moves.Report();
+        fixes.Report();
+        others.Report();
+
+        std::cout << "    shove iterations: " << stats.m_shoveIterations << std::endl;
+        std::cout << "    walkaround iterations: " << stats.m_walkaroundIterations << std::endl;
+        std::cout << "    optimizer passes: " << stats.m_optimizerPasses << ", merge steps "
+                  << stats.m_optimizerMergeSteps << std::endl;
+    }
+
+private:
+    /**
+     * Finds the item an event applies to in the current node of the router, by its kind, net
+     * and layers, among the items under the cursor
+     */
+    static PNS::ITEM* findItem( PNS::ROUTER& aRouter, const PNS::LOGGER::EVENT_ENTRY& aEvent )
+    {
+        if( aEvent.itemKind == 0 )
+            return nullptr;
+
+        PNS::ITEM_SET candidates = aRouter.QueryHoverItems( aEvent.p );
+
+        for( PNS::ITEM* item : candidates.Items() )
+        {
+            if( item->Kind() == aEvent.itemKind && item->Net() == aEvent.itemNet
+                    && item->Layers().Start() == aEvent.itemLayerStart
+                    && item->Layers().End() == aEvent.itemLayerEnd )
+            {
+                return item;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static void applySetting( const PNS::LOGGER::EVENT_ENTRY& aEvent,
+                              PNS::ROUTING_SETTINGS& aSettings, PNS::SIZES_SETTINGS& aSizes,
+                              PNS::ROUTER_MODE& aMode )
+    {
+        const std::string& name = aEvent.name;
+        const int          value = aEvent.arg;
+
+        if( name == "router_mode" )
+            aMode = (PNS::ROUTER_MODE) value;
+        else if( name == "mode" )
+            aSettings.SetMode( (PNS::PNS_MODE) value );
+        else if( name == "optimizer_effort" )
+            aSettings.SetOptimizerEffort( (PNS::PNS_OPTIMIZATION_EFFORT) value );
+        else if( name == "shove_vias" )
+            aSettings.SetShoveVias( value != 0 );
+        else if( name == "remove_loops" )
+            aSettings.SetRemoveLoops( value != 0 );
+        else if( name == "smart_pads" )
+            aSettings.SetSmartPads( value != 0 );
+        else if( name == "free_angle" )
+            aSettings.SetFreeAngleMode( value != 0 );
+        else if( name == "can_violate_drc" )
+            aSettings.SetCanViolateDRC( value != 0 );
+        else if( name == "track_width" )
+            aSizes.SetTrackWidth( value );
+        else if( name == "via_diameter" )
+            aSizes.SetViaDiameter( value );
+        else if( name == "via_drill" )
+            aSizes.SetViaDrill( value );
+        else if( name == "via_type" )
+            aSizes.SetViaType( (VIATYPE_T) value );
+        else if( name == "diff_pair_width" )
+            aSizes.SetDiffPairWidth( value );
+        else if( name == "diff_pair_gap" )
+            aSizes.SetDiffPairGap( value );
+        else
+            std::cerr << "Unknown setting in the event log: " << name << std::endl;
+    }
+
+    static void replayEvent( PNS::ROUTER& aRouter, const PNS::LOGGER::EVENT_ENTRY& aEvent,
+                             PNS::ITEM* aItem, const PNS::ROUTING_SETTINGS& aSettings,
+                             const PNS::SIZES_SETTINGS& aSizes, PNS::ROUTER_MODE aMode,
+                             int& aFailedStarts )
+    {
+        switch( aEvent.type )
+        {
+        case PNS::LOGGER::EVT_START_ROUTE:
+            aRouter.LoadSettings( aSettings );
+            aRouter.UpdateSizes( aSizes );
+            aRouter.SetMode( aMode );
+
+            if( !aRouter.StartRouting( aEvent.p, aItem, aEvent.arg ) )
+                aFailedStarts++;
+
+            break;
+
+        case PNS::LOGGER::EVT_START_DRAG:
+            aRouter.LoadSettings( aSettings );
+            aRouter.UpdateSizes( aSizes );
+            aRouter.SetMode( aMode );
+
+            if( !aRouter.StartDragging( aEvent.p, aItem, aEvent.arg ) )
+                aFailedStarts++;
+
+            break;
+
+        case PNS::LOGGER::EVT_MOVE:
+            aRouter.Move( aEvent.p, aItem );
+            break;
+
+        case PNS::LOGGER::EVT_FIX:
+            aRouter.FixRoute( aEvent.p, aItem, aEvent.arg != 0 );
+            break;
+
+        case PNS::LOGGER::EVT_STOP:
+            aRouter.StopRouting();
+            break;
+
+        case PNS::LOGGER::EVT_SWITCH_LAYER:
+            aRouter.SwitchLayer( aEvent.arg );
+            break;
+
+        case PNS::LOGGER::EVT_TOGGLE_VIA:
+            aRouter.ToggleViaPlacement();
+            break;
+
+        case PNS::LOGGER::EVT_FLIP_POSTURE:
+            aRouter.FlipPosture();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    const std::vector<PNS::LOGGER::EVENT_ENTRY>& m_events;
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "repeat",
+            _( "number of replays (default 1)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "board file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "event log" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum PNS_REPLAY_RET_CODES
+{
+    PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    LOG_READ_FAILED,
+};
+
+
+int pns_replay_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program replays the routing sessions of an event log on a PCB file, "
+               "without a view, and reports the latency percentiles of the router steps and "
+               "the iterations of the shove, walkaround and optimizer algorithms. The log is "
+               "recorded by Pcbnew when the RouterEventLog advanced setting is set; the board "
+               "must be the one the sessions were recorded on, as it was before them." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long repeat = 1;
+    cl_parser.Found( "repeat", &repeat );
+
+    const std::string boardFile = cl_parser.GetParam( 0 ).ToStdString();
+    const std::string logFile = cl_parser.GetParam( 1 ).ToStdString();
+
+    std::vector<PNS::LOGGER::EVENT_ENTRY> events;
+
+    if( !PNS::LOGGER::LoadEvents( logFile, events ) )
+    {
+        std::cerr << "Cannot read the event log " << logFile << std::endl;
+        return PNS_REPLAY_RET_CODES::LOG_READ_FAILED;
+    }
+
+    std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( boardFile );
+
+    if( !board )
+        return PNS_REPLAY_RET_CODES::PARSE_FAILED;
+
+    PNS_REPLAY replay( events );
+
+    for( long i = 0; i < std::max( 1L, repeat ); i++ )
+        replay.Execute( *board, boardFile );
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM pns_replay_tool = {
+    "pns_replay",
+    "Replay logged routing sessions on a PCB file and measure the router latency",
+    pns_replay_main_func,
+};
@@ -0,0 +1,267 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "ratsnest_tool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include <common.h>
+
+#include <wx/cmdline.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <netinfo.h>
+
+#include <connectivity/connectivity_algo.h>
+#include <connectivity/connectivity_data.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/scoped_timer.h>
+
+
+using RATSNEST_DURATION = std::chrono::microseconds;
+
+
+/**
+ * Builds a board with aNetCount nets of aPadsPerNet pads each.  The pads are laid out on a
+ * grid of footprints and given to the nets at random (with a fixed seed), and there are no
+ * tracks: every pad is a cluster of its own, which is the worst case for the ratsnest.
+ */
+static std::unique_ptr<BOARD> makeSyntheticBoard( int aNetCount, int aPadsPerNet )
+{
+    const int padsPerModule = 16;
+    const int pitch = Millimeter2iu( 1.0 );
+    const int padCount = aNetCount * aPadsPerNet;
+    const int moduleCount = ( padCount + padsPerModule - 1 ) / padsPerModule;
+    const int modulesPerRow = std::max( 1, (int) std::sqrt( (double) moduleCount ) );
+
+    std::unique_ptr<BOARD> board( new BOARD );
+
+    for( int net = 1; net <= aNetCount; ++net )
+        board->Add( new NETINFO_ITEM( board.get(), wxString::Format( "N%d", net ), net ) );
+
+    std::vector<int> nets( padCount );
+
+    for( int i = 0; i < padCount; ++i )
+        nets[i] = 1 + i % aNetCount;
+
+    std::mt19937 rng( 1 );
+    std::shuffle( nets.begin(), nets.end(), rng );
+
+    for( int m = 0, pad = 0; m < moduleCount; ++m )
+    {
+        MODULE* module = new MODULE( board.get() );
+        wxPoint modulePos( ( m % modulesPerRow ) * 3 * pitch,
+                           ( m / modulesPerRow ) * ( padsPerModule + 2 ) * pitch );
+
+        module->SetPosition( modulePos );
+        board->Add( module );
+
+        for( int i = 0; i < padsPerModule && pad < padCount; ++i, ++pad )
+        {
+            D_PAD* dpad = new D_PAD( module );
+            wxPoint offset( ( i % 2 ) * 2 * pitch, ( i / 2 ) * pitch );
+
+            dpad->SetShape( PAD_SHAPE_RECT );
+            dpad->SetAttribute( PAD_ATTRIB_SMD );
+            dpad->SetLayerSet( D_PAD::SMDMask() );
+            dpad->SetSize( wxSize( pitch / 2, pitch / 2 ) );
+            dpad->SetPos0( offset );
+            dpad->SetPosition( modulePos + offset );
+            module->Add( dpad );
+            dpad->SetNetCode( nets[pad] );
+        }
+    }
+
+    return board;
+}
+
+
+/**
+ * Times the connectivity build and the full ratsnest update of a board
+ */
+class RATSNEST_BENCHMARK
+{
+public:
+    /**
+     * @param aRepeat the number of full updates: the best and mean times are reported
+     */
+    RATSNEST_BENCHMARK( unsigned aRepeat ) : m_repeat( std::max( 1u, aRepeat ) )
+    {
+    }
+
+    void Execute( BOARD& aBoard, const std::string& aName )
+    {
+        CONNECTIVITY_DATA  connectivity;
+        RATSNEST_DURATION  buildTime;
+
+        {
+            SCOPED_TIMER<RATSNEST_DURATION> timer( buildTime );
+            connectivity.Build( &aBoard );
+        }
+
+        RATSNEST_DURATION best = RATSNEST_DURATION::max();
+        RATSNEST_DURATION total{};
+
+        for( unsigned run = 0; run < m_repeat; ++run )
+        {
+            // Every net is recomputed, as after loading a board
+            for( int net = 0; net < connectivity.GetNetCount(); ++net )
+                connectivity.GetConnectivityAlgo()->MarkNetAsDirty( net );
+
+            RATSNEST_DURATION duration;
+
+            {
+                SCOPED_TIMER<RATSNEST_DURATION> timer( duration );
+                connectivity.RecalculateRatsnest();
+            }
+
+            best = std::min( best, duration );
+            total += duration;
+        }
+
+        std::cout << aName << ": " << connectivity.GetNetCount() << " nets, "
+                  << connectivity.GetNodeCount() << " nodes, "
+                  << connectivity.GetUnconnectedCount() << " unconnected" << std::endl;
+        std::cout << "    build: " << buildTime.count() << "us" << std::endl;
+        std::cout << "    update: best " << best.count() << "us, mean "
+                  << total.count() / m_repeat << "us over " << m_repeat << " runs"
+                  << std::endl;
+    }
+
+private:
+    const unsigned m_repeat;
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "repeat",
+            _( "number of full ratsnest updates to time (default 10)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "s",
+            "synthetic",
+            _( "also benchmark a synthetic board with this number of nets" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "p",
+            "pads-per-net",
+            _( "number of pads of each net of the synthetic board (default 8)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "input file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum RATSNEST_RET_CODES
+{
+    PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+int ratsnest_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program times the connectivity build and the full ratsnest update of "
+               "the given PCB files, and of synthetic boards of the requested size." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long repeat = 10;
+    long synthetic = 0;
+    long padsPerNet = 8;
+
+    cl_parser.Found( "repeat", &repeat );
+    cl_parser.Found( "synthetic", &synthetic );
+    cl_parser.Found( "pads-per-net", &padsPerNet );
+
+    RATSNEST_BENCHMARK benchmark( std::max( 1L, repeat ) );
+
+    for( unsigned i = 0; i < cl_parser.GetParamCount(); i++ )
+    {
+        const std::string filename = cl_parser.GetParam( i ).ToStdString();
+
+        std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+        if( !board )
+            return RATSNEST_RET_CODES::PARSE_FAILED;
+
+        benchmark.Execute( *board, filename );
+    }
+
+    if( synthetic > 0 )
+    {
+        auto board = makeSyntheticBoard( synthetic, std::max( 2L, padsPerNet ) );
+        benchmark.Execute( *board, wxString::Format( "synthetic %ld x %ld", synthetic,
+                                                     padsPerNet ).ToStdString() );
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM ratsnest_tool = {
+    "ratsnest",
+    "Benchmark the ratsnest computation on PCB files or synthetic boards",
+    ratsnest_main_func,
+};
@@ -0,0 +1,414 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "raytrace_tool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <common.h>
+
+#include <wx/cmdline.h>
+#include <wx/image.h>
+
+#include <class_board.h>
+
+#include <3d_canvas/cinfo3d_visu.h>
+#include <3d_rendering/3d_render_raytracing/c3d_render_raytracing.h>
+#include <3d_rendering/3d_render_raytracing/raypacket_simd.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/scoped_timer.h>
+
+
+using RAYTRACE_DURATION = std::chrono::milliseconds;
+
+
+/**
+ * The view of the board, from the default top view.  The rotations are in degrees and are
+ * applied in the order of the view keys of the 3D viewer: z, then x, then y.
+ */
+struct RAYTRACE_CAMERA
+{
+    double m_RotX = 0.0;
+    double m_RotY = 0.0;
+    double m_RotZ = 0.0;
+    double m_Zoom = 1.0;
+};
+
+
+/**
+ * Renders a board with the CPU raytracer, without OpenGL, and optionally times further
+ * renders with each of the packet kernels the CPU supports
+ */
+class RAYTRACE_BENCHMARK
+{
+public:
+    /**
+     * @param aSize the size of the rendered image
+     * @param aCamera the view of the board
+     * @param aRepeat the number of renders with each kernel: the best and mean are reported
+     */
+    RAYTRACE_BENCHMARK( const wxSize& aSize, const RAYTRACE_CAMERA& aCamera, unsigned aRepeat ) :
+            m_size( aSize ),
+            m_camera( aCamera ),
+            m_repeat( aRepeat )
+    {
+    }
+
+    /**
+     * @param aOutput the PNG file to write the first render to, if not empty
+     * @return false if the image could not be written
+     */
+    bool Execute( BOARD& aBoard, const std::string& aName,
+                  const std::vector<RAYTRACING_SIMD>& aKernels, const wxString& aOutput )
+    {
+        CINFO3D_VISU settings;
+
+        settings.SetBoard( &aBoard );
+        settings.RenderEngineSet( RENDER_ENGINE_RAYTRACING );
+
+        CCAMERA& camera = settings.CameraGet();
+
+        camera.SetCurWindowSize( m_size );
+        camera.RotateZ( glm::radians( (float) m_camera.m_RotZ ) );
+        camera.RotateX( glm::radians( (float) m_camera.m_RotX ) );
+        camera.RotateY( glm::radians( (float) m_camera.m_RotY ) );
+
+        if( m_camera.m_Zoom > 0.0 )
+            camera.Zoom( (float) m_camera.m_Zoom );
+
+        C3D_RENDER_RAYTRACING renderer( settings );
+        std::vector<GLubyte>  reference;
+        std::vector<GLubyte>  pixels;
+        RAYTRACE_DURATION     firstTime;
+        wxSize                imageSize;
+
+        // The first render also builds the scene and the BVH
+        {
+            SCOPED_TIMER<RAYTRACE_DURATION> timer( firstTime );
+            imageSize = renderer.RenderOffscreen( m_size, reference );
+        }
+
+        const RT_RENDER_TIMINGS& timings = renderer.GetTimings();
+
+        std::cout << aName << ": " << imageSize.x << "x" << imageSize.y << ", "
+                  << RaytracingSimdName( RaytracingSimdGet() ) << " kernels, "
+                  << firstTime.count() << "ms" << std::endl;
+        std::cout << "    scene build: " << timings.m_sceneBuild / 1000 << "ms" << std::endl;
+        std::cout << "    BVH build: " << timings.m_bvhBuild / 1000 << "ms" << std::endl;
+        std::cout << "    tracing: " << timings.m_tracing / 1000 << "ms" << std::endl;
+        std::cout << "    post shading: " << timings.m_postShading / 1000 << "ms" << std::endl;
+
+        if( !aOutput.IsEmpty() && !writeImage( reference, imageSize, aOutput ) )
+        {
+            std::cerr << "Cannot write " << aOutput << std::endl;
+            return false;
+        }
+
+        if( m_repeat == 0 )
+            return true;
+
+        const RAYTRACING_SIMD previous = RaytracingSimdGet();
+        double scalarMean = 0.0;
+
+        for( RAYTRACING_SIMD kernel : aKernels )
+        {
+            RaytracingSimdSet( kernel );
+
+            RAYTRACE_DURATION best = RAYTRACE_DURATION::max();
+            RAYTRACE_DURATION total{};
+
+            for( unsigned run = 0; run < m_repeat; ++run )
+            {
+                RAYTRACE_DURATION duration;
+
+                {
+                    SCOPED_TIMER<RAYTRACE_DURATION> timer( duration );
+                    renderer.RenderOffscreen( m_size, pixels );
+                }
+
+                best = std::min( best, duration );
+                total += duration;
+            }
+
+            const double mean = (double) total.count() / m_repeat;
+
+            if( kernel == RAYTRACING_SIMD_NONE )
+                scalarMean = mean;
+
+            std::cout << "    " << RaytracingSimdName( kernel ) << ": best " << best.count()
+                      << "ms, mean " << mean << "ms over " << m_repeat << " runs";
+
+            if( kernel != RAYTRACING_SIMD_NONE && scalarMean > 0.0 && mean > 0.0 )
+                std::cout << ", " << scalarMean / mean << "x the scalar one";
+
+            std::cout << ", " << countDifferentPixels( reference, pixels )
+                      << " pixels differ from the first render" << std::endl;
+        }
+
+        RaytracingSimdSet( previous );
+
+        return true;
+    }
+
+private:
+    /**
+     * Writes RGBA pixels, bottom row first, to a PNG file
+     */
+    static bool writeImage( const std::vector<GLubyte>& aPixels, const wxSize& aSize,
+                            const wxString& aFilename )
+    {
+        if( !wxImage::FindHandler( wxBITMAP_TYPE_PNG ) )
+            wxImage::AddHandler( new wxPNGHandler );
+
+        wxImage image( aSize );
+
+        for( int y = 0; y < aSize.y; ++y )
+        {
+            const GLubyte* src = &aPixels[( aSize.y - 1 - y ) * aSize.x * 4];
+
+            for( int x = 0; x < aSize.x; ++x, src += 4 )
+                image.SetRGB( x, y, src[0], src[1], src[2] );
+        }
+
+        return image.SaveFile( aFilename, wxBITMAP_TYPE_PNG );
+    }
+
+    static size_t countDifferentPixels( const std::vector<GLubyte>& aA,
+                                        const std::vector<GLubyte>& aB )
+    {
+        size_t count = 0;
+
+        for( size_t i = 0; i + 3 < std::min( aA.size(), aB.size() ); i += 4 )
+        {
+            if( !std::equal( aA.begin() + i, aA.begin() + i + 4, aB.begin() + i ) )
+                ++count;
+        }
+
+        return count;
+    }
+
+    const wxSize          m_size;
+    const RAYTRACE_CAMERA m_camera;
+    const unsigned        m_repeat;
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "r",
+            "repeat",
+            _( "number of renders to time with each kernel (default 3, 0 with --output)" )
+                    .mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "W",
+            "width",
+            _( "width of the image (default 1024)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "H",
+            "height",
+            _( "height of the image (default 768)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "o",
+            "output",
+            _( "write the render to this PNG file (one input file only)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "",
+            "rot-x",
+            _( "rotation of the view around the x axis, in degrees" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "",
+            "rot-y",
+            _( "rotation of the view around the y axis, in degrees" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "",
+            "rot-z",
+            _( "rotation of the view around the z axis, in degrees" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "z",
+            "zoom",
+            _( "zoom factor of the view (default 1)" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "k",
+            "kernel",
+            _( "only time this kernel: scalar, sse2 or avx" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "input file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_MULTIPLE,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum RAYTRACE_RET_CODES
+{
+    PARSE_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    UNSUPPORTED_KERNEL,
+    WRITE_FAILED,
+};
+
+
+int raytrace_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program renders the given PCB files with the CPU raytracer, without "
+               "OpenGL, reports the time of each phase and optionally writes the image. It "
+               "then times further renders with each ray packet kernel the CPU supports. "
+               "The reference benchmark is qa/data/complex_hierarchy.kicad_pcb at the "
+               "default size." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long repeat = 3;
+    long width = 1024;
+    long height = 768;
+    wxString kernelName;
+    wxString output;
+    RAYTRACE_CAMERA camera;
+
+    if( cl_parser.Found( "output", &output ) )
+    {
+        if( cl_parser.GetParamCount() > 1 )
+        {
+            std::cerr << "Only one input file can be rendered to an image" << std::endl;
+            return KI_TEST::RET_CODES::BAD_CMDLINE;
+        }
+
+        repeat = 0;
+    }
+
+    cl_parser.Found( "repeat", &repeat );
+    cl_parser.Found( "width", &width );
+    cl_parser.Found( "height", &height );
+    cl_parser.Found( "rot-x", &camera.m_RotX );
+    cl_parser.Found( "rot-y", &camera.m_RotY );
+    cl_parser.Found( "rot-z", &camera.m_RotZ );
+    cl_parser.Found( "zoom", &camera.m_Zoom );
+
+    std::vector<RAYTRACING_SIMD> kernels;
+
+    if( cl_parser.Found( "kernel", &kernelName ) )
+    {
+        const RAYTRACING_SIMD all[] = { RAYTRACING_SIMD_NONE, RAYTRACING_SIMD_SSE2,
+                                        RAYTRACING_SIMD_AVX };
+
+        for( RAYTRACING_SIMD kernel : all )
+        {
+            if( kernelName.CmpNoCase( RaytracingSimdName( kernel ) ) == 0 )
+                kernels.push_back( kernel );
+        }
+
+        if( kernels.empty() || kernels[0] > RaytracingSimdSupported() )
+        {
+            std::cerr << "Kernel not supported by this CPU: " << kernelName << std::endl;
+            return RAYTRACE_RET_CODES::UNSUPPORTED_KERNEL;
+        }
+
+        // Also for the first render
+        RaytracingSimdSet( kernels[0] );
+    }
+    else
+    {
+        for( int kernel = RAYTRACING_SIMD_NONE; kernel <= RaytracingSimdSupported(); ++kernel )
+            kernels.push_back( (RAYTRACING_SIMD) kernel );
+    }
+
+    RAYTRACE_BENCHMARK benchmark( wxSize( std::max( 64L, width ), std::max( 64L, height ) ),
+                                  camera, std::max( 0L, repeat ) );
+
+    for( unsigned i = 0; i < cl_parser.GetParamCount(); i++ )
+    {
+        const std::string filename = cl_parser.GetParam( i ).ToStdString();
+
+        std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+        if( !board )
+            return RAYTRACE_RET_CODES::PARSE_FAILED;
+
+        if( !benchmark.Execute( *board, filename, kernels, output ) )
+            return RAYTRACE_RET_CODES::WRITE_FAILED;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM raytrace_tool = {
+    "raytrace",
+    "Render PCB files with the CPU raytracer and benchmark its ray packet kernels",
+    raytrace_main_func,
+};